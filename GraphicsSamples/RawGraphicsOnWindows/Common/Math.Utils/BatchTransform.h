@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+namespace math
+{
+    // Structure-of-arrays view over float3 data: x[i], y[i], z[i] form element i.
+    // Float3Stream -> ConstFloat3Stream converts implicitly.
+    template <typename T>
+    struct BasicFloat3Stream
+    {
+        span<T> x;
+        span<T> y;
+        span<T> z;
+
+        BasicFloat3Stream() = default;
+
+        BasicFloat3Stream(span<T> _x, span<T> _y, span<T> _z) :
+            x(_x), y(_y), z(_z)
+        {
+            assert(x.size() == y.size() && x.size() == z.size());
+        }
+
+        template <typename U>
+        BasicFloat3Stream(const BasicFloat3Stream<U>& other) :
+            x(other.x), y(other.y), z(other.z) {}
+
+        size_t size() const { return x.size(); }
+
+        float3 Get(size_t i) const { return float3(x[i], y[i], z[i]); }
+
+        void Set(size_t i, const float3& v) const
+        {
+            x[i] = v.x;
+            y[i] = v.y;
+            z[i] = v.z;
+        }
+
+        BasicFloat3Stream subspan(size_t offset, size_t count) const
+        {
+            return BasicFloat3Stream(x.subspan(offset, count), y.subspan(offset, count), z.subspan(offset, count));
+        }
+    };
+
+    using Float3Stream      = BasicFloat3Stream<float>;
+    using ConstFloat3Stream = BasicFloat3Stream<const float>;
+
+
+    namespace detail
+    {
+        // Matrix rows broadcast to all lanes
+        struct WideMatrix4x4
+        {
+            simd::vfloat m[4][4];
+
+            explicit WideMatrix4x4(const float4x4& mat)
+            {
+                for (int i = 0; i < 4; ++i)
+                    for (int j = 0; j < 4; ++j)
+                        m[i][j] = simd::broadcast(mat.m[i][j]);
+            }
+
+            // (x y z 1) * M, optionally divided by the resulting w
+            void TransformPoint(simd::vfloat& x, simd::vfloat& y, simd::vfloat& z, bool homogeneousDivide) const
+            {
+                using simd::madd;
+                const auto ox = madd(x, m[0][0], madd(y, m[1][0], madd(z, m[2][0], m[3][0])));
+                const auto oy = madd(x, m[0][1], madd(y, m[1][1], madd(z, m[2][1], m[3][1])));
+                const auto oz = madd(x, m[0][2], madd(y, m[1][2], madd(z, m[2][2], m[3][2])));
+                if (homogeneousDivide)
+                {
+                    const auto ow = madd(x, m[0][3], madd(y, m[1][3], madd(z, m[2][3], m[3][3])));
+                    x             = ox / ow;
+                    y             = oy / ow;
+                    z             = oz / ow;
+                }
+                else
+                {
+                    x = ox;
+                    y = oy;
+                    z = oz;
+                }
+            }
+
+            // (x y z 0) * M, for directions
+            void TransformVector(simd::vfloat& x, simd::vfloat& y, simd::vfloat& z) const
+            {
+                using simd::madd;
+                const auto ox = madd(x, m[0][0], madd(y, m[1][0], z * m[2][0]));
+                const auto oy = madd(x, m[0][1], madd(y, m[1][1], z * m[2][1]));
+                const auto oz = madd(x, m[0][2], madd(y, m[1][2], z * m[2][2]));
+                x             = ox;
+                y             = oy;
+                z             = oz;
+            }
+        };
+
+        inline float3 TransformPointScalar(const float4x4& m, const float3& p, bool homogeneousDivide)
+        {
+            const float x = p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0];
+            const float y = p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1];
+            const float z = p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2];
+            if (!homogeneousDivide)
+                return float3(x, y, z);
+
+            const float w = p.x * m[0][3] + p.y * m[1][3] + p.z * m[2][3] + m[3][3];
+            return float3(x / w, y / w, z / w);
+        }
+        // Body of the SoA TransformPoints. This is a plain loop on purpose: once the
+        // streams are known not to alias there is no cross-lane work left, so the
+        // compiler vectorizes it at the widest width the target has (512-bit with
+        // -march=native on AVX-512), which the fixed-width simd::vfloat can't match.
+        // The pointers are restrict parameters rather than locals because GCC only
+        // honours restrict on parameters; without it the loop needs more run-time
+        // alias checks than it is willing to emit and stays scalar.
+        inline void TransformPointsSoA(const float4x4& m, const float* __restrict inX, const float* __restrict inY, const float* __restrict inZ,
+                                       float* __restrict outX, float* __restrict outY, float* __restrict outZ, size_t count, bool homogeneousDivide)
+        {
+            // Local copies of the matrix, the stores could otherwise alias it
+            const float m00 = m[0][0], m01 = m[0][1], m02 = m[0][2], m03 = m[0][3];
+            const float m10 = m[1][0], m11 = m[1][1], m12 = m[1][2], m13 = m[1][3];
+            const float m20 = m[2][0], m21 = m[2][1], m22 = m[2][2], m23 = m[2][3];
+            const float m30 = m[3][0], m31 = m[3][1], m32 = m[3][2], m33 = m[3][3];
+
+            // Scalar head until the x output is on a 64-byte boundary. Streams that share
+            // their alignment (one allocation, or separately aligned ones) are then all
+            // aligned, which matters here: 512-bit accesses that split cache lines run
+            // at about half speed.
+            const size_t head = std::min(count, ((64 - (reinterpret_cast<uintptr_t>(outX) & 63)) & 63) / sizeof(float));
+            for (size_t i = 0; i < head; ++i)
+            {
+                const float3 p = TransformPointScalar(m, float3(inX[i], inY[i], inZ[i]), homogeneousDivide);
+                outX[i]        = p.x;
+                outY[i]        = p.y;
+                outZ[i]        = p.z;
+            }
+
+            if (!homogeneousDivide)
+            {
+                for (size_t i = head; i < count; ++i)
+                {
+                    const float x = inX[i], y = inY[i], z = inZ[i];
+                    outX[i]       = x * m00 + y * m10 + z * m20 + m30;
+                    outY[i]       = x * m01 + y * m11 + z * m21 + m31;
+                    outZ[i]       = x * m02 + y * m12 + z * m22 + m32;
+                }
+                return;
+            }
+
+            for (size_t i = head; i < count; ++i)
+            {
+                const float x = inX[i], y = inY[i], z = inZ[i];
+                const float w = x * m03 + y * m13 + z * m23 + m33;
+                outX[i]       = (x * m00 + y * m10 + z * m20 + m30) / w;
+                outY[i]       = (x * m01 + y * m11 + z * m21 + m31) / w;
+                outZ[i]       = (x * m02 + y * m12 + z * m22 + m32) / w;
+            }
+        }
+    } // namespace detail
+
+
+    // out[i] = (in[i], 1) * m, processed simd::kWidth points at a time (see below for AVX-512).
+    // Without homogeneousDivide the w column is ignored (affine transforms);
+    // with it the result equals float3 * float4x4, i.e. xyz / w.
+    // `in` and `out` may be the same array.
+    inline void TransformPoints(const float4x4& m, span<const float3> in, span<float3> out, bool homogeneousDivide = false)
+    {
+        assert(in.size() == out.size());
+        static_assert(sizeof(float3) == 3 * sizeof(float), "float3 must be tightly packed");
+
+#if defined(MATH_SIMD_AVX512)
+        // With AVX-512 the compiler vectorizes the plain loop 16 points wide, which
+        // beats the 8-wide simd::vfloat kernel and its interleave shuffles
+        for (size_t i = 0; i < in.size(); ++i)
+            out[i] = detail::TransformPointScalar(m, in[i], homogeneousDivide);
+#else
+        const detail::WideMatrix4x4 wm(m);
+
+        const size_t count = in.size();
+        const float* src   = reinterpret_cast<const float*>(in.data());
+        float*       dst   = reinterpret_cast<float*>(out.data());
+
+        size_t i = 0;
+        for (; i + simd::kWidth <= count; i += simd::kWidth)
+        {
+            simd::vfloat x, y, z;
+            simd::load_interleaved3(src + i * 3, x, y, z);
+            wm.TransformPoint(x, y, z, homogeneousDivide);
+            simd::store_interleaved3(dst + i * 3, x, y, z);
+        }
+
+        for (; i < count; ++i)
+            out[i] = detail::TransformPointScalar(m, in[i], homogeneousDivide);
+#endif
+    }
+
+    // Structure-of-arrays version of TransformPoints, no shuffles needed.
+    // `in` and `out` must not overlap (unlike the AoS version, no in-place use).
+    inline void TransformPoints(const float4x4& m, const ConstFloat3Stream& in, const Float3Stream& out, bool homogeneousDivide = false)
+    {
+        assert(in.size() == out.size());
+
+        detail::TransformPointsSoA(m, in.x.data(), in.y.data(), in.z.data(), out.x.data(), out.y.data(), out.z.data(), in.size(), homogeneousDivide);
+    }
+} // namespace math
@@ -0,0 +1,552 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "RayTriangle.h"
+#include "Simd.h"
+#include "Span.h"
+#include "ThreadPool.h"
+
+// Bounding volume hierarchy over a triangle mesh, for ray casts (picking, occlusion).
+//
+// Built top down with a binned surface area heuristic: per axis the triangle centroids are
+// counted into kBins bins and the bin border with the lowest expected traversal cost becomes
+// the split. Subtrees of at least kParallelThreshold triangles are built as tasks on a ThreadPool.
+//
+// Nodes are 32 bytes and 32-byte aligned, and the two children of a node are stored next to each
+// other. Traversal loads both children at once and slab tests them together: one AVX register
+// holds the two boxes, with SSE2 it is one register per box. The triangles of the leaves go
+// through the watertight test of RayTriangle.h, so rays through shared edges do not slip through.
+
+namespace math
+{
+    struct alignas(32) BvhNode
+    {
+        float3   boundsMin;
+        uint32_t first; // leaf: first triangle in Bvh order, inner node: the left child, the right child follows it
+        float3   boundsMax;
+        uint32_t count; // triangles in a leaf, 0 for inner nodes
+
+        bool IsLeaf() const { return count != 0; }
+    };
+    static_assert(sizeof(BvhNode) == 32, "BvhNode must stay 32 bytes");
+
+    namespace detail
+    {
+        // Triangle as its three vertices, for the watertight test of RayTriangle.h
+        struct BvhTriangle
+        {
+            float3 v0;
+            float3 v1;
+            float3 v2;
+        };
+
+        // The ray in the form the slab tests want
+        struct BvhRay
+        {
+            float3 origin;
+            float3 invDir;
+            float  tMin;
+#if defined(MATH_SIMD_AVX)
+            __m256 origin8; // both halves (x, y, z, 0)
+            __m256 invDir8;
+#elif defined(MATH_SIMD_SSE2)
+            __m128 origin4; // (x, y, z, 0)
+            __m128 invDir4;
+#endif
+
+            explicit BvhRay(const Ray& ray) :
+                origin(ray.origin), tMin(ray.tMin)
+            {
+                // A zero direction component would give 0 * inf = NaN on the slab planes through the
+                // origin. 1e-30 keeps the sign and yields a huge but finite slope instead.
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const float d = ray.direction[axis];
+                    invDir[axis]  = 1.f / (std::abs(d) > 1e-30f ? d : std::copysign(1e-30f, d));
+                }
+#if defined(MATH_SIMD_AVX)
+                origin8 = _mm256_setr_ps(origin.x, origin.y, origin.z, 0.f, origin.x, origin.y, origin.z, 0.f);
+                invDir8 = _mm256_setr_ps(invDir.x, invDir.y, invDir.z, 0.f, invDir.x, invDir.y, invDir.z, 0.f);
+#elif defined(MATH_SIMD_SSE2)
+                origin4 = _mm_setr_ps(origin.x, origin.y, origin.z, 0.f);
+                invDir4 = _mm_setr_ps(invDir.x, invDir.y, invDir.z, 0.f);
+#endif
+            }
+        };
+
+        // Rounding can make tFar come out just below tNear for a ray that grazes a box; widening
+        // tFar by 2 gamma(3) keeps such boxes (Ize, "Robust BVH Ray Traversal", JCGT 2013).
+        constexpr float kSlabTFarScale = 1.f + 2.f * (3.f * FLT_EPSILON * 0.5f) / (1.f - 3.f * FLT_EPSILON * 0.5f);
+
+        // Slab test of the ray against both nodes of pair[0..1] on [ray.tMin, tMax].
+        // Returns bit 0 / bit 1 set when the first / second box is hit, and their entry distances.
+        inline uint32_t IntersectChildren(const BvhNode* pair, const BvhRay& ray, float tMax, float entry[2])
+        {
+#if defined(MATH_SIMD_AVX)
+            // Each node is (min.xyz, first, max.xyz, count). Lane 3 of every half carries the integers,
+            // it is replaced by the ray interval before the reductions.
+            const float* p  = &pair[0].boundsMin.x;
+            const __m256 a  = _mm256_load_ps(p);
+            const __m256 b  = _mm256_load_ps(p + 8);
+            const __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+            const __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+
+            const __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(lo, ray.origin8), ray.invDir8);
+            const __m256 t2 = _mm256_mul_ps(_mm256_sub_ps(hi, ray.origin8), ray.invDir8);
+
+            __m256 tNear = _mm256_blend_ps(_mm256_min_ps(t1, t2), _mm256_set1_ps(ray.tMin), 0x88);
+            __m256 tFar  = _mm256_blend_ps(_mm256_mul_ps(_mm256_max_ps(t1, t2), _mm256_set1_ps(kSlabTFarScale)), _mm256_set1_ps(tMax), 0x88);
+
+            tNear = _mm256_max_ps(tNear, _mm256_permute_ps(tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+            tNear = _mm256_max_ps(tNear, _mm256_permute_ps(tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+            tFar  = _mm256_min_ps(tFar, _mm256_permute_ps(tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+            tFar  = _mm256_min_ps(tFar, _mm256_permute_ps(tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            const uint32_t hit = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+            entry[0]           = _mm256_cvtss_f32(tNear);
+            entry[1]           = _mm_cvtss_f32(_mm256_extractf128_ps(tNear, 1));
+            return (hit & 1u) | ((hit >> 3u) & 2u);
+#elif defined(MATH_SIMD_SSE2)
+            const __m128 xyz   = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+            const __m128 tMin4 = _mm_set1_ps(ray.tMin);
+            const __m128 tMax4 = _mm_set1_ps(tMax);
+            const __m128 scale = _mm_set1_ps(kSlabTFarScale);
+
+            uint32_t hit = 0;
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&pair[i].boundsMin.x), ray.origin4), ray.invDir4);
+                const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&pair[i].boundsMax.x), ray.origin4), ray.invDir4);
+
+                __m128 tNear = _mm_or_ps(_mm_and_ps(xyz, _mm_min_ps(t1, t2)), _mm_andnot_ps(xyz, tMin4));
+                __m128 tFar  = _mm_or_ps(_mm_and_ps(xyz, _mm_mul_ps(_mm_max_ps(t1, t2), scale)), _mm_andnot_ps(xyz, tMax4));
+
+                tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+                tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+                tFar  = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+                tFar  = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+
+                entry[i] = _mm_cvtss_f32(tNear);
+                hit |= static_cast<uint32_t>(_mm_comile_ss(tNear, tFar)) << i;
+            }
+            return hit;
+#else
+            uint32_t hit = 0;
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                float tNear = ray.tMin;
+                float tFar  = tMax;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const float t1 = (pair[i].boundsMin[axis] - ray.origin[axis]) * ray.invDir[axis];
+                    const float t2 = (pair[i].boundsMax[axis] - ray.origin[axis]) * ray.invDir[axis];
+                    tNear          = std::max(tNear, std::min(t1, t2));
+                    tFar           = std::min(tFar, std::max(t1, t2) * kSlabTFarScale);
+                }
+                entry[i] = tNear;
+                hit |= static_cast<uint32_t>(tNear <= tFar) << i;
+            }
+            return hit;
+#endif
+        }
+    } // namespace detail
+
+
+    class Bvh
+    {
+    public:
+        static constexpr uint32_t kBins              = 16;
+        static constexpr uint32_t kMaxLeafSize       = 4;
+        static constexpr uint32_t kMaxSahDepth       = 64; // deeper ranges are split at the median, so depth <= 64 + 32
+        static constexpr uint32_t kStackSize         = 128;
+        static constexpr size_t   kParallelThreshold = 4096;
+
+        Bvh() = default;
+        Bvh(span<const float3> positions, span<const uint32_t> indices) { Build(positions, indices); }
+
+        // Triangles are index triples into positions
+        void Build(ThreadPool& pool, span<const float3> positions, span<const uint32_t> indices)
+        {
+            assert(indices.size() % 3 == 0);
+            const uint32_t count = static_cast<uint32_t>(indices.size() / 3);
+
+            m_nodes.clear();
+            m_triangles.clear();
+            m_triangleIds.clear();
+            if (count == 0)
+                return;
+
+            std::vector<PrimRef> refs(count);
+            BuildRange           root;
+            root.end = count;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                PrimRef& ref = refs[i];
+                ref.triangle = i;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    ref.bounds.Extend(positions[indices[3 * i + corner]]);
+                root.bounds.Extend(ref.bounds);
+                root.centroids.Extend(ref.bounds.Center());
+            }
+
+            // Tasks down to a depth with about two subtrees per thread
+            const unsigned threads   = pool.size();
+            uint32_t       taskDepth = 0;
+            while (threads > 1 && (1u << taskDepth) < 2 * threads)
+                ++taskDepth;
+
+            // Every node owns the slots of its descendants, 2 * (triangles - 1) of them, so tasks
+            // never share an allocator. Unused slots are squeezed out afterwards.
+            BuildState state{refs.data(), std::vector<BvhNode>(2 * size_t(count) - 1), &pool, taskDepth};
+            BuildNode(state, 0, root, 1, 0);
+            Compact(state.nodes);
+
+            m_triangles.resize(count);
+            m_triangleIds.resize(count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint32_t  id = refs[i].triangle;
+                const float3&   a  = positions[indices[3 * id + 0]];
+                const float3&   b  = positions[indices[3 * id + 1]];
+                const float3&   c  = positions[indices[3 * id + 2]];
+                m_triangles[i]     = {a, b, c};
+                m_triangleIds[i]   = id;
+            }
+        }
+
+        void Build(span<const float3> positions, span<const uint32_t> indices) { Build(ThreadPool::Default(), positions, indices); }
+
+        // Closest hit within [ray.tMin, ray.tMax]. hit.triangle is the index of the triangle in the
+        // index buffer passed to Build, divided by 3.
+        bool Intersect(const Ray& ray, RayHit& hit) const
+        {
+            return Traverse<false>(ray, hit);
+        }
+
+        // Any hit within [ray.tMin, ray.tMax], for shadow and occlusion rays
+        bool Occluded(const Ray& ray) const
+        {
+            RayHit hit;
+            return Traverse<true>(ray, hit);
+        }
+
+        span<const BvhNode> Nodes() const { return m_nodes; }
+        size_t              TriangleCount() const { return m_triangles.size(); }
+
+        AABB<float> Bounds() const
+        {
+            return m_nodes.empty() ? AABB<float>() : AABB<float>(m_nodes[0].boundsMin, m_nodes[0].boundsMax);
+        }
+
+    private:
+        struct PrimRef
+        {
+            AABB<float> bounds;
+            uint32_t    triangle;
+        };
+
+        struct BuildState
+        {
+            PrimRef*             refs;
+            std::vector<BvhNode> nodes;
+            ThreadPool*          pool;
+            uint32_t             taskDepth;
+        };
+
+        struct BuildRange
+        {
+            uint32_t    begin = 0;
+            uint32_t    end   = 0;
+            AABB<float> bounds;    // of the triangles
+            AABB<float> centroids; // of their centroids
+        };
+
+        struct Bin
+        {
+            AABB<float> bounds;
+            uint32_t    count = 0;
+        };
+
+        static void MakeLeaf(BvhNode& node, uint32_t begin, uint32_t end)
+        {
+            node.first = begin;
+            node.count = end - begin;
+        }
+
+        // Builds the subtree of refs [range.begin, range.end) into nodes[nodeIndex], its descendants into
+        // the slots from freeSlot on
+        static void BuildNode(BuildState& state, uint32_t nodeIndex, const BuildRange& range, uint32_t freeSlot, uint32_t depth)
+        {
+            PrimRef*       refs  = state.refs;
+            BvhNode&       node  = state.nodes[nodeIndex];
+            const uint32_t begin = range.begin;
+            const uint32_t end   = range.end;
+            const uint32_t count = end - begin;
+
+            node.boundsMin = range.bounds.min;
+            node.boundsMax = range.bounds.max;
+            if (count == 1)
+            {
+                MakeLeaf(node, begin, end);
+                return;
+            }
+
+            // SAH cost of a split relative to one triangle test, with a node visit as expensive as
+            // a triangle test: 1 + (area(L) * count(L) + area(R) * count(R)) / area(parent)
+            uint32_t    bestAxis  = 3;
+            uint32_t    bestSplit = 0;
+            float       bestCost  = FLT_MAX;
+            float3      binScale;
+            AABB<float> bestLeft, bestRight;
+
+            // Small nodes get fewer bins, the bin setup and sweeps would cost more than the binning
+            const uint32_t binCount = std::min(kBins, count);
+            if (depth < kMaxSahDepth)
+            {
+                Bin bins[3][kBins];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const float extent = range.centroids.max[axis] - range.centroids.min[axis];
+                    binScale[axis]     = extent > 0.f ? static_cast<float>(binCount) * (1.f - 1e-6f) / extent : 0.f;
+                }
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const float3 c = refs[i].bounds.Center();
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        Bin& bin = bins[axis][BinIndex(c[axis], range.centroids.min[axis], binScale[axis], binCount)];
+                        bin.bounds.Extend(refs[i].bounds);
+                        ++bin.count;
+                    }
+                }
+
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    if (binScale[axis] == 0.f)
+                        continue;
+
+                    // rightBounds[s], rightCost[s]: bounds and area * count of the bins [s, binCount)
+                    AABB<float> rightBounds[kBins];
+                    float       rightCost[kBins];
+                    AABB<float> right;
+                    uint32_t    rightCount = 0;
+                    for (uint32_t s = binCount - 1; s > 0; --s)
+                    {
+                        right.Extend(bins[axis][s].bounds);
+                        rightCount += bins[axis][s].count;
+                        rightBounds[s] = right;
+                        rightCost[s]   = rightCount ? right.Area() * static_cast<float>(rightCount) : 0.f;
+                    }
+
+                    AABB<float> left;
+                    uint32_t    leftCount = 0;
+                    for (uint32_t s = 1; s < binCount; ++s)
+                    {
+                        left.Extend(bins[axis][s - 1].bounds);
+                        leftCount += bins[axis][s - 1].count;
+                        if (leftCount == 0 || leftCount == count)
+                            continue;
+                        const float cost = left.Area() * static_cast<float>(leftCount) + rightCost[s];
+                        if (cost < bestCost)
+                        {
+                            bestCost  = cost;
+                            bestAxis  = axis;
+                            bestSplit = s;
+                            bestLeft  = left;
+                            bestRight = rightBounds[s];
+                        }
+                    }
+                }
+            }
+
+            const float area = range.bounds.Area();
+            if (bestAxis < 3 && area > 0.f)
+                bestCost = 1.f + bestCost / area;
+            if (count <= kMaxLeafSize && (bestAxis == 3 || bestCost >= static_cast<float>(count)))
+            {
+                MakeLeaf(node, begin, end);
+                return;
+            }
+
+            BuildRange left, right;
+            if (bestAxis < 3)
+            {
+                // Partition by bin, collecting the centroid bounds of both sides on the way. The
+                // node bounds of the children are already known from the bins.
+                const float axisMin = range.centroids.min[bestAxis];
+                const float scale   = binScale[bestAxis];
+                uint32_t    i = begin, j = end;
+                while (i < j)
+                {
+                    const float3 c = refs[i].bounds.Center();
+                    if (BinIndex(c[bestAxis], axisMin, scale, binCount) < bestSplit)
+                    {
+                        left.centroids.Extend(c);
+                        ++i;
+                    }
+                    else
+                    {
+                        right.centroids.Extend(c);
+                        std::swap(refs[i], refs[--j]);
+                    }
+                }
+                left.bounds  = bestLeft;
+                right.bounds = bestRight;
+                left.end = right.begin = i;
+            }
+            else
+            {
+                // No usable SAH split (all centroids in one spot, or too deep): halve by the longest axis
+                const float3   size   = range.centroids.Size();
+                const int      axis   = size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+                const uint32_t middle = begin + count / 2;
+                std::nth_element(refs + begin, refs + middle, refs + end, [axis](const PrimRef& a, const PrimRef& b) {
+                    return a.bounds.Center()[axis] < b.bounds.Center()[axis];
+                });
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    BuildRange& side = i < middle ? left : right;
+                    side.bounds.Extend(refs[i].bounds);
+                    side.centroids.Extend(refs[i].bounds.Center());
+                }
+                left.end = right.begin = middle;
+            }
+            left.begin = begin;
+            right.end  = end;
+
+            const uint32_t first     = freeSlot;
+            const uint32_t leftSlots = 2 * (left.end - left.begin - 1);
+            node.first               = first;
+            node.count               = 0;
+
+            if (depth < state.taskDepth && count >= kParallelThreshold)
+            {
+                // The two children as a loop of two, the caller takes one of them
+                state.pool->ParallelFor(0, 2, 1, [&](size_t begin, size_t end) {
+                    for (size_t child = begin; child < end; ++child)
+                    {
+                        if (child == 0)
+                            BuildNode(state, first, left, freeSlot + 2, depth + 1);
+                        else
+                            BuildNode(state, first + 1, right, freeSlot + 2 + leftSlots, depth + 1);
+                    }
+                });
+            }
+            else
+            {
+                BuildNode(state, first, left, freeSlot + 2, depth + 1);
+                BuildNode(state, first + 1, right, freeSlot + 2 + leftSlots, depth + 1);
+            }
+        }
+
+        static uint32_t BinIndex(float centroid, float axisMin, float scale, uint32_t binCount)
+        {
+            return std::min(binCount - 1, static_cast<uint32_t>((centroid - axisMin) * scale));
+        }
+
+        // Copies the used nodes depth first, the children of each node as one pair
+        void Compact(const std::vector<BvhNode>& sparse)
+        {
+            m_nodes.reserve(sparse.size());
+            m_nodes.push_back(sparse[0]);
+
+            std::vector<uint32_t> stack = {0};
+            while (!stack.empty())
+            {
+                const uint32_t index = stack.back();
+                stack.pop_back();
+                if (m_nodes[index].IsLeaf())
+                    continue;
+
+                const uint32_t oldLeft = m_nodes[index].first;
+                const uint32_t newLeft = static_cast<uint32_t>(m_nodes.size());
+                m_nodes.push_back(sparse[oldLeft]);
+                m_nodes.push_back(sparse[oldLeft + 1]);
+                m_nodes[index].first = newLeft;
+                stack.push_back(newLeft + 1);
+                stack.push_back(newLeft);
+            }
+            m_nodes.shrink_to_fit();
+        }
+
+        template <bool AnyHit>
+        bool Traverse(const Ray& ray, RayHit& hit) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            struct Entry
+            {
+                uint32_t node;
+                float    tNear;
+            };
+            Entry    stack[kStackSize];
+            uint32_t top = 0;
+
+            const detail::BvhRay        bvhRay(ray);
+            const detail::WatertightRay watertight(ray);
+            float                       tMax  = ray.tMax;
+            bool                        found = false;
+            uint32_t                    index = 0;
+            for (;;)
+            {
+                const BvhNode& node = m_nodes[index];
+                if (node.IsLeaf())
+                {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                    {
+                        const detail::BvhTriangle& tri = m_triangles[i];
+                        float                      t, u, v;
+                        if (detail::IntersectTriangle(watertight, tri.v0, tri.v1, tri.v2, ray.tMin, tMax, t, u, v))
+                        {
+                            tMax  = t;
+                            hit   = {t, u, v, m_triangleIds[i]};
+                            found = true;
+                            if constexpr (AnyHit)
+                                return true;
+                        }
+                    }
+                }
+                else
+                {
+                    float          entry[2];
+                    const uint32_t mask = detail::IntersectChildren(&m_nodes[node.first], bvhRay, tMax, entry);
+                    if (mask == 3u)
+                    {
+                        // Nearer child first, the other one waits on the stack
+                        const uint32_t nearChild = entry[1] < entry[0] ? 1u : 0u;
+                        assert(top < kStackSize);
+                        stack[top++] = {node.first + (nearChild ^ 1u), entry[nearChild ^ 1u]};
+                        index        = node.first + nearChild;
+                        continue;
+                    }
+                    if (mask != 0u)
+                    {
+                        index = node.first + (mask >> 1u);
+                        continue;
+                    }
+                }
+
+                // Skip the stacked nodes a closer hit has made irrelevant
+                do
+                {
+                    if (top == 0)
+                        return found;
+                    --top;
+                } while (stack[top].tNear > tMax);
+                index = stack[top].node;
+            }
+        }
+
+        std::vector<BvhNode>             m_nodes;
+        std::vector<detail::BvhTriangle> m_triangles;   // in leaf order
+        std::vector<uint32_t>            m_triangleIds; // original index of each of m_triangles
+    };
+} // namespace math
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+// Bulk RGBA8 <-> float4 conversion for whole images.
+// RGBA8 is packed as in DXGI_FORMAT_R8G8B8A8_UNORM: r in the low byte, a in the high byte.
+// float -> 8 bit clamps to [0, 1] and rounds to nearest (NaN -> 0), 8 bit -> float is exactly c / 255.
+// The *_Srgb versions apply the sRGB transfer function to r, g, b (alpha stays linear),
+// like DXGI_FORMAT_R8G8B8A8_UNORM_SRGB.
+
+namespace math
+{
+    namespace detail
+    {
+        // IEC 61966-2-1
+        inline double SrgbToLinear(double c)
+        {
+            return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+        }
+
+        inline double LinearToSrgb(double l)
+        {
+            return l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+        }
+
+        // Lookup tables for the sRGB transfer, built once on first use.
+        //
+        // Decoding is a plain table indexed by the byte.
+        // Encoding is exact (round(255 * LinearToSrgb(x)) for every float) without pow:
+        // the top mantissa bits and the exponent of x select a bucket with the code of its
+        // lower end. The curve rises by less than one code per bucket (at most 0.88 near 1.0),
+        // so the answer is that code or the next one, decided by one compare with the
+        // threshold where the next code begins.
+        struct SrgbTables
+        {
+            // Buckets cover [2^-13, 1]; everything below encodes to 0
+            static constexpr uint32_t kMinBits     = 0x39000000; // 2^-13
+            static constexpr uint32_t kBucketShift = 23 - 7;     // 128 buckets per octave
+            static constexpr uint32_t kBucketCount = (13 << 7) + 1;
+
+            float    decode[512];          // [c]: sRGB -> linear for r, g, b; [256 + c]: c / 255 for alpha
+            float    threshold[257];       // smallest x that encodes to k, threshold[256] = +inf
+            uint32_t bucket[kBucketCount]; // code of the lower end of the bucket
+
+            SrgbTables()
+            {
+                for (int c = 0; c < 256; ++c)
+                {
+                    decode[c]       = static_cast<float>(SrgbToLinear(c / 255.0));
+                    decode[256 + c] = c / 255.f;
+                }
+
+                threshold[0] = 0;
+                for (int k = 1; k < 256; ++k)
+                {
+                    const auto encodesToK = [k](float x) { return LinearToSrgb(x) * 255.0 >= k - 0.5; };
+
+                    float x = static_cast<float>(SrgbToLinear((k - 0.5) / 255.0));
+                    while (encodesToK(std::nextafter(x, 0.f)))
+                        x = std::nextafter(x, 0.f);
+                    while (!encodesToK(x))
+                        x = std::nextafter(x, 2.f);
+                    threshold[k] = x;
+                }
+                threshold[256] = std::numeric_limits<float>::infinity();
+
+                uint32_t k = 0;
+                for (uint32_t i = 0; i < kBucketCount; ++i)
+                {
+                    const float x = FloatFromBits(kMinBits + (i << kBucketShift));
+                    while (threshold[k + 1] <= x)
+                        ++k;
+                    bucket[i] = k;
+                }
+            }
+
+            static const SrgbTables& Get()
+            {
+                static const SrgbTables tables;
+                return tables;
+            }
+
+            uint32_t Encode(float x) const
+            {
+                if (!(x > 0.f))
+                    return 0;
+                if (x >= 1.f)
+                    return 255;
+
+                const uint32_t bits = FloatBits(x);
+                const uint32_t k    = bits < kMinBits ? 0 : bucket[(bits - kMinBits) >> kBucketShift];
+                return k + (x >= threshold[k + 1] ? 1 : 0);
+            }
+        };
+
+        inline uint32_t F4Color_To_RGBA8Srgb(const SrgbTables& tables, const float4& color)
+        {
+            const auto alpha = QuantizeUnorm8(color.a);
+            return tables.Encode(color.r) | tables.Encode(color.g) << 8u | tables.Encode(color.b) << 16u | alpha << 24u;
+        }
+
+        inline float4 RGBA8Srgb_To_F4Color(const SrgbTables& tables, uint32_t RGBA8)
+        {
+            return float4
+            {
+                tables.decode[(RGBA8 >> 0u) & 0xFF],
+                tables.decode[(RGBA8 >> 8u) & 0xFF],
+                tables.decode[(RGBA8 >> 16u) & 0xFF],
+                tables.decode[256 + ((RGBA8 >> 24u) & 0xFF)]
+            };
+        }
+
+#if defined(MATH_SIMD_AVX2)
+
+        // 2 pixels per register: clamp, scale, round half up
+        inline __m256i QuantizeUnorm8(__m256 x)
+        {
+            x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+            return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(255.f)), _mm256_set1_ps(0.5f)));
+        }
+
+        // Same for r, g, b through SrgbTables::Encode, alpha as QuantizeUnorm8
+        inline __m256i QuantizeSrgb8(const SrgbTables& tables, __m256 x)
+        {
+            x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+
+            const __m256i offset  = _mm256_sub_epi32(_mm256_castps_si256(x), _mm256_set1_epi32(SrgbTables::kMinBits));
+            const __m256i index   = _mm256_srli_epi32(_mm256_max_epi32(offset, _mm256_setzero_si256()), SrgbTables::kBucketShift);
+            const __m256i code    = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tables.bucket), index, 4);
+            const __m256  next    = _mm256_i32gather_ps(tables.threshold, _mm256_add_epi32(code, _mm256_set1_epi32(1)), 4);
+            const __m256i roundUp = _mm256_castps_si256(_mm256_cmp_ps(x, next, _CMP_GE_OQ)); // -1 or 0
+            const __m256i srgb    = _mm256_sub_epi32(code, roundUp);
+
+            const __m256i alpha = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(255.f)), _mm256_set1_ps(0.5f)));
+            return _mm256_blend_epi32(srgb, alpha, 0x88);
+        }
+
+        // a = p0 p1, b = p2 p3, c = p4 p5, d = p6 p7 (32 bit channels) -> 8 packed RGBA8 pixels.
+        // The packs work per 128-bit lane, which leaves the pixels as p0 p2 p4 p6 | p1 p3 p5 p7.
+        inline void StoreRGBA8x8(uint32_t* dst, __m256i a, __m256i b, __m256i c, __m256i d)
+        {
+            const __m256i ab    = _mm256_packs_epi32(a, b);
+            const __m256i cd    = _mm256_packs_epi32(c, d);
+            const __m256i bytes = _mm256_packus_epi16(ab, cd);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+        }
+
+        // 2 pixels -> 8 channels as 32 bit integers, pixel 0 in the low lane
+        inline __m256i LoadRGBA8x2(const uint32_t* src)
+        {
+            return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+        }
+
+#elif defined(MATH_SIMD_SSE2)
+
+        // 1 pixel per register
+        inline __m128i QuantizeUnorm8(__m128 x)
+        {
+            x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.f));
+            return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+        }
+
+#endif
+    } // namespace detail
+
+
+    // Single pixel sRGB versions of RGBA8Unorm_To_F4Color / F4Color_To_RGBA8Unorm
+    inline float4 RGBA8Srgb_To_F4Color(uint32_t RGBA8)
+    {
+        return detail::RGBA8Srgb_To_F4Color(detail::SrgbTables::Get(), RGBA8);
+    }
+
+    inline uint32_t F4Color_To_RGBA8Srgb(const float4& f4Color)
+    {
+        return detail::F4Color_To_RGBA8Srgb(detail::SrgbTables::Get(), f4Color);
+    }
+
+
+    // out[i] = RGBA8Unorm_To_F4Color(in[i])
+    inline void RGBA8Unorm_To_F4Color(span<const uint32_t> in, span<float4> out)
+    {
+        assert(in.size() == out.size());
+
+        const size_t    count = in.size();
+        const uint32_t* src   = in.data();
+        float4*         dst   = out.data();
+
+        size_t i = 0;
+#if defined(MATH_SIMD_AVX2)
+        const __m256 scale = _mm256_set1_ps(255.f);
+        for (; i + 8 <= count; i += 8)
+        {
+            for (size_t j = 0; j < 8; j += 2)
+                _mm256_storeu_ps(&dst[i + j].x, _mm256_div_ps(_mm256_cvtepi32_ps(detail::LoadRGBA8x2(src + i + j)), scale));
+        }
+#elif defined(MATH_SIMD_SSE2)
+        const __m128  scale = _mm_set1_ps(255.f);
+        const __m128i zero  = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i p01    = _mm_unpacklo_epi8(pixels, zero);
+            const __m128i p23    = _mm_unpackhi_epi8(pixels, zero);
+            _mm_storeu_ps(&dst[i + 0].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(p01, zero)), scale));
+            _mm_storeu_ps(&dst[i + 1].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(p01, zero)), scale));
+            _mm_storeu_ps(&dst[i + 2].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(p23, zero)), scale));
+            _mm_storeu_ps(&dst[i + 3].x, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(p23, zero)), scale));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = RGBA8Unorm_To_F4Color(src[i]);
+    }
+
+    // out[i] = F4Color_To_RGBA8Unorm(in[i])
+    inline void F4Color_To_RGBA8Unorm(span<const float4> in, span<uint32_t> out)
+    {
+        assert(in.size() == out.size());
+
+        const size_t  count = in.size();
+        const float4* src   = in.data();
+        uint32_t*     dst   = out.data();
+
+        size_t i = 0;
+#if defined(MATH_SIMD_AVX2)
+        for (; i + 8 <= count; i += 8)
+        {
+            const float* p = &src[i].x;
+            detail::StoreRGBA8x8(dst + i,
+                                 detail::QuantizeUnorm8(_mm256_loadu_ps(p + 0)),
+                                 detail::QuantizeUnorm8(_mm256_loadu_ps(p + 8)),
+                                 detail::QuantizeUnorm8(_mm256_loadu_ps(p + 16)),
+                                 detail::QuantizeUnorm8(_mm256_loadu_ps(p + 24)));
+        }
+#elif defined(MATH_SIMD_SSE2)
+        for (; i + 4 <= count; i += 4)
+        {
+            const float*  p   = &src[i].x;
+            const __m128i p01 = _mm_packs_epi32(detail::QuantizeUnorm8(_mm_loadu_ps(p + 0)), detail::QuantizeUnorm8(_mm_loadu_ps(p + 4)));
+            const __m128i p23 = _mm_packs_epi32(detail::QuantizeUnorm8(_mm_loadu_ps(p + 8)), detail::QuantizeUnorm8(_mm_loadu_ps(p + 12)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(p01, p23));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = F4Color_To_RGBA8Unorm(src[i]);
+    }
+
+    // out[i] = RGBA8Srgb_To_F4Color(in[i]).
+    // Table lookups; with AVX2 one gather per two pixels.
+    inline void RGBA8Srgb_To_F4Color(span<const uint32_t> in, span<float4> out)
+    {
+        assert(in.size() == out.size());
+
+        const auto&     tables = detail::SrgbTables::Get();
+        const size_t    count  = in.size();
+        const uint32_t* src    = in.data();
+        float4*         dst    = out.data();
+
+        size_t i = 0;
+#if defined(MATH_SIMD_AVX2)
+        const __m256i alphaOffset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+        for (; i + 8 <= count; i += 8)
+        {
+            for (size_t j = 0; j < 8; j += 2)
+            {
+                const __m256i index = _mm256_add_epi32(detail::LoadRGBA8x2(src + i + j), alphaOffset);
+                _mm256_storeu_ps(&dst[i + j].x, _mm256_i32gather_ps(tables.decode, index, 4));
+            }
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = detail::RGBA8Srgb_To_F4Color(tables, src[i]);
+    }
+
+    // out[i] = F4Color_To_RGBA8Srgb(in[i]), exact round-to-nearest of the sRGB curve.
+    // Two gathers per two pixels with AVX2, scalar table lookups otherwise.
+    inline void F4Color_To_RGBA8Srgb(span<const float4> in, span<uint32_t> out)
+    {
+        assert(in.size() == out.size());
+
+        const auto&   tables = detail::SrgbTables::Get();
+        const size_t  count  = in.size();
+        const float4* src    = in.data();
+        uint32_t*     dst    = out.data();
+
+        size_t i = 0;
+#if defined(MATH_SIMD_AVX2)
+        for (; i + 8 <= count; i += 8)
+        {
+            const float* p = &src[i].x;
+            detail::StoreRGBA8x8(dst + i,
+                                 detail::QuantizeSrgb8(tables, _mm256_loadu_ps(p + 0)),
+                                 detail::QuantizeSrgb8(tables, _mm256_loadu_ps(p + 8)),
+                                 detail::QuantizeSrgb8(tables, _mm256_loadu_ps(p + 16)),
+                                 detail::QuantizeSrgb8(tables, _mm256_loadu_ps(p + 24)));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = detail::F4Color_To_RGBA8Srgb(tables, src[i]);
+    }
+} // namespace math
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Simd.h"
+
+// Polynomial approximations of transcendental functions for the batch kernels and, with
+// MATH_FAST_TRIG, the rotation builders of Math.h. They trade the last bits of precision and
+// the full input range of <cmath> for branch-free code that runs on simd::kWidth lanes at once.
+// Every function has a float and a simd::vfloat version computing the same polynomials.
+//
+// Errors against the exact result, measured by the FastMath benchmark over dense samples of
+// the documented ranges (ulp = the spacing of floats at the exact result):
+//
+//   sincos, sin, cos   |x| <= 8192: 1.6 ulp where the result is at least 0.25 in magnitude,
+//                      2.3e-8 absolute near the zeros. Beyond 8192 the reduction by pi/2 loses
+//                      bits.
+//   acos               [-1, 1]: 2.8 ulp, 4.1e-7 absolute near x = -1.
+//   atan2              finite inputs: 2.7 ulp. atan2(0, 0) = 0; -0 as x counts as +0.
+//   rsqrt              positive normal floats: 4 ulp with SSE, one Newton step on the 12 bit
+//                      estimate; 1.5 ulp without SSE, where it is 1 / sqrt(x).
+//
+// The scalar and SIMD versions return the same bits.
+//
+// Does not include Math.h, so Math.h can use it.
+
+namespace math::fast
+{
+    namespace detail
+    {
+        constexpr float kPi          = 3.14159265f;
+        constexpr float kHalfPi      = 1.57079633f;
+        constexpr float kQuarterPi   = 0.785398163f;
+        constexpr float kTwoOverPi   = 0.636619772f;
+        constexpr float kTanPiOver8  = 0.414213562f;
+
+        // pi/2 in three parts (Cody & Waite): k * kHalfPi1 and k * kHalfPi2 are exact for
+        // |k| < 2^13, so x - k * pi/2 keeps its low bits for |x| <= 8192
+        constexpr float kHalfPi1 = 1.5703125f;
+        constexpr float kHalfPi2 = 4.837512969970703125e-4f;
+        constexpr float kHalfPi3 = 7.54978995489188216e-8f;
+
+        // Minimax polynomials on [-pi/4, pi/4] from Cephes' sinf/cosf, z = r * r
+        constexpr float kSin[] = {-1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f};
+        constexpr float kCos[] = {2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f};
+
+        // atan on [0, tan(pi/8)] from Cephes' atanf
+        constexpr float kAtan[] = {8.05374449538e-2f, -1.38776856032e-1f, 1.99777106478e-1f, -3.33329491539e-1f};
+
+        // acos(|x|) = sqrt(1 - |x|) * P7(|x|), Abramowitz & Stegun 4.4.46, |error| <= 2e-8
+        constexpr float kAcos[] = {-0.0012624911f, 0.0066700901f, -0.0170881256f, 0.0308918810f,
+                                   -0.0501743046f, 0.0889789874f, -0.2145988016f, 1.5707963050f};
+
+        inline float MultiplyAdd(float a, float b, float c)
+        {
+#if defined(MATH_SIMD_FMA)
+            return std::fma(a, b, c);
+#else
+            return a * b + c;
+#endif
+        }
+
+        inline uint32_t Bits(float x)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            return bits;
+        }
+
+        inline float FromBits(uint32_t bits)
+        {
+            float x;
+            std::memcpy(&x, &bits, sizeof(x));
+            return x;
+        }
+
+        // The scalar versions select with bit masks rather than branches: the branches depend
+        // on the input and mispredict on unsorted data, and masks let the compiler vectorize loops
+        inline uint32_t Mask(bool condition)
+        {
+            return 0u - static_cast<uint32_t>(condition);
+        }
+
+        inline float FlipSign(float x, uint32_t signBit)
+        {
+            return FromBits(Bits(x) ^ signBit);
+        }
+
+        inline simd::vfloat FlipSign(simd::vfloat x, simd::vint signBit)
+        {
+            return simd::reinterpret_float(simd::reinterpret_int(x) ^ signBit);
+        }
+    } // namespace detail
+
+    // sin(x) and cos(x) at once, see the error table above
+    inline void sincos(float x, float& s, float& c)
+    {
+        using detail::MultiplyAdd;
+
+        // x = k * pi/2 + r, |r| <= pi/4, k rounded the same way as in the SIMD version
+        const float   fk = std::floor(MultiplyAdd(x, detail::kTwoOverPi, 0.5f));
+        const int32_t k  = static_cast<int32_t>(fk);
+        float         r  = MultiplyAdd(fk, -detail::kHalfPi1, x);
+        r                   = MultiplyAdd(fk, -detail::kHalfPi2, r);
+        r                   = MultiplyAdd(fk, -detail::kHalfPi3, r);
+
+        const float z    = r * r;
+        const float sinR = MultiplyAdd(MultiplyAdd(MultiplyAdd(detail::kSin[0], z, detail::kSin[1]), z, detail::kSin[2]) * z, r, r);
+        const float cosR = MultiplyAdd(MultiplyAdd(MultiplyAdd(detail::kCos[0], z, detail::kCos[1]), z, detail::kCos[2]) * z, z,
+                                       MultiplyAdd(-0.5f, z, 1.f));
+
+        // Quadrants 1 and 3 swap sin and cos, the sign follows the quadrant
+        const uint32_t q    = static_cast<uint32_t>(k);
+        const uint32_t swap = (detail::Bits(sinR) ^ detail::Bits(cosR)) & detail::Mask((q & 1u) != 0);
+        s                   = detail::FromBits(detail::Bits(sinR) ^ swap ^ ((q & 2u) << 30));
+        c                   = detail::FromBits(detail::Bits(cosR) ^ swap ^ (((q + 1u) & 2u) << 30));
+    }
+
+    inline void sincos(simd::vfloat x, simd::vfloat& s, simd::vfloat& c)
+    {
+        using namespace simd;
+
+        const vfloat fk = floor(madd(x, broadcast(detail::kTwoOverPi), broadcast(0.5f)));
+        vfloat       r  = madd(fk, broadcast(-detail::kHalfPi1), x);
+        r               = madd(fk, broadcast(-detail::kHalfPi2), r);
+        r               = madd(fk, broadcast(-detail::kHalfPi3), r);
+
+        const vfloat z    = r * r;
+        const vfloat sinR = madd(madd(madd(broadcast(detail::kSin[0]), z, broadcast(detail::kSin[1])), z, broadcast(detail::kSin[2])) * z, r, r);
+        const vfloat cosR = madd(madd(madd(broadcast(detail::kCos[0]), z, broadcast(detail::kCos[1])), z, broadcast(detail::kCos[2])) * z, z,
+                                 madd(broadcast(-0.5f), z, broadcast(1.f)));
+
+        const vint   k   = convert_trunc(fk);
+        const vmask  odd = convert_float(k & broadcast_int(1)) > broadcast(0.5f);
+        s                = detail::FlipSign(select(odd, cosR, sinR), (k & broadcast_int(2)) << 30);
+        c                = detail::FlipSign(select(odd, sinR, cosR), ((k + broadcast_int(1)) & broadcast_int(2)) << 30);
+    }
+
+    inline float sin(float x)
+    {
+        float s, c;
+        sincos(x, s, c);
+        return s;
+    }
+
+    inline simd::vfloat sin(simd::vfloat x)
+    {
+        simd::vfloat s, c;
+        sincos(x, s, c);
+        return s;
+    }
+
+    inline float cos(float x)
+    {
+        float s, c;
+        sincos(x, s, c);
+        return c;
+    }
+
+    inline simd::vfloat cos(simd::vfloat x)
+    {
+        simd::vfloat s, c;
+        sincos(x, s, c);
+        return c;
+    }
+
+    // acos(x) for x in [-1, 1], result in [0, pi]; acos(-x) = pi - acos(x).
+    // Inputs slightly outside [-1, 1] (e.g. dot products of unit vectors) are clamped.
+    inline float acos(float x)
+    {
+        using detail::MultiplyAdd;
+
+        const float a = std::min(std::fabs(x), 1.f);
+        float       p = detail::kAcos[0];
+        for (int i = 1; i < 8; ++i)
+            p = MultiplyAdd(p, a, detail::kAcos[i]);
+
+        // pi - r for negative x
+        const uint32_t negative = detail::Mask(x < 0.f);
+        const float    r        = std::sqrt(1.f - a) * p;
+        return detail::FlipSign(r, negative & 0x80000000u) + detail::FromBits(detail::Bits(detail::kPi) & negative);
+    }
+
+    inline simd::vfloat acos(simd::vfloat x)
+    {
+        using namespace simd;
+
+        const vfloat one = broadcast(1.f);
+        const vfloat a   = min(abs(x), one);
+
+        vfloat p = broadcast(detail::kAcos[0]);
+        for (int i = 1; i < 8; ++i)
+            p = madd(p, a, broadcast(detail::kAcos[i]));
+
+        const vfloat r = sqrt(one - a) * p;
+        return select(x < broadcast(0.f), broadcast(detail::kPi) - r, r);
+    }
+
+    // atan2(y, x) in [-pi, pi]. The ratio of the smaller to the larger of |x| and |y| is
+    // reduced to [0, tan(pi/8)] with atan(a) = pi/4 + atan((a - 1) / (a + 1)), the octant
+    // restored from the signs and the larger component.
+    inline float atan2(float y, float x)
+    {
+        using detail::MultiplyAdd;
+
+        const float ax = std::fabs(x), ay = std::fabs(y);
+        const float large = std::max(ax, ay), small = std::min(ax, ay);
+        const bool  upper = small > detail::kTanPiOver8 * large;
+        const float a     = large > 0.f ? (upper ? small - large : small) / (upper ? small + large : large) : 0.f;
+
+        const float z = a * a;
+        float       p = detail::kAtan[0];
+        for (int i = 1; i < 4; ++i)
+            p = MultiplyAdd(p, z, detail::kAtan[i]);
+        float r = MultiplyAdd(p * z, a, a) + (upper ? detail::kQuarterPi : 0.f);
+
+        r = ay > ax ? detail::kHalfPi - r : r;
+        r = x < 0.f ? detail::kPi - r : r;
+        return std::copysign(r, y);
+    }
+
+    inline simd::vfloat atan2(simd::vfloat y, simd::vfloat x)
+    {
+        using namespace simd;
+
+        const vfloat zero = broadcast(0.f);
+        const vfloat ax = abs(x), ay = abs(y);
+        const vfloat large = max(ax, ay), small = min(ax, ay);
+        const vmask  upper = small > broadcast(detail::kTanPiOver8) * large;
+        const vfloat a     = select(large > zero, select(upper, small - large, small) / select(upper, small + large, large), zero);
+
+        const vfloat z = a * a;
+        vfloat       p = broadcast(detail::kAtan[0]);
+        for (int i = 1; i < 4; ++i)
+            p = madd(p, z, broadcast(detail::kAtan[i]));
+        vfloat r = madd(p * z, a, a) + select(upper, broadcast(detail::kQuarterPi), zero);
+
+        r = select(ay > ax, broadcast(detail::kHalfPi) - r, r);
+        r = select(x < zero, broadcast(detail::kPi) - r, r);
+        return reinterpret_float(reinterpret_int(r) | (reinterpret_int(y) & broadcast_int(INT32_MIN)));
+    }
+
+    // 1 / sqrt(x) for positive normal x, see the error table above
+    inline float rsqrt(float x)
+    {
+#if defined(MATH_SIMD_SSE2)
+        const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+        return y * detail::MultiplyAdd(-0.5f * x * y, y, 1.5f);
+#else
+        return 1.f / std::sqrt(x);
+#endif
+    }
+
+    inline simd::vfloat rsqrt(simd::vfloat x)
+    {
+        using namespace simd;
+#if defined(MATH_SIMD_SSE2)
+#   if defined(MATH_SIMD_AVX2)
+        const vfloat y = {_mm256_rsqrt_ps(x.v)};
+#   else
+        const vfloat y = {_mm_rsqrt_ps(x.v)};
+#   endif
+        return y * madd(broadcast(-0.5f) * x * y, y, broadcast(1.5f));
+#else
+        return broadcast(1.f) / sqrt(x);
+#endif
+    }
+} // namespace math::fast
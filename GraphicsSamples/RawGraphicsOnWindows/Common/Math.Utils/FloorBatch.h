@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+// FastFloor / FastCeil over whole arrays, e.g. noise lattice coordinates or voxel indices.
+// Results are bit-exact with std::floor / std::ceil for every float, including -0, values
+// outside the int32 range, infinities and NaN (see simd::floor). The tail that does not fill
+// a register goes through the same kernel, so the output does not depend on the array length.
+// in and out may be the same span.
+
+namespace math
+{
+    namespace detail
+    {
+        template <typename Op>
+        void RoundBatch(span<const float> in, span<float> out, Op op)
+        {
+            assert(in.size() == out.size());
+
+            const size_t count = in.size();
+            const float* src   = in.data();
+            float*       dst   = out.data();
+
+            size_t i = 0;
+            for (; i + simd::kWidth <= count; i += simd::kWidth)
+                simd::store(dst + i, op(simd::load(src + i)));
+
+            if (i < count)
+            {
+                float lanes[simd::kWidth] = {};
+                std::memcpy(lanes, src + i, (count - i) * sizeof(float));
+                simd::store(lanes, op(simd::load(lanes)));
+                std::memcpy(dst + i, lanes, (count - i) * sizeof(float));
+            }
+        }
+    } // namespace detail
+
+    // out[i] = floor(in[i])
+    inline void FastFloor(span<const float> in, span<float> out)
+    {
+        detail::RoundBatch(in, out, [](simd::vfloat x) { return simd::floor(x); });
+    }
+
+    // out[i] = ceil(in[i])
+    inline void FastCeil(span<const float> in, span<float> out)
+    {
+        detail::RoundBatch(in, out, [](simd::vfloat x) { return simd::ceil(x); });
+    }
+} // namespace math
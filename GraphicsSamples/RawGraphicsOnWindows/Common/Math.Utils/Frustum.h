@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "BatchTransform.h"
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+// View frustum culling of bounding spheres and boxes.
+//
+// The planes come straight from a view-projection matrix (Gribb and Hartmann, "Fast
+// Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"), so any
+// perspective or orthographic projection works. With a view-projection matrix the planes
+// are in world space, with a projection alone in view space.
+//
+// The batch functions take structure-of-arrays input, test simd::kWidth objects at once and
+// write the indices of the visible ones in increasing order. The tests are conservative:
+// a box or sphere close to a frustum edge or corner may be reported visible although it is
+// just outside, nothing visible is ever culled.
+
+namespace math
+{
+    // Points with dot(normal, p) + d >= 0 are on the inner side
+    struct Plane
+    {
+        float3 normal;
+        float  d = 0.f;
+
+        Plane() = default;
+        Plane(const float3& _normal, float _d) :
+            normal(_normal), d(_d)
+        {}
+
+        // (a, b, c, d) scaled to a unit normal, so that Distance is in world units
+        static Plane FromCoefficients(const float4& abcd)
+        {
+            const float3 n(abcd.x, abcd.y, abcd.z);
+            const float  invLength = 1.f / std::sqrt(dot(n, n));
+            return Plane(n * invLength, abcd.w * invLength);
+        }
+
+        float Distance(const float3& p) const
+        {
+            return dot(normal, p) + d;
+        }
+    };
+
+    struct Frustum
+    {
+        enum PlaneIndex
+        {
+            kLeft,
+            kRight,
+            kBottom,
+            kTop,
+            kNear,
+            kFar,
+            kPlaneCount
+        };
+
+        Plane planes[kPlaneCount];
+
+        // viewProjection maps row vectors to clip space, as float4x4::Projection does. isGL
+        // selects the clip space depth range: -w <= z <= w instead of 0 <= z <= w.
+        static Frustum FromMatrix(const float4x4& viewProjection, bool isGL)
+        {
+            // clip = (p, 1) * M, so each clip coordinate is the dot product with a column of M
+            float4 column[4];
+            for (int j = 0; j < 4; ++j)
+                column[j] = float4(viewProjection.m[0][j], viewProjection.m[1][j], viewProjection.m[2][j], viewProjection.m[3][j]);
+
+            Frustum frustum;
+            frustum.planes[kLeft]   = Plane::FromCoefficients(column[3] + column[0]);
+            frustum.planes[kRight]  = Plane::FromCoefficients(column[3] - column[0]);
+            frustum.planes[kBottom] = Plane::FromCoefficients(column[3] + column[1]);
+            frustum.planes[kTop]    = Plane::FromCoefficients(column[3] - column[1]);
+            frustum.planes[kNear]   = Plane::FromCoefficients(isGL ? column[3] + column[2] : column[2]);
+            frustum.planes[kFar]    = Plane::FromCoefficients(column[3] - column[2]);
+            return frustum;
+        }
+
+        bool Contains(const float3& point) const
+        {
+            for (const Plane& plane : planes)
+            {
+                if (plane.Distance(point) < 0.f)
+                    return false;
+            }
+            return true;
+        }
+
+        bool Intersects(const float3& center, float radius) const
+        {
+            for (const Plane& plane : planes)
+            {
+                if (plane.Distance(center) < -radius)
+                    return false;
+            }
+            return true;
+        }
+
+        // The box is outside a plane when its corner farthest along the normal is
+        bool Intersects(const AABB<float>& box) const
+        {
+            const float3 center = box.Center();
+            const float3 extent = box.max - center;
+            for (const Plane& plane : planes)
+            {
+                const float3 n = plane.normal;
+                if (plane.Distance(center) + std::abs(n.x) * extent.x + std::abs(n.y) * extent.y + std::abs(n.z) * extent.z < 0.f)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+
+    namespace detail
+    {
+        // Frustum planes broadcast to all lanes, |normal| for the box test
+        struct WideFrustum
+        {
+            simd::vfloat nx[Frustum::kPlaneCount], ny[Frustum::kPlaneCount], nz[Frustum::kPlaneCount], d[Frustum::kPlaneCount];
+            simd::vfloat ax[Frustum::kPlaneCount], ay[Frustum::kPlaneCount], az[Frustum::kPlaneCount];
+
+            explicit WideFrustum(const Frustum& frustum)
+            {
+                for (int i = 0; i < Frustum::kPlaneCount; ++i)
+                {
+                    const Plane& plane = frustum.planes[i];
+                    nx[i]              = simd::broadcast(plane.normal.x);
+                    ny[i]              = simd::broadcast(plane.normal.y);
+                    nz[i]              = simd::broadcast(plane.normal.z);
+                    d[i]               = simd::broadcast(plane.d);
+                    ax[i]              = simd::broadcast(std::abs(plane.normal.x));
+                    ay[i]              = simd::broadcast(std::abs(plane.normal.y));
+                    az[i]              = simd::broadcast(std::abs(plane.normal.z));
+                }
+            }
+
+            simd::vfloat Distance(int i, simd::vfloat x, simd::vfloat y, simd::vfloat z) const
+            {
+                return simd::madd(x, nx[i], simd::madd(y, ny[i], simd::madd(z, nz[i], d[i])));
+            }
+
+            simd::vmask Spheres(simd::vfloat x, simd::vfloat y, simd::vfloat z, simd::vfloat radius) const
+            {
+                const simd::vfloat minusRadius = -radius;
+                simd::vmask        inside      = Distance(0, x, y, z) >= minusRadius;
+                for (int i = 1; i < Frustum::kPlaneCount; ++i)
+                    inside = inside & (Distance(i, x, y, z) >= minusRadius);
+                return inside;
+            }
+
+            simd::vmask Boxes(simd::vfloat minX, simd::vfloat minY, simd::vfloat minZ,
+                              simd::vfloat maxX, simd::vfloat maxY, simd::vfloat maxZ) const
+            {
+                const simd::vfloat half = simd::broadcast(0.5f);
+                const simd::vfloat cx = (minX + maxX) * half, cy = (minY + maxY) * half, cz = (minZ + maxZ) * half;
+                const simd::vfloat ex = maxX - cx, ey = maxY - cy, ez = maxZ - cz;
+
+                simd::vmask inside = Distance(0, cx, cy, cz) + simd::madd(ex, ax[0], simd::madd(ey, ay[0], ez * az[0])) >= simd::broadcast(0.f);
+                for (int i = 1; i < Frustum::kPlaneCount; ++i)
+                    inside = inside & (Distance(i, cx, cy, cz) + simd::madd(ex, ax[i], simd::madd(ey, ay[i], ez * az[i])) >= simd::broadcast(0.f));
+                return inside;
+            }
+        };
+
+        // Appends base + lane for every set bit of the visible mask. Every lane is stored and
+        // the cursor only advances for the visible ones, so there is no branch per object;
+        // out needs room for n + simd::kWidth indices.
+        inline size_t Compact(uint32_t visible, uint32_t base, uint32_t* out, size_t n)
+        {
+            for (uint32_t lane = 0; lane < simd::kWidth; ++lane)
+            {
+                out[n] = base + lane;
+                n += (visible >> lane) & 1u;
+            }
+            return n;
+        }
+
+        // Runs test over full registers of the streams, then over a zero padded copy of the
+        // tail, whose visible lanes are appended one by one so that nothing is written past
+        // visible[count - 1].
+        template <size_t StreamCount, typename Test>
+        size_t CullBatch(const span<const float> (&streams)[StreamCount], span<uint32_t> visible, Test test)
+        {
+            const size_t count = streams[0].size();
+            for (size_t s = 1; s < StreamCount; ++s)
+                assert(streams[s].size() == count);
+            assert(visible.size() >= count);
+            assert(count <= UINT32_MAX);
+
+            uint32_t* out = visible.data();
+            size_t    n   = 0;
+
+            simd::vfloat lanes[StreamCount];
+            size_t       i = 0;
+            for (; i + simd::kWidth <= count; i += simd::kWidth)
+            {
+                for (size_t s = 0; s < StreamCount; ++s)
+                    lanes[s] = simd::load(streams[s].data() + i);
+                n = Compact(static_cast<uint32_t>(simd::movemask(test(lanes))), static_cast<uint32_t>(i), out, n);
+            }
+
+            if (i < count)
+            {
+                for (size_t s = 0; s < StreamCount; ++s)
+                {
+                    float padded[simd::kWidth] = {};
+                    std::memcpy(padded, streams[s].data() + i, (count - i) * sizeof(float));
+                    lanes[s] = simd::load(padded);
+                }
+                const uint32_t mask = static_cast<uint32_t>(simd::movemask(test(lanes)));
+                for (size_t lane = 0; i + lane < count; ++lane)
+                {
+                    if ((mask >> lane) & 1u)
+                        out[n++] = static_cast<uint32_t>(i + lane);
+                }
+            }
+            return n;
+        }
+    } // namespace detail
+
+    // Writes the indices of the spheres that intersect the frustum to visible, which needs
+    // room for one per sphere, and returns their number
+    inline size_t CullSpheres(const Frustum& frustum, ConstFloat3Stream centers, span<const float> radii, span<uint32_t> visible)
+    {
+        const detail::WideFrustum wide(frustum);
+        const span<const float>   streams[] = {centers.x, centers.y, centers.z, radii};
+        return detail::CullBatch(streams, visible, [&](const simd::vfloat* v) {
+            return wide.Spheres(v[0], v[1], v[2], v[3]);
+        });
+    }
+
+    // The same for boxes given by their min and max corners
+    inline size_t CullBoxes(const Frustum& frustum, ConstFloat3Stream boxMin, ConstFloat3Stream boxMax, span<uint32_t> visible)
+    {
+        const detail::WideFrustum wide(frustum);
+        const span<const float>   streams[] = {boxMin.x, boxMin.y, boxMin.z, boxMax.x, boxMax.y, boxMax.z};
+        return detail::CullBatch(streams, visible, [&](const simd::vfloat* v) {
+            return wide.Boxes(v[0], v[1], v[2], v[3], v[4], v[5]);
+        });
+    }
+} // namespace math
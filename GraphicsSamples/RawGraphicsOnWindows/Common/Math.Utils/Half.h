@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+// IEEE 754 binary16 storage type: 1 sign, 5 exponent and 10 mantissa bits, as
+// DXGI_FORMAT_R16_FLOAT and HLSL's half. It converts implicitly to and from float and computes
+// in float, so Vector2/3/4<half> (half2/3/4) work with the Math.h templates, but it is meant for
+// storage: vertex and texture data at half the size of float.
+//
+// Conversions round to nearest even and handle denormals, infinities and NaN like the F16C
+// instructions vcvtps2ph/vcvtph2ps, which are used when available (MATH_SIMD_F16C). Otherwise
+// the bits are moved by hand after F. Giesen, https://gist.github.com/rygorous/2156668, with
+// the same results. NaN keeps its sign and the top of its payload and becomes quiet.
+//
+// FloatToHalf and HalfToFloat convert whole spans, 8 values per instruction with F16C and
+// simd::kWidth at a time with the bit manipulation.
+
+namespace math
+{
+    namespace detail
+    {
+        constexpr uint32_t kHalfInfinityAsFloat  = 0x47800000u; // 65536.f: from here on the half is infinite
+        constexpr uint32_t kHalfMinNormalAsFloat = 0x38800000u; // 2^-14: below this the half is denormal
+        constexpr uint32_t kFloatToHalfMagic     = 0x3F000000u; // 0.5f: adding it moves the denormal mantissa to the low bits
+        constexpr uint32_t kHalfExponentShifted  = 0x7C00u << 13;
+        constexpr int32_t  kHalfToFloatBias      = (127 - 15) << 23;
+        constexpr int32_t  kFloatToHalfRounding  = -kHalfToFloatBias + 0xFFF;
+
+        inline uint16_t FloatToHalfBitsGeneric(float f)
+        {
+            const uint32_t bits = FloatBits(f);
+            const uint32_t sign = (bits >> 16) & 0x8000u;
+            const uint32_t abs  = bits & 0x7FFFFFFFu;
+
+            uint32_t result;
+            if (abs >= kHalfInfinityAsFloat)
+            {
+                // Infinity stays, NaN becomes quiet and keeps the top of its payload
+                result = abs > 0x7F800000u ? 0x7E00u | ((abs >> 13) & 0x3FFu) : 0x7C00u;
+            }
+            else if (abs < kHalfMinNormalAsFloat)
+            {
+                // The float addition rounds to the 10 bits left of the denormal half
+                result = FloatBits(FloatFromBits(abs) + FloatFromBits(kFloatToHalfMagic)) - kFloatToHalfMagic;
+            }
+            else
+            {
+                // Rebias the exponent and round to nearest even: + 0xFFF rounds half down, the
+                // lowest kept mantissa bit makes ties round up to the even value
+                const uint32_t odd = (abs >> 13) & 1u;
+                result             = (abs + static_cast<uint32_t>(kFloatToHalfRounding) + odd) >> 13;
+            }
+            return static_cast<uint16_t>(result | sign);
+        }
+
+        inline float HalfBitsToFloatGeneric(uint16_t h)
+        {
+            uint32_t       bits     = static_cast<uint32_t>(h & 0x7FFFu) << 13;
+            const uint32_t exponent = bits & kHalfExponentShifted;
+            bits += kHalfToFloatBias;
+
+            if (exponent == kHalfExponentShifted)
+            {
+                // Infinity or NaN: maximum exponent, NaN made quiet
+                bits += kHalfToFloatBias;
+                if (bits & 0x7FFFFFu)
+                    bits |= 0x400000u;
+            }
+            else if (exponent == 0)
+            {
+                // Zero or denormal: let the float subtraction normalize it
+                bits = FloatBits(FloatFromBits(bits + (1u << 23)) - FloatFromBits(kHalfMinNormalAsFloat));
+            }
+            return FloatFromBits(bits | (static_cast<uint32_t>(h & 0x8000u) << 16));
+        }
+
+        // The same on simd::kWidth values, the half bits in the low 16 bits of each lane
+        inline simd::vint FloatToHalfBitsGeneric(simd::vfloat f)
+        {
+            const simd::vfloat abs   = simd::abs(f);
+            const simd::vint   bits  = simd::reinterpret_int(abs);
+            const simd::vint   sign  = (simd::reinterpret_int(f) ^ bits) >> 16;
+            const simd::vfloat magic = simd::reinterpret_float(simd::broadcast_int(kFloatToHalfMagic));
+
+            const simd::vint odd      = (bits >> 13) & simd::broadcast_int(1);
+            const simd::vint normal   = (bits + simd::broadcast_int(kFloatToHalfRounding) + odd) >> 13;
+            const simd::vint denormal = simd::reinterpret_int(abs + magic) - simd::broadcast_int(kFloatToHalfMagic);
+            const simd::vint nan      = simd::broadcast_int(0x7E00) | ((bits >> 13) & simd::broadcast_int(0x3FF));
+
+            simd::vfloat result = simd::select(abs < simd::reinterpret_float(simd::broadcast_int(kHalfMinNormalAsFloat)),
+                                               simd::reinterpret_float(denormal), simd::reinterpret_float(normal));
+            result              = simd::select(abs >= simd::reinterpret_float(simd::broadcast_int(kHalfInfinityAsFloat)),
+                                               simd::reinterpret_float(simd::broadcast_int(0x7C00)), result);
+            result              = simd::select(abs == abs, result, simd::reinterpret_float(nan));
+            return simd::reinterpret_int(result) | sign;
+        }
+
+        inline simd::vfloat HalfBitsToFloatGeneric(simd::vint h)
+        {
+            const simd::vint   bits     = (h & simd::broadcast_int(0x7FFF)) << 13;
+            const simd::vfloat exponent = simd::reinterpret_float(bits & simd::broadcast_int(kHalfExponentShifted));
+            const simd::vint   normal   = bits + simd::broadcast_int(kHalfToFloatBias);
+
+            const simd::vfloat hasPayload = simd::convert_float(h & simd::broadcast_int(0x3FF));
+            const simd::vfloat quiet      = simd::select(hasPayload > simd::broadcast(0.f), simd::reinterpret_float(simd::broadcast_int(0x400000)),
+                                                         simd::broadcast(0.f));
+            const simd::vint   special    = (normal + simd::broadcast_int(kHalfToFloatBias)) | simd::reinterpret_int(quiet);
+            const simd::vfloat denormal   = simd::reinterpret_float(normal + simd::broadcast_int(1 << 23)) -
+                                          simd::reinterpret_float(simd::broadcast_int(kHalfMinNormalAsFloat));
+
+            simd::vfloat result = simd::select(exponent == simd::broadcast(0.f), denormal, simd::reinterpret_float(normal));
+            result              = simd::select(exponent == simd::reinterpret_float(simd::broadcast_int(kHalfExponentShifted)),
+                                               simd::reinterpret_float(special), result);
+            return simd::reinterpret_float(simd::reinterpret_int(result) | ((h & simd::broadcast_int(0x8000)) << 16));
+        }
+
+        inline uint16_t FloatToHalfBits(float f)
+        {
+#if defined(MATH_SIMD_F16C)
+            return static_cast<uint16_t>(_mm_extract_epi16(_mm_cvtps_ph(_mm_set_ss(f), _MM_FROUND_TO_NEAREST_INT), 0));
+#else
+            return FloatToHalfBitsGeneric(f);
+#endif
+        }
+
+        inline float HalfFloatFromBits(uint16_t h)
+        {
+#if defined(MATH_SIMD_F16C)
+            return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(h)));
+#else
+            return HalfBitsToFloatGeneric(h);
+#endif
+        }
+    } // namespace detail
+
+    struct half
+    {
+        uint16_t bits;
+
+        half() = default;
+        half(float f) :
+            bits(detail::FloatToHalfBits(f)) {}
+
+        operator float() const { return detail::HalfFloatFromBits(bits); }
+
+        static half FromBits(uint16_t bits)
+        {
+            half h;
+            h.bits = bits;
+            return h;
+        }
+
+        half& operator+=(float right) { return *this = *this + right; }
+        half& operator-=(float right) { return *this = *this - right; }
+        half& operator*=(float right) { return *this = *this * right; }
+        half& operator/=(float right) { return *this = *this / right; }
+    };
+
+    static_assert(sizeof(half) == 2, "half must be 16 bits");
+
+    using half2 = Vector2<half>;
+    using half3 = Vector3<half>;
+    using half4 = Vector4<half>;
+
+    namespace detail
+    {
+        // Both conversions without F16C, also used for the tails with it
+        inline void FloatToHalfGeneric(span<const float> in, span<half> out)
+        {
+            assert(in.size() == out.size());
+            const size_t count = in.size();
+            const float* src   = in.data();
+            uint16_t*    dst   = &out.data()->bits;
+
+            // Without SIMD the branches of the scalar version are cheaper than the selects
+            size_t i = 0;
+            if constexpr (simd::kWidth > 1)
+            {
+                uint32_t lanes[simd::kWidth];
+                for (; i + simd::kWidth <= count; i += simd::kWidth)
+                {
+                    simd::store(lanes, FloatToHalfBitsGeneric(simd::load(src + i)));
+                    for (size_t lane = 0; lane < simd::kWidth; ++lane)
+                        dst[i + lane] = static_cast<uint16_t>(lanes[lane]);
+                }
+            }
+            for (; i < count; ++i)
+                dst[i] = FloatToHalfBitsGeneric(src[i]);
+        }
+
+        inline void HalfToFloatGeneric(span<const half> in, span<float> out)
+        {
+            assert(in.size() == out.size());
+            const size_t    count = in.size();
+            const uint16_t* src   = &in.data()->bits;
+            float*          dst   = out.data();
+
+            size_t i = 0;
+            if constexpr (simd::kWidth > 1)
+            {
+                uint32_t lanes[simd::kWidth];
+                for (; i + simd::kWidth <= count; i += simd::kWidth)
+                {
+                    for (size_t lane = 0; lane < simd::kWidth; ++lane)
+                        lanes[lane] = src[i + lane];
+                    simd::store(dst + i, HalfBitsToFloatGeneric(simd::load(lanes)));
+                }
+            }
+            for (; i < count; ++i)
+                dst[i] = HalfBitsToFloatGeneric(src[i]);
+        }
+    } // namespace detail
+
+    // out[i] = half(in[i])
+    inline void FloatToHalf(span<const float> in, span<half> out)
+    {
+#if defined(MATH_SIMD_F16C)
+        assert(in.size() == out.size());
+        const size_t count = in.size();
+        const float* src   = in.data();
+        half*        dst   = out.data();
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+        for (; i < count; ++i)
+            dst[i] = half(src[i]);
+#else
+        detail::FloatToHalfGeneric(in, out);
+#endif
+    }
+
+    // out[i] = float(in[i])
+    inline void HalfToFloat(span<const half> in, span<float> out)
+    {
+#if defined(MATH_SIMD_F16C)
+        assert(in.size() == out.size());
+        const size_t count = in.size();
+        const half*  src   = in.data();
+        float*       dst   = out.data();
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+        for (; i < count; ++i)
+            dst[i] = src[i];
+#else
+        detail::HalfToFloatGeneric(in, out);
+#endif
+    }
+
+    // Whole vectors, e.g. a stream of float3 positions to half3
+    template <template <class> class Vector>
+    void FloatToHalf(span<const Vector<float>> in, span<Vector<half>> out)
+    {
+        constexpr size_t kComponents = sizeof(Vector<float>) / sizeof(float);
+        static_assert(sizeof(Vector<half>) == kComponents * sizeof(half), "unexpected vector layout");
+        FloatToHalf(span<const float>(in.data()->Data(), in.size() * kComponents), span<half>(out.data()->Data(), out.size() * kComponents));
+    }
+
+    template <template <class> class Vector>
+    void HalfToFloat(span<const Vector<half>> in, span<Vector<float>> out)
+    {
+        constexpr size_t kComponents = sizeof(Vector<float>) / sizeof(float);
+        static_assert(sizeof(Vector<half>) == kComponents * sizeof(half), "unexpected vector layout");
+        HalfToFloat(span<const half>(in.data()->Data(), in.size() * kComponents), span<float>(out.data()->Data(), out.size() * kComponents));
+    }
+} // namespace math
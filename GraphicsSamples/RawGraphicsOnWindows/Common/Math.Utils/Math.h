@@ -1,13 +1,172 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "FastMath.h"
+#include "Simd.h"
+
+// True while a constexpr function is evaluated at compile time. Functions that use <cmath>,
+// SIMD intrinsics or type punning at run time switch to plain constexpr code then.
+// Without compiler support (before GCC 9, Clang 9, MSVC 19.25) it is always false: those
+// functions still work at run time but cannot be used in constant expressions.
+#if defined(__cpp_lib_is_constant_evaluated)
+#define MATH_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(__clang__) && __clang_major__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define MATH_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define MATH_IS_CONSTANT_EVALUATED() false
+#endif
 
 namespace math
 {    
     static constexpr double PI   = 3.14159265358979323846;
     static constexpr float  PI_F = 3.1415927f;
     
+    
+    // sin, cos and sqrt for constant expressions, so that rotation builders and normalize can
+    // fill compile-time tables. Evaluated in double; the float results are within an ulp of
+    // <cmath>. At run time use <cmath>, these are written for the compiler, not for speed.
+    
+    constexpr double ConstexprSin(double x)
+    {
+        // Reduce to [-pi, pi]; there the 20th term of the Taylor series is below 1e-18
+        const double turns = x / (2 * PI);
+        const double k     = static_cast<double>(static_cast<int64_t>(turns + (turns < 0 ? -0.5 : 0.5)));
+        x -= k * (2 * PI);
+    
+        double sum  = x;
+        double term = x;
+        for (int n = 1; n < 20; ++n)
+        {
+            term *= -x * x / ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+    
+    constexpr double ConstexprCos(double x)
+    {
+        return ConstexprSin(x + PI / 2);
+    }
+    
+    // Newton iteration from an initial guess within a factor of two
+    constexpr double ConstexprSqrt(double x)
+    {
+        if (!(x >= 0))
+            return std::numeric_limits<double>::quiet_NaN();
+        if (x == 0 || x == std::numeric_limits<double>::infinity())
+            return x;
+    
+        double guess = 1;
+        while (guess * guess > x)
+            guess *= 0.5;
+        while (guess * guess * 4 < x)
+            guess *= 2;
+        for (int i = 0; i < 8; ++i)
+            guess = 0.5 * (guess + x / guess);
+        return guess;
+    }
+    
+    namespace detail
+    {
+        // <cmath> at run time, the Constexpr versions at compile time
+        template <class T>
+        constexpr T Sin(T x)
+        {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return static_cast<T>(ConstexprSin(static_cast<double>(x)));
+            return std::sin(x);
+        }
+    
+        template <class T>
+        constexpr T Cos(T x)
+        {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return static_cast<T>(ConstexprCos(static_cast<double>(x)));
+            return std::cos(x);
+        }
+    
+        // sin and cos together, for the rotation builders. With MATH_FAST_TRIG defined (for the
+        // whole program, like MATH_SIMD_DISABLE) float angles use fast::sincos instead of <cmath>,
+        // see FastMath.h for its error.
+        template <class T>
+        constexpr void SinCos(T x, T& s, T& c)
+        {
+            if (MATH_IS_CONSTANT_EVALUATED())
+            {
+                s = static_cast<T>(ConstexprSin(static_cast<double>(x)));
+                c = static_cast<T>(ConstexprCos(static_cast<double>(x)));
+                return;
+            }
+#if defined(MATH_FAST_TRIG)
+            if constexpr (std::is_same_v<T, float>)
+            {
+                fast::sincos(x, s, c);
+                return;
+            }
+#endif
+            s = std::sin(x);
+            c = std::cos(x);
+        }
+    
+        // Run time only; fast::acos and fast::atan2 for float with MATH_FAST_TRIG
+        template <class T>
+        T Acos(T x)
+        {
+#if defined(MATH_FAST_TRIG)
+            if constexpr (std::is_same_v<T, float>)
+                return fast::acos(x);
+#endif
+            return std::acos(x);
+        }
+    
+        template <class T>
+        T Atan2(T y, T x)
+        {
+#if defined(MATH_FAST_TRIG)
+            if constexpr (std::is_same_v<T, float>)
+                return fast::atan2(y, x);
+#endif
+            return std::atan2(y, x);
+        }
+    
+        template <class T>
+        constexpr T Tan(T x)
+        {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return static_cast<T>(ConstexprSin(static_cast<double>(x)) / ConstexprCos(static_cast<double>(x)));
+            return std::tan(x);
+        }
+    
+        template <class T>
+        constexpr auto Sqrt(T x) -> decltype(std::sqrt(x))
+        {
+            using Result = decltype(std::sqrt(x));
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return static_cast<Result>(ConstexprSqrt(static_cast<double>(x)));
+            return std::sqrt(x);
+        }
+    
+        inline uint32_t FloatBits(float f)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+    
+        inline float FloatFromBits(uint32_t bits)
+        {
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+    } // namespace detail
+    
     // Template Vector & Matrix Classes
     template <class T> struct Matrix2x2;
     template <class T> struct Matrix3x3;
@@ -36,60 +195,60 @@ namespace math
         };
     
     
-        Vector2 operator-(const Vector2<T>& right) const
+        constexpr Vector2 operator-(const Vector2<T>& right) const
         {
             return Vector2(x - right.x, y - right.y);
         }
     
-        Vector2& operator-=(const Vector2<T>& right)
+        constexpr Vector2& operator-=(const Vector2<T>& right)
         {
             x -= right.x;
             y -= right.y;
             return *this;
         }
     
-        Vector2 operator-() const
+        constexpr Vector2 operator-() const
         {
             return Vector2(-x, -y);
         }
     
-        Vector2 operator+(const Vector2<T>& right) const
+        constexpr Vector2 operator+(const Vector2<T>& right) const
         {
             return Vector2(x + right.x, y + right.y);
         }
     
-        Vector2& operator+=(const Vector2<T>& right)
+        constexpr Vector2& operator+=(const Vector2<T>& right)
         {
             x += right.x;
             y += right.y;
             return *this;
         }
     
-        Vector2 operator*(T s) const
+        constexpr Vector2 operator*(T s) const
         {
             return Vector2(x * s, y * s);
         }
     
-        Vector2 operator*(const Vector2& right) const
+        constexpr Vector2 operator*(const Vector2& right) const
         {
             return Vector2(x * right.x, y * right.y);
         }
     
-        Vector2& operator*=(const Vector2& right)
+        constexpr Vector2& operator*=(const Vector2& right)
         {
             x *= right.x;
             y *= right.y;
             return *this;
         }
     
-        Vector2& operator*=(T s)
+        constexpr Vector2& operator*=(T s)
         {
             x *= s;
             y *= s;
             return *this;
         }
     
-        Vector2 operator*(const Matrix2x2<T>& m) const
+        constexpr Vector2 operator*(const Matrix2x2<T>& m) const
         {
             Vector2 out;
             out[0] = x * m[0][0] + y * m[1][0];
@@ -97,59 +256,59 @@ namespace math
             return out;
         }
     
-        Vector2 operator/(const Vector2& right) const
+        constexpr Vector2 operator/(const Vector2& right) const
         {
             return Vector2(x / right.x, y / right.y);
         }
     
-        Vector2& operator/=(const Vector2& right)
+        constexpr Vector2& operator/=(const Vector2& right)
         {
             x /= right.x;
             y /= right.y;
             return *this;
         }
     
-        Vector2 operator/(T s) const
+        constexpr Vector2 operator/(T s) const
         {
             return Vector2(x / s, y / s);
         }
     
-        Vector2& operator/=(T s)
+        constexpr Vector2& operator/=(T s)
         {
             x /= s;
             y /= s;
             return *this;
         }
     
-        bool operator==(const Vector2& right) const
+        constexpr bool operator==(const Vector2& right) const
         {
             return x == right.x && y == right.y;
         }
     
-        bool operator!=(const Vector2& right) const
+        constexpr bool operator!=(const Vector2& right) const
         {
             return !(*this == right);
         }
     
-        Vector2 operator<(const Vector2& right) const
+        constexpr Vector2 operator<(const Vector2& right) const
         {
             return Vector2(x < right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y < right.y ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector2 operator>(const Vector2& right) const
+        constexpr Vector2 operator>(const Vector2& right) const
         {
             return Vector2(x > right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y > right.y ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector2 operator<=(const Vector2& right) const
+        constexpr Vector2 operator<=(const Vector2& right) const
         {
             return Vector2(x <= right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y <= right.y ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector2 operator>=(const Vector2& right) const
+        constexpr Vector2 operator>=(const Vector2& right) const
         {
             return Vector2(x >= right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y >= right.y ? static_cast<T>(1) : static_cast<T>(0));
@@ -159,30 +318,35 @@ namespace math
     
         const T* Data() const { return reinterpret_cast<const T*>(this); }
     
-        T& operator[](size_t index)
+        // Data() reinterprets the union, which constant evaluation does not allow
+        constexpr T& operator[](size_t index)
         {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return index == 0 ? x : y;
             return Data()[index];
         }
     
-        const T& operator[](size_t index) const
+        constexpr const T& operator[](size_t index) const
         {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return index == 0 ? x : y;
             return Data()[index];
         }
     
-        Vector2() :
+        constexpr Vector2() :
             x(0), y(0) {}
-        Vector2(T _x, T _y) :
+        constexpr Vector2(T _x, T _y) :
             x(_x), y(_y) {}
     
         template <typename Y>
-        static Vector2 MakeVector(Y it)
+        static constexpr Vector2 MakeVector(Y it)
         {
             return Vector2{static_cast<T>(*it++),
                            static_cast<T>(*it++)};
         }
     
         template <typename Y>
-        Vector2<Y> Recast() const
+        constexpr Vector2<Y> Recast() const
         {
             return Vector2<Y>{static_cast<Y>(x),
                               static_cast<Y>(y)};
@@ -190,7 +354,7 @@ namespace math
     };
     
     template <class T>
-    Vector2<T> operator*(T s, const Vector2<T>& a)
+    constexpr Vector2<T> operator*(T s, const Vector2<T>& a)
     {
         return a * s;
     }
@@ -221,17 +385,17 @@ namespace math
         };
     
     
-        Vector3 operator-(const Vector3& right) const
+        constexpr Vector3 operator-(const Vector3& right) const
         {
             return Vector3(x - right.x, y - right.y, z - right.z);
         }
     
-        Vector3 operator-() const
+        constexpr Vector3 operator-() const
         {
             return Vector3(-x, -y, -z);
         }
     
-        Vector3& operator-=(const Vector3<T>& right)
+        constexpr Vector3& operator-=(const Vector3<T>& right)
         {
             x -= right.x;
             y -= right.y;
@@ -239,12 +403,12 @@ namespace math
             return *this;
         }
     
-        Vector3 operator+(const Vector3& right) const
+        constexpr Vector3 operator+(const Vector3& right) const
         {
             return Vector3(x + right.x, y + right.y, z + right.z);
         }
     
-        Vector3& operator+=(const Vector3<T>& right)
+        constexpr Vector3& operator+=(const Vector3<T>& right)
         {
             x += right.x;
             y += right.y;
@@ -252,12 +416,12 @@ namespace math
             return *this;
         }
     
-        Vector3 operator*(T s) const
+        constexpr Vector3 operator*(T s) const
         {
             return Vector3(x * s, y * s, z * s);
         }
     
-        Vector3& operator*=(T s)
+        constexpr Vector3& operator*=(T s)
         {
             x *= s;
             y *= s;
@@ -265,18 +429,18 @@ namespace math
             return *this;
         }
     
-        Vector3 operator*(const Vector3& right) const
+        constexpr Vector3 operator*(const Vector3& right) const
         {
             return Vector3(x * right.x, y * right.y, z * right.z);
         }
     
-        Vector3 operator*(const Matrix4x4<T>& m) const
+        constexpr Vector3 operator*(const Matrix4x4<T>& m) const
         {
             Vector4<T> out4 = Vector4<T>(x, y, z, 1) * m;
             return Vector3(out4.x / out4.w, out4.y / out4.w, out4.z / out4.w);
         }
     
-        Vector3& operator*=(const Vector3& right)
+        constexpr Vector3& operator*=(const Vector3& right)
         {
             x *= right.x;
             y *= right.y;
@@ -284,7 +448,7 @@ namespace math
             return *this;
         }
     
-        Vector3 operator*(const Matrix3x3<T>& m) const
+        constexpr Vector3 operator*(const Matrix3x3<T>& m) const
         {
             Vector3 out;
             out[0] = x * m[0][0] + y * m[1][0] + z * m[2][0];
@@ -293,12 +457,12 @@ namespace math
             return out;
         }
     
-        Vector3 operator/(T s) const
+        constexpr Vector3 operator/(T s) const
         {
             return Vector3(x / s, y / s, z / s);
         }
     
-        Vector3& operator/=(T s)
+        constexpr Vector3& operator/=(T s)
         {
             x /= s;
             y /= s;
@@ -306,12 +470,12 @@ namespace math
             return *this;
         }
     
-        Vector3 operator/(const Vector3& right) const
+        constexpr Vector3 operator/(const Vector3& right) const
         {
             return Vector3(x / right.x, y / right.y, z / right.z);
         }
     
-        Vector3& operator/=(const Vector3& right)
+        constexpr Vector3& operator/=(const Vector3& right)
         {
             x /= right.x;
             y /= right.y;
@@ -319,38 +483,38 @@ namespace math
             return *this;
         }
     
-        bool operator==(const Vector3& right) const
+        constexpr bool operator==(const Vector3& right) const
         {
             return x == right.x && y == right.y && z == right.z;
         }
     
-        bool operator!=(const Vector3& right) const
+        constexpr bool operator!=(const Vector3& right) const
         {
             return !(*this == right);
         }
     
-        Vector3 operator<(const Vector3& right) const
+        constexpr Vector3 operator<(const Vector3& right) const
         {
             return Vector3(x < right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y < right.y ? static_cast<T>(1) : static_cast<T>(0),
                            z < right.z ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector3 operator>(const Vector3& right) const
+        constexpr Vector3 operator>(const Vector3& right) const
         {
             return Vector3(x > right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y > right.y ? static_cast<T>(1) : static_cast<T>(0),
                            z > right.z ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector3 operator<=(const Vector3& right) const
+        constexpr Vector3 operator<=(const Vector3& right) const
         {
             return Vector3(x <= right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y <= right.y ? static_cast<T>(1) : static_cast<T>(0),
                            z <= right.z ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector3 operator>=(const Vector3& right) const
+        constexpr Vector3 operator>=(const Vector3& right) const
         {
             return Vector3(x >= right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y >= right.y ? static_cast<T>(1) : static_cast<T>(0),
@@ -361,23 +525,27 @@ namespace math
     
         const T* Data() const { return reinterpret_cast<const T*>(this); }
     
-        T& operator[](size_t index)
+        constexpr T& operator[](size_t index)
         {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return index == 0 ? x : index == 1 ? y : z;
             return Data()[index];
         }
     
-        const T& operator[](size_t index) const
+        constexpr const T& operator[](size_t index) const
         {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return index == 0 ? x : index == 1 ? y : z;
             return Data()[index];
         }
     
-        Vector3() :
+        constexpr Vector3() :
             x(0), y(0), z(0) {}
-        Vector3(T _x, T _y, T _z) :
+        constexpr Vector3(T _x, T _y, T _z) :
             x(_x), y(_y), z(_z) {}
     
         template <typename Y>
-        static Vector3 MakeVector(Y it)
+        static constexpr Vector3 MakeVector(Y it)
         {
             return Vector3{static_cast<T>(*it++),
                            static_cast<T>(*it++),
@@ -385,18 +553,18 @@ namespace math
         }
     
         template <typename Y>
-        Vector3<Y> Recast() const
+        constexpr Vector3<Y> Recast() const
         {
             return Vector3<Y>{static_cast<Y>(x),
                               static_cast<Y>(y),
                               static_cast<Y>(z)};
         }
     
-        operator Vector2<T>() const { return Vector2<T>(x, y); }
+        constexpr operator Vector2<T>() const { return Vector2<T>(x, y); }
     };
     
     template <class T>
-    Vector3<T> operator*(T s, const Vector3<T>& a)
+    constexpr Vector3<T> operator*(T s, const Vector3<T>& a)
     {
         return a * s;
     }
@@ -422,17 +590,17 @@ namespace math
             };
         };
     
-        Vector4 operator-(const Vector4& right) const
+        constexpr Vector4 operator-(const Vector4& right) const
         {
             return Vector4(x - right.x, y - right.y, z - right.z, w - right.w);
         }
     
-        Vector4 operator-() const
+        constexpr Vector4 operator-() const
         {
             return Vector4(-x, -y, -z, -w);
         }
     
-        Vector4& operator-=(const Vector4<T>& right)
+        constexpr Vector4& operator-=(const Vector4<T>& right)
         {
             x -= right.x;
             y -= right.y;
@@ -441,12 +609,12 @@ namespace math
             return *this;
         }
     
-        Vector4 operator+(const Vector4& right) const
+        constexpr Vector4 operator+(const Vector4& right) const
         {
             return Vector4(x + right.x, y + right.y, z + right.z, w + right.w);
         }
     
-        Vector4& operator+=(const Vector4<T>& right)
+        constexpr Vector4& operator+=(const Vector4<T>& right)
         {
             x += right.x;
             y += right.y;
@@ -455,12 +623,12 @@ namespace math
             return *this;
         }
     
-        Vector4 operator*(T s) const
+        constexpr Vector4 operator*(T s) const
         {
             return Vector4(x * s, y * s, z * s, w * s);
         }
     
-        Vector4& operator*=(T s)
+        constexpr Vector4& operator*=(T s)
         {
             x *= s;
             y *= s;
@@ -469,12 +637,12 @@ namespace math
             return *this;
         }
     
-        Vector4 operator*(const Vector4& right) const
+        constexpr Vector4 operator*(const Vector4& right) const
         {
             return Vector4(x * right.x, y * right.y, z * right.z, w * right.w);
         }
     
-        Vector4& operator*=(const Vector4& right)
+        constexpr Vector4& operator*=(const Vector4& right)
         {
             x *= right.x;
             y *= right.y;
@@ -483,12 +651,12 @@ namespace math
             return *this;
         }
     
-        Vector4 operator/(T s) const
+        constexpr Vector4 operator/(T s) const
         {
             return Vector4(x / s, y / s, z / s, w / s);
         }
     
-        Vector4& operator/=(T s)
+        constexpr Vector4& operator/=(T s)
         {
             x /= s;
             y /= s;
@@ -497,12 +665,12 @@ namespace math
             return *this;
         }
     
-        Vector4 operator/(const Vector4& right) const
+        constexpr Vector4 operator/(const Vector4& right) const
         {
             return Vector4(x / right.x, y / right.y, z / right.z, w / right.w);
         }
     
-        Vector4& operator/=(const Vector4& right)
+        constexpr Vector4& operator/=(const Vector4& right)
         {
             x /= right.x;
             y /= right.y;
@@ -511,17 +679,17 @@ namespace math
             return *this;
         }
     
-        bool operator==(const Vector4& right) const
+        constexpr bool operator==(const Vector4& right) const
         {
             return x == right.x && y == right.y && z == right.z && w == right.w;
         }
     
-        bool operator!=(const Vector4& right) const
+        constexpr bool operator!=(const Vector4& right) const
         {
             return !(*this == right);
         }
     
-        Vector4 operator*(const Matrix4x4<T>& m) const
+        constexpr Vector4 operator*(const Matrix4x4<T>& m) const
         {
             Vector4 out;
             out[0] = x * m[0][0] + y * m[1][0] + z * m[2][0] + w * m[3][0];
@@ -531,7 +699,7 @@ namespace math
             return out;
         }
     
-        Vector4& operator=(const Vector3<T>& v3)
+        constexpr Vector4& operator=(const Vector3<T>& v3)
         {
             x = v3.x;
             y = v3.y;
@@ -541,7 +709,7 @@ namespace math
         }
         Vector4& operator=(const Vector4&) = default;
     
-        Vector4 operator<(const Vector4& right) const
+        constexpr Vector4 operator<(const Vector4& right) const
         {
             return Vector4(x < right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y < right.y ? static_cast<T>(1) : static_cast<T>(0),
@@ -549,7 +717,7 @@ namespace math
                            w < right.w ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector4 operator>(const Vector4& right) const
+        constexpr Vector4 operator>(const Vector4& right) const
         {
             return Vector4(x > right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y > right.y ? static_cast<T>(1) : static_cast<T>(0),
@@ -557,7 +725,7 @@ namespace math
                            w > right.w ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector4 operator<=(const Vector4& right) const
+        constexpr Vector4 operator<=(const Vector4& right) const
         {
             return Vector4(x <= right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y <= right.y ? static_cast<T>(1) : static_cast<T>(0),
@@ -565,7 +733,7 @@ namespace math
                            w <= right.w ? static_cast<T>(1) : static_cast<T>(0));
         }
     
-        Vector4 operator>=(const Vector4& right) const
+        constexpr Vector4 operator>=(const Vector4& right) const
         {
             return Vector4(x >= right.x ? static_cast<T>(1) : static_cast<T>(0),
                            y >= right.y ? static_cast<T>(1) : static_cast<T>(0),
@@ -577,25 +745,29 @@ namespace math
     
         const T* Data() const { return reinterpret_cast<const T*>(this); }
     
-        T& operator[](size_t index)
+        constexpr T& operator[](size_t index)
         {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return index == 0 ? x : index == 1 ? y : index == 2 ? z : w;
             return Data()[index];
         }
     
-        const T& operator[](size_t index) const
+        constexpr const T& operator[](size_t index) const
         {
+            if (MATH_IS_CONSTANT_EVALUATED())
+                return index == 0 ? x : index == 1 ? y : index == 2 ? z : w;
             return Data()[index];
         }
     
-        Vector4() :
+        constexpr Vector4() :
             x(0), y(0), z(0), w(0) {}
-        Vector4(T _x, T _y, T _z, T _w) :
+        constexpr Vector4(T _x, T _y, T _z, T _w) :
             x(_x), y(_y), z(_z), w(_w) {}
-        Vector4(const Vector3<T>& v3, T _w) :
+        constexpr Vector4(const Vector3<T>& v3, T _w) :
             x(v3.x), y(v3.y), z(v3.z), w(_w) {}
     
         template <typename Y>
-        static Vector4 MakeVector(Y it)
+        static constexpr Vector4 MakeVector(Y it)
         {
             return Vector4{static_cast<T>(*it++),
                            static_cast<T>(*it++),
@@ -604,7 +776,7 @@ namespace math
         }
     
         template <typename Y>
-        Vector4<Y> Recast() const
+        constexpr Vector4<Y> Recast() const
         {
             return Vector4<Y>{static_cast<Y>(x),
                               static_cast<Y>(y),
@@ -612,7 +784,7 @@ namespace math
                               static_cast<Y>(w)};
         }
     
-        operator Vector3<T>() const
+        constexpr operator Vector3<T>() const
         {
             return Vector3<T>(x, y, z);
         }
@@ -620,7 +792,7 @@ namespace math
     
     
     template <class T>
-    Vector4<T> operator*(T s, const Vector4<T>& a)
+    constexpr Vector4<T> operator*(T s, const Vector4<T>& a)
     {
         return a * s;
     }
@@ -647,35 +819,31 @@ namespace math
             T m[2][2];
         };
     
-        explicit Matrix2x2(T value)
-        {
-            _11 = _12 = value;
-            _21 = _22 = value;
-        }
+        // The constructors initialize m, the member constant evaluation may read: constexpr
+        // code uses m[i][j] or operator[], not _11 or m00
+        explicit constexpr Matrix2x2(T value) :
+            m{{value, value}, {value, value}}
+        {}
     
-        Matrix2x2() :
+        constexpr Matrix2x2() :
             Matrix2x2(0) {}
     
-        Matrix2x2(
+        constexpr Matrix2x2(
             T i11,
             T i12,
             T i21,
-            T i22)
-        {
-            _11 = i11;
-            _12 = i12;
-            _21 = i21;
-            _22 = i22;
-        }
+            T i22) :
+            m{{i11, i12}, {i21, i22}}
+        {}
     
         template <typename Y>
-        static Matrix2x2 MakeMatrix(Y it)
+        static constexpr Matrix2x2 MakeMatrix(Y it)
         {
             return Matrix2x2{static_cast<T>(*it++), static_cast<T>(*it++),
                              static_cast<T>(*it++), static_cast<T>(*it++)};
         }
     
-        bool operator==(const Matrix2x2& r) const
+        constexpr bool operator==(const Matrix2x2& r) const
         {
             for (int i = 0; i < 2; ++i)
                 for (int j = 0; j < 2; ++j)
@@ -685,17 +853,17 @@ namespace math
             return true;
         }
     
-        bool operator!=(const Matrix2x2& r) const
+        constexpr bool operator!=(const Matrix2x2& r) const
         {
             return !(*this == r);
         }
     
-        T* operator[](size_t row)
+        constexpr T* operator[](size_t row)
         {
             return m[row];
         }
     
-        const T* operator[](size_t row) const
+        constexpr const T* operator[](size_t row) const
         {
             return m[row];
         }
@@ -705,35 +873,36 @@ namespace math
         const T* Data() const { return (*this)[0]; }
     
     
-        Matrix2x2& operator*=(T s)
+        constexpr Matrix2x2& operator*=(T s)
         {
-            for (int i = 0; i < 4; ++i)
-                (reinterpret_cast<T*>(this))[i] *= s;
+            for (int i = 0; i < 2; ++i)
+                for (int j = 0; j < 2; ++j)
+                    m[i][j] *= s;
     
             return *this;
         }
     
-        Matrix2x2& operator*=(const Matrix2x2& right)
+        constexpr Matrix2x2& operator*=(const Matrix2x2& right)
         {
             *this = Mul(*this, right);
             return *this;
         }
     
-        Matrix2x2 Transpose() const
+        constexpr Matrix2x2 Transpose() const
         {
             return Matrix2x2{
-                _11, _21,
-                _12, _22};
+                m[0][0], m[1][0],
+                m[0][1], m[1][1]};
         }
     
-        static Matrix2x2 Identity()
+        static constexpr Matrix2x2 Identity()
         {
             return Matrix2x2{
                 1, 0,
                 0, 1};
         }
     
-        static Matrix2x2 Mul(const Matrix2x2& m1, const Matrix2x2& m2)
+        static constexpr Matrix2x2 Mul(const Matrix2x2& m1, const Matrix2x2& m2)
         {
             Matrix2x2 mOut;
             for (int i = 0; i < 2; i++)
@@ -749,10 +918,10 @@ namespace math
             return mOut;
         }
     
-        static Matrix2x2 Rotation(T angleInRadians)
+        static constexpr Matrix2x2 Rotation(T angleInRadians)
         {
-            auto s = std::sin(angleInRadians);
-            auto c = std::cos(angleInRadians);
+            T s{}, c{};
+            detail::SinCos(angleInRadians, s, c);
     
             return Matrix2x2 //
                 {
@@ -811,17 +980,14 @@ namespace math
             T m[3][3];
         };
     
-        explicit Matrix3x3(T value)
-        {
-            _11 = _12 = _13 = value;
-            _21 = _22 = _23 = value;
-            _31 = _32 = _33 = value;
-        }
+        explicit constexpr Matrix3x3(T value) :
+            m{{value, value, value}, {value, value, value}, {value, value, value}}
+        {}
     
-        Matrix3x3() :
+        constexpr Matrix3x3() :
             Matrix3x3(0) {}
     
-        Matrix3x3(
+        constexpr Matrix3x3(
             T i11,
             T i12,
             T i13,
@@ -830,21 +996,12 @@ namespace math
             T i23,
             T i31,
             T i32,
-            T i33)
-        {
-            _11 = i11;
-            _12 = i12;
-            _13 = i13;
-            _21 = i21;
-            _22 = i22;
-            _23 = i23;
-            _31 = i31;
-            _32 = i32;
-            _33 = i33;
-        }
+            T i33) :
+            m{{i11, i12, i13}, {i21, i22, i23}, {i31, i32, i33}}
+        {}
     
         template <typename Y>
-        static Matrix3x3 MakeMatrix(Y it)
+        static constexpr Matrix3x3 MakeMatrix(Y it)
         {
             return Matrix3x3 //
                 {
@@ -854,7 +1011,7 @@ namespace math
                 };
         }
     
-        bool operator==(const Matrix3x3& r) const
+        constexpr bool operator==(const Matrix3x3& r) const
         {
             for (int i = 0; i < 3; ++i)
                 for (int j = 0; j < 3; ++j)
@@ -864,17 +1021,17 @@ namespace math
             return true;
         }
     
-        bool operator!=(const Matrix3x3& r) const
+        constexpr bool operator!=(const Matrix3x3& r) const
         {
             return !(*this == r);
         }
     
-        T* operator[](size_t row)
+        constexpr T* operator[](size_t row)
         {
             return m[row];
         }
     
-        const T* operator[](size_t row) const
+        constexpr const T* operator[](size_t row) const
         {
             return m[row];
         }
@@ -883,31 +1040,32 @@ namespace math
     
         const T* Data() const { return (*this)[0]; }
     
-        Matrix3x3& operator*=(T s)
+        constexpr Matrix3x3& operator*=(T s)
         {
-            for (int i = 0; i < 9; ++i)
-                (reinterpret_cast<T*>(this))[i] *= s;
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    m[i][j] *= s;
     
             return *this;
         }
     
-        Matrix3x3& operator*=(const Matrix3x3& right)
+        constexpr Matrix3x3& operator*=(const Matrix3x3& right)
         {
             *this = Mul(*this, right);
             return *this;
         }
     
-        Matrix3x3 Transpose() const
+        constexpr Matrix3x3 Transpose() const
         {
             return Matrix3x3 //
                 {
-                    _11, _21, _31,
-                    _12, _22, _32,
-                    _13, _23, _33 //
+                    m[0][0], m[1][0], m[2][0],
+                    m[0][1], m[1][1], m[2][1],
+                    m[0][2], m[1][2], m[2][2] //
                 };
         }
     
-        static Matrix3x3 Identity()
+        static constexpr Matrix3x3 Identity()
         {
             return Matrix3x3 //
                 {
@@ -917,7 +1075,7 @@ namespace math
                 };
         }
     
-        static Matrix3x3 Mul(const Matrix3x3& m1, const Matrix3x3& m2)
+        static constexpr Matrix3x3 Mul(const Matrix3x3& m1, const Matrix3x3& m2)
         {
             Matrix3x3 mOut;
             for (int i = 0; i < 3; i++)
@@ -989,18 +1147,14 @@ namespace math
             T m[4][4];
         };
     
-        explicit Matrix4x4(T value)
-        {
-            _11 = _12 = _13 = _14 = value;
-            _21 = _22 = _23 = _24 = value;
-            _31 = _32 = _33 = _34 = value;
-            _41 = _42 = _43 = _44 = value;
-        }
+        explicit constexpr Matrix4x4(T value) :
+            m{{value, value, value, value}, {value, value, value, value}, {value, value, value, value}, {value, value, value, value}}
+        {}
     
-        Matrix4x4() :
+        constexpr Matrix4x4() :
             Matrix4x4(0) {}
     
-        Matrix4x4(
+        constexpr Matrix4x4(
             T i11,
             T i12,
             T i13,
@@ -1016,28 +1170,12 @@ namespace math
             T i41,
             T i42,
             T i43,
-            T i44)
-        {
-            _11 = i11;
-            _12 = i12;
-            _13 = i13;
-            _14 = i14;
-            _21 = i21;
-            _22 = i22;
-            _23 = i23;
-            _24 = i24;
-            _31 = i31;
-            _32 = i32;
-            _33 = i33;
-            _34 = i34;
-            _41 = i41;
-            _42 = i42;
-            _43 = i43;
-            _44 = i44;
-        }
+            T i44) :
+            m{{i11, i12, i13, i14}, {i21, i22, i23, i24}, {i31, i32, i33, i34}, {i41, i42, i43, i44}}
+        {}
     
         template <typename Y>
-        static Matrix4x4 MakeMatrix(Y it)
+        static constexpr Matrix4x4 MakeMatrix(Y it)
         {
             return Matrix4x4 //
                 {
@@ -1048,7 +1186,7 @@ namespace math
                 };
         }
     
-        bool operator==(const Matrix4x4& r) const
+        constexpr bool operator==(const Matrix4x4& r) const
         {
             for (int i = 0; i < 4; ++i)
                 for (int j = 0; j < 4; ++j)
@@ -1058,17 +1196,17 @@ namespace math
             return true;
         }
     
-        bool operator!=(const Matrix4x4& r) const
+        constexpr bool operator!=(const Matrix4x4& r) const
         {
             return !(*this == r);
         }
     
-        T* operator[](size_t row)
+        constexpr T* operator[](size_t row)
         {
             return m[row];
         }
     
-        const T* operator[](size_t row) const
+        constexpr const T* operator[](size_t row) const
         {
             return m[row];
         }
@@ -1077,32 +1215,33 @@ namespace math
     
         const T* Data() const { return (*this)[0]; }
     
-        Matrix4x4& operator*=(T s)
+        constexpr Matrix4x4& operator*=(T s)
         {
-            for (int i = 0; i < 16; ++i)
-                (reinterpret_cast<T*>(this))[i] *= s;
+            for (int i = 0; i < 4; ++i)
+                for (int j = 0; j < 4; ++j)
+                    m[i][j] *= s;
     
             return *this;
         }
     
-        Matrix4x4& operator*=(const Matrix4x4& right)
+        constexpr Matrix4x4& operator*=(const Matrix4x4& right)
         {
             *this = Mul(*this, right);
             return *this;
         }
     
-        Matrix4x4 Transpose() const
+        constexpr Matrix4x4 Transpose() const
         {
             return Matrix4x4 //
                 {
-                    _11, _21, _31, _41,
-                    _12, _22, _32, _42,
-                    _13, _23, _33, _43,
-                    _14, _24, _34, _44 //
+                    m[0][0], m[1][0], m[2][0], m[3][0],
+                    m[0][1], m[1][1], m[2][1], m[3][1],
+                    m[0][2], m[1][2], m[2][2], m[3][2],
+                    m[0][3], m[1][3], m[2][3], m[3][3] //
                 };
         }
     
-        static Matrix4x4 Identity()
+        static constexpr Matrix4x4 Identity()
         {
             return Matrix4x4 //
                 {
@@ -1113,7 +1252,7 @@ namespace math
                 };
         }
     
-        static Matrix4x4 Translation(T x, T y, T z)
+        static constexpr Matrix4x4 Translation(T x, T y, T z)
         {
             return Matrix4x4 //
                 {
@@ -1124,12 +1263,12 @@ namespace math
                 };
         }
     
-        static Matrix4x4 Translation(const Vector3<T>& v)
+        static constexpr Matrix4x4 Translation(const Vector3<T>& v)
         {
             return Translation(v.x, v.y, v.z);
         }
     
-        static Matrix4x4 Scale(T x, T y, T z)
+        static constexpr Matrix4x4 Scale(T x, T y, T z)
         {
             return Matrix4x4 //
                 {
@@ -1140,12 +1279,12 @@ namespace math
                 };
         }
     
-        static Matrix4x4 Scale(const Vector3<T>& v)
+        static constexpr Matrix4x4 Scale(const Vector3<T>& v)
         {
             return Scale(v.x, v.y, v.z);
         }
     
-        static Matrix4x4 Scale(T s)
+        static constexpr Matrix4x4 Scale(T s)
         {
             return Scale(s, s, s);
         }
@@ -1154,10 +1293,10 @@ namespace math
         // D3D-style left-handed matrix that rotates a point around the x axis. Angle (in radians)
         // is measured clockwise when looking along the rotation axis toward the origin:
         // (x' y' z' 1) = (x y z 1) * RotationX
-        static Matrix4x4 RotationX(T angleInRadians)
+        static constexpr Matrix4x4 RotationX(T angleInRadians)
         {
-            auto s = std::sin(angleInRadians);
-            auto c = std::cos(angleInRadians);
+            T s{}, c{};
+            detail::SinCos(angleInRadians, s, c);
     
             return Matrix4x4
                 {
@@ -1171,10 +1310,10 @@ namespace math
         // D3D-style left-handed matrix that rotates a point around the y axis. Angle (in radians)
         // is measured clockwise when looking along the rotation axis toward the origin:
         // (x' y' z' 1) = (x y z 1) * RotationY
-        static Matrix4x4 RotationY(T angleInRadians)
+        static constexpr Matrix4x4 RotationY(T angleInRadians)
         {
-            auto s = std::sin(angleInRadians);
-            auto c = std::cos(angleInRadians);
+            T s{}, c{};
+            detail::SinCos(angleInRadians, s, c);
     
             return Matrix4x4
                 {
@@ -1188,10 +1327,10 @@ namespace math
         // D3D-style left-handed matrix that rotates a point around the z axis. Angle (in radians)
         // is measured clockwise when looking along the rotation axis toward the origin:
         // (x' y' z' 1) = (x y z 1) * RotationZ
-        static Matrix4x4 RotationZ(T angleInRadians)
+        static constexpr Matrix4x4 RotationZ(T angleInRadians)
         {
-            auto s = std::sin(angleInRadians);
-            auto c = std::cos(angleInRadians);
+            T s{}, c{};
+            detail::SinCos(angleInRadians, s, c);
     
             return Matrix4x4
                 {
@@ -1203,40 +1342,40 @@ namespace math
         }
     
         // 3D Rotation matrix for an arbitrary axis specified by x, y and z
-        static Matrix4x4 RotationArbitrary(Vector3<T> axis, T angleInRadians)
+        static constexpr Matrix4x4 RotationArbitrary(Vector3<T> axis, T angleInRadians)
         {
             axis = normalize(axis);
     
-            auto sinAngle         = std::sin(angleInRadians);
-            auto cosAngle         = std::cos(angleInRadians);
+            T sinAngle{}, cosAngle{};
+            detail::SinCos(angleInRadians, sinAngle, cosAngle);
             auto oneMinusCosAngle = 1 - cosAngle;
     
             Matrix4x4 mOut;
     
-            mOut._11 = 1 + oneMinusCosAngle * (axis.x * axis.x - 1);
-            mOut._12 = axis.z * sinAngle + oneMinusCosAngle * axis.x * axis.y;
-            mOut._13 = -axis.y * sinAngle + oneMinusCosAngle * axis.x * axis.z;
-            mOut._41 = 0;
+            mOut.m[0][0] = 1 + oneMinusCosAngle * (axis.x * axis.x - 1);
+            mOut.m[0][1] = axis.z * sinAngle + oneMinusCosAngle * axis.x * axis.y;
+            mOut.m[0][2] = -axis.y * sinAngle + oneMinusCosAngle * axis.x * axis.z;
+            mOut.m[3][0] = 0;
     
-            mOut._21 = -axis.z * sinAngle + oneMinusCosAngle * axis.y * axis.x;
-            mOut._22 = 1 + oneMinusCosAngle * (axis.y * axis.y - 1);
-            mOut._23 = axis.x * sinAngle + oneMinusCosAngle * axis.y * axis.z;
-            mOut._24 = 0;
+            mOut.m[1][0] = -axis.z * sinAngle + oneMinusCosAngle * axis.y * axis.x;
+            mOut.m[1][1] = 1 + oneMinusCosAngle * (axis.y * axis.y - 1);
+            mOut.m[1][2] = axis.x * sinAngle + oneMinusCosAngle * axis.y * axis.z;
+            mOut.m[1][3] = 0;
     
-            mOut._31 = axis.y * sinAngle + oneMinusCosAngle * axis.z * axis.x;
-            mOut._32 = -axis.x * sinAngle + oneMinusCosAngle * axis.z * axis.y;
-            mOut._33 = 1 + oneMinusCosAngle * (axis.z * axis.z - 1);
-            mOut._34 = 0;
+            mOut.m[2][0] = axis.y * sinAngle + oneMinusCosAngle * axis.z * axis.x;
+            mOut.m[2][1] = -axis.x * sinAngle + oneMinusCosAngle * axis.z * axis.y;
+            mOut.m[2][2] = 1 + oneMinusCosAngle * (axis.z * axis.z - 1);
+            mOut.m[2][3] = 0;
     
-            mOut._41 = 0;
-            mOut._42 = 0;
-            mOut._43 = 0;
-            mOut._44 = 1;
+            mOut.m[3][0] = 0;
+            mOut.m[3][1] = 0;
+            mOut.m[3][2] = 0;
+            mOut.m[3][3] = 1;
     
             return mOut;
         }
     
-        static Matrix4x4 ViewFromBasis(const Vector3<T>& f3X, const Vector3<T>& f3Y, const Vector3<T>& f3Z)
+        static constexpr Matrix4x4 ViewFromBasis(const Vector3<T>& f3X, const Vector3<T>& f3Y, const Vector3<T>& f3Z)
         {
             return Matrix4x4
                 {
@@ -1248,7 +1387,8 @@ namespace math
         }
     
     
-        void SetNearFarClipPlanes(T zNear, T zFar, T isGL)
+        // Sets _33, _43 and _34 (through m, so that it works in constant expressions)
+        constexpr void SetNearFarClipPlanes(T zNear, T zFar, T isGL)
         {
             if (isGL)
             {
@@ -1267,15 +1407,15 @@ namespace math
                 // sign of the values in the third column in the matrix
                 // from the references:
     
-                _33 = -(-(zFar + zNear) / (zFar - zNear));
-                _43 = -2 * zNear * zFar / (zFar - zNear);
-                _34 = -(-1);
+                m[2][2] = -(-(zFar + zNear) / (zFar - zNear));
+                m[3][2] = -2 * zNear * zFar / (zFar - zNear);
+                m[2][3] = -(-1);
             }
             else
             {
-                _33 = zFar / (zFar - zNear);
-                _43 = -zNear * zFar / (zFar - zNear);
-                _34 = 1;
+                m[2][2] = zFar / (zFar - zNear);
+                m[3][2] = -zNear * zFar / (zFar - zNear);
+                m[2][3] = 1;
             }
         }
     
@@ -1293,20 +1433,20 @@ namespace math
             }
         }
     
-        static Matrix4x4 Projection(T fov, T aspectRatio, T zNear, T zFar, bool isGL) // Left-handed projection
+        static constexpr Matrix4x4 Projection(T fov, T aspectRatio, T zNear, T zFar, bool isGL) // Left-handed projection
         {
             Matrix4x4 mOut;
-            auto      yScale = static_cast<T>(1) / std::tan(fov / static_cast<T>(2));
+            auto      yScale = static_cast<T>(1) / detail::Tan(fov / static_cast<T>(2));
             auto      xScale = yScale / aspectRatio;
-            mOut._11         = xScale;
-            mOut._22         = yScale;
+            mOut.m[0][0]     = xScale;
+            mOut.m[1][1]     = yScale;
     
             mOut.SetNearFarClipPlanes(zNear, zFar, isGL);
     
             return mOut;
         }
     
-        static Matrix4x4 OrthoOffCenter(T left, T right, T bottom, T top, T zNear, T zFar, bool isGL) // Left-handed ortho projection
+        static constexpr Matrix4x4 OrthoOffCenter(T left, T right, T bottom, T top, T zNear, T zFar, bool isGL) // Left-handed ortho projection
         {
             auto _22 = (isGL ? 2 : 1) / (zFar - zNear);
             auto _32 = (isGL ? zNear + zFar : zNear) / (zNear - zFar);
@@ -1319,7 +1459,7 @@ namespace math
                 };
         }
     
-        static Matrix4x4 Ortho(T width, T height, T zNear, T zFar, bool isGL) // Left-handed ortho projection
+        static constexpr Matrix4x4 Ortho(T width, T height, T zNear, T zFar, bool isGL) // Left-handed ortho projection
         {
             return OrthoOffCenter(
                 -width * static_cast<T>(0.5),
@@ -1329,17 +1469,26 @@ namespace math
                 zNear, zFar, isGL);
         }
     
-        static Matrix4x4 Mul(const Matrix4x4& m1, const Matrix4x4& m2)
+        // Generic version. Matrix4x4<float> has a SIMD specialization below.
+        static constexpr Matrix4x4 Mul(const Matrix4x4& m1, const Matrix4x4& m2)
+        {
+            return MulScalar(m1, m2);
+        }
+    
+        static constexpr Matrix4x4 MulScalar(const Matrix4x4& m1, const Matrix4x4& m2)
         {
             Matrix4x4 mOut;
             for (int i = 0; i < 4; i++)
             {
                 for (int j = 0; j < 4; j++)
                 {
-                    for (int k = 0; k < 4; k++)
+                    // Accumulate in a register instead of going through mOut.m[i][j]
+                    T sum = m1.m[i][0] * m2.m[0][j];
+                    for (int k = 1; k < 4; k++)
                     {
-                        mOut.m[i][j] += m1.m[i][k] * m2.m[k][j];
+                        sum += m1.m[i][k] * m2.m[k][j];
                     }
+                    mOut.m[i][j] = sum;
                 }
             }
             return mOut;
@@ -1348,147 +1497,114 @@ namespace math
     
         T Determinant() const
         {
-            T det = 0.f;
+            // Laplace expansion by the 2x2 minors of the first two rows and the
+            // complementary 2x2 minors of the last two rows
+            const T s0 = m00 * m11 - m10 * m01;
+            const T s1 = m00 * m12 - m10 * m02;
+            const T s2 = m00 * m13 - m10 * m03;
+            const T s3 = m01 * m12 - m11 * m02;
+            const T s4 = m01 * m13 - m11 * m03;
+            const T s5 = m02 * m13 - m12 * m03;
     
-            det += _11 *
-                Matrix3x3<T>(_22, _23, _24,
-                             _32, _33, _34,
-                             _42, _43, _44)
-                    .Determinant();
+            const T c5 = m22 * m33 - m32 * m23;
+            const T c4 = m21 * m33 - m31 * m23;
+            const T c3 = m21 * m32 - m31 * m22;
+            const T c2 = m20 * m33 - m30 * m23;
+            const T c1 = m20 * m32 - m30 * m22;
+            const T c0 = m20 * m31 - m30 * m21;
     
-            det -= _12 *
-                Matrix3x3<T>(_21, _23, _24,
-                             _31, _33, _34,
-                             _41, _43, _44)
-                    .Determinant();
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        }
     
-            det += _13 *
-                Matrix3x3<T>(_21, _22, _24,
-                             _31, _32, _34,
-                             _41, _42, _44)
-                    .Determinant();
+        // General inverse. The twelve 2x2 minors are shared between all cofactors:
+        // https://www.geometrictools.com/Documentation/LaplaceExpansionTheorem.pdf
+        Matrix4x4 Inverse() const
+        {
+            const T s0 = m00 * m11 - m10 * m01;
+            const T s1 = m00 * m12 - m10 * m02;
+            const T s2 = m00 * m13 - m10 * m03;
+            const T s3 = m01 * m12 - m11 * m02;
+            const T s4 = m01 * m13 - m11 * m03;
+            const T s5 = m02 * m13 - m12 * m03;
     
-            det -= _14 *
-                Matrix3x3<T>(_21, _22, _23,
-                             _31, _32, _33,
-                             _41, _42, _43)
-                    .Determinant();
+            const T c5 = m22 * m33 - m32 * m23;
+            const T c4 = m21 * m33 - m31 * m23;
+            const T c3 = m21 * m32 - m31 * m22;
+            const T c2 = m20 * m33 - m30 * m23;
+            const T c1 = m20 * m32 - m30 * m22;
+            const T c0 = m20 * m31 - m30 * m21;
     
-            return det;
+            const T det    = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            const T invDet = static_cast<T>(1) / det;
+    
+            return Matrix4x4
+                {
+                    ( m11 * c5 - m12 * c4 + m13 * c3) * invDet,
+                    (-m01 * c5 + m02 * c4 - m03 * c3) * invDet,
+                    ( m31 * s5 - m32 * s4 + m33 * s3) * invDet,
+                    (-m21 * s5 + m22 * s4 - m23 * s3) * invDet,
+    
+                    (-m10 * c5 + m12 * c2 - m13 * c1) * invDet,
+                    ( m00 * c5 - m02 * c2 + m03 * c1) * invDet,
+                    (-m30 * s5 + m32 * s2 - m33 * s1) * invDet,
+                    ( m20 * s5 - m22 * s2 + m23 * s1) * invDet,
+    
+                    ( m10 * c4 - m11 * c2 + m13 * c0) * invDet,
+                    (-m00 * c4 + m01 * c2 - m03 * c0) * invDet,
+                    ( m30 * s4 - m31 * s2 + m33 * s0) * invDet,
+                    (-m20 * s4 + m21 * s2 - m23 * s0) * invDet,
+    
+                    (-m10 * c3 + m11 * c1 - m12 * c0) * invDet,
+                    ( m00 * c3 - m01 * c1 + m02 * c0) * invDet,
+                    (-m30 * s3 + m31 * s1 - m32 * s0) * invDet,
+                    ( m20 * s3 - m21 * s1 + m22 * s0) * invDet
+                };
         }
     
-        Matrix4x4 Inverse() const
+        // Inverse of an affine transform: any 3x3 linear part (rotation, scale, shear) in the
+        // upper-left block, translation in the 4th row, and (0, 0, 0, 1) as the 4th column.
+        //   M = | A 0 |   ->   M^-1 = | A^-1      0 |
+        //       | t 1 |               | -t * A^-1 1 |
+        Matrix4x4 InverseAffine() const
+        {
+            const Vector3<T> r0(_11, _12, _13);
+            const Vector3<T> r1(_21, _22, _23);
+            const Vector3<T> r2(_31, _32, _33);
+            const Vector3<T> t(_41, _42, _43);
+    
+            // Columns of A^-1 are the cross products of the rows of A divided by det(A)
+            const T invDet = static_cast<T>(1) / dot(r0, cross(r1, r2));
+            const auto c0  = cross(r1, r2) * invDet;
+            const auto c1  = cross(r2, r0) * invDet;
+            const auto c2  = cross(r0, r1) * invDet;
+    
+            return Matrix4x4
+                {
+                    c0.x,          c1.x,          c2.x,          0,
+                    c0.y,          c1.y,          c2.y,          0,
+                    c0.z,          c1.z,          c2.z,          0,
+                    -dot(t, c0),   -dot(t, c1),   -dot(t, c2),   1
+                };
+        }
+    
+        // Inverse of a rigid-body transform: rotation (orthonormal upper-left block) plus
+        // translation. The rotation inverts by transposition:
+        //   M = | R 0 |   ->   M^-1 = | R^T      0 |
+        //       | t 1 |               | -t * R^T 1 |
+        Matrix4x4 InverseRigid() const
         {
-            Matrix4x4 inv;
-    
-            // row 1
-            inv._11 =
-                Matrix3x3<T>(_22, _23, _24,
-                             _32, _33, _34,
-                             _42, _43, _44)
-                    .Determinant();
-    
-            inv._12 =
-                -Matrix3x3<T>(_21, _23, _24,
-                              _31, _33, _34,
-                              _41, _43, _44)
-                     .Determinant();
-    
-            inv._13 =
-                Matrix3x3<T>(_21, _22, _24,
-                             _31, _32, _34,
-                             _41, _42, _44)
-                    .Determinant();
-    
-            inv._14 =
-                -Matrix3x3<T>(_21, _22, _23,
-                              _31, _32, _33,
-                              _41, _42, _43)
-                     .Determinant();
-    
-    
-            // row 2
-            inv._21 =
-                -Matrix3x3<T>(_12, _13, _14,
-                              _32, _33, _34,
-                              _42, _43, _44)
-                     .Determinant();
-    
-            inv._22 =
-                Matrix3x3<T>(_11, _13, _14,
-                             _31, _33, _34,
-                             _41, _43, _44)
-                    .Determinant();
-    
-            inv._23 =
-                -Matrix3x3<T>(_11, _12, _14,
-                              _31, _32, _34,
-                              _41, _42, _44)
-                     .Determinant();
-    
-            inv._24 =
-                Matrix3x3<T>(_11, _12, _13,
-                             _31, _32, _33,
-                             _41, _42, _43)
-                    .Determinant();
-    
-    
-            // row 3
-            inv._31 =
-                Matrix3x3<T>(_12, _13, _14,
-                             _22, _23, _24,
-                             _42, _43, _44)
-                    .Determinant();
-    
-            inv._32 =
-                -Matrix3x3<T>(_11, _13, _14,
-                              _21, _23, _24,
-                              _41, _43, _44)
-                     .Determinant();
-    
-            inv._33 =
-                Matrix3x3<T>(_11, _12, _14,
-                             _21, _22, _24,
-                             _41, _42, _44)
-                    .Determinant();
-    
-            inv._34 =
-                -Matrix3x3<T>(_11, _12, _13,
-                              _21, _22, _23,
-                              _41, _42, _43)
-                     .Determinant();
-    
-    
-            // row 4
-            inv._41 =
-                -Matrix3x3<T>(_12, _13, _14,
-                              _22, _23, _24,
-                              _32, _33, _34)
-                     .Determinant();
-    
-            inv._42 =
-                Matrix3x3<T>(_11, _13, _14,
-                             _21, _23, _24,
-                             _31, _33, _34)
-                    .Determinant();
-    
-            inv._43 =
-                -Matrix3x3<T>(_11, _12, _14,
-                              _21, _22, _24,
-                              _31, _32, _34)
-                     .Determinant();
-    
-            inv._44 =
-                Matrix3x3<T>(_11, _12, _13,
-                             _21, _22, _23,
-                             _31, _32, _33)
-                    .Determinant();
-    
-            auto det = _11 * inv._11 + _12 * inv._12 + _13 * inv._13 + _14 * inv._14;
-            inv      = inv.Transpose();
-            inv *= static_cast<T>(1) / det;
-    
-            return inv;
+            const Vector3<T> r0(_11, _12, _13);
+            const Vector3<T> r1(_21, _22, _23);
+            const Vector3<T> r2(_31, _32, _33);
+            const Vector3<T> t(_41, _42, _43);
+    
+            return Matrix4x4
+                {
+                    _11,           _21,           _31,           0,
+                    _12,           _22,           _32,           0,
+                    _13,           _23,           _33,           0,
+                    -dot(t, r0),   -dot(t, r1),   -dot(t, r2),   1
+                };
         }
     
         Matrix4x4 RemoveTranslation() const
@@ -1503,60 +1619,127 @@ namespace math
         }
     };
     
+#if defined(MATH_SIMD_SSE2)
+    
+    // Row-major, row-vector convention: row i of the product is
+    // m1[i][0] * m2.row0 + m1[i][1] * m2.row1 + m1[i][2] * m2.row2 + m1[i][3] * m2.row3
+    template <>
+    constexpr Matrix4x4<float> Matrix4x4<float>::Mul(const Matrix4x4<float>& m1, const Matrix4x4<float>& m2)
+    {
+        if (MATH_IS_CONSTANT_EVALUATED())
+            return MulScalar(m1, m2);
+    
+        Matrix4x4<float> mOut;
+    
+#if defined(MATH_SIMD_AVX512)
+        // The whole matrix in one register, one row per 128-bit lane. The rows of m2 are
+        // broadcast to all lanes straight from memory and _mm512_shuffle_ps splats element k
+        // of every row within its own lane, so there are only four shuffles in total. The
+        // all-ones maskz broadcast compiles to the plain one; GCC 12 warns about the unmasked
+        // intrinsic's undefined source.
+        const __m512 a = _mm512_loadu_ps(m1.m[0]);
+    
+        __m512 r = _mm512_mul_ps(_mm512_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), _mm512_maskz_broadcast_f32x4(0xFFFF, _mm_loadu_ps(m2.m[0])));
+        r        = _mm512_fmadd_ps(_mm512_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), _mm512_maskz_broadcast_f32x4(0xFFFF, _mm_loadu_ps(m2.m[1])), r);
+        r        = _mm512_fmadd_ps(_mm512_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), _mm512_maskz_broadcast_f32x4(0xFFFF, _mm_loadu_ps(m2.m[2])), r);
+        r        = _mm512_fmadd_ps(_mm512_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), _mm512_maskz_broadcast_f32x4(0xFFFF, _mm_loadu_ps(m2.m[3])), r);
+    
+        _mm512_storeu_ps(mOut.m[0], r);
+#elif defined(MATH_SIMD_AVX)
+        // Two output rows per iteration: each 128-bit half of a 256-bit register holds one row
+        // and _mm256_shuffle_ps broadcasts an element within each half independently.
+        const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[0]));
+        const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[1]));
+        const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[2]));
+        const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[3]));
+    
+        for (int i = 0; i < 4; i += 2)
+        {
+            const __m256 a = _mm256_loadu_ps(m1.m[i]);
+    
+            __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+            r        = simd::madd(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1, r);
+            r        = simd::madd(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2, r);
+            r        = simd::madd(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3, r);
+    
+            _mm256_storeu_ps(mOut.m[i], r);
+        }
+#else
+        const __m128 b0 = _mm_loadu_ps(m2.m[0]);
+        const __m128 b1 = _mm_loadu_ps(m2.m[1]);
+        const __m128 b2 = _mm_loadu_ps(m2.m[2]);
+        const __m128 b3 = _mm_loadu_ps(m2.m[3]);
+    
+        for (int i = 0; i < 4; i++)
+        {
+            __m128 r = _mm_mul_ps(_mm_set1_ps(m1.m[i][0]), b0);
+            r        = simd::madd(_mm_set1_ps(m1.m[i][1]), b1, r);
+            r        = simd::madd(_mm_set1_ps(m1.m[i][2]), b2, r);
+            r        = simd::madd(_mm_set1_ps(m1.m[i][3]), b3, r);
+    
+            _mm_storeu_ps(mOut.m[i], r);
+        }
+#endif
+    
+        return mOut;
+    }
+    
+#endif
+    
     // Template Vector Operations
     
     
     template <class T>
-    T dot(const Vector2<T>& a, const Vector2<T>& b)
+    constexpr T dot(const Vector2<T>& a, const Vector2<T>& b)
     {
         return a.x * b.x + a.y * b.y;
     }
     
     template <class T>
-    T dot(const Vector3<T>& a, const Vector3<T>& b)
+    constexpr T dot(const Vector3<T>& a, const Vector3<T>& b)
     {
         return a.x * b.x + a.y * b.y + a.z * b.z;
     }
     
     template <class T>
-    T dot(const Vector4<T>& a, const Vector4<T>& b)
+    constexpr T dot(const Vector4<T>& a, const Vector4<T>& b)
     {
         return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
     }
     
     template <class VectorType>
-    auto length(const VectorType& a) -> decltype(dot(a, a))
+    constexpr auto length(const VectorType& a) -> decltype(dot(a, a))
     {
-        return sqrt(dot(a, a));
+        return detail::Sqrt(dot(a, a));
     }
     
     
     template <class T>
-    Vector3<T> min(const Vector3<T>& a, const Vector3<T>& b)
+    constexpr Vector3<T> min(const Vector3<T>& a, const Vector3<T>& b)
     {
         return Vector3<T>(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
     }
     
     template <class T>
-    Vector4<T> min(const Vector4<T>& a, const Vector4<T>& b)
+    constexpr Vector4<T> min(const Vector4<T>& a, const Vector4<T>& b)
     {
         return Vector4<T>(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z), std::min(a.w, b.w));
     }
     
     template <class T>
-    Vector3<T> max(const Vector3<T>& a, const Vector3<T>& b)
+    constexpr Vector3<T> max(const Vector3<T>& a, const Vector3<T>& b)
     {
         return Vector3<T>(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
     }
     
     template <class T>
-    Vector4<T> max(const Vector4<T>& a, const Vector4<T>& b)
+    constexpr Vector4<T> max(const Vector4<T>& a, const Vector4<T>& b)
     {
         return Vector4<T>(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w));
     }
     
     template <class T>
-    Vector2<T> abs(const Vector2<T>& a)
+    constexpr Vector2<T> abs(const Vector2<T>& a)
     {
         // WARNING: abs() on gcc is for integers only!
         return Vector2<T>(a.x < 0 ? -a.x : a.x,
@@ -1564,7 +1747,7 @@ namespace math
     }
     
     template <class T>
-    Vector3<T> abs(const Vector3<T>& a)
+    constexpr Vector3<T> abs(const Vector3<T>& a)
     {
         // WARNING: abs() on gcc is for integers only!
         return Vector3<T>(a.x < 0 ? -a.x : a.x,
@@ -1573,7 +1756,7 @@ namespace math
     }
     
     template <class T>
-    Vector4<T> abs(const Vector4<T>& a)
+    constexpr Vector4<T> abs(const Vector4<T>& a)
     {
         // WARNING: abs() on gcc is for integers only!
         return Vector4<T>(a.x < 0 ? -a.x : a.x,
@@ -1584,20 +1767,20 @@ namespace math
     
     
     template <typename T>
-    T clamp(T val, T _min, T _max)
+    constexpr T clamp(T val, T _min, T _max)
     {
         return val < _min ? _min : (val > _max ? _max : val);
     }
     
     template <class T>
-    Vector2<T> clamp(const Vector2<T>& a, const Vector2<T>& _min, const Vector2<T>& _max)
+    constexpr Vector2<T> clamp(const Vector2<T>& a, const Vector2<T>& _min, const Vector2<T>& _max)
     {
         return Vector2<T>(clamp(a.x, _min.x, _max.x),
                           clamp(a.y, _min.y, _max.y));
     }
     
     template <class T>
-    Vector3<T> clamp(const Vector3<T>& a, const Vector3<T>& _min, const Vector3<T>& _max)
+    constexpr Vector3<T> clamp(const Vector3<T>& a, const Vector3<T>& _min, const Vector3<T>& _max)
     {
         return Vector3<T>(clamp(a.x, _min.x, _max.x),
                           clamp(a.y, _min.y, _max.y),
@@ -1605,7 +1788,7 @@ namespace math
     }
     
     template <class T>
-    Vector4<T> clamp(const Vector4<T>& a, const Vector4<T>& _min, const Vector4<T>& _max)
+    constexpr Vector4<T> clamp(const Vector4<T>& a, const Vector4<T>& _min, const Vector4<T>& _max)
     {
         return Vector4<T>(clamp(a.x, _min.x, _max.x),
                           clamp(a.y, _min.y, _max.y),
@@ -1615,7 +1798,7 @@ namespace math
     
     
     template <class T>
-    Vector3<T> cross(const Vector3<T>& a, const Vector3<T>& b)
+    constexpr Vector3<T> cross(const Vector3<T>& a, const Vector3<T>& b)
     {
         // |   i    j    k   |
         // |  a.x  a.y  a.z  |
@@ -1624,7 +1807,7 @@ namespace math
     }
     
     template <class T, class Y>
-    Vector3<T> cross(const Vector3<T>& a, const Vector3<T>& b)
+    constexpr Vector3<T> cross(const Vector3<T>& a, const Vector3<T>& b)
     {
         // |   i    j    k   |
         // |  a.x  a.y  a.z  |
@@ -1637,18 +1820,18 @@ namespace math
             };
     }
     
-    inline Vector3<float> high_precision_cross(const Vector3<float>& a, const Vector3<float>& b)
+    constexpr Vector3<float> high_precision_cross(const Vector3<float>& a, const Vector3<float>& b)
     {
         return cross<float, double>(a, b);
     }
     
-    inline Vector3<int32_t> high_precision_cross(const Vector3<int32_t>& a, const Vector3<int32_t>& b)
+    constexpr Vector3<int32_t> high_precision_cross(const Vector3<int32_t>& a, const Vector3<int32_t>& b)
     {
         return cross<int32_t, int64_t>(a, b);
     }
     
     template <class VectorType>
-    VectorType normalize(const VectorType& a)
+    constexpr VectorType normalize(const VectorType& a)
     {
         auto len = length(a);
         return a / len;
@@ -1658,19 +1841,19 @@ namespace math
     // Template Matrix-Matrix multiplications
     
     template <class T>
-    Matrix4x4<T> operator*(const Matrix4x4<T>& m1, const Matrix4x4<T>& m2)
+    constexpr Matrix4x4<T> operator*(const Matrix4x4<T>& m1, const Matrix4x4<T>& m2)
     {
         return Matrix4x4<T>::Mul(m1, m2);
     }
     
     template <class T>
-    Matrix3x3<T> operator*(const Matrix3x3<T>& m1, const Matrix3x3<T>& m2)
+    constexpr Matrix3x3<T> operator*(const Matrix3x3<T>& m1, const Matrix3x3<T>& m2)
     {
         return Matrix3x3<T>::Mul(m1, m2);
     }
     
     template <class T>
-    Matrix2x2<T> operator*(const Matrix2x2<T>& m1, const Matrix2x2<T>& m2)
+    constexpr Matrix2x2<T> operator*(const Matrix2x2<T>& m1, const Matrix2x2<T>& m2)
     {
         return Matrix2x2<T>::Mul(m1, m2);
     }
@@ -1679,7 +1862,7 @@ namespace math
     // Template Matrix-Vector multiplications
     
     template <class T>
-    Vector4<T> operator*(const Matrix4x4<T>& m, const Vector4<T>& v)
+    constexpr Vector4<T> operator*(const Matrix4x4<T>& m, const Vector4<T>& v)
     {
         Vector4<T> out;
         out[0] = m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3] * v.w;
@@ -1690,7 +1873,7 @@ namespace math
     }
     
     template <class T>
-    Vector3<T> operator*(const Matrix3x3<T>& m, Vector3<T>& v)
+    constexpr Vector3<T> operator*(const Matrix3x3<T>& m, Vector3<T>& v)
     {
         Vector3<T> out;
         out[0] = m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z;
@@ -1700,7 +1883,7 @@ namespace math
     }
     
     template <class T>
-    Vector2<T> operator*(const Matrix2x2<T>& m, const Vector2<T>& v)
+    constexpr Vector2<T> operator*(const Matrix2x2<T>& m, const Vector2<T>& v)
     {
         Vector2<T> out;
         out[0] = m[0][0] * v.x + m[0][1] * v.y;
@@ -1736,41 +1919,108 @@ namespace math
     using double2x2 = Matrix2x2<double>;
     
     
+    // Axis-aligned bounding box. A default constructed box is empty: min > max, so extending it
+    // with the first point or box yields exactly that point or box.
+    template <class T> struct AABB
+    {
+        Vector3<T> min;
+        Vector3<T> max;
+    
+        AABB() noexcept :
+            min(std::numeric_limits<T>::max(), std::numeric_limits<T>::max(), std::numeric_limits<T>::max()),
+            max(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest(), std::numeric_limits<T>::lowest())
+        {}
+        AABB(const Vector3<T>& _min, const Vector3<T>& _max) noexcept :
+            min(_min), max(_max)
+        {}
+    
+        bool operator==(const AABB& right) const
+        {
+            return min == right.min && max == right.max;
+        }
+    
+        bool IsEmpty() const
+        {
+            return !(min.x <= max.x && min.y <= max.y && min.z <= max.z);
+        }
+    
+        Vector3<T> Center() const
+        {
+            return (min + max) / T(2);
+        }
+    
+        Vector3<T> Size() const
+        {
+            return max - min;
+        }
+    
+        // Surface area, the probability measure of the SAH
+        T Area() const
+        {
+            const Vector3<T> d = max - min;
+            return T(2) * (d.x * d.y + d.y * d.z + d.z * d.x);
+        }
+    
+        void Extend(const Vector3<T>& point)
+        {
+            min = math::min(min, point);
+            max = math::max(max, point);
+        }
+    
+        void Extend(const AABB& box)
+        {
+            min = math::min(min, box.min);
+            max = math::max(max, box.max);
+        }
+    
+        bool Contains(const Vector3<T>& point) const
+        {
+            return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z;
+        }
+    
+        bool Intersects(const AABB& box) const
+        {
+            return min.x <= box.max.x && max.x >= box.min.x && min.y <= box.max.y && max.y >= box.min.y && min.z <= box.max.z && max.z >= box.min.z;
+        }
+    };
+    
+    
     struct Quaternion
     {
         float4 q;
     
-        Quaternion(const float4& _q) noexcept :
+        constexpr Quaternion(const float4& _q) noexcept :
             q{_q}
         {}
-        Quaternion(float x, float y, float z, float w) noexcept :
+        constexpr Quaternion(float x, float y, float z, float w) noexcept :
             q{x, y, z, w}
         {
         }
-        Quaternion() noexcept {}
+        constexpr Quaternion() noexcept {}
     
-        bool operator==(const Quaternion& right) const
+        constexpr bool operator==(const Quaternion& right) const
         {
             return q == right.q;
         }
     
         template <typename Y>
-        static Quaternion MakeQuaternion(Y it)
+        static constexpr Quaternion MakeQuaternion(Y it)
         {
             return Quaternion{float4::MakeVector(it)};
         }
     
-        static Quaternion RotationFromAxisAngle(const float3& axis, float angle)
+        static constexpr Quaternion RotationFromAxisAngle(const float3& axis, float angle)
         {
             Quaternion out{0, 0, 0, 1};
             float      norm = length(axis);
             if (norm != 0)
             {
-                float sina2 = sin(0.5f * angle);
-                out.q[0]    = sina2 * axis[0] / norm;
-                out.q[1]    = sina2 * axis[1] / norm;
-                out.q[2]    = sina2 * axis[2] / norm;
-                out.q[3]    = cos(0.5f * angle);
+                float sina2 = 0, cosa2 = 0;
+                detail::SinCos(0.5f * angle, sina2, cosa2);
+                out.q[0] = sina2 * axis[0] / norm;
+                out.q[1] = sina2 * axis[1] / norm;
+                out.q[2] = sina2 * axis[2] / norm;
+                out.q[3] = cosa2;
             }
             return out;
         }
@@ -1778,14 +2028,14 @@ namespace math
         void GetAxisAngle(float3& outAxis, float& outAngle) const
         {
             float sina2 = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
-            outAngle    = 2.0f * atan2(sina2, q[3]);
+            outAngle    = 2.0f * detail::Atan2(sina2, q[3]);
             float r     = (sina2 > 0) ? (1.0f / sina2) : 0;
             outAxis[0]  = r * q[0];
             outAxis[1]  = r * q[1];
             outAxis[2]  = r * q[2];
         }
     
-        float4x4 ToMatrix() const
+        constexpr float4x4 ToMatrix() const
         {
             float4x4 out;
             float    yy2 = 2.0f * q[1] * q[1];
@@ -1814,7 +2064,7 @@ namespace math
             return out;
         }
     
-        static Quaternion Mul(const Quaternion& q1, const Quaternion& q2)
+        static constexpr Quaternion Mul(const Quaternion& q1, const Quaternion& q2)
         {
             Quaternion q1_q2;
             q1_q2.q.x = +q1.q.x * q2.q.w + q1.q.y * q2.q.z - q1.q.z * q2.q.y + q1.q.w * q2.q.x;
@@ -1824,31 +2074,25 @@ namespace math
             return q1_q2;
         }
     
-        Quaternion& operator=(const Quaternion& rhs)
-        {
-            q = rhs.q;
-            return *this;
-        }
-    
-        Quaternion& operator*=(const Quaternion& rhs)
+        constexpr Quaternion& operator*=(const Quaternion& rhs)
         {
             *this = Mul(*this, rhs);
             return *this;
         }
     
-        float3 RotateVector(const float3& v) const
+        constexpr float3 RotateVector(const float3& v) const
         {
             const float3 axis(q.x, q.y, q.z);
             return v + 2.f * cross(axis, cross(axis, v) + q.w * v);
         }
     };
     
-    inline Quaternion operator*(const Quaternion& q1, const Quaternion& q2)
+    constexpr Quaternion operator*(const Quaternion& q1, const Quaternion& q2)
     {
         return Quaternion::Mul(q1, q2);
     }
     
-    inline Quaternion normalize(const Quaternion& q)
+    constexpr Quaternion normalize(const Quaternion& q)
     {
         return Quaternion{normalize(q.q)};
     }
@@ -1889,12 +2133,14 @@ namespace math
         }
     
         // Since dot is in range [0, DOT_THRESHOLD], acos is safe
-        auto theta_0     = std::acos(dp);     // theta_0 = angle between input vectors
-        auto theta       = theta_0 * t;       // theta = angle between v0 and result
-        auto sin_theta   = std::sin(theta);   // compute this value only once
-        auto sin_theta_0 = std::sin(theta_0); // compute this value only once
-    
-        auto s0 = cos(theta) - dp * sin_theta / sin_theta_0; // == sin(theta_0 - theta) / sin(theta_0)
+        auto  theta_0     = detail::Acos(dp);  // theta_0 = angle between input vectors
+        auto  theta       = theta_0 * t;       // theta = angle between v0 and result
+        float sin_theta   = 0, cos_theta = 0;
+        float sin_theta_0 = 0, cos_theta_0 = 0;
+        detail::SinCos(theta, sin_theta, cos_theta);
+        detail::SinCos(theta_0, sin_theta_0, cos_theta_0);
+    
+        auto s0 = cos_theta - dp * sin_theta / sin_theta_0; // == sin(theta_0 - theta) / sin(theta_0)
         auto s1 = sin_theta / sin_theta_0;
     
         auto v = Quaternion{v0.q * s0 + v1.q * s1};
@@ -1907,26 +2153,26 @@ namespace math
     
     
     template <typename T>
-    T lerp(const T& left, const T& right, float w)
+    constexpr T lerp(const T& left, const T& right, float w)
     {
         return left * (1.f - w) + right * w;
     }
     
     template <typename T>
-    T SmoothStep(T left, T right, T w)
+    constexpr T SmoothStep(T left, T right, T w)
     {
         auto t = clamp((w - left) / (right - left), static_cast<T>(0), static_cast<T>(1));
         return t * t * (static_cast<T>(3) - static_cast<T>(2) * t);
     }
     
     template <typename T>
-    T max3(const T& x, const T& y, const T& z)
+    constexpr T max3(const T& x, const T& y, const T& z)
     {
         return std::max(std::max(x, y), z);
     }
     
     template <typename T>
-    T min3(const T& x, const T& y, const T& z)
+    constexpr T min3(const T& x, const T& y, const T& z)
     {
         return std::min(std::min(x, y), z);
     }
@@ -1942,13 +2188,23 @@ namespace math
         };
     }
     
+    namespace detail
+    {
+        // [0, 1] -> [0, 255], round to nearest (half up), NaN -> 0
+        inline uint32_t QuantizeUnorm8(float x)
+        {
+            x = x > 0.f ? (x < 1.f ? x : 1.f) : 0.f;
+            return static_cast<uint32_t>(x * 255.f + 0.5f);
+        }
+    } // namespace detail
+    
     inline uint32_t F4Color_To_RGBA8Unorm(const float4& f4Color)
     {
         uint32_t RGBA8U = 0;
-        RGBA8U |= static_cast<uint32_t>(clamp(f4Color.r, 0.f, 1.f) * 255.f) << 0u;
-        RGBA8U |= static_cast<uint32_t>(clamp(f4Color.g, 0.f, 1.f) * 255.f) << 8u;
-        RGBA8U |= static_cast<uint32_t>(clamp(f4Color.b, 0.f, 1.f) * 255.f) << 16u;
-        RGBA8U |= static_cast<uint32_t>(clamp(f4Color.a, 0.f, 1.f) * 255.f) << 24u;
+        RGBA8U |= detail::QuantizeUnorm8(f4Color.r) << 0u;
+        RGBA8U |= detail::QuantizeUnorm8(f4Color.g) << 8u;
+        RGBA8U |= detail::QuantizeUnorm8(f4Color.b) << 16u;
+        RGBA8U |= detail::QuantizeUnorm8(f4Color.a) << 24u;
         return RGBA8U;
     }
     
@@ -1962,6 +2218,8 @@ namespace math
     {
         // All floats that have fractional part are representable as 32-bit int
         using Type = int32_t;
+        // Floats at or above 2^23 have no fractional part
+        static constexpr float kIntegral = 8388608.f;
     };
     
     template <>
@@ -1969,14 +2227,21 @@ namespace math
     {
         // All doubles that have fractional part are representable as 64-bit int
         using Type = int64_t;
+        static constexpr double kIntegral = 4503599627370496.0; // 2^52
     };
     
     // At least on MSVC std::floor is an actual function call into ucrtbase.dll.
     // All floats/doubles that have fractional parts also fit into integer
     // representable range, so we can do much better.
+    // Larger values, infinities and NaN are returned as they are; converting
+    // them to the integer type would be undefined. FastFloor(-0) is +0.
+    // Simd.h has simd::floor for registers, FloorBatch.h the span versions.
     template <typename T>
     T FastFloor(T x)
     {
+        if (!(std::abs(x) < _FastFloatIntermediateType<T>::kIntegral))
+            return x;
+    
         auto i   = static_cast<typename _FastFloatIntermediateType<T>::Type>(x);
         auto flr = static_cast<T>(i);
         //   x         flr    floor(x)  flr <= x
@@ -1986,7 +2251,10 @@ namespace math
         // -0.5   ->   0.0     -1.0      false
         // -1.0   ->  -1.0     -1.0       true
     
-        return flr <= x ? flr : flr - 1;
+        // Step down in the integer domain: GCC turns a float ?: (or subtracting the
+        // comparison as float) into a branch, which mispredicts on random input
+        i -= flr > x ? 1 : 0;
+        return static_cast<T>(i);
     }
     
     template <typename T>
@@ -2051,6 +2319,7 @@ namespace math
             FastCeil(vec.w)};
     }
     
+    // 2D Morton code. Morton.h has the 3D, 64-bit, decode and batch versions.
     inline uint32_t BitInterleave16(uint16_t _x, uint16_t _y)
     {
         // https://graphics.stanford.edu/~seander/bithacks.html#InterleaveBMN
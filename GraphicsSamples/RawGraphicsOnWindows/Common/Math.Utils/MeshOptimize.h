@@ -0,0 +1,488 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "Span.h"
+
+// Index buffer optimization for indexed triangle lists, plain C++ without platform headers so
+// the asset build can run it on any OS:
+//
+//   OptimizeVertexCache   reorders triangles for the post-transform vertex cache, after Tom
+//                         Forsyth, "Linear-Speed Vertex Cache Optimisation" (2006)
+//   OptimizeOverdraw      splits the cache-optimized order into clusters that cost little
+//                         cache efficiency and sorts them outside in, after Sander, Nehab and
+//                         Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+//                         Overdraw" (2007)
+//   OptimizeVertexFetch   renumbers the vertices in the order the triangles use them
+//
+// Run them in that order. The Analyze functions measure the results: ACMR is transformed
+// vertices per triangle (0.5 is the best possible for a regular grid, 3 the worst), ATVR is
+// transformed vertices per vertex (1 is the best possible), overdraw is shaded pixels per covered
+// pixel. Front faces are counter-clockwise: cross(b - a, c - a) points out of the mesh.
+
+namespace math
+{
+    // FIFO size the cache statistics and the overdraw clusters assume, a typical GPU
+    constexpr uint32_t kPostTransformCacheSize = 16;
+
+    // Resolution of every view of AnalyzeOverdraw
+    constexpr uint32_t kOverdrawViewport = 256;
+
+    struct VertexCacheStats
+    {
+        size_t transformed = 0; // cache misses
+        float  acmr        = 0.f;
+        float  atvr        = 0.f;
+    };
+
+    struct OverdrawStats
+    {
+        size_t covered  = 0; // pixels, summed over the views
+        size_t shaded   = 0; // fragments that passed the depth test
+        float  overdraw = 0.f;
+    };
+
+    namespace detail
+    {
+        // Forsyth's scoring: a vertex scores higher the more recently it was used and the fewer
+        // triangles still need it, a triangle scores the sum of its vertices
+        constexpr uint32_t kForsythCacheSize  = 32;
+        constexpr uint32_t kForsythMaxValence = 32;
+
+        struct ForsythTables
+        {
+            float cache[kForsythCacheSize];
+            float valence[kForsythMaxValence + 1];
+
+            ForsythTables()
+            {
+                for (uint32_t i = 0; i < kForsythCacheSize; ++i)
+                    cache[i] = i < 3 ? 0.75f : std::pow(1.f - static_cast<float>(i - 3) / static_cast<float>(kForsythCacheSize - 3), 1.5f);
+                valence[0] = 0.f;
+                for (uint32_t i = 1; i <= kForsythMaxValence; ++i)
+                    valence[i] = 2.f / std::sqrt(static_cast<float>(i));
+            }
+        };
+
+        inline float ForsythScore(int32_t cachePosition, uint32_t liveTriangles)
+        {
+            static const ForsythTables tables;
+            if (liveTriangles == 0)
+                return 0.f;
+            const float cache = cachePosition < 0 ? 0.f : tables.cache[cachePosition];
+            return cache + tables.valence[std::min(liveTriangles, kForsythMaxValence)];
+        }
+
+        // Cache misses of every triangle with a FIFO of cacheSize vertices
+        inline std::vector<uint8_t> SimulateVertexCache(span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+        {
+            // A vertex is in the cache while fewer than cacheSize misses happened since its own
+            std::vector<uint32_t> timestamps(vertexCount, 0);
+            std::vector<uint8_t>  misses(indices.size() / 3, 0);
+            uint32_t              time = cacheSize + 1;
+            for (size_t i = 0; i < indices.size(); ++i)
+            {
+                const uint32_t index = indices[i];
+                assert(index < vertexCount);
+                if (time - timestamps[index] > cacheSize)
+                {
+                    timestamps[index] = time++;
+                    ++misses[i / 3];
+                }
+            }
+            return misses;
+        }
+
+        // Depth tested rasterization of one triangle, already in viewport coordinates with z the
+        // depth, at the pixel centers
+        inline void RasterizeOverdraw(const float3& a, const float3& b, const float3& c, std::vector<float>& depth, OverdrawStats& stats)
+        {
+            const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area == 0.f)
+                return;
+            const float inv = 1.f / area;
+
+            const float viewport = static_cast<float>(kOverdrawViewport);
+            const int   x0 = static_cast<int>(std::max(0.f, std::floor(std::min({a.x, b.x, c.x}))));
+            const int   y0 = static_cast<int>(std::max(0.f, std::floor(std::min({a.y, b.y, c.y}))));
+            const int   x1 = static_cast<int>(std::min(viewport - 1.f, std::floor(std::max({a.x, b.x, c.x}))));
+            const int   y1 = static_cast<int>(std::min(viewport - 1.f, std::floor(std::max({a.y, b.y, c.y}))));
+
+            for (int y = y0; y <= y1; ++y)
+            {
+                const float py = static_cast<float>(y) + 0.5f;
+                for (int x = x0; x <= x1; ++x)
+                {
+                    const float px = static_cast<float>(x) + 0.5f;
+
+                    // Barycentric coordinates of b and c, normalized by the signed area
+                    const float u = ((px - a.x) * (c.y - a.y) - (py - a.y) * (c.x - a.x)) * inv;
+                    const float v = ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) * inv;
+                    if (u < 0.f || v < 0.f || u + v > 1.f)
+                        continue;
+
+                    const float z     = a.z + u * (b.z - a.z) + v * (c.z - a.z);
+                    float&      pixel = depth[size_t(y) * kOverdrawViewport + x];
+                    if (z < pixel)
+                    {
+                        stats.covered += pixel == FLT_MAX;
+                        pixel = z;
+                        ++stats.shaded;
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+    // Post-transform cache efficiency of the index buffer with a FIFO of cacheSize vertices
+    inline VertexCacheStats AnalyzeVertexCache(span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = kPostTransformCacheSize)
+    {
+        VertexCacheStats stats;
+        for (uint8_t misses : detail::SimulateVertexCache(indices, vertexCount, cacheSize))
+            stats.transformed += misses;
+
+        std::vector<uint8_t> used(vertexCount, 0);
+        size_t               unique = 0;
+        for (uint32_t index : indices)
+        {
+            unique += !used[index];
+            used[index] = 1;
+        }
+
+        if (!indices.empty())
+        {
+            stats.acmr = static_cast<float>(stats.transformed) / static_cast<float>(indices.size() / 3);
+            stats.atvr = static_cast<float>(stats.transformed) / static_cast<float>(unique);
+        }
+        return stats;
+    }
+
+    // Overdraw with back face culling and a less depth test, rendering the mesh in its index
+    // order orthographically along +x, -x, +y, -y, +z and -z into kOverdrawViewport squares
+    inline OverdrawStats AnalyzeOverdraw(span<const uint32_t> indices, span<const float3> positions)
+    {
+        OverdrawStats stats;
+        if (indices.empty())
+            return stats;
+
+        float3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX), boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (uint32_t index : indices)
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], positions[index][axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], positions[index][axis]);
+            }
+        const float extent = std::max({boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z});
+        const float scale  = extent > 0.f ? static_cast<float>(kOverdrawViewport) / extent : 0.f;
+
+        std::vector<float> depth(size_t(kOverdrawViewport) * kOverdrawViewport);
+        for (int view = 0; view < 6; ++view)
+        {
+            // Looking along +axis or -axis; the two other axes span the viewport
+            const int   axis = view / 2, u = (axis + 1) % 3, v = (axis + 2) % 3;
+            const float sign = view % 2 == 0 ? 1.f : -1.f;
+            std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                const float3& a = positions[indices[i + 0]];
+                const float3& b = positions[indices[i + 1]];
+                const float3& c = positions[indices[i + 2]];
+                if (cross(b - a, c - a)[axis] * sign >= 0.f)
+                    continue;
+
+                auto project = [&](const float3& p) {
+                    return float3((p[u] - boundsMin[u]) * scale, (p[v] - boundsMin[v]) * scale, p[axis] * sign);
+                };
+                detail::RasterizeOverdraw(project(a), project(b), project(c), depth, stats);
+            }
+        }
+
+        stats.overdraw = stats.covered == 0 ? 0.f : static_cast<float>(stats.shaded) / static_cast<float>(stats.covered);
+        return stats;
+    }
+
+    // Reorders the triangles of the index buffer in place so that consecutive triangles share
+    // vertices. Linear in the number of triangles. Triangles that repeat a vertex draw nothing
+    // and go to the end, in their input order.
+    inline void OptimizeVertexCache(span<uint32_t> indices, size_t vertexCount)
+    {
+        using namespace detail;
+        assert(indices.size() % 3 == 0);
+
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return;
+        const std::vector<uint32_t> source(indices.begin(), indices.end());
+
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        size_t               validCount = 0;
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            const uint32_t* tri = &source[3 * t];
+            emitted[t]          = tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0];
+            validCount += !emitted[t];
+        }
+
+        // Triangles of every vertex, the ones not emitted yet first
+        std::vector<uint32_t> offsets(vertexCount + 1, 0), live(vertexCount, 0), adjacency(3 * validCount);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            assert(source[i] < vertexCount);
+            offsets[source[i] + 1] += !emitted[i / 3];
+        }
+        for (size_t v = 0; v < vertexCount; ++v)
+            offsets[v + 1] += offsets[v];
+        for (size_t i = 0; i < source.size(); ++i)
+            if (!emitted[i / 3])
+                adjacency[offsets[source[i]] + live[source[i]]++] = static_cast<uint32_t>(i / 3);
+
+        std::vector<int32_t> cachePosition(vertexCount, -1);
+        std::vector<float>   vertexScore(vertexCount), triangleScore(triangleCount, 0.f);
+        for (size_t v = 0; v < vertexCount; ++v)
+            vertexScore[v] = ForsythScore(-1, live[v]);
+        for (size_t i = 0; i < source.size(); ++i)
+            triangleScore[i / 3] += emitted[i / 3] ? -1.f : vertexScore[source[i]];
+
+        auto rescore = [&](uint32_t v) {
+            const float score = ForsythScore(cachePosition[v], live[v]);
+            const float delta = score - vertexScore[v];
+            vertexScore[v]    = score;
+            for (uint32_t k = offsets[v]; k < offsets[v] + live[v]; ++k)
+                triangleScore[adjacency[k]] += delta;
+        };
+
+        // Starts with the best triangle overall, afterwards only the triangles of cached vertices
+        // are candidates. When none is left the next triangle of the input order continues.
+        uint32_t best   = static_cast<uint32_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+        size_t   cursor = 0;
+
+        uint32_t cache[kForsythCacheSize + 3], next[kForsythCacheSize + 3];
+        size_t   cacheSize = 0;
+
+        for (size_t out = 0; out < validCount; ++out)
+        {
+            if (best == UINT32_MAX)
+            {
+                while (emitted[cursor])
+                    ++cursor;
+                best = static_cast<uint32_t>(cursor);
+            }
+            emitted[best]       = 1;
+            const uint32_t* tri = &source[3 * size_t(best)];
+            std::copy(tri, tri + 3, &indices[3 * out]);
+
+            // The triangle's vertices move to the front of the cache
+            size_t nextSize = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t v = tri[k];
+                if (std::find(next, next + nextSize, v) != next + nextSize)
+                    continue;
+                next[nextSize++] = v;
+
+                const uint32_t last = offsets[v] + --live[v];
+                std::swap(*std::find(&adjacency[offsets[v]], &adjacency[last], best), adjacency[last]);
+            }
+            for (size_t i = 0; i < cacheSize; ++i)
+                if (std::find(tri, tri + 3, cache[i]) == tri + 3)
+                    next[nextSize++] = cache[i];
+
+            for (size_t i = kForsythCacheSize; i < nextSize; ++i)
+            {
+                cachePosition[next[i]] = -1;
+                rescore(next[i]);
+            }
+            cacheSize = std::min<size_t>(nextSize, kForsythCacheSize);
+            for (size_t i = 0; i < cacheSize; ++i)
+            {
+                cache[i]                = next[i];
+                cachePosition[cache[i]] = static_cast<int32_t>(i);
+                rescore(cache[i]);
+            }
+
+            best            = UINT32_MAX;
+            float bestScore = -1.f;
+            for (size_t i = 0; i < cacheSize; ++i)
+            {
+                const uint32_t v = cache[i];
+                for (uint32_t k = offsets[v]; k < offsets[v] + live[v]; ++k)
+                    if (triangleScore[adjacency[k]] > bestScore)
+                    {
+                        best      = adjacency[k];
+                        bestScore = triangleScore[best];
+                    }
+            }
+        }
+
+        size_t out = validCount;
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            const uint32_t* tri = &source[3 * t];
+            if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+                std::copy(tri, tri + 3, &indices[3 * out++]);
+        }
+    }
+
+    // Reorders the triangles of a cache-optimized index buffer in place to reduce overdraw. The
+    // buffer is cut where the cache starts over and, within those runs, wherever the ACMR so far
+    // is at most threshold times the ACMR of the run; the pieces are sorted by how far their
+    // centroid lies out along their average normal, so that the outside of the mesh is drawn
+    // first. threshold = 1.05 trades at most about 5% of the ACMR.
+    inline void OptimizeOverdraw(span<uint32_t> indices, span<const float3> positions, float threshold = 1.05f)
+    {
+        assert(indices.size() % 3 == 0);
+
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return;
+
+        // Runs start where a triangle misses all its vertices. Within a run the cache is simulated
+        // again, starting empty at every cut, because after sorting any piece may follow any other.
+        const std::vector<uint8_t> runStarts = detail::SimulateVertexCache(indices, positions.size(), kPostTransformCacheSize);
+        std::vector<uint32_t>      timestamps(positions.size(), 0);
+        uint32_t                   time   = kPostTransformCacheSize + 1;
+        auto                       misses = [&](size_t t) {
+            size_t result = 0;
+            for (size_t i = 3 * t; i < 3 * t + 3; ++i)
+                if (time - timestamps[indices[i]] > kPostTransformCacheSize)
+                {
+                    timestamps[indices[i]] = time++;
+                    ++result;
+                }
+            return result;
+        };
+        auto flush = [&] { time += kPostTransformCacheSize + 1; };
+
+        std::vector<size_t> clusters;
+        for (size_t start = 0, end; start < triangleCount; start = end)
+        {
+            for (end = start + 1; end < triangleCount && runStarts[end] < 3; ++end)
+                ;
+
+            flush();
+            size_t runMisses = 0;
+            for (size_t t = start; t < end; ++t)
+                runMisses += misses(t);
+            const float limit = threshold * static_cast<float>(runMisses) / static_cast<float>(end - start);
+
+            flush();
+            size_t first = start, running = 0;
+            clusters.push_back(start);
+            for (size_t t = start; t + 1 < end; ++t)
+            {
+                running += misses(t);
+                if (static_cast<float>(running) <= limit * static_cast<float>(t + 1 - first))
+                {
+                    first   = t + 1;
+                    running = 0;
+                    clusters.push_back(first);
+                    flush();
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // Area weighted centroids and normals
+        auto triangle = [&](size_t t, float3& centroid, float3& normal, float& area) {
+            const float3& a = positions[indices[3 * t + 0]];
+            const float3& b = positions[indices[3 * t + 1]];
+            const float3& c = positions[indices[3 * t + 2]];
+            normal          = cross(b - a, c - a);
+            area            = length(normal);
+            centroid        = (a + b + c) * (area / 3.f);
+        };
+        float3 meshCentroid(0.f, 0.f, 0.f);
+        float  meshArea = 0.f;
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            float3 centroid, normal;
+            float  area;
+            triangle(t, centroid, normal, area);
+            meshCentroid = meshCentroid + centroid;
+            meshArea += area;
+        }
+        if (meshArea > 0.f)
+            meshCentroid = meshCentroid * (1.f / meshArea);
+
+        std::vector<float> keys(clusters.size() - 1);
+        for (size_t k = 0; k + 1 < clusters.size(); ++k)
+        {
+            float3 clusterCentroid(0.f, 0.f, 0.f), clusterNormal(0.f, 0.f, 0.f);
+            float  clusterArea = 0.f;
+            for (size_t t = clusters[k]; t < clusters[k + 1]; ++t)
+            {
+                float3 centroid, normal;
+                float  area;
+                triangle(t, centroid, normal, area);
+                clusterCentroid = clusterCentroid + centroid;
+                clusterNormal   = clusterNormal + normal;
+                clusterArea += area;
+            }
+            const float normalLength = length(clusterNormal);
+            keys[k] = clusterArea > 0.f && normalLength > 0.f
+                          ? dot(clusterCentroid * (1.f / clusterArea) - meshCentroid, clusterNormal) / normalLength
+                          : 0.f;
+        }
+
+        std::vector<uint32_t> order(keys.size());
+        for (size_t k = 0; k < order.size(); ++k)
+            order[k] = static_cast<uint32_t>(k);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+        const std::vector<uint32_t> source(indices.begin(), indices.end());
+        size_t                      out = 0;
+        for (uint32_t k : order)
+            for (size_t i = 3 * clusters[k]; i < 3 * clusters[k + 1]; ++i)
+                indices[out++] = source[i];
+    }
+
+    // Renumbers the vertices in the order of their first use in the index buffer and rewrites the
+    // indices. Returns the new position of every old vertex, UINT32_MAX for unused ones; apply it
+    // to every vertex stream, e.g. with RemapVertices.
+    inline std::vector<uint32_t> OptimizeVertexFetchRemap(span<uint32_t> indices, size_t vertexCount)
+    {
+        std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+        uint32_t              next = 0;
+        for (uint32_t& index : indices)
+        {
+            assert(index < vertexCount);
+            if (remap[index] == UINT32_MAX)
+                remap[index] = next++;
+            index = remap[index];
+        }
+        return remap;
+    }
+
+    // Moves every vertex to remap[vertex] and drops the unused ones
+    template <class Vertex>
+    void RemapVertices(std::vector<Vertex>& vertices, span<const uint32_t> remap)
+    {
+        assert(vertices.size() == remap.size());
+        size_t count = 0;
+        for (uint32_t target : remap)
+            count += target != UINT32_MAX;
+
+        std::vector<Vertex> remapped(count);
+        for (size_t v = 0; v < vertices.size(); ++v)
+            if (remap[v] != UINT32_MAX)
+                remapped[remap[v]] = vertices[v];
+        vertices.swap(remapped);
+    }
+
+    // OptimizeVertexFetchRemap and RemapVertices for a single interleaved vertex buffer. Returns
+    // the new vertex count.
+    template <class Vertex>
+    size_t OptimizeVertexFetch(span<uint32_t> indices, std::vector<Vertex>& vertices)
+    {
+        const std::vector<uint32_t> remap = OptimizeVertexFetchRemap(indices, vertices.size());
+        RemapVertices(vertices, remap);
+        return vertices.size();
+    }
+} // namespace math
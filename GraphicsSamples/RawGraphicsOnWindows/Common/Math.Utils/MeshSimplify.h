@@ -0,0 +1,699 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+#include "Math.h"
+#include "Span.h"
+#include "ThreadPool.h"
+
+// Mesh simplification by edge collapse with quadric error metrics (Garland and Heckbert, "Surface
+// Simplification Using Quadric Error Metrics", 1997), for automatic LOD chains.
+//
+// Every vertex carries the quadric of the planes of its triangles, weighted by triangle area;
+// the error of a position is its area weighted squared distance to those planes. Collapsing an
+// edge adds the quadrics of its ends and moves the kept vertex to the position that minimizes
+// the sum, falling back to the ends or the midpoint when that position is not well defined.
+// Collapses that would flip a triangle or break the surface apart (the link condition) are
+// skipped. Open borders get planes perpendicular to them, so that they keep their outline.
+//
+// A heap orders the edges by error, a radix heap since the errors mostly grow as the collapses go
+// on. The first fill evaluates every edge in parallel on a ThreadPool; after that the heap is
+// updated lazily. A collapse stamps the kept vertex, which leaves the entries of its edges out of
+// date, and an entry that comes up out of date is evaluated again and pushed back instead of
+// collapsed. Costs rarely drop when a neighbor collapses, so the old cost keeps the entry in about
+// the right place, and an edge that changes several times before it comes up is evaluated once.
+// Entries of the removed vertex are dropped when they come up; the edges the kept vertex takes
+// over from it get new entries. Edges that fail the checks leave the heap; when it runs empty
+// before the target, it is filled again with every edge.
+//
+// Colors go along: the kept vertex takes the color of the edge at the new position, and the
+// color change of both ends, weighted by their area, adds to the error of the collapse.
+//
+// Errors are distances relative to the diagonal of the mesh bounds: 0.01 means the simplified
+// surface is about 1% of the mesh size away from the planes it replaced.
+
+namespace math
+{
+    // Weight of the border planes relative to the triangle planes
+    constexpr double kSimplifyBorderWeight = 10.0;
+
+    // Edges evaluated per task
+    constexpr size_t kSimplifyChunkSize = 4096;
+
+    namespace detail
+    {
+        // Index of the highest set bit, x > 0
+        inline uint32_t HighestBit(uint32_t x)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse(&index, x);
+            return static_cast<uint32_t>(index);
+#else
+            return 31u - static_cast<uint32_t>(__builtin_clz(x));
+#endif
+        }
+
+        // A priority queue for entries with a non-negative float key that mostly come out in
+        // increasing order, a radix heap (Ahuja et al., "Faster Algorithms for the Shortest Path
+        // Problem", 1990). The keys compare as their bits. Bucket 0 holds the keys equal to the
+        // last one that came out, bucket i > 0 those whose highest bit that differs from it is
+        // bit i - 1; when bucket 0 runs empty, the smallest key of the first bucket in use becomes
+        // the last one and its entries move to lower buckets. Each entry moves at most 32 times,
+        // usually a few, and push and pop cost no comparisons that mispredict, unlike a binary
+        // heap. A key below the last one out goes to bucket 0 and comes out next.
+        template <typename T>
+        class RadixHeap
+        {
+        public:
+            bool Empty() const { return m_count == 0; }
+
+            void Clear()
+            {
+                for (std::vector<T>& bucket : m_buckets)
+                    bucket.clear();
+                m_count = 0;
+                m_last  = 0;
+            }
+
+            void Push(const T& entry)
+            {
+                m_buckets[Bucket(Bits(entry.key))].push_back(entry);
+                ++m_count;
+            }
+
+            // The entry with the smallest key, not empty
+            const T& Top()
+            {
+                if (m_buckets[0].empty())
+                    Redistribute();
+                return m_buckets[0].back();
+            }
+
+            void Pop()
+            {
+                Top();
+                m_buckets[0].pop_back();
+                --m_count;
+            }
+
+        private:
+            static uint32_t Bits(float key)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &key, sizeof(bits));
+                return bits;
+            }
+
+            size_t Bucket(uint32_t bits) const { return bits <= m_last ? 0 : HighestBit(bits ^ m_last) + 1; }
+
+            void Redistribute()
+            {
+                size_t i = 1;
+                while (m_buckets[i].empty())
+                    ++i;
+                std::vector<T>& bucket = m_buckets[i];
+                m_last                 = UINT32_MAX;
+                for (const T& entry : bucket)
+                    m_last = std::min(m_last, Bits(entry.key));
+                for (const T& entry : bucket)
+                    m_buckets[Bucket(Bits(entry.key))].push_back(entry);
+                bucket.clear();
+            }
+
+            std::array<std::vector<T>, 33> m_buckets;
+            size_t                         m_count = 0;
+            uint32_t                       m_last  = 0; // bits of the last key out
+        };
+    } // namespace detail
+
+    struct SimplifiedMesh
+    {
+        std::vector<float3>   positions;
+        std::vector<float4>   colors; // empty when the source mesh had none
+        std::vector<uint32_t> indices;
+        double                error = 0.0; // largest error of any collapse so far, relative to the mesh size
+    };
+
+    // Symmetric 4x4 quadric sum(w * (dot(n, p) + d)^2) over planes (n, d) with weights w, as its
+    // ten distinct entries: the upper triangle of the 3x3 block a, the vector b = sum(w * d * n)
+    // and c = sum(w * d^2)
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c      = 0.0;
+        double weight = 0.0; // sum of the triangle areas, not of the border planes
+
+        static Quadric FromPlane(const double3& n, double d, double w)
+        {
+            Quadric q;
+            q.a00 = w * n.x * n.x;
+            q.a01 = w * n.x * n.y;
+            q.a02 = w * n.x * n.z;
+            q.a11 = w * n.y * n.y;
+            q.a12 = w * n.y * n.z;
+            q.a22 = w * n.z * n.z;
+            q.b0  = w * n.x * d;
+            q.b1  = w * n.y * d;
+            q.b2  = w * n.z * d;
+            q.c   = w * d * d;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& r)
+        {
+            a00 += r.a00;
+            a01 += r.a01;
+            a02 += r.a02;
+            a11 += r.a11;
+            a12 += r.a12;
+            a22 += r.a22;
+            b0 += r.b0;
+            b1 += r.b1;
+            b2 += r.b2;
+            c += r.c;
+            weight += r.weight;
+            return *this;
+        }
+
+        // p^T a p + 2 b^T p + c, never negative
+        double Error(const double3& p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double e = x * (a00 * x + 2.0 * (a01 * y + a02 * z + b0)) + y * (a11 * y + 2.0 * (a12 * z + b1)) + z * (a22 * z + 2.0 * b2) + c;
+            return std::max(e, 0.0);
+        }
+
+        // The position of the smallest error, a p = -b, when a is well conditioned
+        bool Minimum(double3& p) const
+        {
+            // The inverse of the symmetric a is its symmetric adjugate over the determinant
+            const double c00 = a11 * a22 - a12 * a12, c01 = a02 * a12 - a01 * a22, c02 = a01 * a12 - a02 * a11;
+            const double c11 = a00 * a22 - a02 * a02, c12 = a01 * a02 - a00 * a12, c22 = a00 * a11 - a01 * a01;
+            const double det   = a00 * c00 + a01 * c01 + a02 * c02;
+            const double scale = (a00 + a11 + a22) / 3.0;
+            if (!(std::abs(det) > 1e-9 * scale * scale * scale))
+                return false;
+
+            const double inv = -1.0 / det;
+            p.x              = inv * (c00 * b0 + c01 * b1 + c02 * b2);
+            p.y              = inv * (c01 * b0 + c11 * b1 + c12 * b2);
+            p.z              = inv * (c02 * b0 + c12 * b1 + c22 * b2);
+            return std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z);
+        }
+    };
+
+    // The state of a simplification, for stepping through several targets. SimplifyMesh and
+    // BuildLodChain cover the common cases.
+    class MeshSimplifier
+    {
+    public:
+        // colors may be empty. A color change of 1 (colors in [0, 1]) costs as much as moving the
+        // surface by colorWeight, relative to the mesh size like the errors; 0 ignores colors.
+        MeshSimplifier(span<const float3> positions, span<const float4> colors, span<const uint32_t> indices, double colorWeight = 0.01)
+        {
+            assert(indices.size() % 3 == 0);
+            assert(colors.empty() || colors.size() == positions.size());
+
+            const size_t vertexCount   = positions.size();
+            const size_t triangleCount = indices.size() / 3;
+
+            m_positions.resize(vertexCount);
+            double3 boundsMin(DBL_MAX, DBL_MAX, DBL_MAX), boundsMax(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                m_positions[v] = double3(positions[v].x, positions[v].y, positions[v].z);
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    boundsMin[axis] = std::min(boundsMin[axis], m_positions[v][axis]);
+                    boundsMax[axis] = std::max(boundsMax[axis], m_positions[v][axis]);
+                }
+            }
+            m_scale = vertexCount == 0 ? 1.0 : length(boundsMax - boundsMin);
+            if (!(m_scale > 0.0))
+                m_scale = 1.0;
+            m_colors.assign(colors.begin(), colors.end());
+            m_colorWeight = colorWeight * m_scale;
+
+            m_indices.assign(indices.begin(), indices.end());
+            m_dead.assign(triangleCount, 0);
+            m_quadrics.assign(vertexCount, Quadric());
+            m_changed.assign(vertexCount, 0);
+
+            // The triangle planes
+            for (size_t t = 0; t < triangleCount; ++t)
+            {
+                const uint32_t* tri = &m_indices[3 * t];
+                assert(tri[0] < vertexCount && tri[1] < vertexCount && tri[2] < vertexCount);
+                if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+                {
+                    m_dead[t] = 1;
+                    continue;
+                }
+                ++m_live;
+
+                double3      n    = cross(m_positions[tri[1]] - m_positions[tri[0]], m_positions[tri[2]] - m_positions[tri[0]]);
+                const double area = 0.5 * length(n);
+                if (area > 0.0)
+                {
+                    n         = n * (0.5 / area);
+                    Quadric q = Quadric::FromPlane(n, -dot(n, m_positions[tri[0]]), area);
+                    q.weight  = area;
+                    for (int k = 0; k < 3; ++k)
+                        m_quadrics[tri[k]] += q;
+                }
+            }
+
+            // An edge on a single triangle is a border and gets a plane. Counting the triangles of
+            // every neighbor around each vertex finds it from both ends; the triangle where it runs
+            // from the vertex to the next corner adds the plane.
+            BuildCorners();
+            std::vector<uint32_t> uses(vertexCount, 0);
+            for (uint32_t a = 0; a < vertexCount; ++a)
+            {
+                for (uint32_t i = m_begin[a]; i < m_end[a]; ++i)
+                {
+                    const uint32_t t = m_corners[i] / 3, k = m_corners[i] % 3;
+                    ++uses[m_indices[3 * t + (k + 1) % 3]];
+                    ++uses[m_indices[3 * t + (k + 2) % 3]];
+                }
+                for (uint32_t i = m_begin[a]; i < m_end[a]; ++i)
+                {
+                    const uint32_t t = m_corners[i] / 3, k = m_corners[i] % 3;
+                    const uint32_t b = m_indices[3 * t + (k + 1) % 3], c = m_indices[3 * t + (k + 2) % 3];
+                    if (uses[b] != 1)
+                        continue;
+
+                    // The plane through the border edge, perpendicular to the triangle
+                    const double3 edge   = m_positions[b] - m_positions[a];
+                    const double3 normal = cross(edge, m_positions[c] - m_positions[a]);
+                    double3       n      = cross(edge, normal);
+                    const double  len    = length(n);
+                    if (len == 0.0)
+                        continue;
+                    n               = n * (1.0 / len);
+                    const Quadric q = Quadric::FromPlane(n, -dot(n, m_positions[a]), kSimplifyBorderWeight * dot(edge, edge));
+                    m_quadrics[a] += q;
+                    m_quadrics[b] += q;
+                }
+                for (uint32_t i = m_begin[a]; i < m_end[a]; ++i)
+                {
+                    const uint32_t t = m_corners[i] / 3, k = m_corners[i] % 3;
+                    uses[m_indices[3 * t + (k + 1) % 3]] = uses[m_indices[3 * t + (k + 2) % 3]] = 0;
+                }
+            }
+        }
+
+        size_t TriangleCount() const { return m_live; }
+
+        // Largest error of any collapse so far, relative to the mesh size
+        double Error() const { return m_error; }
+
+        // Collapses edges until at most targetTriangles are left or the next collapse would cost
+        // more than maxError. Returns the number of triangles left. Can be called again with lower
+        // targets, which continues where the last call stopped.
+        size_t Collapse(ThreadPool& pool, size_t targetTriangles, double maxError = DBL_MAX)
+        {
+            const float maxKey = maxError >= FLT_MAX ? FLT_MAX : static_cast<float>(maxError * maxError);
+
+            // A fill after which nothing collapses leaves only edges that fail the checks
+            bool collapsed = true;
+            while (m_live > targetTriangles)
+            {
+                if (m_heap.Empty())
+                {
+                    if (!collapsed)
+                        break;
+                    FillHeap(pool);
+                    if (m_heap.Empty())
+                        break;
+                    collapsed = false;
+                }
+
+                const Entry entry = m_heap.Top();
+                if (!Current(entry))
+                {
+                    Refresh(entry);
+                    continue;
+                }
+                if (entry.key > maxKey)
+                    break;
+                m_heap.Pop();
+
+                const Candidate candidate = Evaluate(entry.a, entry.b);
+                if (CanCollapse(entry.a, entry.b, candidate.position))
+                {
+                    Apply(entry.a, entry.b, candidate);
+                    collapsed = true;
+                }
+            }
+            return m_live;
+        }
+
+        size_t Collapse(size_t targetTriangles, double maxError = DBL_MAX) { return Collapse(ThreadPool::Default(), targetTriangles, maxError); }
+
+        // The current mesh, its vertices in the order the triangles first use them
+        SimplifiedMesh Extract() const
+        {
+            SimplifiedMesh        mesh;
+            std::vector<uint32_t> remap(m_positions.size(), kNone);
+            mesh.indices.reserve(3 * m_live);
+            for (size_t t = 0; t < m_dead.size(); ++t)
+            {
+                if (m_dead[t])
+                    continue;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const uint32_t v = m_indices[3 * t + k];
+                    if (remap[v] == kNone)
+                    {
+                        remap[v] = static_cast<uint32_t>(mesh.positions.size());
+                        mesh.positions.emplace_back(static_cast<float>(m_positions[v].x), static_cast<float>(m_positions[v].y),
+                                                    static_cast<float>(m_positions[v].z));
+                        if (!m_colors.empty())
+                            mesh.colors.push_back(m_colors[v]);
+                    }
+                    mesh.indices.push_back(remap[v]);
+                }
+            }
+            mesh.error = m_error;
+            return mesh;
+        }
+
+    private:
+        static constexpr uint32_t kNone = UINT32_MAX;
+
+        // An edge and its cost as of collapse number time. It is out of date when either end
+        // changed after that.
+        struct Entry
+        {
+            float    key; // squared error relative to the mesh size
+            uint32_t a, b;
+            uint32_t time;
+        };
+
+        struct Candidate
+        {
+            double3 position;
+            float4  color;
+            double  key;
+        };
+
+        // Removed vertices count as changed after every entry
+        bool Current(const Entry& entry) const { return m_changed[entry.a] <= entry.time && m_changed[entry.b] <= entry.time; }
+
+        // Evaluates the out of date entry on top again and pushes it back, or drops it when an end
+        // was removed: the collapse gave the kept vertex entries for the edges it took over
+        void Refresh(const Entry& entry)
+        {
+            m_heap.Pop();
+            if (m_changed[entry.a] != kNone && m_changed[entry.b] != kNone)
+                m_heap.Push({static_cast<float>(Evaluate(entry.a, entry.b).key), entry.a, entry.b, m_time});
+        }
+
+        // The corners of the live triangles by vertex, packed, and fresh marks
+        void BuildCorners()
+        {
+            const size_t vertexCount = m_positions.size();
+            m_begin.assign(vertexCount, 0);
+            m_end.assign(vertexCount, 0);
+            for (size_t t = 0; t < m_dead.size(); ++t)
+                if (!m_dead[t])
+                    for (int k = 0; k < 3; ++k)
+                        ++m_end[m_indices[3 * t + k]];
+            uint32_t offset = 0;
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                m_begin[v] = offset;
+                offset += m_end[v];
+                m_end[v] = m_begin[v];
+            }
+
+            m_corners.resize(offset);
+            for (size_t t = 0; t < m_dead.size(); ++t)
+                if (!m_dead[t])
+                    for (uint32_t k = 0; k < 3; ++k)
+                        m_corners[m_end[m_indices[3 * t + k]]++] = static_cast<uint32_t>(3 * t + k);
+
+            m_mark.assign(vertexCount, 0);
+            m_stamp = 0;
+        }
+
+        // Every edge between live vertices once, evaluated on the pool
+        void FillHeap(ThreadPool& pool)
+        {
+            BuildCorners();
+            std::vector<Entry> entries;
+            for (uint32_t v = 0; v < m_positions.size(); ++v)
+            {
+                const uint32_t stamp = ++m_stamp;
+                for (uint32_t i = m_begin[v]; i < m_end[v]; ++i)
+                {
+                    const uint32_t t = m_corners[i] / 3, k = m_corners[i] % 3;
+                    for (uint32_t n : {m_indices[3 * t + (k + 1) % 3], m_indices[3 * t + (k + 2) % 3]})
+                        if (n > v && m_mark[n] != stamp)
+                        {
+                            m_mark[n] = stamp;
+                            entries.push_back({0.f, v, n, m_time});
+                        }
+                }
+            }
+
+            pool.ParallelFor(0, entries.size(), kSimplifyChunkSize, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i)
+                    entries[i].key = static_cast<float>(Evaluate(entries[i].a, entries[i].b).key);
+            });
+            m_heap.Clear();
+            for (const Entry& entry : entries)
+                m_heap.Push(entry);
+        }
+
+        Candidate Evaluate(uint32_t a, uint32_t b) const
+        {
+            Quadric q = m_quadrics[a];
+            q += m_quadrics[b];
+
+            const double3& pa = m_positions[a];
+            const double3& pb = m_positions[b];
+            const double3  edge = pb - pa, mid = pa + edge * 0.5;
+            const double   edgeLength2 = dot(edge, edge);
+
+            // The minimum, unless it is far from the edge, where a nearly flat quadric slides
+            Candidate best;
+            if (q.Minimum(best.position) && dot(best.position - mid, best.position - mid) <= edgeLength2)
+                best.key = q.Error(best.position) + ColorCost(a, b, best.position, best.color);
+            else
+            {
+                best.key = DBL_MAX;
+                for (const double3& p : {pa, pb, mid})
+                {
+                    float4       color;
+                    const double cost = q.Error(p) + ColorCost(a, b, p, color);
+                    if (cost < best.key)
+                        best = {p, color, cost};
+                }
+            }
+
+            const double weight = q.weight > 0.0 ? q.weight : 1.0;
+            best.key            = best.key / (weight * m_scale * m_scale);
+            return best;
+        }
+
+        // The color of the edge at the projection of p, and how much both ends change, weighted by
+        // their area
+        double ColorCost(uint32_t a, uint32_t b, const double3& p, float4& color) const
+        {
+            if (m_colors.empty())
+                return 0.0;
+
+            const double3& pa          = m_positions[a];
+            const double3  edge        = m_positions[b] - pa;
+            const double   edgeLength2 = dot(edge, edge);
+            const double   t           = edgeLength2 > 0.0 ? std::clamp(dot(p - pa, edge) / edgeLength2, 0.0, 1.0) : 0.0;
+            color                      = lerp(m_colors[a], m_colors[b], static_cast<float>(t));
+            const float4 da            = color - m_colors[a];
+            const float4 db            = color - m_colors[b];
+            return m_colorWeight * m_colorWeight * (m_quadrics[a].weight * dot(da, da) + m_quadrics[b].weight * dot(db, db));
+        }
+
+        // Walks the corners of v, which moves to position when the edge to other collapses:
+        // counts the triangles on the edge and the neighbors of v other than other that carry the
+        // mark match, then marks them with stamp. Returns false as soon as a triangle that keeps
+        // its area would turn over.
+        bool VisitCorners(uint32_t v, uint32_t other, const double3& position, uint32_t match, uint32_t stamp, size_t& onEdge, size_t& marked)
+        {
+            onEdge = marked = 0;
+            for (uint32_t i = m_begin[v]; i < m_end[v]; ++i)
+            {
+                const uint32_t t = m_corners[i] / 3;
+                if (m_dead[t])
+                    continue;
+
+                const uint32_t k  = m_corners[i] % 3;
+                const uint32_t n1 = m_indices[3 * t + (k + 1) % 3], n2 = m_indices[3 * t + (k + 2) % 3];
+                for (uint32_t n : {n1, n2})
+                    if (n != other)
+                    {
+                        marked += m_mark[n] == match;
+                        m_mark[n] = stamp;
+                    }
+                if (n1 == other || n2 == other)
+                {
+                    ++onEdge;
+                    continue;
+                }
+
+                const double3& p1     = m_positions[n1];
+                const double3& p2     = m_positions[n2];
+                const double3  before = cross(p1 - m_positions[v], p2 - m_positions[v]);
+                const double3  after  = cross(p1 - position, p2 - position);
+                if (!(dot(before, after) > 0.0))
+                    return false;
+            }
+            return true;
+        }
+
+        // a and b must still share an edge, no triangle may turn over, and the link condition must
+        // hold: the common neighbors of a and b are exactly the opposite vertices of the triangles
+        // on the edge, else the collapse pinches the surface
+        bool CanCollapse(uint32_t a, uint32_t b, const double3& position)
+        {
+            const uint32_t stampA = ++m_stamp, stampB = ++m_stamp;
+            size_t         onEdge, onEdgeB, unused, shared;
+            return VisitCorners(a, b, position, kNone, stampA, onEdge, unused) && onEdge > 0 &&
+                   VisitCorners(b, a, position, stampA, stampB, onEdgeB, shared) && shared == onEdge;
+        }
+
+        // The live corners of a and b go to a new range at the end of m_corners, which becomes
+        // the list of a; the triangles on the edge die. The edges a takes over from b get entries.
+        void Apply(uint32_t a, uint32_t b, const Candidate& candidate)
+        {
+            m_error = std::max(m_error, std::sqrt(candidate.key));
+
+            const uint32_t stamp = ++m_stamp;
+            const uint32_t begin = static_cast<uint32_t>(m_corners.size());
+            for (uint32_t i = m_begin[a]; i < m_end[a]; ++i)
+            {
+                const uint32_t corner = m_corners[i], t = corner / 3;
+                if (m_dead[t])
+                    continue;
+                const uint32_t* tri = &m_indices[3 * t];
+                if (tri[0] == b || tri[1] == b || tri[2] == b)
+                {
+                    m_dead[t] = 1;
+                    --m_live;
+                    continue;
+                }
+                m_mark[tri[0]] = m_mark[tri[1]] = m_mark[tri[2]] = stamp;
+                m_corners.push_back(corner);
+            }
+            const uint32_t takeOver = static_cast<uint32_t>(m_corners.size());
+            for (uint32_t i = m_begin[b]; i < m_end[b]; ++i)
+            {
+                const uint32_t corner = m_corners[i];
+                if (m_dead[corner / 3])
+                    continue;
+                m_indices[corner] = a;
+                m_corners.push_back(corner);
+            }
+            m_begin[a] = begin;
+            m_end[a]   = static_cast<uint32_t>(m_corners.size());
+
+            m_positions[a] = candidate.position;
+            if (!m_colors.empty())
+                m_colors[a] = candidate.color;
+            m_quadrics[a] += m_quadrics[b];
+            m_changed[a] = ++m_time;
+            m_changed[b] = kNone;
+
+            for (uint32_t i = takeOver; i < m_end[a]; ++i)
+            {
+                const uint32_t t = m_corners[i] / 3, k = m_corners[i] % 3;
+                for (uint32_t n : {m_indices[3 * t + (k + 1) % 3], m_indices[3 * t + (k + 2) % 3]})
+                    if (m_mark[n] != stamp)
+                    {
+                        m_mark[n] = stamp;
+                        m_heap.Push({static_cast<float>(Evaluate(a, n).key), a, n, m_time});
+                    }
+            }
+        }
+
+        double                m_scale       = 1.0;
+        double                m_colorWeight = 0.0;
+        double                m_error       = 0.0;
+        size_t                m_live        = 0;
+        uint32_t              m_time        = 0; // collapses so far
+        std::vector<double3>  m_positions;
+        std::vector<float4>   m_colors;
+        std::vector<Quadric>  m_quadrics;
+        std::vector<uint32_t> m_indices;
+        std::vector<uint8_t>  m_dead;    // per triangle
+        std::vector<uint32_t> m_changed; // per vertex, the collapse that last moved it, kNone once it is removed
+
+        // Corners (3 * triangle + k) of vertex v in m_corners from m_begin[v] to m_end[v]. Dead
+        // triangles are skipped; a collapse appends the new list of the kept vertex.
+        std::vector<uint32_t> m_begin;
+        std::vector<uint32_t> m_end;
+        std::vector<uint32_t> m_corners;
+
+        detail::RadixHeap<Entry> m_heap;
+        std::vector<uint32_t> m_mark; // per vertex, the stamp of the last walk that met it
+        uint32_t              m_stamp = 0;
+    };
+
+    // The mesh simplified to at most targetTriangles, or fewer, as long as the error stays within
+    // maxError
+    inline SimplifiedMesh SimplifyMesh(ThreadPool& pool, span<const float3> positions, span<const float4> colors, span<const uint32_t> indices,
+                                       size_t targetTriangles, double maxError = DBL_MAX, double colorWeight = 0.01)
+    {
+        MeshSimplifier simplifier(positions, colors, indices, colorWeight);
+        simplifier.Collapse(pool, targetTriangles, maxError);
+        return simplifier.Extract();
+    }
+
+    inline SimplifiedMesh SimplifyMesh(span<const float3> positions, span<const float4> colors, span<const uint32_t> indices,
+                                       size_t targetTriangles, double maxError = DBL_MAX, double colorWeight = 0.01)
+    {
+        return SimplifyMesh(ThreadPool::Default(), positions, colors, indices, targetTriangles, maxError, colorWeight);
+    }
+
+    // LOD 1 to levels: every level has ratio times the triangles of the one before, until an
+    // error above maxError stops the chain early. A single simplification runs through all
+    // levels, so every level keeps the quadrics of everything collapsed before it. LOD 0, the
+    // source mesh, is not included.
+    inline std::vector<SimplifiedMesh> BuildLodChain(ThreadPool& pool, span<const float3> positions, span<const float4> colors,
+                                                     span<const uint32_t> indices, size_t levels, double ratio = 0.5, double maxError = DBL_MAX,
+                                                     double colorWeight = 0.01)
+    {
+        std::vector<SimplifiedMesh> chain;
+        MeshSimplifier              simplifier(positions, colors, indices, colorWeight);
+        double                      target = static_cast<double>(simplifier.TriangleCount());
+        for (size_t level = 0; level < levels; ++level)
+        {
+            target *= ratio;
+            const size_t before = simplifier.TriangleCount();
+            if (simplifier.Collapse(pool, static_cast<size_t>(target), maxError) == before)
+                break;
+            chain.push_back(simplifier.Extract());
+        }
+        return chain;
+    }
+
+    inline std::vector<SimplifiedMesh> BuildLodChain(span<const float3> positions, span<const float4> colors, span<const uint32_t> indices,
+                                                     size_t levels, double ratio = 0.5, double maxError = DBL_MAX, double colorWeight = 0.01)
+    {
+        return BuildLodChain(ThreadPool::Default(), positions, colors, indices, levels, ratio, maxError, colorWeight);
+    }
+} // namespace math
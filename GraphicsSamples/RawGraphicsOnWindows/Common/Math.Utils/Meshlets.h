@@ -0,0 +1,375 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "BatchTransform.h"
+#include "Frustum.h"
+#include "Math.h"
+#include "Morton.h"
+#include "Simd.h"
+#include "Span.h"
+
+// Meshlets: an indexed triangle list split into small clusters that are culled as a whole, on
+// the CPU here or in a task/mesh shader.
+//
+// BuildMeshlets grows every meshlet from the triangles that share vertices with it, preferring
+// those that add the fewest new vertices and then those closest to its center. A meshlet is full
+// at kMeshletMaxVertices vertices or kMeshletMaxTriangles triangles, the limits that fit the
+// usual mesh shader output (124 triangles keep the 8-bit local indices of a meshlet within 372
+// bytes), or when no neighbouring triangle fits any more. The next meshlet starts on its border,
+// or, when the last one has no unused neighbours, at the next unused triangle in the Morton order
+// of the triangle centroids, so consecutive meshlets are also close in space.
+//
+// Every meshlet gets a bounding sphere and a cone that contains the normals of its triangles
+// (after Arseny Kapoulkine's meshoptimizer). CullMeshlets tests simd::kWidth meshlets at once
+// in view space: a meshlet is culled when its sphere is outside the frustum, or when the camera
+// sees all of its triangles from behind. Both tests are conservative. Front faces are
+// counter-clockwise, as in MeshOptimize.h: cross(b - a, c - a) points out of the mesh.
+
+namespace math
+{
+    constexpr uint32_t kMeshletMaxVertices  = 64;
+    constexpr uint32_t kMeshletMaxTriangles = 124;
+
+    struct Meshlet
+    {
+        uint32_t vertexOffset   = 0; // into MeshletBuffers::vertices
+        uint32_t triangleOffset = 0; // into MeshletBuffers::triangles, in local index triples
+        uint32_t vertexCount    = 0;
+        uint32_t triangleCount  = 0;
+    };
+
+    // The meshlet is backfacing for every camera position p outside the sphere with
+    // dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius. coneCutoff is the
+    // sine of the largest angle between the axis and a triangle normal; a cutoff of 1 means the
+    // normals spread over a half space or more and the meshlet is never backfacing.
+    struct MeshletBounds
+    {
+        float3 center;
+        float  radius = 0.f;
+        float3 coneAxis;
+        float  coneCutoff = 1.f;
+    };
+
+    struct MeshletBuffers
+    {
+        std::vector<Meshlet>       meshlets;
+        std::vector<uint32_t>      vertices;  // mesh vertex indices, vertexCount per meshlet
+        std::vector<uint8_t>       triangles; // indices into the meshlet vertices, three per triangle
+        std::vector<MeshletBounds> bounds;    // one per meshlet
+    };
+
+    // MeshletBounds as structure of arrays, the input of CullMeshlets
+    struct MeshletCullData
+    {
+        std::vector<float> centerX, centerY, centerZ, radius;
+        std::vector<float> axisX, axisY, axisZ, cutoff;
+
+        MeshletCullData() = default;
+        explicit MeshletCullData(span<const MeshletBounds> bounds)
+        {
+            const size_t count = bounds.size();
+            for (std::vector<float>* stream : {&centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff})
+                stream->resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                centerX[i] = bounds[i].center.x;
+                centerY[i] = bounds[i].center.y;
+                centerZ[i] = bounds[i].center.z;
+                radius[i]  = bounds[i].radius;
+                axisX[i]   = bounds[i].coneAxis.x;
+                axisY[i]   = bounds[i].coneAxis.y;
+                axisZ[i]   = bounds[i].coneAxis.z;
+                cutoff[i]  = bounds[i].coneCutoff;
+            }
+        }
+
+        size_t size() const { return centerX.size(); }
+    };
+
+    namespace detail
+    {
+        // Sphere around the center of the bounding box of the vertices
+        inline void MeshletSphere(span<const float3> positions, span<const uint32_t> vertices, MeshletBounds& bounds)
+        {
+            float3 boxMin(FLT_MAX, FLT_MAX, FLT_MAX), boxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (uint32_t v : vertices)
+            {
+                const float3& p = positions[v];
+                boxMin          = float3(std::min(boxMin.x, p.x), std::min(boxMin.y, p.y), std::min(boxMin.z, p.z));
+                boxMax          = float3(std::max(boxMax.x, p.x), std::max(boxMax.y, p.y), std::max(boxMax.z, p.z));
+            }
+
+            const float3 center = (boxMin + boxMax) * 0.5f;
+            float        radius = 0.f;
+            for (uint32_t v : vertices)
+                radius = std::max(radius, length(positions[v] - center));
+
+            bounds.center = center;
+            bounds.radius = radius;
+        }
+
+        // Axis along the sum of the unit normals, cutoff from the normal farthest from it.
+        // Degenerate triangles have no normal and do not count.
+        inline void MeshletCone(span<const float3> positions, span<const uint32_t> vertices, span<const uint8_t> triangles,
+                                MeshletBounds& bounds)
+        {
+            const size_t        count = triangles.size() / 3;
+            std::vector<float3> normals;
+            normals.reserve(count);
+
+            float3 sum;
+            for (size_t t = 0; t < count; ++t)
+            {
+                const float3& a = positions[vertices[triangles[3 * t + 0]]];
+                const float3& b = positions[vertices[triangles[3 * t + 1]]];
+                const float3& c = positions[vertices[triangles[3 * t + 2]]];
+                const float3  n = cross(b - a, c - a);
+                const float   l = length(n);
+                if (l > 0.f)
+                {
+                    normals.push_back(n / l);
+                    sum = sum + normals.back();
+                }
+            }
+
+            bounds.coneAxis   = float3();
+            bounds.coneCutoff = 1.f;
+            const float sumLength = length(sum);
+            if (normals.empty() || sumLength <= 1e-6f * static_cast<float>(normals.size()))
+                return;
+
+            const float3 axis   = sum / sumLength;
+            float        minDot = 1.f;
+            for (const float3& n : normals)
+                minDot = std::min(minDot, dot(axis, n));
+
+            bounds.coneAxis = axis;
+            if (minDot > 0.f)
+                bounds.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        }
+    } // namespace detail
+
+    // Bounding sphere and normal cone of one meshlet
+    inline MeshletBounds ComputeMeshletBounds(span<const float3> positions, const MeshletBuffers& buffers, const Meshlet& meshlet)
+    {
+        const span<const uint32_t> vertices(buffers.vertices.data() + meshlet.vertexOffset, meshlet.vertexCount);
+        const span<const uint8_t>  triangles(buffers.triangles.data() + 3 * size_t(meshlet.triangleOffset), 3 * size_t(meshlet.triangleCount));
+
+        MeshletBounds bounds;
+        detail::MeshletSphere(positions, vertices, bounds);
+        detail::MeshletCone(positions, vertices, triangles, bounds);
+        return bounds;
+    }
+
+    // Splits the triangle list into meshlets of at most maxVertices vertices and maxTriangles
+    // triangles and computes their bounds. Every triangle ends up in exactly one meshlet, with
+    // its winding kept.
+    inline MeshletBuffers BuildMeshlets(span<const uint32_t> indices, span<const float3> positions,
+                                        uint32_t maxVertices = kMeshletMaxVertices, uint32_t maxTriangles = kMeshletMaxTriangles)
+    {
+        assert(indices.size() % 3 == 0);
+        assert(maxVertices >= 3 && maxVertices < 256 && maxTriangles >= 1);
+
+        const size_t triangleCount = indices.size() / 3;
+        const size_t vertexCount   = positions.size();
+
+        MeshletBuffers out;
+        if (triangleCount == 0)
+            return out;
+
+        // Morton order of the centroids
+        std::vector<float3> centroids(triangleCount);
+        float3              boxMin(FLT_MAX, FLT_MAX, FLT_MAX), boxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            const float3 c = (positions[indices[3 * t]] + positions[indices[3 * t + 1]] + positions[indices[3 * t + 2]]) * (1.f / 3.f);
+            centroids[t]   = c;
+            boxMin         = float3(std::min(boxMin.x, c.x), std::min(boxMin.y, c.y), std::min(boxMin.z, c.z));
+            boxMax         = float3(std::max(boxMax.x, c.x), std::max(boxMax.y, c.y), std::max(boxMax.z, c.z));
+        }
+        std::vector<uint32_t> codes(triangleCount);
+        MortonEncode3D32(centroids, boxMin, boxMax, codes);
+
+        std::vector<uint32_t> order(triangleCount);
+        for (size_t t = 0; t < triangleCount; ++t)
+            order[t] = static_cast<uint32_t>(t);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return codes[a] != codes[b] ? codes[a] < codes[b] : a < b;
+        });
+
+        // Triangles around every vertex
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for (uint32_t v : indices)
+            ++adjacencyOffset[v + 1];
+        for (size_t v = 0; v < vertexCount; ++v)
+            adjacencyOffset[v + 1] += adjacencyOffset[v];
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> cursor(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i)
+                adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        constexpr uint8_t     kNotInMeshlet = 0xFF;
+        std::vector<uint8_t>  local(vertexCount, kNotInMeshlet); // index in the current meshlet
+        std::vector<bool>     emitted(triangleCount, false);
+        std::vector<uint32_t> live(vertexCount);  // triangles around the vertex not emitted yet
+        std::vector<uint32_t> candidates;         // triangles around the vertices of the current meshlet, may repeat
+        Meshlet               meshlet;
+        float3                centroidSum;
+        size_t                next = 0; // into order
+        for (size_t v = 0; v < vertexCount; ++v)
+            live[v] = adjacencyOffset[v + 1] - adjacencyOffset[v];
+
+        auto newVertices = [&](uint32_t t) {
+            return uint32_t(local[indices[3 * t]] == kNotInMeshlet) + uint32_t(local[indices[3 * t + 1]] == kNotInMeshlet) +
+                   uint32_t(local[indices[3 * t + 2]] == kNotInMeshlet);
+        };
+        auto liveAround = [&](uint32_t t) { return live[indices[3 * t]] + live[indices[3 * t + 1]] + live[indices[3 * t + 2]]; };
+
+        auto finish = [&] {
+            if (meshlet.triangleCount == 0)
+                return;
+            for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+                local[out.vertices[meshlet.vertexOffset + i]] = kNotInMeshlet;
+            out.meshlets.push_back(meshlet);
+            meshlet.vertexOffset   = static_cast<uint32_t>(out.vertices.size());
+            meshlet.triangleOffset = static_cast<uint32_t>(out.triangles.size() / 3);
+            meshlet.vertexCount    = 0;
+            meshlet.triangleCount  = 0;
+            centroidSum            = float3();
+        };
+
+        auto add = [&](uint32_t t) {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t v = indices[3 * t + corner];
+                if (local[v] == kNotInMeshlet)
+                {
+                    local[v] = static_cast<uint8_t>(meshlet.vertexCount++);
+                    out.vertices.push_back(v);
+                    candidates.insert(candidates.end(), adjacency.begin() + adjacencyOffset[v], adjacency.begin() + adjacencyOffset[v + 1]);
+                }
+                out.triangles.push_back(local[v]);
+                --live[v];
+            }
+            emitted[t] = true;
+            ++meshlet.triangleCount;
+            centroidSum = centroidSum + centroids[t];
+        };
+
+        // The next meshlet starts on the border of the last one at the triangle with the fewest
+        // unused neighbours, so that no small islands are left behind, or in Morton order
+        auto seed = [&] {
+            uint32_t best = UINT32_MAX, fewest = UINT32_MAX;
+            for (uint32_t t : candidates)
+            {
+                if (!emitted[t] && liveAround(t) < fewest)
+                {
+                    best   = t;
+                    fewest = liveAround(t);
+                }
+            }
+            candidates.clear();
+            if (best != UINT32_MAX)
+                return best;
+            while (emitted[order[next]])
+                ++next;
+            return order[next];
+        };
+
+        for (size_t done = 0; done < triangleCount; ++done)
+        {
+            // Best neighbour: fewest new vertices, then closest to the meshlet center, where
+            // triangles with fewer unused neighbours count as closer so that the meshlet fills in
+            // corners instead of leaving them to small meshlets. When none fits the meshlet is
+            // done; it never joins a distant piece.
+            uint32_t best = UINT32_MAX;
+            if (meshlet.triangleCount > 0)
+            {
+                uint32_t     bestNew   = 4;
+                float        bestDist  = FLT_MAX;
+                const float3 center    = centroidSum * (1.f / static_cast<float>(meshlet.triangleCount));
+                size_t       remaining = 0;
+                for (uint32_t t : candidates)
+                {
+                    if (emitted[t])
+                        continue;
+                    candidates[remaining++] = t;
+
+                    const uint32_t added = newVertices(t);
+                    if (meshlet.vertexCount + added > maxVertices || added > bestNew)
+                        continue;
+                    const float3 d    = centroids[t] - center;
+                    const float  dist = dot(d, d) * static_cast<float>(1 + liveAround(t));
+                    if (added < bestNew || dist < bestDist)
+                    {
+                        best     = t;
+                        bestNew  = added;
+                        bestDist = dist;
+                    }
+                }
+                candidates.resize(remaining);
+                if (best == UINT32_MAX)
+                    finish();
+            }
+            if (meshlet.triangleCount == 0)
+                best = seed();
+
+            add(best);
+            if (meshlet.triangleCount == maxTriangles)
+                finish();
+        }
+        finish();
+
+        out.bounds.reserve(out.meshlets.size());
+        for (const Meshlet& m : out.meshlets)
+            out.bounds.push_back(ComputeMeshletBounds(positions, out, m));
+        return out;
+    }
+
+    // view maps world to view space and must be rigid, e.g. float4x4::Translation(-eye) *
+    // float4x4::ViewFromBasis(x, y, z) with an orthonormal basis; viewFrustum is
+    // Frustum::FromMatrix(projection, isGL), in view space. One meshlet at a time.
+    inline bool IsMeshletVisible(const MeshletBounds& bounds, const float4x4& view, const Frustum& viewFrustum)
+    {
+        const float3 center = detail::TransformPointScalar(view, bounds.center, false);
+        if (!viewFrustum.Intersects(center, bounds.radius))
+            return false;
+
+        const float3& a = bounds.coneAxis;
+        const float3  axis(a.x * view[0][0] + a.y * view[1][0] + a.z * view[2][0],
+                           a.x * view[0][1] + a.y * view[1][1] + a.z * view[2][1],
+                           a.x * view[0][2] + a.y * view[1][2] + a.z * view[2][2]);
+        return dot(center, axis) < bounds.coneCutoff * length(center) + bounds.radius;
+    }
+
+    // Writes the indices of the visible meshlets to visible, which needs room for one per
+    // meshlet, in increasing order and returns their number. Same arguments and results as
+    // IsMeshletVisible; the centers and axes are moved to view space on simd::kWidth lanes,
+    // where the camera is at the origin.
+    inline size_t CullMeshlets(const MeshletCullData& data, const float4x4& view, const Frustum& viewFrustum, span<uint32_t> visible)
+    {
+        const detail::WideMatrix4x4 wideView(view);
+        const detail::WideFrustum   wideFrustum(viewFrustum);
+        const span<const float>     streams[] = {data.centerX, data.centerY, data.centerZ, data.radius,
+                                                 data.axisX, data.axisY, data.axisZ, data.cutoff};
+        return detail::CullBatch(streams, visible, [&](const simd::vfloat* v) {
+            using simd::madd;
+            simd::vfloat x = v[0], y = v[1], z = v[2];
+            simd::vfloat ax = v[4], ay = v[5], az = v[6];
+            wideView.TransformPoint(x, y, z, false);
+            wideView.TransformVector(ax, ay, az);
+
+            const simd::vfloat distance = simd::sqrt(madd(x, x, madd(y, y, z * z)));
+            const simd::vmask  front    = madd(x, ax, madd(y, ay, z * az)) < madd(v[7], distance, v[3]);
+            return wideFrustum.Spheres(x, y, z, v[3]) & front;
+        });
+    }
+} // namespace math
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "Morton.h"
+#include "Span.h"
+
+// Linear octree over a point cloud: the points sorted by their 30-bit Morton code.
+//
+// Every octree node is a contiguous range of the sorted codes, so the tree itself is never stored.
+// Queries walk it top down, find the children ranges by binary search and skip whole subtrees
+// that are outside the query. Building is one pass for the bounds, one for the codes and three
+// radix sort passes.
+
+namespace math
+{
+    // Sorts (key, value) pairs by key, stable. Three passes of 11 bits, passes in which all keys
+    // share the digit are skipped.
+    inline void RadixSort(span<uint32_t> keys, span<uint32_t> values)
+    {
+        assert(keys.size() == values.size());
+
+        constexpr uint32_t kDigitBits = 11;
+        constexpr uint32_t kBuckets   = 1u << kDigitBits;
+        constexpr uint32_t kPasses    = 3;
+
+        const size_t count = keys.size();
+
+        std::vector<uint32_t> histogram(kPasses * kBuckets, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t key = keys[i];
+            for (uint32_t pass = 0; pass < kPasses; ++pass)
+                ++histogram[pass * kBuckets + ((key >> (pass * kDigitBits)) & (kBuckets - 1))];
+        }
+
+        std::vector<uint32_t> keysTmp(count), valuesTmp(count);
+        uint32_t*             srcKeys   = keys.data();
+        uint32_t*             srcValues = values.data();
+        uint32_t*             dstKeys   = keysTmp.data();
+        uint32_t*             dstValues = valuesTmp.data();
+
+        for (uint32_t pass = 0; pass < kPasses; ++pass)
+        {
+            uint32_t* offsets = histogram.data() + pass * kBuckets;
+            if (count == 0 || offsets[(srcKeys[0] >> (pass * kDigitBits)) & (kBuckets - 1)] == count)
+                continue;
+
+            uint32_t sum = 0;
+            for (uint32_t b = 0; b < kBuckets; ++b)
+            {
+                const uint32_t n = offsets[b];
+                offsets[b]       = sum;
+                sum += n;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const uint32_t dst = offsets[(srcKeys[i] >> (pass * kDigitBits)) & (kBuckets - 1)]++;
+                dstKeys[dst]       = srcKeys[i];
+                dstValues[dst]     = srcValues[i];
+            }
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcValues, dstValues);
+        }
+
+        if (srcKeys != keys.data())
+        {
+            std::copy(srcKeys, srcKeys + count, keys.data());
+            std::copy(srcValues, srcValues + count, values.data());
+        }
+    }
+
+
+    namespace detail
+    {
+        // std::lower_bound without the data dependent branches, which mispredict about half the
+        // time in a binary search
+        inline size_t LowerBound(const uint32_t* keys, size_t begin, size_t end, uint32_t key)
+        {
+            const uint32_t* base = keys + begin;
+            size_t          n    = end - begin;
+            while (n > 1)
+            {
+                const size_t half = n / 2;
+                base              = base[half] < key ? base + half : base;
+                n -= half;
+            }
+            return static_cast<size_t>(base - keys) + (n == 1 && *base < key);
+        }
+    } // namespace detail
+
+
+    // Spatial index over a float3 point cloud.
+    // Results are indices into the span passed to Build. The index keeps its own copy of the points.
+    class MortonIndex
+    {
+    public:
+        static constexpr uint32_t kBits     = 10;   // per axis, 1024^3 cells
+        static constexpr size_t   kLeafSize = 16;   // nodes with fewer points are scanned directly
+
+        static constexpr uint32_t kMaxTableLevel = 6;  // 2^18 node starts, 1 MB
+
+        MortonIndex() = default;
+        explicit MortonIndex(span<const float3> points) { Build(points); }
+
+        void Build(span<const float3> points)
+        {
+            assert(points.size() < UINT32_MAX);
+            const size_t count = points.size();
+
+            m_boxMin = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+            m_boxMax = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const float3& p : points)
+            {
+                m_boxMin = min(m_boxMin, p);
+                m_boxMax = max(m_boxMax, p);
+            }
+            if (count == 0)
+                m_boxMin = m_boxMax = float3(0, 0, 0);
+
+            m_quantizer = detail::MortonQuantizer(m_boxMin, m_boxMax, kBits);
+
+            m_codes.resize(count);
+            m_order.resize(count);
+            MortonEncode3D32(points, m_boxMin, m_boxMax, m_codes);
+            for (size_t i = 0; i < count; ++i)
+                m_order[i] = static_cast<uint32_t>(i);
+            RadixSort(m_codes, m_order);
+
+            m_points.resize(count);
+            for (size_t i = 0; i < count; ++i)
+                m_points[i] = points[m_order[i]];
+
+            // Start of every node at the table level, about one node per kLeafSize points. Ranges down
+            // to that level are looked up, deeper ones binary searched within the node.
+            m_tableLevel = 1;
+            while (m_tableLevel < kMaxTableLevel && (size_t(1) << (3 * m_tableLevel)) * kLeafSize < count)
+                ++m_tableLevel;
+
+            const uint32_t nodes = 1u << (3 * m_tableLevel);
+            const uint32_t shift = Shift(m_tableLevel);
+            m_tableStart.resize(nodes + 1);
+            size_t i = 0;
+            for (uint32_t node = 0; node < nodes; ++node)
+            {
+                m_tableStart[node] = static_cast<uint32_t>(i);
+                while (i < count && (m_codes[i] >> shift) == node)
+                    ++i;
+            }
+            m_tableStart[nodes] = static_cast<uint32_t>(count);
+
+            // Points on a cell border may round outside of the cell bounds computed in DistanceSq().
+            // The nearest neighbour search widens the bounds by this much so it never prunes them.
+            const float3 magnitude = max(abs(m_boxMin), abs(m_boxMax));
+            m_cellSlack            = 8.f * FLT_EPSILON * std::max(magnitude.x, std::max(magnitude.y, magnitude.z));
+        }
+
+        size_t Size() const { return m_points.size(); }
+
+        // Points in Morton order and the index of each in the span passed to Build
+        span<const float3>   Points() const { return m_points; }
+        span<const uint32_t> Order() const { return m_order; }
+
+        // Calls visit(index, point) for every point with boxMin <= point <= boxMax
+        template <typename Visitor>
+        void ForEachInBox(const float3& boxMin, const float3& boxMax, Visitor&& visit) const
+        {
+            if (m_points.empty())
+                return;
+
+            // Quantization is monotonic, so a point inside the box has its cell inside [lo, hi] and every
+            // point of a cell strictly between lo and hi is inside the box. Where the query covers the
+            // whole cloud on an axis, the bounds move out by one so the border cells count as covered.
+
+            CellBox query;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                query.lo[axis] = boxMin[axis] <= m_boxMin[axis] ? -1 : static_cast<int32_t>(m_quantizer.Cell(boxMin[axis], axis));
+                query.hi[axis] = boxMax[axis] >= m_boxMax[axis] ? static_cast<int32_t>(1u << kBits)
+                                                                : static_cast<int32_t>(m_quantizer.Cell(boxMax[axis], axis));
+            }
+
+            const CellBox root = NodeCells(0, 0);
+            if (Overlaps(root, query))
+                VisitBox(0, 0, root, 0, m_codes.size(), query, boxMin, boxMax, visit);
+        }
+
+        // Appends the indices of the points inside [boxMin, boxMax] to result, in Morton order
+        void QueryBox(const float3& boxMin, const float3& boxMax, std::vector<uint32_t>& result) const
+        {
+            ForEachInBox(boxMin, boxMax, [&result](uint32_t index, const float3&) { result.push_back(index); });
+        }
+
+        // Replaces result with the indices of the k points nearest to point, closest first
+        void QueryNearest(const float3& point, size_t k, std::vector<uint32_t>& result) const
+        {
+            result.clear();
+            k = std::min(k, m_points.size());
+            if (k == 0)
+                return;
+
+            NearestSearch search{point, k, {}};
+            search.heap.reserve(k);
+            VisitNearest(0, 0, 0, m_codes.size(), search);
+
+            std::sort_heap(search.heap.begin(), search.heap.end());
+            result.reserve(k);
+            for (const Neighbour& n : search.heap)
+                result.push_back(m_order[n.slot]);
+        }
+
+    private:
+        struct CellBox
+        {
+            int32_t lo[3];
+            int32_t hi[3];
+        };
+
+        struct Neighbour
+        {
+            float    distSq;
+            uint32_t slot;
+
+            bool operator<(const Neighbour& other) const { return distSq < other.distSq; }
+        };
+
+        struct NearestSearch
+        {
+            float3                 point;
+            size_t                 k;
+            std::vector<Neighbour> heap; // max-heap of the best k found so far
+
+            float Worst() const { return heap.size() < k ? FLT_MAX : heap.front().distSq; }
+
+            void Offer(float distSq, uint32_t slot)
+            {
+                if (heap.size() < k)
+                {
+                    heap.push_back({distSq, slot});
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                else if (distSq < heap.front().distSq)
+                {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = {distSq, slot};
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        };
+
+        // The node at `level` with Morton prefix `prefix` holds the codes [prefix << shift, (prefix + 1) << shift)
+        static uint32_t Shift(uint32_t level) { return 3 * (kBits - level); }
+
+        CellBox NodeCells(uint32_t level, uint32_t prefix) const
+        {
+            const uint3    corner = MortonDecode3D32(prefix << Shift(level));
+            const uint32_t size   = 1u << (kBits - level);
+
+            CellBox box;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                box.lo[axis] = static_cast<int32_t>(corner[axis]);
+                box.hi[axis] = static_cast<int32_t>(corner[axis] + size - 1);
+            }
+            return box;
+        }
+
+        static bool Overlaps(const CellBox& a, const CellBox& b)
+        {
+            return a.lo[0] <= b.hi[0] && a.hi[0] >= b.lo[0] && a.lo[1] <= b.hi[1] && a.hi[1] >= b.lo[1] && a.lo[2] <= b.hi[2] && a.hi[2] >= b.lo[2];
+        }
+
+        // Range of the node at `level` with Morton prefix `prefix`, which starts at or after `from` and ends
+        // at or before `to`
+        void ChildRange(uint32_t level, uint32_t prefix, size_t from, size_t to, size_t& begin, size_t& end) const
+        {
+            if (level <= m_tableLevel)
+            {
+                const uint32_t shift = 3 * (m_tableLevel - level);
+                begin                = m_tableStart[prefix << shift];
+                end                  = m_tableStart[(prefix + 1) << shift];
+                return;
+            }
+
+            begin = detail::LowerBound(m_codes.data(), from, to, prefix << Shift(level));
+            end   = (prefix & 7u) == 7u ? to : detail::LowerBound(m_codes.data(), begin, to, (prefix + 1) << Shift(level));
+        }
+
+        // Splits the sorted range [begin, end) of a node into its 8 children
+        void SplitNode(uint32_t level, uint32_t prefix, size_t begin, size_t end, size_t bounds[9]) const
+        {
+            bounds[0] = begin;
+            for (uint32_t child = 0; child < 8; ++child)
+            {
+                size_t childBegin;
+                ChildRange(level + 1, (prefix << 3u) | child, bounds[child], end, childBegin, bounds[child + 1]);
+            }
+        }
+
+        // `node` holds the cells of the node, which must overlap the query
+        template <typename Visitor>
+        void VisitBox(uint32_t level, uint32_t prefix, const CellBox& node, size_t begin, size_t end, const CellBox& query,
+                      const float3& boxMin, const float3& boxMax, Visitor& visit) const
+        {
+            bool inside = true;
+            for (int axis = 0; axis < 3; ++axis)
+                inside &= node.lo[axis] > query.lo[axis] && node.hi[axis] < query.hi[axis];
+
+            if (inside)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    visit(m_order[i], m_points[i]);
+                return;
+            }
+
+            if (end - begin <= kLeafSize || level == kBits)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float3& p = m_points[i];
+                    if (p.x >= boxMin.x && p.x <= boxMax.x && p.y >= boxMin.y && p.y <= boxMax.y && p.z >= boxMin.z && p.z <= boxMax.z)
+                        visit(m_order[i], p);
+                }
+                return;
+            }
+
+            // Bit `axis` of a child index selects the upper half on that axis. Per axis, the query
+            // rules out the children of one half or of none.
+            constexpr uint32_t kUpper[3] = {0xAA, 0xCC, 0xF0};
+
+            const int32_t half     = (node.hi[0] - node.lo[0] + 1) / 2;
+            uint32_t      children = 0xFF;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const int32_t mid = node.lo[axis] + half;
+                children &= (query.lo[axis] < mid ? ~kUpper[axis] : 0u) | (query.hi[axis] >= mid ? kUpper[axis] : 0u);
+            }
+
+            size_t childBegin = begin;
+            for (uint32_t child = 0; child < 8; ++child)
+            {
+                if (!(children & (1u << child)))
+                    continue;
+
+                const uint32_t childPrefix = (prefix << 3u) | child;
+                size_t         childEnd;
+                ChildRange(level + 1, childPrefix, childBegin, end, childBegin, childEnd);
+                if (childBegin != childEnd)
+                {
+                    CellBox childCells;
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        childCells.lo[axis] = node.lo[axis] + (child & (1u << axis) ? half : 0);
+                        childCells.hi[axis] = childCells.lo[axis] + half - 1;
+                    }
+                    VisitBox(level + 1, childPrefix, childCells, childBegin, childEnd, query, boxMin, boxMax, visit);
+                }
+                childBegin = childEnd;
+            }
+        }
+
+        // Squared distance from point to the world space bounds of a node, widened by m_cellSlack
+        float DistanceSq(const CellBox& cells, const float3& point) const
+        {
+            const float3 extent = m_boxMax - m_boxMin;
+            const float  scale  = 1.f / static_cast<float>(1u << kBits);
+
+            float distSq = 0.f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float lo = m_boxMin[axis] + extent[axis] * (static_cast<float>(cells.lo[axis]) * scale) - m_cellSlack;
+                const float hi = m_boxMin[axis] + extent[axis] * (static_cast<float>(cells.hi[axis] + 1) * scale) + m_cellSlack;
+                const float d  = point[axis] < lo ? lo - point[axis] : point[axis] > hi ? point[axis] - hi : 0.f;
+                distSq += d * d;
+            }
+            return distSq;
+        }
+
+        void VisitNearest(uint32_t level, uint32_t prefix, size_t begin, size_t end, NearestSearch& search) const
+        {
+            if (end - begin <= kLeafSize || level == kBits)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float3 d = m_points[i] - search.point;
+                    search.Offer(dot(d, d), static_cast<uint32_t>(i));
+                }
+                return;
+            }
+
+            size_t bounds[9];
+            SplitNode(level, prefix, begin, end, bounds);
+
+            // Nearest child first, so the k-th distance shrinks early and prunes the rest
+            struct Child
+            {
+                float    distSq;
+                uint32_t index;
+            };
+            Child    children[8];
+            uint32_t childCount = 0;
+            for (uint32_t child = 0; child < 8; ++child)
+            {
+                if (bounds[child] == bounds[child + 1])
+                    continue;
+                const uint32_t childPrefix = (prefix << 3u) | child;
+                children[childCount++]     = {DistanceSq(NodeCells(level + 1, childPrefix), search.point), child};
+            }
+            for (uint32_t c = 1; c < childCount; ++c)
+            {
+                const Child item = children[c];
+                uint32_t    j    = c;
+                for (; j > 0 && children[j - 1].distSq > item.distSq; --j)
+                    children[j] = children[j - 1];
+                children[j] = item;
+            }
+
+            for (uint32_t c = 0; c < childCount; ++c)
+            {
+                if (children[c].distSq > search.Worst())
+                    break;
+                const uint32_t child = children[c].index;
+                VisitNearest(level + 1, (prefix << 3u) | child, bounds[child], bounds[child + 1], search);
+            }
+        }
+
+        float3                  m_boxMin     = float3(0, 0, 0);
+        float3                  m_boxMax     = float3(0, 0, 0);
+        float                   m_cellSlack  = 0.f;
+        detail::MortonQuantizer m_quantizer  = detail::MortonQuantizer(float3(0, 0, 0), float3(0, 0, 0), kBits);
+        uint32_t                m_tableLevel = 1;
+        std::vector<uint32_t>   m_codes;
+        std::vector<uint32_t>   m_order;
+        std::vector<float3>     m_points;
+        std::vector<uint32_t>   m_tableStart;
+    };
+} // namespace math
@@ -0,0 +1,528 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "Math.h"
+#include "Span.h"
+
+// Exact geometric predicates after J. R. Shewchuk, "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates" (https://www.cs.cmu.edu/~quake/robust.html).
+//
+//   Orient2D(a, b, c)      > 0 if a, b, c are counterclockwise, < 0 if clockwise, 0 if collinear
+//   Orient3D(a, b, c, d)   > 0 if d is below the plane of a, b, c, which are counterclockwise seen
+//                          from above; < 0 if above, 0 if coplanar
+//   InCircle(a, b, c, d)   > 0 if d is inside the circle through the counterclockwise a, b, c,
+//                          < 0 if outside, 0 if on it
+//
+// The sign of the result is always exact, the magnitude is an approximation of the determinant.
+// The determinant is first computed in double with Shewchuk's forward error bound, which decides
+// all but nearly degenerate inputs. Those are evaluated exactly with floating-point expansions:
+// first on the differences of the coordinates, which are usually exact, and only if they are not
+// on the differences split into two doubles each. Shewchuk's intermediate stages B and C, which
+// refine the approximation before going exact, are not implemented.
+//
+// Inputs can be float, double or int32 vectors, all of which convert to double exactly. The
+// error bounds assume double arithmetic with round to nearest and no overflow or underflow:
+// coordinates should stay within about 1e50 of each other and away from denormals, and the code
+// must not be built with -ffast-math or /fp:fast. FMA contraction is harmless: the products of
+// the exact stages use std::fma when FMA is available and Dekker's split, which is only exact
+// without contraction, otherwise.
+
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#   define MATH_PREDICATES_FMA 1
+#endif
+
+namespace math
+{
+    namespace detail
+    {
+        constexpr double kPredicateEpsilon = 1.1102230246251565e-16; // 2^-53, half an ulp of 1
+        constexpr double kOrient2DErrorBound = (3.0 + 16.0 * kPredicateEpsilon) * kPredicateEpsilon;
+        constexpr double kOrient3DErrorBound = (7.0 + 56.0 * kPredicateEpsilon) * kPredicateEpsilon;
+        constexpr double kInCircleErrorBound = (10.0 + 96.0 * kPredicateEpsilon) * kPredicateEpsilon;
+
+        template <class T>
+        constexpr bool kExactInDouble = std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, int32_t>;
+
+        // x + y == a + b exactly, x = fl(a + b)
+        inline void TwoSum(double a, double b, double& x, double& y)
+        {
+            x                  = a + b;
+            const double bVirt = x - a;
+            const double aVirt = x - bVirt;
+            y                  = (a - aVirt) + (b - bVirt);
+        }
+
+        // The same for |a| >= |b|
+        inline void FastTwoSum(double a, double b, double& x, double& y)
+        {
+            x = a + b;
+            y = b - (x - a);
+        }
+
+        // x + y == a - b exactly, x = fl(a - b)
+        inline void TwoDiff(double a, double b, double& x, double& y)
+        {
+            x                  = a - b;
+            const double bVirt = a - x;
+            const double aVirt = x + bVirt;
+            y                  = (a - aVirt) + (bVirt - b);
+        }
+
+        // x + y == a * b exactly, x = fl(a * b)
+        inline void TwoProduct(double a, double b, double& x, double& y)
+        {
+            x = a * b;
+#if defined(MATH_PREDICATES_FMA)
+            y = std::fma(a, b, -x);
+#else
+            // Dekker: a and b split into 26 bit halves, whose products are exact
+            constexpr double kSplitter = 134217729.0; // 2^27 + 1
+            const double     ca = kSplitter * a, cb = kSplitter * b;
+            const double     aHi = ca - (ca - a), aLo = a - aHi;
+            const double     bHi = cb - (cb - b), bLo = b - bHi;
+            y = aLo * bLo - (((x - aHi * bHi) - aLo * bHi) - aHi * bLo);
+#endif
+        }
+
+        // A nonoverlapping expansion: the exact sum of its components, stored in increasing
+        // order of magnitude, without zeros unless the value is zero. The last component
+        // approximates the value and has its sign.
+        template <int N>
+        struct Expansion
+        {
+            double c[N];
+            int    size = 0;
+
+            double Estimate() const { return c[size - 1]; }
+        };
+
+        // h = e + f, h needs room for elen + flen components (Shewchuk's
+        // fast_expansion_sum_zeroelim)
+        inline int ExpansionSum(const double* e, int elen, const double* f, int flen, double* h)
+        {
+            int    ei = 0, fi = 0, hi = 0;
+            double q, sum, error;
+
+            auto nextE = [&] { return ++ei < elen ? e[ei] : 0.0; };
+            auto nextF = [&] { return ++fi < flen ? f[fi] : 0.0; };
+
+            double eNow = e[0], fNow = f[0];
+            if ((fNow > eNow) == (fNow > -eNow))
+            {
+                q    = eNow;
+                eNow = nextE();
+            }
+            else
+            {
+                q    = fNow;
+                fNow = nextF();
+            }
+
+            if (ei < elen && fi < flen)
+            {
+                if ((fNow > eNow) == (fNow > -eNow))
+                {
+                    FastTwoSum(eNow, q, sum, error);
+                    eNow = nextE();
+                }
+                else
+                {
+                    FastTwoSum(fNow, q, sum, error);
+                    fNow = nextF();
+                }
+                q = sum;
+                if (error != 0.0)
+                    h[hi++] = error;
+
+                while (ei < elen && fi < flen)
+                {
+                    if ((fNow > eNow) == (fNow > -eNow))
+                    {
+                        TwoSum(q, eNow, sum, error);
+                        eNow = nextE();
+                    }
+                    else
+                    {
+                        TwoSum(q, fNow, sum, error);
+                        fNow = nextF();
+                    }
+                    q = sum;
+                    if (error != 0.0)
+                        h[hi++] = error;
+                }
+            }
+            for (; ei < elen; eNow = nextE())
+            {
+                TwoSum(q, eNow, sum, error);
+                q = sum;
+                if (error != 0.0)
+                    h[hi++] = error;
+            }
+            for (; fi < flen; fNow = nextF())
+            {
+                TwoSum(q, fNow, sum, error);
+                q = sum;
+                if (error != 0.0)
+                    h[hi++] = error;
+            }
+            if (q != 0.0 || hi == 0)
+                h[hi++] = q;
+            return hi;
+        }
+
+        // h = e * b, h needs room for 2 * elen components (scale_expansion_zeroelim)
+        inline int ExpansionScale(const double* e, int elen, double b, double* h)
+        {
+            int    hi = 0;
+            double q, error;
+            TwoProduct(e[0], b, q, error);
+            if (error != 0.0)
+                h[hi++] = error;
+            for (int i = 1; i < elen; ++i)
+            {
+                double product, productError, sum;
+                TwoProduct(e[i], b, product, productError);
+                TwoSum(q, productError, sum, error);
+                if (error != 0.0)
+                    h[hi++] = error;
+                FastTwoSum(product, sum, q, error);
+                if (error != 0.0)
+                    h[hi++] = error;
+            }
+            if (q != 0.0 || hi == 0)
+                h[hi++] = q;
+            return hi;
+        }
+
+        template <int A, int B>
+        Expansion<A + B> operator+(const Expansion<A>& e, const Expansion<B>& f)
+        {
+            Expansion<A + B> h;
+            h.size = ExpansionSum(e.c, e.size, f.c, f.size, h.c);
+            return h;
+        }
+
+        template <int A>
+        Expansion<A> operator-(const Expansion<A>& e)
+        {
+            Expansion<A> h = e;
+            for (int i = 0; i < h.size; ++i)
+                h.c[i] = -h.c[i];
+            return h;
+        }
+
+        template <int A, int B>
+        Expansion<A + B> operator-(const Expansion<A>& e, const Expansion<B>& f)
+        {
+            return e + -f;
+        }
+
+        // Sum of e scaled by every component of f
+        template <int A, int B>
+        Expansion<2 * A * B> operator*(const Expansion<A>& e, const Expansion<B>& f)
+        {
+            Expansion<2 * A * B> h;
+            h.size = ExpansionScale(e.c, e.size, f.c[0], h.c);
+            for (int i = 1; i < f.size; ++i)
+            {
+                double scaled[2 * A], sum[2 * A * B];
+                const int scaledSize = ExpansionScale(e.c, e.size, f.c[i], scaled);
+                h.size               = ExpansionSum(h.c, h.size, scaled, scaledSize, sum);
+                for (int k = 0; k < h.size; ++k)
+                    h.c[k] = sum[k];
+            }
+            return h;
+        }
+
+        // a - b as an exact expansion: one component when the difference is exact, else two.
+        // tail is the rounding error of the first one.
+        inline double DifferenceTail(double a, double b, double difference)
+        {
+            const double bVirt = a - difference;
+            const double aVirt = difference + bVirt;
+            return (a - aVirt) + (bVirt - b);
+        }
+
+        inline Expansion<2> ExactDifference(double a, double b)
+        {
+            Expansion<2> e;
+            TwoDiff(a, b, e.c[1], e.c[0]);
+            if (e.c[0] == 0.0)
+            {
+                e.c[0] = e.c[1];
+                e.size = 1;
+            }
+            else
+            {
+                e.size = 2;
+            }
+            return e;
+        }
+
+        inline Expansion<1> ExactValue(double a)
+        {
+            Expansion<1> e;
+            e.c[0] = a;
+            e.size = 1;
+            return e;
+        }
+
+        // Determinants of the differences to the last point, as expansions of D components
+        template <int D>
+        double Orient2DExpansion(const Expansion<D>& acx, const Expansion<D>& acy, const Expansion<D>& bcx, const Expansion<D>& bcy)
+        {
+            return (acx * bcy - acy * bcx).Estimate();
+        }
+
+        template <int D>
+        double Orient3DExpansion(const Expansion<D> (&d)[9])
+        {
+            const Expansion<D>&adx = d[0], &ady = d[1], &adz = d[2];
+            const Expansion<D>&bdx = d[3], &bdy = d[4], &bdz = d[5];
+            const Expansion<D>&cdx = d[6], &cdy = d[7], &cdz = d[8];
+            return (adz * (bdx * cdy - bdy * cdx) + bdz * (cdx * ady - cdy * adx) + cdz * (adx * bdy - ady * bdx)).Estimate();
+        }
+
+        template <int D>
+        double InCircleExpansion(const Expansion<D> (&d)[6])
+        {
+            const Expansion<D>&adx = d[0], &ady = d[1];
+            const Expansion<D>&bdx = d[2], &bdy = d[3];
+            const Expansion<D>&cdx = d[4], &cdy = d[5];
+            const auto         aLift = adx * adx + ady * ady;
+            const auto         bLift = bdx * bdx + bdy * bdy;
+            const auto         cLift = cdx * cdx + cdy * cdy;
+            return (aLift * (bdx * cdy - cdx * bdy) + bLift * (cdx * ady - cdy * adx) + cLift * (adx * bdy - bdx * ady)).Estimate();
+        }
+
+        // Exact evaluation for the inputs the filters cannot decide. n coordinate differences
+        // a[i] - b[i] are tried first as plain doubles and split into expansions only if one of
+        // them is inexact.
+        template <int N, class Evaluate>
+        double ExactFromDifferences(const double (&a)[N], const double (&b)[N], Evaluate evaluate)
+        {
+            bool exact = true;
+            for (int i = 0; i < N; ++i)
+                exact &= DifferenceTail(a[i], b[i], a[i] - b[i]) == 0.0;
+
+            if (exact)
+            {
+                Expansion<1> d[N];
+                for (int i = 0; i < N; ++i)
+                    d[i] = ExactValue(a[i] - b[i]);
+                return evaluate(d);
+            }
+            Expansion<2> d[N];
+            for (int i = 0; i < N; ++i)
+                d[i] = ExactDifference(a[i], b[i]);
+            return evaluate(d);
+        }
+
+        inline double Orient2DExact(const double2& a, const double2& b, const double2& c)
+        {
+            const double minuend[]    = {a.x, a.y, b.x, b.y};
+            const double subtrahend[] = {c.x, c.y, c.x, c.y};
+            return ExactFromDifferences(minuend, subtrahend, [](const auto& d) {
+                return Orient2DExpansion(d[0], d[1], d[2], d[3]);
+            });
+        }
+
+        inline double Orient3DExact(const double3& a, const double3& b, const double3& c, const double3& d)
+        {
+            const double minuend[]    = {a.x, a.y, a.z, b.x, b.y, b.z, c.x, c.y, c.z};
+            const double subtrahend[] = {d.x, d.y, d.z, d.x, d.y, d.z, d.x, d.y, d.z};
+            return ExactFromDifferences(minuend, subtrahend, [](const auto& differences) {
+                return Orient3DExpansion(differences);
+            });
+        }
+
+        inline double InCircleExact(const double2& a, const double2& b, const double2& c, const double2& d)
+        {
+            const double minuend[]    = {a.x, a.y, b.x, b.y, c.x, c.y};
+            const double subtrahend[] = {d.x, d.y, d.x, d.y, d.x, d.y};
+            return ExactFromDifferences(minuend, subtrahend, [](const auto& differences) {
+                return InCircleExpansion(differences);
+            });
+        }
+
+        // Floating-point filters: true if det has the sign of the exact determinant
+
+        inline bool Orient2DFilter(const double2& a, const double2& b, const double2& c, double& det)
+        {
+            const double left  = (a.x - c.x) * (b.y - c.y);
+            const double right = (a.y - c.y) * (b.x - c.x);
+            det                = left - right;
+
+            // Shewchuk returns early when the products have opposite signs, as they cannot
+            // cancel then. The bound covers that case too, and without the branch random
+            // input does not mispredict half of the time.
+            const double sum = std::abs(left) + std::abs(right);
+            return (std::abs(det) > kOrient2DErrorBound * sum) | (sum == 0.0);
+        }
+
+        inline bool Orient3DFilter(const double3& a, const double3& b, const double3& c, const double3& d, double& det)
+        {
+            const double adx = a.x - d.x, bdx = b.x - d.x, cdx = c.x - d.x;
+            const double ady = a.y - d.y, bdy = b.y - d.y, cdy = c.y - d.y;
+            const double adz = a.z - d.z, bdz = b.z - d.z, cdz = c.z - d.z;
+
+            const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+            const double cdxady = cdx * ady, adxcdy = adx * cdy;
+            const double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+            det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+
+            const double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz) +
+                                     (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz) +
+                                     (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+            return (std::abs(det) > kOrient3DErrorBound * permanent) | (permanent == 0.0);
+        }
+
+        inline bool InCircleFilter(const double2& a, const double2& b, const double2& c, const double2& d, double& det)
+        {
+            const double adx = a.x - d.x, bdx = b.x - d.x, cdx = c.x - d.x;
+            const double ady = a.y - d.y, bdy = b.y - d.y, cdy = c.y - d.y;
+
+            const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy, aLift = adx * adx + ady * ady;
+            const double cdxady = cdx * ady, adxcdy = adx * cdy, bLift = bdx * bdx + bdy * bdy;
+            const double adxbdy = adx * bdy, bdxady = bdx * ady, cLift = cdx * cdx + cdy * cdy;
+
+            det = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+
+            const double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * aLift +
+                                     (std::abs(cdxady) + std::abs(adxcdy)) * bLift +
+                                     (std::abs(adxbdy) + std::abs(bdxady)) * cLift;
+            return (std::abs(det) > kInCircleErrorBound * permanent) | (permanent == 0.0);
+        }
+
+        template <class T>
+        double2 ToDouble(const Vector2<T>& v)
+        {
+            static_assert(kExactInDouble<T>, "coordinates must be float, double or int32");
+            return double2(static_cast<double>(v.x), static_cast<double>(v.y));
+        }
+
+        template <class T>
+        double3 ToDouble(const Vector3<T>& v)
+        {
+            static_assert(kExactInDouble<T>, "coordinates must be float, double or int32");
+            return double3(static_cast<double>(v.x), static_cast<double>(v.y), static_cast<double>(v.z));
+        }
+
+        inline int8_t Sign(double value)
+        {
+            return static_cast<int8_t>((value > 0.0) - (value < 0.0));
+        }
+    } // namespace detail
+
+    template <class T>
+    double Orient2D(const Vector2<T>& a, const Vector2<T>& b, const Vector2<T>& c)
+    {
+        const double2 da = detail::ToDouble(a), db = detail::ToDouble(b), dc = detail::ToDouble(c);
+        double        det;
+        if (detail::Orient2DFilter(da, db, dc, det))
+            return det;
+        return detail::Orient2DExact(da, db, dc);
+    }
+
+    template <class T>
+    double Orient3D(const Vector3<T>& a, const Vector3<T>& b, const Vector3<T>& c, const Vector3<T>& d)
+    {
+        const double3 da = detail::ToDouble(a), db = detail::ToDouble(b), dc = detail::ToDouble(c), dd = detail::ToDouble(d);
+        double        det;
+        if (detail::Orient3DFilter(da, db, dc, dd, det))
+            return det;
+        return detail::Orient3DExact(da, db, dc, dd);
+    }
+
+    template <class T>
+    double InCircle(const Vector2<T>& a, const Vector2<T>& b, const Vector2<T>& c, const Vector2<T>& d)
+    {
+        const double2 da = detail::ToDouble(a), db = detail::ToDouble(b), dc = detail::ToDouble(c), dd = detail::ToDouble(d);
+        double        det;
+        if (detail::InCircleFilter(da, db, dc, dd, det))
+            return det;
+        return detail::InCircleExact(da, db, dc, dd);
+    }
+
+
+    // Batch versions over indexed triangle lists: triangle t has the vertices
+    // indices[3t], indices[3t + 1] and indices[3t + 2], and signs[t] receives the sign of
+    // the predicate (-1, 0 or 1). They return the number of triangles that needed the exact
+    // evaluation, which stays small unless the input is full of degeneracies.
+
+    // Orient2D of every triangle: 1 counterclockwise, -1 clockwise, 0 degenerate
+    template <class T>
+    size_t TriangleOrientations(span<const Vector2<T>> vertices, span<const uint32_t> indices, span<int8_t> signs)
+    {
+        assert(indices.size() % 3 == 0 && signs.size() >= indices.size() / 3);
+        const Vector2<T>* v      = vertices.data();
+        const uint32_t*   index  = indices.data();
+        size_t            exacts = 0;
+        for (size_t t = 0, count = indices.size() / 3; t < count; ++t, index += 3)
+        {
+            const double2 a = detail::ToDouble(v[index[0]]), b = detail::ToDouble(v[index[1]]), c = detail::ToDouble(v[index[2]]);
+            double        det;
+            if (!detail::Orient2DFilter(a, b, c, det))
+            {
+                det = detail::Orient2DExact(a, b, c);
+                ++exacts;
+            }
+            signs[t] = detail::Sign(det);
+        }
+        return exacts;
+    }
+
+    // Orient3D(a, b, c, point) of every triangle: 1 if the point is behind the triangle (on
+    // the side from which it appears clockwise), -1 in front of it, 0 in its plane
+    template <class T>
+    size_t SideOfTriangles(span<const Vector3<T>> vertices, span<const uint32_t> indices, const Vector3<T>& point, span<int8_t> signs)
+    {
+        assert(indices.size() % 3 == 0 && signs.size() >= indices.size() / 3);
+        const Vector3<T>* v      = vertices.data();
+        const uint32_t*   index  = indices.data();
+        const double3     p      = detail::ToDouble(point);
+        size_t            exacts = 0;
+        for (size_t t = 0, count = indices.size() / 3; t < count; ++t, index += 3)
+        {
+            const double3 a = detail::ToDouble(v[index[0]]), b = detail::ToDouble(v[index[1]]), c = detail::ToDouble(v[index[2]]);
+            double        det;
+            if (!detail::Orient3DFilter(a, b, c, p, det))
+            {
+                det = detail::Orient3DExact(a, b, c, p);
+                ++exacts;
+            }
+            signs[t] = detail::Sign(det);
+        }
+        return exacts;
+    }
+
+    // InCircle(a, b, c, point) of every triangle, e.g. to find the triangles whose Delaunay
+    // condition a new point violates. Clockwise triangles flip the sign.
+    template <class T>
+    size_t InCircumcircles(span<const Vector2<T>> vertices, span<const uint32_t> indices, const Vector2<T>& point, span<int8_t> signs)
+    {
+        assert(indices.size() % 3 == 0 && signs.size() >= indices.size() / 3);
+        const Vector2<T>* v      = vertices.data();
+        const uint32_t*   index  = indices.data();
+        const double2     p      = detail::ToDouble(point);
+        size_t            exacts = 0;
+        for (size_t t = 0, count = indices.size() / 3; t < count; ++t, index += 3)
+        {
+            const double2 a = detail::ToDouble(v[index[0]]), b = detail::ToDouble(v[index[1]]), c = detail::ToDouble(v[index[2]]);
+            double        det;
+            if (!detail::InCircleFilter(a, b, c, p, det))
+            {
+                det = detail::InCircleExact(a, b, c, p);
+                ++exacts;
+            }
+            signs[t] = detail::Sign(det);
+        }
+        return exacts;
+    }
+} // namespace math
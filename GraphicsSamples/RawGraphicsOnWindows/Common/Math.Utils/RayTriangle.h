@@ -0,0 +1,439 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+// Ray casts against triangle soups without an acceleration structure, simd::kWidth triangles or
+// rays at a time (8 with AVX2, 4 with SSE2):
+//
+//   TriangleSoA          the triangle vertices, one array per component
+//   IntersectNearest     one ray against all triangles, kWidth triangles per step
+//   Occluded             the same, stopping at the first hit
+//   IntersectNearest     kWidth rays against one triangle per step, for a span of rays
+//
+// The test is the watertight one of Woop, Benthin and Wald (JCGT 2013), double sided. The
+// vertices are moved into a space where the ray starts at the origin and runs along +z: the axis
+// with the largest direction component becomes z, and a shear puts the direction on the z axis.
+// The three edge functions are the 2D cross products of the sheared vertices in x and y; the ray
+// hits when they all have the same sign. A vertex is sheared the same way in every triangle it
+// belongs to and the edge function of a shared edge only changes sign between the two triangles,
+// so a ray through an edge or a vertex hits at least one of the triangles around it, no matter how
+// far the mesh is from the origin. That needs the sign of every edge function to be exact: one
+// within its rounding error of 0 is recomputed in double, where the products are exact. The paper
+// only recomputes exact zeros, which is not enough once the compiler contracts a * b - c * d into
+// an FMA. The Bvh leaves use the same scalar test. A ray through an edge may report either
+// triangle. For many rays or large meshes build a Bvh.
+
+namespace math
+{
+    struct Ray
+    {
+        float3 origin;
+        float  tMin = 0.f;
+        float3 direction;
+        float  tMax = FLT_MAX;
+
+        Ray() = default;
+        Ray(const float3& _origin, const float3& _direction, float _tMin = 0.f, float _tMax = FLT_MAX) :
+            origin(_origin), tMin(_tMin), direction(_direction), tMax(_tMax)
+        {}
+    };
+
+    struct RayHit
+    {
+        float    t        = FLT_MAX;
+        float    u        = 0.f; // barycentric coordinates of the second and third vertex
+        float    v        = 0.f;
+        uint32_t triangle = UINT32_MAX;
+    };
+
+    // Triangle vertices as a structure of arrays. The arrays are padded to a multiple of
+    // simd::kWidth with degenerate triangles that no ray hits.
+    class TriangleSoA
+    {
+    public:
+        TriangleSoA() = default;
+        TriangleSoA(span<const float3> positions, span<const uint32_t> indices) { Build(positions, indices); }
+
+        // Triangles are index triples into positions
+        void Build(span<const float3> positions, span<const uint32_t> indices)
+        {
+            assert(indices.size() % 3 == 0);
+            m_count             = indices.size() / 3;
+            const size_t padded = (m_count + simd::kWidth - 1) / simd::kWidth * simd::kWidth;
+            for (auto& vertex : m_vertices)
+                for (auto& component : vertex)
+                    component.assign(padded, 0.f);
+
+            for (size_t i = 0; i < m_count; ++i)
+            {
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    const float3& p = positions[indices[3 * i + corner]];
+                    for (int axis = 0; axis < 3; ++axis)
+                        m_vertices[corner][axis][i] = p[axis];
+                }
+            }
+        }
+
+        size_t size() const { return m_count; }
+        size_t PaddedSize() const { return m_vertices[0][0].size(); }
+
+        // Component axis of vertex corner (0, 1 or 2) of every triangle, PaddedSize() long
+        const float* Vertex(int corner, int axis) const { return m_vertices[corner][axis].data(); }
+
+    private:
+        size_t             m_count = 0;
+        std::vector<float> m_vertices[3][3];
+    };
+
+    namespace detail
+    {
+        // The ray of the watertight test: the axis permutation that makes the largest direction
+        // component z, and the shear that then puts the direction on the z axis
+        struct WatertightRay
+        {
+            float3 origin;
+            int    axis[3]; // kx, ky, kz
+            float  shear[3]; // dx / dz, dy / dz, 1 / dz
+
+            explicit WatertightRay(const Ray& ray) :
+                origin(ray.origin)
+            {
+                const float3& d  = ray.direction;
+                const float   ax = std::abs(d.x), ay = std::abs(d.y), az = std::abs(d.z);
+                axis[2]          = ax >= ay && ax >= az ? 0 : ay >= az ? 1 : 2;
+                axis[0]          = (axis[2] + 1) % 3;
+                axis[1]          = (axis[2] + 2) % 3;
+                shear[2]         = 1.f / d[axis[2]];
+                shear[0]         = d[axis[0]] * shear[2];
+                shear[1]         = d[axis[1]] * shear[2];
+            }
+        };
+
+        // Bound on the rounding error of px * qy - py * qx relative to |px * qy| + |py * qx|, with
+        // or without FMA contraction
+        constexpr float kEdgeFunctionErrorBound = 2.f * FLT_EPSILON;
+
+        // Twice the signed area of the origin, p and q in the sheared xy plane, in double. The
+        // products are exact, only the final difference rounds, so the sign is exact.
+        inline float EdgeFunctionExact(float px, float py, float qx, float qy)
+        {
+            return static_cast<float>(static_cast<double>(px) * qy - static_cast<double>(py) * qx);
+        }
+
+        // The same in float, recomputed in double when the result is too close to 0 for its sign
+        // to be certain
+        inline float EdgeFunction(float px, float py, float qx, float qy)
+        {
+            const float pq = px * qy, qp = py * qx;
+            const float edge = pq - qp;
+            if (std::abs(edge) > kEdgeFunctionErrorBound * (std::abs(pq) + std::abs(qp)))
+                return edge;
+            return EdgeFunctionExact(px, py, qx, qy);
+        }
+
+        // Watertight double sided test of the triangle abc. Hits with t in [tMin, tMax] count.
+        inline bool IntersectTriangle(const WatertightRay& ray, const float3& a, const float3& b, const float3& c,
+                                      float tMin, float tMax, float& t, float& u, float& v)
+        {
+            const int    kx = ray.axis[0], ky = ray.axis[1], kz = ray.axis[2];
+            const float3 pa = a - ray.origin, pb = b - ray.origin, pc = c - ray.origin;
+            const float  ax = pa[kx] - ray.shear[0] * pa[kz], ay = pa[ky] - ray.shear[1] * pa[kz];
+            const float  bx = pb[kx] - ray.shear[0] * pb[kz], by = pb[ky] - ray.shear[1] * pb[kz];
+            const float  cx = pc[kx] - ray.shear[0] * pc[kz], cy = pc[ky] - ray.shear[1] * pc[kz];
+
+            // The edge functions weigh the opposite vertex
+            const float ea = EdgeFunction(cx, cy, bx, by), eb = EdgeFunction(ax, ay, cx, cy), ec = EdgeFunction(bx, by, ax, ay);
+            if ((ea < 0.f || eb < 0.f || ec < 0.f) && (ea > 0.f || eb > 0.f || ec > 0.f))
+                return false;
+
+            const float det = ea + eb + ec;
+            if (det == 0.f)
+                return false;
+
+            const float inv = 1.f / det;
+            t               = (ea * pa[kz] + eb * pb[kz] + ec * pc[kz]) * ray.shear[2] * inv;
+            if (!(t >= tMin && t <= tMax))
+                return false;
+            u = eb * inv;
+            v = ec * inv;
+            return true;
+        }
+
+        // Ray components in the order kx, ky, kz of each lane, with the shear
+        struct RayLanes
+        {
+            simd::vfloat origin[3];
+            simd::vfloat shear[3];
+            simd::vmask  zIsX, zIsY; // which axis kz is, per lane
+        };
+
+        // Triangle vertices in the order kx, ky, kz of the ray lanes
+        struct TriangleLanes
+        {
+            simd::vfloat vertex[3][3];
+        };
+
+        inline TriangleLanes LoadTriangles(const TriangleSoA& triangles, size_t first, const WatertightRay& ray)
+        {
+            TriangleLanes lanes;
+            for (int corner = 0; corner < 3; ++corner)
+                for (int axis = 0; axis < 3; ++axis)
+                    lanes.vertex[corner][axis] = simd::load(triangles.Vertex(corner, ray.axis[axis]) + first);
+            return lanes;
+        }
+
+        // One triangle for all lanes, permuted per lane
+        inline TriangleLanes BroadcastTriangle(const TriangleSoA& triangles, size_t index, const RayLanes& ray)
+        {
+            using simd::select;
+
+            TriangleLanes lanes;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const simd::vfloat x = simd::broadcast(triangles.Vertex(corner, 0)[index]);
+                const simd::vfloat y = simd::broadcast(triangles.Vertex(corner, 1)[index]);
+                const simd::vfloat z = simd::broadcast(triangles.Vertex(corner, 2)[index]);
+                lanes.vertex[corner][0] = select(ray.zIsX, y, select(ray.zIsY, z, x));
+                lanes.vertex[corner][1] = select(ray.zIsX, z, select(ray.zIsY, x, y));
+                lanes.vertex[corner][2] = select(ray.zIsX, x, select(ray.zIsY, y, z));
+            }
+            return lanes;
+        }
+
+        inline RayLanes BroadcastRay(const WatertightRay& ray)
+        {
+            RayLanes lanes;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lanes.origin[axis] = simd::broadcast(ray.origin[ray.axis[axis]]);
+                lanes.shear[axis]  = simd::broadcast(ray.shear[axis]);
+            }
+            lanes.zIsX = simd::broadcast(static_cast<float>(ray.axis[2])) == simd::broadcast(0.f);
+            lanes.zIsY = simd::broadcast(static_cast<float>(ray.axis[2])) == simd::broadcast(1.f);
+            return lanes;
+        }
+
+        // Recomputes the edge functions of the lanes in uncertainLanes (a movemask) in double
+        inline void ExactEdgeFunctions(int uncertainLanes, const simd::vfloat x[3], const simd::vfloat y[3], simd::vfloat edges[3])
+        {
+            float xs[3][simd::kWidth], ys[3][simd::kWidth], es[3][simd::kWidth];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                simd::store(xs[corner], x[corner]);
+                simd::store(ys[corner], y[corner]);
+                simd::store(es[corner], edges[corner]);
+            }
+            for (size_t lane = 0; lane < simd::kWidth; ++lane)
+            {
+                if ((uncertainLanes >> lane & 1) == 0)
+                    continue;
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    const int p = (corner + 2) % 3, q = (corner + 1) % 3;
+                    es[corner][lane] = EdgeFunctionExact(xs[p][lane], ys[p][lane], xs[q][lane], ys[q][lane]);
+                }
+            }
+            for (int corner = 0; corner < 3; ++corner)
+                edges[corner] = simd::load(es[corner]);
+        }
+
+        // The watertight test of IntersectTriangle on every lane. Lanes with t in [tMin, tMax]
+        // inside the triangle hit.
+        inline simd::vmask IntersectLanes(const RayLanes& ray, const TriangleLanes& tri, simd::vfloat tMin, simd::vfloat tMax,
+                                          simd::vfloat& t, simd::vfloat& u, simd::vfloat& v)
+        {
+            using namespace simd;
+
+            vfloat x[3], y[3], z[3];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const vfloat pz = tri.vertex[corner][2] - ray.origin[2];
+                x[corner]       = (tri.vertex[corner][0] - ray.origin[0]) - ray.shear[0] * pz;
+                y[corner]       = (tri.vertex[corner][1] - ray.origin[1]) - ray.shear[1] * pz;
+                z[corner]       = pz;
+            }
+
+            // Edge function of the edge opposite each corner, as in IntersectTriangle
+            vfloat edges[3], bounds[3];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const int    p = (corner + 2) % 3, q = (corner + 1) % 3;
+                const vfloat pq = x[p] * y[q], qp = y[p] * x[q];
+                edges[corner]   = pq - qp;
+                bounds[corner]  = broadcast(kEdgeFunctionErrorBound) * (abs(pq) + abs(qp));
+            }
+            const vmask uncertain = (abs(edges[0]) <= bounds[0]) | (abs(edges[1]) <= bounds[1]) | (abs(edges[2]) <= bounds[2]);
+            if (any(uncertain))
+                ExactEdgeFunctions(movemask(uncertain), x, y, edges);
+
+            const vfloat zero = broadcast(0.f);
+
+            const vmask  inside = ((edges[0] >= zero) & (edges[1] >= zero) & (edges[2] >= zero)) |
+                                 ((edges[0] <= zero) & (edges[1] <= zero) & (edges[2] <= zero));
+            const vfloat det    = edges[0] + edges[1] + edges[2];
+            const vfloat inv    = broadcast(1.f) / det;
+            t                   = madd(edges[0], z[0], madd(edges[1], z[1], edges[2] * z[2])) * ray.shear[2] * inv;
+            u                   = edges[1] * inv;
+            v                   = edges[2] * inv;
+
+            // A zero determinant makes t infinite or NaN, which the comparisons reject as well
+            return inside & (t >= tMin) & (t <= tMax) & (abs(det) > zero);
+        }
+
+        // The nearest hit of every lane so far. The triangle index is kept in float lanes, bit
+        // for bit, so that select can move it; UINT32_MAX means no hit.
+        struct NearestLanes
+        {
+            simd::vfloat t, u, v, triangle;
+
+            explicit NearestLanes(simd::vfloat tMax) :
+                t(tMax), u(simd::broadcast(0.f)), v(simd::broadcast(0.f)), triangle(simd::reinterpret_float(simd::broadcast_int(-1)))
+            {}
+
+            void Update(simd::vmask hit, simd::vfloat hitT, simd::vfloat hitU, simd::vfloat hitV, simd::vint hitTriangle)
+            {
+                t        = simd::select(hit, hitT, t);
+                u        = simd::select(hit, hitU, u);
+                v        = simd::select(hit, hitV, v);
+                triangle = simd::select(hit, simd::reinterpret_float(hitTriangle), triangle);
+            }
+
+            RayHit Lane(size_t lane) const
+            {
+                float    ts[simd::kWidth], us[simd::kWidth], vs[simd::kWidth];
+                uint32_t triangles[simd::kWidth];
+                simd::store(ts, t);
+                simd::store(us, u);
+                simd::store(vs, v);
+                simd::store(triangles, simd::reinterpret_int(triangle));
+                return {ts[lane], us[lane], vs[lane], triangles[lane]};
+            }
+        };
+
+        // 0, 1, ..., kWidth - 1
+        inline simd::vint LaneIndices()
+        {
+            int32_t indices[simd::kWidth];
+            for (size_t lane = 0; lane < simd::kWidth; ++lane)
+                indices[lane] = static_cast<int32_t>(lane);
+            return simd::load(indices);
+        }
+    } // namespace detail
+
+    // Nearest hit of the ray with t in [ray.tMin, ray.tMax]. hit.triangle is the index of the
+    // triangle in the index buffer passed to TriangleSoA, divided by 3.
+    inline bool IntersectNearest(const Ray& ray, const TriangleSoA& triangles, RayHit& hit)
+    {
+        using namespace simd;
+
+        const detail::WatertightRay watertight(ray);
+        const detail::RayLanes      lanes = detail::BroadcastRay(watertight);
+        const vfloat                tMin  = broadcast(ray.tMin);
+        const vint                  iota  = detail::LaneIndices();
+        detail::NearestLanes        nearest(broadcast(ray.tMax));
+
+        // Every lane keeps its own nearest hit, which is also its tMax
+        for (size_t first = 0; first < triangles.PaddedSize(); first += kWidth)
+        {
+            vfloat      t, u, v;
+            const vmask hits = detail::IntersectLanes(lanes, detail::LoadTriangles(triangles, first, watertight), tMin, nearest.t, t, u, v);
+            if (any(hits))
+                nearest.Update(hits, t, u, v, broadcast_int(static_cast<int32_t>(first)) + iota);
+        }
+
+        bool found = false;
+        for (size_t lane = 0; lane < kWidth; ++lane)
+        {
+            const RayHit candidate = nearest.Lane(lane);
+            if (candidate.triangle != UINT32_MAX && (!found || candidate.t < hit.t || (candidate.t == hit.t && candidate.triangle < hit.triangle)))
+            {
+                hit   = candidate;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // Whether any triangle is hit with t in [ray.tMin, ray.tMax], for shadow and occlusion rays
+    inline bool Occluded(const Ray& ray, const TriangleSoA& triangles)
+    {
+        using namespace simd;
+
+        const detail::WatertightRay watertight(ray);
+        const detail::RayLanes      lanes = detail::BroadcastRay(watertight);
+        const vfloat                tMin = broadcast(ray.tMin), tMax = broadcast(ray.tMax);
+        for (size_t first = 0; first < triangles.PaddedSize(); first += kWidth)
+        {
+            vfloat t, u, v;
+            if (any(detail::IntersectLanes(lanes, detail::LoadTriangles(triangles, first, watertight), tMin, tMax, t, u, v)))
+                return true;
+        }
+        return false;
+    }
+
+    // Nearest hits of many rays: kWidth rays at a time go through the triangles, one triangle
+    // per step. Best for bundles of similar rays such as a grid of picking or visibility rays.
+    // hits[i] is left as RayHit() when rays[i] misses. Returns the number of rays that hit.
+    inline size_t IntersectNearest(span<const Ray> rays, const TriangleSoA& triangles, span<RayHit> hits)
+    {
+        using namespace simd;
+        assert(rays.size() == hits.size());
+
+        size_t found = 0;
+        for (size_t first = 0; first < rays.size(); first += kWidth)
+        {
+            // The last packet repeats the last ray
+            float origin[3][kWidth], shear[3][kWidth], zAxis[kWidth], tMin[kWidth], tMax[kWidth];
+            for (size_t lane = 0; lane < kWidth; ++lane)
+            {
+                const Ray&                  ray = rays[std::min(first + lane, rays.size() - 1)];
+                const detail::WatertightRay watertight(ray);
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    origin[axis][lane] = ray.origin[watertight.axis[axis]];
+                    shear[axis][lane]  = watertight.shear[axis];
+                }
+                zAxis[lane] = static_cast<float>(watertight.axis[2]);
+                tMin[lane]  = ray.tMin;
+                tMax[lane]  = ray.tMax;
+            }
+
+            detail::RayLanes lanes;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lanes.origin[axis] = load(origin[axis]);
+                lanes.shear[axis]  = load(shear[axis]);
+            }
+            lanes.zIsX = load(zAxis) == broadcast(0.f);
+            lanes.zIsY = load(zAxis) == broadcast(1.f);
+            const vfloat         rayTMin = load(tMin);
+            detail::NearestLanes nearest(load(tMax));
+
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                vfloat      t, u, v;
+                const vmask hit = detail::IntersectLanes(lanes, detail::BroadcastTriangle(triangles, i, lanes), rayTMin, nearest.t, t, u, v);
+                if (any(hit))
+                    nearest.Update(hit, t, u, v, broadcast_int(static_cast<int32_t>(i)));
+            }
+
+            for (size_t lane = 0; lane < kWidth && first + lane < rays.size(); ++lane)
+            {
+                const RayHit hit = nearest.Lane(lane);
+                hits[first + lane] = hit.triangle != UINT32_MAX ? hit : RayHit();
+                found += hit.triangle != UINT32_MAX;
+            }
+        }
+        return found;
+    }
+} // namespace math
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "BatchTransform.h"
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+#include "ThreadPool.h"
+
+// CPU skinning of vertex streams with up to four bone influences per vertex:
+//
+//   SkinLinear           linear blend skinning: the weighted sum of the bone matrices
+//   SkinDualQuaternion   dual quaternion skinning (Kavan et al., "Geometric Skinning with
+//                        Approximate Dual Quaternion Blending", 2008): the weighted sum of unit
+//                        dual quaternions, normalized. Keeps the volume around twisting joints
+//                        where linear blending collapses, but supports rigid bones only.
+//
+// Positions, normals and influences are structures of arrays. simd::kWidth vertices are skinned
+// at a time, each lane gathering the palette entries of its own bones, and the tail goes through
+// the scalar code. The vertices are split into chunks of at least kSkinningChunkSize, about 80 KB
+// of input and output, which run on a ThreadPool, ThreadPool::Default() unless one is given.
+
+namespace math
+{
+    constexpr size_t kMaxBoneInfluences = 4;
+    constexpr size_t kSkinningChunkSize = 1024;
+
+    // Affine transform as the three rows of a column vector matrix, the skinning palette layout
+    // of HLSL's float3x4: p' = (dot(rows[0], p1), dot(rows[1], p1), dot(rows[2], p1)), p1 = (p, 1)
+    struct float3x4
+    {
+        float4 rows[3];
+
+        // m is a Math.h row vector matrix, p' = float4(p, 1) * m, with (0 0 0 1) as last column
+        static float3x4 FromMatrix(const float4x4& m)
+        {
+            float3x4 out;
+            for (int i = 0; i < 3; ++i)
+                out.rows[i] = float4(m[0][i], m[1][i], m[2][i], m[3][i]);
+            return out;
+        }
+
+        float3 TransformPoint(const float3& p) const
+        {
+            const float4 p1(p, 1.f);
+            return float3(dot(rows[0], p1), dot(rows[1], p1), dot(rows[2], p1));
+        }
+
+        float3 TransformVector(const float3& v) const
+        {
+            const float4 v0(v, 0.f);
+            return float3(dot(rows[0], v0), dot(rows[1], v0), dot(rows[2], v0));
+        }
+    };
+
+    static_assert(sizeof(float3x4) == 12 * sizeof(float), "float3x4 must be tightly packed");
+
+    // Rigid transform as a unit dual quaternion real + e * dual: the rotation is real, the
+    // translation t is stored as dual = 0.5 * (t, 0) * real
+    struct DualQuaternion
+    {
+        Quaternion real{0.f, 0.f, 0.f, 1.f};
+        Quaternion dual{0.f, 0.f, 0.f, 0.f};
+
+        DualQuaternion() = default;
+        DualQuaternion(const Quaternion& rotation, const float3& translation) :
+            real(rotation), dual(Quaternion(translation.x, translation.y, translation.z, 0.f) * rotation)
+        {
+            dual.q *= 0.5f;
+        }
+
+        // 2 * dual * conjugate(real)
+        float3 Translation() const
+        {
+            const float3 r(real.q.x, real.q.y, real.q.z);
+            const float3 d(dual.q.x, dual.q.y, dual.q.z);
+            return 2.f * (real.q.w * d - dual.q.w * r + cross(r, d));
+        }
+
+        float3 TransformPoint(const float3& p) const { return real.RotateVector(p) + Translation(); }
+        float3 TransformVector(const float3& v) const { return real.RotateVector(v); }
+    };
+
+    static_assert(sizeof(DualQuaternion) == 8 * sizeof(float), "DualQuaternion must be tightly packed");
+
+    // Bone indices and weights as structures of arrays: influence k of vertex i is bone
+    // bones[k][i] with weight weights[k][i]. The weights of a vertex should sum to 1; unused
+    // influences have weight 0 and any valid bone index. The indices are 32 bits wide so that
+    // they load straight into simd::vint lanes.
+    struct SkinInfluenceStream
+    {
+        span<const uint32_t> bones[kMaxBoneInfluences];
+        span<const float>    weights[kMaxBoneInfluences];
+
+        size_t size() const { return bones[0].size(); }
+    };
+
+    namespace detail
+    {
+        inline void CheckSkinningStreams(ConstFloat3Stream positions, ConstFloat3Stream normals, const SkinInfluenceStream& influences,
+                                         Float3Stream outPositions, Float3Stream outNormals)
+        {
+            (void)positions, (void)normals, (void)influences, (void)outPositions, (void)outNormals;
+            assert(positions.size() == outPositions.size() && influences.size() == positions.size());
+            assert(normals.size() == outNormals.size() && (normals.size() == 0 || normals.size() == positions.size()));
+            for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+                assert(influences.bones[k].size() == positions.size() && influences.weights[k].size() == positions.size());
+        }
+
+        // kWidth normals scaled to unit length
+        inline void Normalize(simd::vfloat& x, simd::vfloat& y, simd::vfloat& z)
+        {
+            using simd::madd;
+            const simd::vfloat scale = simd::broadcast(1.f) / simd::sqrt(madd(x, x, madd(y, y, z * z)));
+            x *= scale;
+            y *= scale;
+            z *= scale;
+        }
+
+        // index * 8 and index * 12 without a vint multiply
+        inline simd::vint Times8(simd::vint index) { return index << 3; }
+        inline simd::vint Times12(simd::vint index) { return (index << 3) + (index << 2); }
+
+        inline float3x4 BlendBones(span<const float3x4> palette, const SkinInfluenceStream& influences, size_t i)
+        {
+            float3x4 m;
+            m.rows[0] = m.rows[1] = m.rows[2] = float4(0.f, 0.f, 0.f, 0.f);
+            for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+            {
+                const float     w    = influences.weights[k][i];
+                const float3x4& bone = palette[influences.bones[k][i]];
+                for (int row = 0; row < 3; ++row)
+                    m.rows[row] += w * bone.rows[row];
+            }
+            return m;
+        }
+
+        inline DualQuaternion BlendBones(span<const DualQuaternion> palette, const SkinInfluenceStream& influences, size_t i)
+        {
+            // Every bone in the hemisphere of the first: q and -q are the same transform
+            const DualQuaternion& first = palette[influences.bones[0][i]];
+            DualQuaternion        blend;
+            blend.real.q = float4(0.f, 0.f, 0.f, 0.f);
+            for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+            {
+                const DualQuaternion& bone = palette[influences.bones[k][i]];
+                const float           w    = dot(bone.real.q, first.real.q) < 0.f ? -influences.weights[k][i] : influences.weights[k][i];
+                blend.real.q += w * bone.real.q;
+                blend.dual.q += w * bone.dual.q;
+            }
+            const float scale = 1.f / length(blend.real.q);
+            blend.real.q *= scale;
+            blend.dual.q *= scale;
+            return blend;
+        }
+
+        template <class Palette>
+        void SkinScalar(span<const Palette> palette, ConstFloat3Stream positions, ConstFloat3Stream normals,
+                        const SkinInfluenceStream& influences, Float3Stream outPositions, Float3Stream outNormals, size_t first,
+                        size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                const Palette bone = BlendBones(palette, influences, i);
+                outPositions.Set(i, bone.TransformPoint(positions.Get(i)));
+                if (normals.size())
+                    outNormals.Set(i, normalize(bone.TransformVector(normals.Get(i))));
+            }
+        }
+
+        inline void SkinLinearChunk(span<const float3x4> palette, ConstFloat3Stream positions, ConstFloat3Stream normals,
+                                    const SkinInfluenceStream& influences, Float3Stream outPositions, Float3Stream outNormals,
+                                    size_t first, size_t last)
+        {
+            using simd::madd;
+            const float* base = &palette.data()->rows[0].x;
+
+            size_t i = first;
+            for (; i + simd::kWidth <= last; i += simd::kWidth)
+            {
+                // Blended matrix, element e of every lane in m[e]
+                simd::vfloat m[12];
+                for (simd::vfloat& e : m)
+                    e = simd::broadcast(0.f);
+                for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+                {
+                    const simd::vfloat w = simd::load(influences.weights[k].data() + i);
+                    if (!simd::any(simd::abs(w) > simd::broadcast(0.f)))
+                        continue;
+                    const simd::vint index = Times12(simd::load(influences.bones[k].data() + i));
+                    for (int e = 0; e < 12; ++e)
+                        m[e] = madd(simd::gather(base + e, index), w, m[e]);
+                }
+
+                const simd::vfloat x = simd::load(positions.x.data() + i);
+                const simd::vfloat y = simd::load(positions.y.data() + i);
+                const simd::vfloat z = simd::load(positions.z.data() + i);
+                simd::store(outPositions.x.data() + i, madd(m[0], x, madd(m[1], y, madd(m[2], z, m[3]))));
+                simd::store(outPositions.y.data() + i, madd(m[4], x, madd(m[5], y, madd(m[6], z, m[7]))));
+                simd::store(outPositions.z.data() + i, madd(m[8], x, madd(m[9], y, madd(m[10], z, m[11]))));
+
+                if (normals.size())
+                {
+                    const simd::vfloat nx = simd::load(normals.x.data() + i);
+                    const simd::vfloat ny = simd::load(normals.y.data() + i);
+                    const simd::vfloat nz = simd::load(normals.z.data() + i);
+                    simd::vfloat       ox = madd(m[0], nx, madd(m[1], ny, m[2] * nz));
+                    simd::vfloat       oy = madd(m[4], nx, madd(m[5], ny, m[6] * nz));
+                    simd::vfloat       oz = madd(m[8], nx, madd(m[9], ny, m[10] * nz));
+                    Normalize(ox, oy, oz);
+                    simd::store(outNormals.x.data() + i, ox);
+                    simd::store(outNormals.y.data() + i, oy);
+                    simd::store(outNormals.z.data() + i, oz);
+                }
+            }
+            SkinScalar(palette, positions, normals, influences, outPositions, outNormals, i, last);
+        }
+
+        inline void SkinDualQuaternionChunk(span<const DualQuaternion> palette, ConstFloat3Stream positions, ConstFloat3Stream normals,
+                                            const SkinInfluenceStream& influences, Float3Stream outPositions, Float3Stream outNormals,
+                                            size_t first, size_t last)
+        {
+            using simd::madd;
+            const float* base = &palette.data()->real.q.x;
+
+            size_t i = first;
+            for (; i + simd::kWidth <= last; i += simd::kWidth)
+            {
+                // Real part in r, dual part in d, the first bone as the reference hemisphere
+                const simd::vint   firstIndex = Times8(simd::load(influences.bones[0].data() + i));
+                const simd::vfloat first[4]   = {simd::gather(base + 0, firstIndex), simd::gather(base + 1, firstIndex),
+                                                 simd::gather(base + 2, firstIndex), simd::gather(base + 3, firstIndex)};
+                simd::vfloat       r[4], d[4];
+                const simd::vfloat w0 = simd::load(influences.weights[0].data() + i);
+                for (int c = 0; c < 4; ++c)
+                {
+                    r[c] = first[c] * w0;
+                    d[c] = simd::gather(base + 4 + c, firstIndex) * w0;
+                }
+
+                for (size_t k = 1; k < kMaxBoneInfluences; ++k)
+                {
+                    simd::vfloat w = simd::load(influences.weights[k].data() + i);
+                    if (!simd::any(simd::abs(w) > simd::broadcast(0.f)))
+                        continue;
+                    const simd::vint   index = Times8(simd::load(influences.bones[k].data() + i));
+                    const simd::vfloat bx    = simd::gather(base + 0, index);
+                    const simd::vfloat by    = simd::gather(base + 1, index);
+                    const simd::vfloat bz    = simd::gather(base + 2, index);
+                    const simd::vfloat bw    = simd::gather(base + 3, index);
+
+                    const simd::vfloat hemisphere = madd(bx, first[0], madd(by, first[1], madd(bz, first[2], bw * first[3])));
+                    w                             = simd::select(hemisphere < simd::broadcast(0.f), -w, w);
+                    r[0]                          = madd(bx, w, r[0]);
+                    r[1]                          = madd(by, w, r[1]);
+                    r[2]                          = madd(bz, w, r[2]);
+                    r[3]                          = madd(bw, w, r[3]);
+                    for (int c = 0; c < 4; ++c)
+                        d[c] = madd(simd::gather(base + 4 + c, index), w, d[c]);
+                }
+
+                const simd::vfloat scale = simd::broadcast(1.f) / simd::sqrt(madd(r[0], r[0], madd(r[1], r[1], madd(r[2], r[2], r[3] * r[3]))));
+                for (int c = 0; c < 4; ++c)
+                {
+                    r[c] *= scale;
+                    d[c] *= scale;
+                }
+
+                // v + 2 * cross(r, cross(r, v) + w * v), as Quaternion::RotateVector
+                auto rotate = [&](simd::vfloat& vx, simd::vfloat& vy, simd::vfloat& vz) {
+                    const simd::vfloat tx = madd(r[3], vx, r[1] * vz - r[2] * vy);
+                    const simd::vfloat ty = madd(r[3], vy, r[2] * vx - r[0] * vz);
+                    const simd::vfloat tz = madd(r[3], vz, r[0] * vy - r[1] * vx);
+                    const simd::vfloat two = simd::broadcast(2.f);
+                    vx                     = madd(two, r[1] * tz - r[2] * ty, vx);
+                    vy                     = madd(two, r[2] * tx - r[0] * tz, vy);
+                    vz                     = madd(two, r[0] * ty - r[1] * tx, vz);
+                };
+
+                simd::vfloat x = simd::load(positions.x.data() + i);
+                simd::vfloat y = simd::load(positions.y.data() + i);
+                simd::vfloat z = simd::load(positions.z.data() + i);
+                rotate(x, y, z);
+
+                // Translation 2 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz))
+                const simd::vfloat two = simd::broadcast(2.f);
+                const simd::vfloat tx  = madd(r[3], d[0], madd(-d[3], r[0], r[1] * d[2] - r[2] * d[1]));
+                const simd::vfloat ty  = madd(r[3], d[1], madd(-d[3], r[1], r[2] * d[0] - r[0] * d[2]));
+                const simd::vfloat tz  = madd(r[3], d[2], madd(-d[3], r[2], r[0] * d[1] - r[1] * d[0]));
+                simd::store(outPositions.x.data() + i, madd(two, tx, x));
+                simd::store(outPositions.y.data() + i, madd(two, ty, y));
+                simd::store(outPositions.z.data() + i, madd(two, tz, z));
+
+                if (normals.size())
+                {
+                    simd::vfloat nx = simd::load(normals.x.data() + i);
+                    simd::vfloat ny = simd::load(normals.y.data() + i);
+                    simd::vfloat nz = simd::load(normals.z.data() + i);
+                    rotate(nx, ny, nz);
+                    Normalize(nx, ny, nz);
+                    simd::store(outNormals.x.data() + i, nx);
+                    simd::store(outNormals.y.data() + i, ny);
+                    simd::store(outNormals.z.data() + i, nz);
+                }
+            }
+            SkinScalar(palette, positions, normals, influences, outPositions, outNormals, i, last);
+        }
+    } // namespace detail
+
+    // Linear blend skinning: p' = sum(w_k * palette[b_k]) applied to p. Normals go through the
+    // same matrix and are renormalized, which is exact for rotations and uniform scales. normals
+    // and outNormals may be empty.
+    inline void SkinLinear(ThreadPool& pool, span<const float3x4> palette, ConstFloat3Stream positions, ConstFloat3Stream normals,
+                           const SkinInfluenceStream& influences, Float3Stream outPositions, Float3Stream outNormals)
+    {
+        detail::CheckSkinningStreams(positions, normals, influences, outPositions, outNormals);
+        pool.ParallelFor(0, positions.size(), kSkinningChunkSize, [&](size_t first, size_t last) {
+            detail::SkinLinearChunk(palette, positions, normals, influences, outPositions, outNormals, first, last);
+        });
+    }
+
+    inline void SkinLinear(span<const float3x4> palette, ConstFloat3Stream positions, ConstFloat3Stream normals,
+                           const SkinInfluenceStream& influences, Float3Stream outPositions, Float3Stream outNormals)
+    {
+        SkinLinear(ThreadPool::Default(), palette, positions, normals, influences, outPositions, outNormals);
+    }
+
+    // Dual quaternion skinning, the palette holding unit dual quaternions
+    inline void SkinDualQuaternion(ThreadPool& pool, span<const DualQuaternion> palette, ConstFloat3Stream positions,
+                                   ConstFloat3Stream normals, const SkinInfluenceStream& influences, Float3Stream outPositions,
+                                   Float3Stream outNormals)
+    {
+        detail::CheckSkinningStreams(positions, normals, influences, outPositions, outNormals);
+        pool.ParallelFor(0, positions.size(), kSkinningChunkSize, [&](size_t first, size_t last) {
+            detail::SkinDualQuaternionChunk(palette, positions, normals, influences, outPositions, outNormals, first, last);
+        });
+    }
+
+    inline void SkinDualQuaternion(span<const DualQuaternion> palette, ConstFloat3Stream positions, ConstFloat3Stream normals,
+                                   const SkinInfluenceStream& influences, Float3Stream outPositions, Float3Stream outNormals)
+    {
+        SkinDualQuaternion(ThreadPool::Default(), palette, positions, normals, influences, outPositions, outNormals);
+    }
+} // namespace math
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace math
+{
+    // Minimal non-owning view over a contiguous sequence, a subset of C++20 std::span
+    // (the solution is built with /std:c++17).
+    template <typename T>
+    class span
+    {
+    public:
+        using element_type = T;
+        using value_type   = std::remove_cv_t<T>;
+        using size_type    = size_t;
+        using pointer      = T*;
+        using reference    = T&;
+        using iterator     = T*;
+
+        span() noexcept = default;
+
+        span(T* data, size_t size) noexcept :
+            m_data(data), m_size(size) {}
+
+        template <size_t N>
+        span(T (&arr)[N]) noexcept :
+            m_data(arr), m_size(N) {}
+
+        template <typename U, size_t N, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+        span(std::array<U, N>& arr) noexcept :
+            m_data(arr.data()), m_size(N) {}
+
+        template <typename U, size_t N, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+        span(const std::array<U, N>& arr) noexcept :
+            m_data(arr.data()), m_size(N) {}
+
+        template <typename U, typename A, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+        span(std::vector<U, A>& vec) noexcept :
+            m_data(vec.data()), m_size(vec.size()) {}
+
+        template <typename U, typename A, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+        span(const std::vector<U, A>& vec) noexcept :
+            m_data(vec.data()), m_size(vec.size()) {}
+
+        // span<T> -> span<const T>
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+        span(const span<U>& other) noexcept :
+            m_data(other.data()), m_size(other.size()) {}
+
+        T*     data() const noexcept { return m_data; }
+        size_t size() const noexcept { return m_size; }
+        size_t size_bytes() const noexcept { return m_size * sizeof(T); }
+        bool   empty() const noexcept { return m_size == 0; }
+
+        T* begin() const noexcept { return m_data; }
+        T* end() const noexcept { return m_data + m_size; }
+
+        T& operator[](size_t index) const
+        {
+            assert(index < m_size);
+            return m_data[index];
+        }
+
+        span first(size_t count) const
+        {
+            assert(count <= m_size);
+            return span(m_data, count);
+        }
+
+        span last(size_t count) const
+        {
+            assert(count <= m_size);
+            return span(m_data + (m_size - count), count);
+        }
+
+        span subspan(size_t offset, size_t count) const
+        {
+            assert(offset + count <= m_size);
+            return span(m_data + offset, count);
+        }
+
+        span subspan(size_t offset) const
+        {
+            assert(offset <= m_size);
+            return span(m_data + offset, m_size - offset);
+        }
+
+    private:
+        T*     m_data = nullptr;
+        size_t m_size = 0;
+    };
+} // namespace math
@@ -0,0 +1,438 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+#include "Span.h"
+
+// Work-stealing thread pool for the data-parallel loops over spans of Math.h types:
+//
+//   parallel_for(items, body)                         body(subspan) on disjoint subspans
+//   parallel_reduce(items, identity, map, combine)    combine(... combine(identity, map(s0)), map(s1)) ...)
+//
+// Every worker owns a Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models", 2013): it pushes and pops tasks at the bottom, idle workers steal from the top.
+// A task is a range of indices. Its worker splits off the upper half into its deque whenever the
+// deque has run empty, and otherwise runs grain indices and looks again (lazy binary splitting,
+// Tzannes et al. 2010), so the number of tasks adapts to how many workers are hungry instead of
+// being fixed up front.
+//
+// Affinity: a loop starts with one contiguous block per worker, handed to the worker's mailbox,
+// so consecutive loops over the same data give each worker the same block and its caches stay
+// warm; stealing only moves the remainder. With pinThreads the workers are also bound to one
+// hardware thread each.
+//
+// The thread that calls a loop works on it as worker 0 until the loop is done. Loops may be
+// nested inside bodies; loops from several outside threads run one after the other.
+
+namespace math
+{
+    class ThreadPool
+    {
+    public:
+        // threads = 0 uses every hardware thread; the calling thread counts as one of them
+        explicit ThreadPool(unsigned threads = 0, bool pinThreads = false)
+        {
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+
+            m_workers = std::vector<Worker>(threads);
+            for (unsigned i = 1; i < threads; ++i)
+            {
+                m_threads.emplace_back([this, i] { WorkerLoop(i); });
+                if (pinThreads)
+                    Pin(m_threads.back(), i);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& thread : m_threads)
+                thread.join();
+        }
+
+        ThreadPool(const ThreadPool&)            = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+        // Shared pool with a worker per hardware thread, created on first use
+        static ThreadPool& Default()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        // body(first, last) on disjoint ranges covering [begin, end), each at least grain long
+        // unless it is the end of the range. grain = 0 picks one from the size of the range.
+        template <class Body>
+        void ParallelFor(size_t begin, size_t end, size_t grain, const Body& body)
+        {
+            if (begin >= end)
+                return;
+            const size_t count = end - begin;
+            if (grain == 0)
+                grain = std::clamp<size_t>(count / (16 * size()), 1, 4096);
+            if (size() == 1 || count <= grain)
+            {
+                body(begin, end);
+                return;
+            }
+
+            Job job;
+            job.body      = &body;
+            job.run       = [](const void* b, size_t first, size_t last) { (*static_cast<const Body*>(b))(first, last); };
+            job.grain     = grain;
+            job.remaining = count;
+
+            // Outside threads share worker 0, one loop at a time
+            std::unique_lock<std::mutex> callerLock;
+            unsigned                     self = CurrentWorker();
+            if (self == kNotAWorker)
+            {
+                callerLock = std::unique_lock<std::mutex>(m_callerMutex);
+                self       = 0;
+            }
+            const CurrentWorkerScope scope(this, self);
+
+            if (m_active++ == 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_wake.notify_all();
+            }
+
+            // One block per worker through the mailboxes, this worker keeps the first one. A full
+            // mailbox (the worker is still busy with a block of an outer loop) goes to our deque,
+            // and when that is full too we run the block right away.
+            const size_t blocks = std::min<size_t>(size(), (count + grain - 1) / grain);
+            for (size_t i = blocks; i-- > 1;)
+            {
+                const size_t first = begin + count * i / blocks, last = begin + count * (i + 1) / blocks;
+                Task*        task  = new Task{&job, first, last};
+                const size_t owner = (self + i) % size();
+                Task*        empty = nullptr;
+                if (!m_workers[owner].mailbox.compare_exchange_strong(empty, task) && !Push(self, task))
+                    Execute(self, task);
+            }
+            Execute(self, new Task{&job, begin, begin + count / blocks});
+
+            while (job.remaining.load(std::memory_order_acquire) != 0)
+            {
+                if (Task* task = FindTask(self))
+                    Execute(self, task);
+                else
+                    std::this_thread::yield();
+            }
+            --m_active;
+
+            if (job.error)
+                std::rethrow_exception(job.error);
+        }
+
+    private:
+        static constexpr unsigned kNotAWorker       = UINT32_MAX;
+        static constexpr int64_t  kDequeSize        = 256; // power of two; a task that does not fit runs at once
+        static constexpr int      kSpinsBeforeSleep = 64;
+
+        struct Job
+        {
+            const void*         body;
+            void                (*run)(const void* body, size_t first, size_t last);
+            size_t              grain;
+            std::atomic<size_t> remaining;
+            std::atomic<bool>   failed{false};
+            std::exception_ptr  error;
+        };
+
+        struct Task
+        {
+            Job*   job;
+            size_t first;
+            size_t last;
+        };
+
+        // The Chase-Lev deque of a worker and its mailbox, on their own cache lines
+        struct alignas(64) Worker
+        {
+            std::atomic<int64_t> top{0};
+            alignas(64) std::atomic<int64_t> bottom{0};
+            std::atomic<Task*>   tasks[kDequeSize] = {};
+            alignas(64) std::atomic<Task*> mailbox{nullptr};
+            uint32_t             random = 0;
+        };
+
+        struct CurrentWorkerScope
+        {
+            ThreadPool* previousPool;
+            unsigned    previousIndex;
+
+            CurrentWorkerScope(ThreadPool* pool, unsigned index) :
+                previousPool(CurrentPool()), previousIndex(CurrentIndex())
+            {
+                CurrentPool()  = pool;
+                CurrentIndex() = index;
+            }
+
+            ~CurrentWorkerScope()
+            {
+                CurrentPool()  = previousPool;
+                CurrentIndex() = previousIndex;
+            }
+        };
+
+        static ThreadPool*& CurrentPool()
+        {
+            static thread_local ThreadPool* pool = nullptr;
+            return pool;
+        }
+
+        static unsigned& CurrentIndex()
+        {
+            static thread_local unsigned index = kNotAWorker;
+            return index;
+        }
+
+        unsigned CurrentWorker() const { return CurrentPool() == this ? CurrentIndex() : kNotAWorker; }
+
+        // Owner only
+        bool Push(unsigned self, Task* task)
+        {
+            Worker&       w = m_workers[self];
+            const int64_t b = w.bottom.load(std::memory_order_relaxed);
+            const int64_t t = w.top.load(std::memory_order_acquire);
+            if (b - t >= kDequeSize)
+                return false;
+            w.tasks[b & (kDequeSize - 1)].store(task, std::memory_order_relaxed);
+            w.bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Owner only
+        Task* Pop(unsigned self)
+        {
+            Worker&       w = m_workers[self];
+            const int64_t b = w.bottom.load(std::memory_order_relaxed) - 1;
+            w.bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = w.top.load(std::memory_order_relaxed);
+            if (t > b)
+            {
+                w.bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            Task* task = w.tasks[b & (kDequeSize - 1)].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // The last task, thieves may want it too
+                if (!w.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    task = nullptr;
+                w.bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+
+        Task* Steal(unsigned victim)
+        {
+            Worker& w = m_workers[victim];
+            int64_t t = w.top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t b = w.bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return nullptr;
+            Task* task = w.tasks[t & (kDequeSize - 1)].load(std::memory_order_relaxed);
+            return w.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) ? task : nullptr;
+        }
+
+        bool DequeEmpty(unsigned self) const
+        {
+            const Worker& w = m_workers[self];
+            return w.bottom.load(std::memory_order_relaxed) <= w.top.load(std::memory_order_relaxed);
+        }
+
+        // Own mailbox, own deque, then the deques and mailboxes of the others from a random start
+        Task* FindTask(unsigned self)
+        {
+            Worker& w = m_workers[self];
+            if (Task* task = w.mailbox.exchange(nullptr, std::memory_order_acquire))
+                return task;
+            if (Task* task = Pop(self))
+                return task;
+
+            w.random = w.random * 1664525u + 1013904223u;
+            const unsigned n     = size();
+            const unsigned start = (w.random >> 16) % n;
+            for (unsigned i = 0; i < n; ++i)
+            {
+                const unsigned victim = (start + i) % n;
+                if (victim == self)
+                    continue;
+                if (Task* task = Steal(victim))
+                    return task;
+                if (Task* task = m_workers[victim].mailbox.exchange(nullptr, std::memory_order_acquire))
+                    return task;
+            }
+            return nullptr;
+        }
+
+        void Execute(unsigned self, Task* task)
+        {
+            Job&   job   = *task->job;
+            size_t first = task->first, last = task->last;
+            delete task;
+
+            size_t done = 0;
+            while (first < last)
+            {
+                // Share the upper half while nobody can steal from us, else run a grain
+                if (last - first >= 2 * job.grain && DequeEmpty(self))
+                {
+                    const size_t middle = first + (last - first) / 2;
+                    Task*        upper  = new Task{&job, middle, last};
+                    if (Push(self, upper))
+                    {
+                        last = middle;
+                        continue;
+                    }
+                    delete upper;
+                }
+
+                const size_t end = last - first > job.grain ? first + job.grain : last;
+                if (!job.failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        job.run(job.body, first, end);
+                    }
+                    catch (...)
+                    {
+                        if (!job.failed.exchange(true))
+                            job.error = std::current_exception();
+                    }
+                }
+                done += end - first;
+                first = end;
+            }
+            // The last access to the job: the caller may return once remaining reaches 0
+            job.remaining.fetch_sub(done, std::memory_order_acq_rel);
+        }
+
+        void WorkerLoop(unsigned self)
+        {
+            const CurrentWorkerScope scope(this, self);
+            m_workers[self].random = self * 2654435761u;
+
+            int idle = 0;
+            while (true)
+            {
+                if (Task* task = FindTask(self))
+                {
+                    Execute(self, task);
+                    idle = 0;
+                    continue;
+                }
+                if (m_active.load(std::memory_order_relaxed) > 0 || ++idle < kSpinsBeforeSleep)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || m_active.load() > 0; });
+                if (m_stop)
+                    return;
+                idle = 0;
+            }
+        }
+
+        static void Pin(std::thread& thread, unsigned index)
+        {
+            const unsigned cpu = index % std::max(1u, std::thread::hardware_concurrency());
+#if defined(_WIN32)
+            if (cpu < 64)
+                SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu);
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+            (void)thread, (void)cpu;
+#endif
+        }
+
+        std::vector<Worker>      m_workers;
+        std::vector<std::thread> m_threads;
+        std::atomic<unsigned>    m_active{0}; // loops in progress; the workers sleep when there are none
+        std::mutex               m_callerMutex;
+        std::mutex               m_mutex;
+        std::condition_variable  m_wake;
+        bool                     m_stop = false;
+    };
+
+    // body(subspan) on disjoint subspans covering items, in parallel on the pool.
+    // grain is the smallest subspan worth a task, 0 picks one from items.size().
+    template <class T, class Body>
+    void parallel_for(ThreadPool& pool, span<T> items, const Body& body, size_t grain = 0)
+    {
+        pool.ParallelFor(0, items.size(), grain, [&](size_t first, size_t last) { body(items.subspan(first, last - first)); });
+    }
+
+    template <class T, class Body>
+    void parallel_for(span<T> items, const Body& body, size_t grain = 0)
+    {
+        parallel_for(ThreadPool::Default(), items, body, grain);
+    }
+
+    // map(subspan) on subspans of grain items, in parallel, then combine over the results from
+    // left to right. The split depends only on items.size() and grain, so floating point results
+    // are the same from run to run and with any number of threads.
+    template <class T, class R, class Map, class Combine>
+    R parallel_reduce(ThreadPool& pool, span<T> items, R identity, const Map& map, const Combine& combine, size_t grain = 0)
+    {
+        if (grain == 0)
+            grain = std::clamp<size_t>(items.size() / 64, 1, 4096);
+        const size_t   blocks = (items.size() + grain - 1) / grain;
+        std::vector<R> partial(blocks, identity);
+        pool.ParallelFor(0, blocks, 1, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; ++block)
+                partial[block] = map(items.subspan(block * grain, std::min(grain, items.size() - block * grain)));
+        });
+
+        R result = identity;
+        for (const R& value : partial)
+            result = combine(result, value);
+        return result;
+    }
+
+    template <class T, class R, class Map, class Combine>
+    R parallel_reduce(span<T> items, R identity, const Map& map, const Combine& combine, size_t grain = 0)
+    {
+        return parallel_reduce(ThreadPool::Default(), items, identity, map, combine, grain);
+    }
+} // namespace math
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+#include "ThreadPool.h"
+
+// Scene graph transforms: every node has a local translation, rotation and scale relative to its
+// parent, and a world matrix
+//
+//   world = Scale(scale) * rotation.ToMatrix() * Translation(translation) * world(parent)
+//
+// (row vectors, p' = float4(p, 1) * world). Roots use the local matrix as world matrix.
+//
+// Nodes are stored breadth first: all roots, then all nodes of depth 1, and so on, the children
+// of a node next to each other. The local transforms are structures of arrays in that order.
+// SetLocal marks a node dirty; Update recomputes the world matrices of the dirty nodes and their
+// descendants, one depth level after the other, and leaves everything else alone, so its cost
+// follows the number of nodes that moved rather than the size of the scene.
+//
+// Within a level the dirty nodes are independent: simd::kWidth of them are computed at a time,
+// gathering their local transforms and parent world matrices, and levels with more than
+// kTransformChunkSize dirty nodes are split into chunks that run on a ThreadPool. Every node goes
+// through the same SIMD code, so a world matrix does not depend on which other nodes were updated
+// with it.
+
+namespace math
+{
+    class TransformHierarchy
+    {
+    public:
+        static constexpr uint32_t kNoParent           = UINT32_MAX;
+        static constexpr size_t   kTransformChunkSize = 1024;
+
+        TransformHierarchy() = default;
+
+        // parents[i] is the parent of node i or kNoParent; the parents must form a forest. Every
+        // local transform starts as the identity, and the first Update computes all world matrices.
+        explicit TransformHierarchy(span<const uint32_t> parents)
+        {
+            const uint32_t count = static_cast<uint32_t>(parents.size());
+
+            // Children of each node, in node order
+            std::vector<uint32_t> childStart(size_t(count) + 1, 0), children(count);
+            for (uint32_t parent : parents)
+                if (parent != kNoParent)
+                {
+                    assert(parent < count);
+                    ++childStart[parent + 1];
+                }
+            for (uint32_t i = 0; i < count; ++i)
+                childStart[i + 1] += childStart[i];
+            std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+            for (uint32_t i = 0; i < count; ++i)
+                if (parents[i] != kNoParent)
+                    children[fill[parents[i]]++] = i;
+
+            // Breadth first: the roots, then the children of every slot in slot order
+            m_nodes.reserve(count);
+            for (uint32_t i = 0; i < count; ++i)
+                if (parents[i] == kNoParent)
+                    m_nodes.push_back(i);
+            m_parents.assign(m_nodes.size(), kNoParent);
+            m_levels.assign(m_nodes.size(), 0);
+            m_firstChild.resize(count);
+            m_childCount.resize(count);
+            for (uint32_t slot = 0; slot < m_nodes.size(); ++slot)
+            {
+                const uint32_t node = m_nodes[slot];
+                m_firstChild[slot]  = static_cast<uint32_t>(m_nodes.size());
+                m_childCount[slot]  = childStart[node + 1] - childStart[node];
+                for (uint32_t c = childStart[node]; c < childStart[node + 1]; ++c)
+                {
+                    m_nodes.push_back(children[c]);
+                    m_parents.push_back(slot);
+                    m_levels.push_back(m_levels[slot] + 1);
+                }
+            }
+            assert(m_nodes.size() == count && "parents contain a cycle");
+
+            m_slots.resize(count);
+            for (uint32_t slot = 0; slot < count; ++slot)
+                m_slots[m_nodes[slot]] = slot;
+
+            for (auto* stream : {&m_translation[0], &m_translation[1], &m_translation[2], &m_rotation[0], &m_rotation[1], &m_rotation[2]})
+                stream->assign(count, 0.f);
+            for (auto* stream : {&m_rotation[3], &m_scale[0], &m_scale[1], &m_scale[2]})
+                stream->assign(count, 1.f);
+            m_world.resize(count);
+
+            // The roots are dirty, which makes everything else dirty
+            m_dirty.assign(count, 0);
+            m_dirtyLevels.resize(count == 0 ? 0 : m_levels.back() + 1);
+            for (uint32_t slot = 0; slot < count && m_parents[slot] == kNoParent; ++slot)
+                MarkDirty(slot);
+        }
+
+        size_t size() const { return m_nodes.size(); }
+
+        uint32_t Parent(uint32_t node) const
+        {
+            const uint32_t parent = m_parents[m_slots[node]];
+            return parent == kNoParent ? kNoParent : m_nodes[parent];
+        }
+
+        // Takes effect with the next Update
+        void SetLocal(uint32_t node, const float3& translation, const Quaternion& rotation, const float3& scale)
+        {
+            const uint32_t slot = m_slots[node];
+            for (int i = 0; i < 3; ++i)
+            {
+                m_translation[i][slot] = translation[i];
+                m_scale[i][slot]       = scale[i];
+            }
+            for (int i = 0; i < 4; ++i)
+                m_rotation[i][slot] = rotation.q[i];
+            MarkDirty(slot);
+        }
+
+        float3 GetLocalTranslation(uint32_t node) const
+        {
+            const uint32_t slot = m_slots[node];
+            return float3(m_translation[0][slot], m_translation[1][slot], m_translation[2][slot]);
+        }
+
+        Quaternion GetLocalRotation(uint32_t node) const
+        {
+            const uint32_t slot = m_slots[node];
+            return Quaternion(m_rotation[0][slot], m_rotation[1][slot], m_rotation[2][slot], m_rotation[3][slot]);
+        }
+
+        float3 GetLocalScale(uint32_t node) const
+        {
+            const uint32_t slot = m_slots[node];
+            return float3(m_scale[0][slot], m_scale[1][slot], m_scale[2][slot]);
+        }
+
+        // As of the last Update
+        const float4x4& GetWorld(uint32_t node) const { return m_world[m_slots[node]]; }
+
+        // Recomputes the world matrices of the dirty nodes and their descendants and returns
+        // their number
+        size_t Update(ThreadPool& pool)
+        {
+            size_t updated = 0;
+            for (size_t level = 0; level < m_dirtyLevels.size(); ++level)
+            {
+                std::vector<uint32_t>& dirty = m_dirtyLevels[level];
+                if (dirty.empty())
+                    continue;
+
+                ComputeWorld(dirty, pool);
+                for (uint32_t slot : dirty)
+                {
+                    for (uint32_t child = m_firstChild[slot]; child < m_firstChild[slot] + m_childCount[slot]; ++child)
+                        MarkDirty(child);
+                    m_dirty[slot] = 0;
+                }
+                updated += dirty.size();
+                dirty.clear();
+            }
+            return updated;
+        }
+
+        size_t Update() { return Update(ThreadPool::Default()); }
+
+    private:
+        void MarkDirty(uint32_t slot)
+        {
+            if (!m_dirty[slot])
+            {
+                m_dirty[slot] = 1;
+                m_dirtyLevels[m_levels[slot]].push_back(slot);
+            }
+        }
+
+        // World matrices of the given slots, all of one level
+        void ComputeWorld(const std::vector<uint32_t>& slots, ThreadPool& pool)
+        {
+            pool.ParallelFor(0, slots.size(), kTransformChunkSize, [&](size_t first, size_t last) {
+                ComputeWorld(span<const uint32_t>(slots.data() + first, last - first));
+            });
+        }
+
+        void ComputeWorld(span<const uint32_t> slots)
+        {
+            using namespace simd;
+
+            const bool roots = m_parents[slots[0]] == kNoParent;
+
+            for (size_t i = 0; i < slots.size(); i += kWidth)
+            {
+                // The last batch repeats the last slot
+                uint32_t lanes[kWidth];
+                for (size_t lane = 0; lane < kWidth; ++lane)
+                    lanes[lane] = slots[std::min(i + lane, slots.size() - 1)];
+
+                // Dirty runs are often consecutive slots, e.g. every node of a moving subtree
+                bool consecutive = true;
+                for (size_t lane = 1; lane < kWidth; ++lane)
+                    consecutive &= lanes[lane] == lanes[0] + lane;
+                const vint slot  = load(lanes);
+                auto       fetch = [&](const std::vector<float>& stream) {
+                    return consecutive ? load(stream.data() + lanes[0]) : gather(stream.data(), slot);
+                };
+
+                const vfloat x = fetch(m_rotation[0]), y = fetch(m_rotation[1]), z = fetch(m_rotation[2]), w = fetch(m_rotation[3]);
+                const vfloat sx = fetch(m_scale[0]), sy = fetch(m_scale[1]), sz = fetch(m_scale[2]);
+
+                // Rows of Scale * rotation.ToMatrix(), then the translation
+                const vfloat x2 = x + x, y2 = y + y, z2 = z + z;
+                const vfloat xx2 = x * x2, yy2 = y * y2, zz2 = z * z2;
+                const vfloat xy2 = x * y2, xz2 = x * z2, yz2 = y * z2;
+                const vfloat wx2 = w * x2, wy2 = w * y2, wz2 = w * z2;
+                const vfloat unit = broadcast(1.f);
+
+                vfloat local[4][3] = {
+                    {sx * (unit - yy2 - zz2), sx * (xy2 + wz2), sx * (xz2 - wy2)},
+                    {sy * (xy2 - wz2), sy * (unit - xx2 - zz2), sy * (yz2 + wx2)},
+                    {sz * (xz2 + wy2), sz * (yz2 - wx2), sz * (unit - xx2 - yy2)},
+                    {fetch(m_translation[0]), fetch(m_translation[1]), fetch(m_translation[2])},
+                };
+
+                vfloat world[4][3];
+                if (roots)
+                {
+                    for (int r = 0; r < 4; ++r)
+                        for (int c = 0; c < 3; ++c)
+                            world[r][c] = local[r][c];
+                }
+                else
+                {
+                    // local * parent, both affine
+                    uint32_t parents[kWidth];
+                    for (size_t lane = 0; lane < kWidth; ++lane)
+                        parents[lane] = m_parents[lanes[lane]];
+
+                    const float* base     = &m_world[0].m[0][0];
+                    const vint   elements = load(parents) << 4;
+                    vfloat       parent[4][3];
+                    for (int r = 0; r < 4; ++r)
+                        for (int c = 0; c < 3; ++c)
+                            parent[r][c] = gather(base, elements + broadcast_int(4 * r + c));
+
+                    for (int r = 0; r < 4; ++r)
+                        for (int c = 0; c < 3; ++c)
+                            world[r][c] = madd(local[r][0], parent[0][c], madd(local[r][1], parent[1][c], local[r][2] * parent[2][c]));
+                    for (int c = 0; c < 3; ++c)
+                        world[3][c] = world[3][c] + parent[3][c];
+                }
+
+                float values[4][3][kWidth];
+                for (int r = 0; r < 4; ++r)
+                    for (int c = 0; c < 3; ++c)
+                        store(values[r][c], world[r][c]);
+                for (size_t lane = 0; lane < kWidth && i + lane < slots.size(); ++lane)
+                {
+                    float4x4& out = m_world[lanes[lane]];
+                    for (int r = 0; r < 4; ++r)
+                    {
+                        for (int c = 0; c < 3; ++c)
+                            out.m[r][c] = values[r][c][lane];
+                        out.m[r][3] = r == 3 ? 1.f : 0.f;
+                    }
+                }
+            }
+        }
+
+        std::vector<uint32_t> m_nodes;      // node of each slot
+        std::vector<uint32_t> m_slots;      // slot of each node
+        std::vector<uint32_t> m_parents;    // parent slot of each slot
+        std::vector<uint32_t> m_levels;     // depth of each slot
+        std::vector<uint32_t> m_firstChild; // the children of a slot are m_childCount slots from here
+        std::vector<uint32_t> m_childCount;
+
+        std::vector<float>    m_translation[3];
+        std::vector<float>    m_rotation[4];
+        std::vector<float>    m_scale[3];
+        std::vector<float4x4> m_world;
+
+        std::vector<uint8_t>               m_dirty;
+        std::vector<std::vector<uint32_t>> m_dirtyLevels; // dirty slots of each level
+    };
+} // namespace math
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Math.h"
+#include "Span.h"
+
+// Opt-in expression templates for the Math.h vectors.
+//
+// lazy() wraps a vector, a scalar or a span of either; the operators on the wrapped values
+// build an expression tree instead of computing intermediate vectors, and eval() / assign()
+// compute the whole expression component by component:
+//
+//   float3 r = eval(lazy(v) + 2.f * cross(lazy(axis), cross(lazy(axis), lazy(v)) + q.w * lazy(v)));
+//   assign(out, lazy(a) * (1.f - w) + lazy(b) * w);                  // spans of float4, one pass
+//   assign(out, lazy(a) + lazy(weights) * (lazy(b) - lazy(a)));     // per-element weights
+//
+// Everything is resolved at compile time: component indices are template arguments, so an
+// expression inlines to the same scalar code one would write by hand. Scalars (plain values,
+// dot() and spans of scalars) broadcast to all components. Subexpressions that are read more
+// than once, like the operands of cross() or dot(), are recomputed and left to the optimizer;
+// eval() an inner expression to compute it once.
+//
+// Leaves hold references: an expression must not outlive the vectors and spans it was built
+// from, so use it in the statement that builds it.
+
+namespace math::expr
+{
+    template <class E>
+    struct Expr
+    {
+        const E& Self() const { return static_cast<const E&>(*this); }
+    };
+
+    namespace detail
+    {
+        template <class V>
+        struct VectorTraits
+        {
+            static constexpr int kSize = 0;
+        };
+        template <class T>
+        struct VectorTraits<Vector2<T>>
+        {
+            using Scalar                = T;
+            static constexpr int kSize = 2;
+        };
+        template <class T>
+        struct VectorTraits<Vector3<T>>
+        {
+            using Scalar                = T;
+            static constexpr int kSize = 3;
+        };
+        template <class T>
+        struct VectorTraits<Vector4<T>>
+        {
+            using Scalar                = T;
+            static constexpr int kSize = 4;
+        };
+
+        template <class T, int N>
+        struct VectorOf;
+        template <class T>
+        struct VectorOf<T, 2>
+        {
+            using Type = Vector2<T>;
+        };
+        template <class T>
+        struct VectorOf<T, 3>
+        {
+            using Type = Vector3<T>;
+        };
+        template <class T>
+        struct VectorOf<T, 4>
+        {
+            using Type = Vector4<T>;
+        };
+
+        template <int I, class V>
+        auto Component(const V& v)
+        {
+            static_assert(I < VectorTraits<V>::kSize, "component out of range");
+            if constexpr (I == 0)
+                return v.x;
+            else if constexpr (I == 1)
+                return v.y;
+            else if constexpr (I == 2)
+                return v.z;
+            else
+                return v.w;
+        }
+
+        // Size of a binary node: 0 stands for a scalar, which broadcasts
+        template <class A, class B>
+        constexpr int CombinedSize()
+        {
+            static_assert(A::kSize == 0 || B::kSize == 0 || A::kSize == B::kSize, "vectors of different sizes");
+            return A::kSize > B::kSize ? A::kSize : B::kSize;
+        }
+
+        // Elements in the spans of an expression, SIZE_MAX if it has none
+        constexpr size_t CombinedCount(size_t a, size_t b)
+        {
+            assert(a == SIZE_MAX || b == SIZE_MAX || a == b);
+            return a < b ? a : b;
+        }
+
+        struct Add
+        {
+            template <class T, class U>
+            static auto Apply(T a, U b) { return a + b; }
+        };
+        struct Subtract
+        {
+            template <class T, class U>
+            static auto Apply(T a, U b) { return a - b; }
+        };
+        struct Multiply
+        {
+            template <class T, class U>
+            static auto Apply(T a, U b) { return a * b; }
+        };
+        struct Divide
+        {
+            template <class T, class U>
+            static auto Apply(T a, U b) { return a / b; }
+        };
+    } // namespace detail
+
+
+    // Leaves. Get<I>(k) is component I of element k; leaves without spans ignore k.
+
+    template <class V>
+    struct VectorRef : Expr<VectorRef<V>>
+    {
+        using Scalar               = typename detail::VectorTraits<V>::Scalar;
+        static constexpr int kSize = detail::VectorTraits<V>::kSize;
+
+        const V& v;
+
+        explicit VectorRef(const V& _v) :
+            v(_v) {}
+
+        template <int I>
+        Scalar Get(size_t) const { return detail::Component<I>(v); }
+
+        size_t Count() const { return SIZE_MAX; }
+    };
+
+    template <class T>
+    struct ScalarValue : Expr<ScalarValue<T>>
+    {
+        using Scalar               = T;
+        static constexpr int kSize = 0;
+
+        T s;
+
+        explicit ScalarValue(T _s) :
+            s(_s) {}
+
+        template <int I>
+        T Get(size_t) const { return s; }
+
+        size_t Count() const { return SIZE_MAX; }
+    };
+
+    template <class V>
+    struct VectorSpan : Expr<VectorSpan<V>>
+    {
+        using Scalar               = typename detail::VectorTraits<V>::Scalar;
+        static constexpr int kSize = detail::VectorTraits<V>::kSize;
+
+        span<const V> elements;
+
+        explicit VectorSpan(span<const V> _elements) :
+            elements(_elements) {}
+
+        template <int I>
+        Scalar Get(size_t k) const { return detail::Component<I>(elements.data()[k]); }
+
+        size_t Count() const { return elements.size(); }
+    };
+
+    template <class T>
+    struct ScalarSpan : Expr<ScalarSpan<T>>
+    {
+        using Scalar               = T;
+        static constexpr int kSize = 0;
+
+        span<const T> elements;
+
+        explicit ScalarSpan(span<const T> _elements) :
+            elements(_elements) {}
+
+        template <int I>
+        T Get(size_t k) const { return elements.data()[k]; }
+
+        size_t Count() const { return elements.size(); }
+    };
+
+
+    // Nodes, held by value so that temporaries inside an expression stay alive
+
+    template <class Op, class A, class B>
+    struct Binary : Expr<Binary<Op, A, B>>
+    {
+        using Scalar               = decltype(Op::Apply(std::declval<typename A::Scalar>(), std::declval<typename B::Scalar>()));
+        static constexpr int kSize = detail::CombinedSize<A, B>();
+
+        A a;
+        B b;
+
+        Binary(const A& _a, const B& _b) :
+            a(_a), b(_b) {}
+
+        template <int I>
+        Scalar Get(size_t k) const { return Op::Apply(a.template Get<I>(k), b.template Get<I>(k)); }
+
+        size_t Count() const { return detail::CombinedCount(a.Count(), b.Count()); }
+    };
+
+    template <class A>
+    struct Negate : Expr<Negate<A>>
+    {
+        using Scalar               = typename A::Scalar;
+        static constexpr int kSize = A::kSize;
+
+        A a;
+
+        explicit Negate(const A& _a) :
+            a(_a) {}
+
+        template <int I>
+        Scalar Get(size_t k) const { return -a.template Get<I>(k); }
+
+        size_t Count() const { return a.Count(); }
+    };
+
+    template <class A, class B>
+    struct Cross : Expr<Cross<A, B>>
+    {
+        static_assert(A::kSize == 3 && B::kSize == 3, "cross needs 3 component vectors");
+        using Scalar               = decltype(std::declval<typename A::Scalar>() * std::declval<typename B::Scalar>());
+        static constexpr int kSize = 3;
+
+        A a;
+        B b;
+
+        Cross(const A& _a, const B& _b) :
+            a(_a), b(_b) {}
+
+        template <int I>
+        Scalar Get(size_t k) const
+        {
+            constexpr int i1 = (I + 1) % 3;
+            constexpr int i2 = (I + 2) % 3;
+            return a.template Get<i1>(k) * b.template Get<i2>(k) - a.template Get<i2>(k) * b.template Get<i1>(k);
+        }
+
+        size_t Count() const { return detail::CombinedCount(a.Count(), b.Count()); }
+    };
+
+    // A scalar: broadcasts when combined with vectors
+    template <class A, class B>
+    struct Dot : Expr<Dot<A, B>>
+    {
+        static_assert(A::kSize != 0 && A::kSize == B::kSize, "dot needs two vectors of the same size");
+        using Scalar               = decltype(std::declval<typename A::Scalar>() * std::declval<typename B::Scalar>());
+        static constexpr int kSize = 0;
+
+        A a;
+        B b;
+
+        Dot(const A& _a, const B& _b) :
+            a(_a), b(_b) {}
+
+        template <int I>
+        Scalar Get(size_t k) const { return Sum(k, std::make_integer_sequence<int, A::kSize>()); }
+
+        size_t Count() const { return detail::CombinedCount(a.Count(), b.Count()); }
+
+    private:
+        template <int... J>
+        Scalar Sum(size_t k, std::integer_sequence<int, J...>) const
+        {
+            Scalar sum = 0;
+            ((sum += a.template Get<J>(k) * b.template Get<J>(k)), ...);
+            return sum;
+        }
+    };
+
+
+    // Entry points
+
+    template <class T>
+    VectorRef<Vector2<T>> lazy(const Vector2<T>& v) { return VectorRef<Vector2<T>>(v); }
+    template <class T>
+    VectorRef<Vector3<T>> lazy(const Vector3<T>& v) { return VectorRef<Vector3<T>>(v); }
+    template <class T>
+    VectorRef<Vector4<T>> lazy(const Vector4<T>& v) { return VectorRef<Vector4<T>>(v); }
+
+    template <class V, class U = std::remove_const_t<V>, class = std::enable_if_t<detail::VectorTraits<U>::kSize != 0>>
+    VectorSpan<U> lazy(span<V> elements) { return VectorSpan<U>(elements); }
+
+    template <class V, class A, class = std::enable_if_t<detail::VectorTraits<V>::kSize != 0>>
+    VectorSpan<V> lazy(const std::vector<V, A>& elements) { return VectorSpan<V>(span<const V>(elements.data(), elements.size())); }
+
+    template <class V, class = std::enable_if_t<std::is_same_v<std::remove_const_t<V>, float>>>
+    ScalarSpan<float> lazy(span<V> elements) { return ScalarSpan<float>(elements); }
+
+    template <class A>
+    ScalarSpan<float> lazy(const std::vector<float, A>& elements) { return ScalarSpan<float>(span<const float>(elements.data(), elements.size())); }
+
+
+    // Operators. An arithmetic operand is a ScalarValue.
+
+    namespace detail
+    {
+        template <class T>
+        using EnableIfArithmetic = std::enable_if_t<std::is_arithmetic_v<T>>;
+    }
+
+#define MATH_EXPR_BINARY_OPERATOR(OP, NAME)                                                                \
+    template <class A, class B>                                                                            \
+    Binary<detail::NAME, A, B> operator OP(const Expr<A>& a, const Expr<B>& b)                             \
+    {                                                                                                      \
+        return {a.Self(), b.Self()};                                                                       \
+    }                                                                                                      \
+    template <class A, class T, class = detail::EnableIfArithmetic<T>>                                     \
+    Binary<detail::NAME, A, ScalarValue<T>> operator OP(const Expr<A>& a, T b)                             \
+    {                                                                                                      \
+        return {a.Self(), ScalarValue<T>(b)};                                                              \
+    }                                                                                                      \
+    template <class T, class B, class = detail::EnableIfArithmetic<T>>                                     \
+    Binary<detail::NAME, ScalarValue<T>, B> operator OP(T a, const Expr<B>& b)                             \
+    {                                                                                                      \
+        return {ScalarValue<T>(a), b.Self()};                                                              \
+    }
+
+    MATH_EXPR_BINARY_OPERATOR(+, Add)
+    MATH_EXPR_BINARY_OPERATOR(-, Subtract)
+    MATH_EXPR_BINARY_OPERATOR(*, Multiply)
+    MATH_EXPR_BINARY_OPERATOR(/, Divide)
+
+#undef MATH_EXPR_BINARY_OPERATOR
+
+    template <class A>
+    Negate<A> operator-(const Expr<A>& a)
+    {
+        return Negate<A>(a.Self());
+    }
+
+    template <class A, class B>
+    Cross<A, B> cross(const Expr<A>& a, const Expr<B>& b)
+    {
+        return {a.Self(), b.Self()};
+    }
+
+    template <class A, class B>
+    Dot<A, B> dot(const Expr<A>& a, const Expr<B>& b)
+    {
+        return {a.Self(), b.Self()};
+    }
+
+
+    namespace detail
+    {
+        template <class V, class E, int... I>
+        V Make(const E& e, size_t k, std::integer_sequence<int, I...>)
+        {
+            return V(static_cast<typename VectorTraits<V>::Scalar>(e.template Get<I>(k))...);
+        }
+    } // namespace detail
+
+    // Computes an expression without spans. The result has the expression's scalar type:
+    // float for float vectors.
+    template <class E>
+    auto eval(const Expr<E>& e)
+    {
+        static_assert(E::kSize != 0, "the expression is a scalar, use Get<0>(0)");
+        const E& self = e.Self();
+        assert(self.Count() == SIZE_MAX);
+        using V = typename detail::VectorOf<typename E::Scalar, E::kSize>::Type;
+        return detail::Make<V>(self, 0, std::make_integer_sequence<int, E::kSize>());
+    }
+
+    // out[k] = element k of the expression, for every element of the spans in it. out may
+    // alias an input span when every element only reads its own index, as all nodes here do.
+    template <class V, class E>
+    void assign(span<V> out, const Expr<E>& e)
+    {
+        static_assert(detail::VectorTraits<V>::kSize == E::kSize, "result and expression sizes differ");
+        const E& self = e.Self();
+        assert(self.Count() == SIZE_MAX || self.Count() == out.size());
+
+        V* dst = out.data();
+        for (size_t k = 0, count = out.size(); k < count; ++k)
+            dst[k] = detail::Make<V>(self, k, std::make_integer_sequence<int, E::kSize>());
+    }
+
+    template <class V, class A, class E>
+    void assign(std::vector<V, A>& out, const Expr<E>& e)
+    {
+        assign(span<V>(out.data(), out.size()), e);
+    }
+} // namespace math::expr
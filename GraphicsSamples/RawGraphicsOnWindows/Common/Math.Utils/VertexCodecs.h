@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Math.h"
+#include "Simd.h"
+#include "Span.h"
+
+// Normalized integer vertex formats, decoded the way the DXGI_FORMAT_*_UNORM / *_SNORM input
+// layouts read them, to shrink vertex streams:
+//
+//   unorm8/16     [0, 1]  -> 0 .. 2^n - 1, decoded as c / (2^n - 1)
+//   snorm8/16     [-1, 1] -> -(2^(n-1) - 1) .. 2^(n-1) - 1, decoded as max(c / (2^(n-1) - 1), -1)
+//   R10G10B10A2   unorm 10:10:10:2 in one uint32, r in the low bits (DXGI_FORMAT_R10G10B10A2_UNORM)
+//   Octahedral    a unit vector projected onto the octahedron, the lower half folded over the
+//                 diagonals, stored as two snorm16 in one uint32 with u in the low half
+//                 (Cigolle et al., "A Survey of Efficient Representations for Independent Unit
+//                 Vectors", JCGT 2014)
+//
+// Encoding clamps, rounds to nearest with ties away from zero and maps NaN to 0, so decoding
+// returns the clamped value within half a step, plus the rounding of the float division:
+// 1 / (2 * (2^n - 1)) for unorm and 1 / (2 * (2^(n-1) - 1)) for snorm, e.g. 2.0e-3 for unorm8
+// and 1.6e-5 for snorm16. Octahedral normals decode to unit length within 0.004 degrees of the
+// original direction (measured by the VertexCodecs benchmark); the zero vector decodes to +z. unorm8x4 is the RGBA8 format of
+// F4Color_To_RGBA8Unorm, with the same rounding.
+//
+// The span versions run simd::kWidth values at a time and pad the tail, so every element goes
+// through the same code; without SIMD they loop over the single value functions, as do the
+// float3/float4 encoders with AVX-512, where the compiler vectorizes that loop wider.
+
+namespace math
+{
+    namespace detail
+    {
+        constexpr float kUnorm2Scale  = 3.f;
+        constexpr float kUnorm8Scale  = 255.f;
+        constexpr float kUnorm10Scale = 1023.f;
+        constexpr float kUnorm16Scale = 65535.f;
+        constexpr float kSnorm8Scale  = 127.f;
+        constexpr float kSnorm16Scale = 32767.f;
+
+        // With AVX-512 the compiler vectorizes the single value encoders of whole vectors 16
+        // wide by itself, which beats the 8-wide simd::vfloat kernels and their interleave
+        // shuffles, so the span versions just loop there
+#if defined(MATH_SIMD_AVX512)
+        constexpr bool kLoopVectorEncode = true;
+#else
+        constexpr bool kLoopVectorEncode = simd::kWidth == 1;
+#endif
+
+        // a * b + c rounded like simd::madd, so that the scalar and span versions agree
+        inline float MultiplyAdd(float a, float b, float c)
+        {
+#if defined(MATH_SIMD_FMA)
+            return std::fma(a, b, c);
+#else
+            return a * b + c;
+#endif
+        }
+
+        // Clamped to [low, 1], scaled and rounded with ties away from zero, NaN -> 0
+        inline int32_t Quantize(float x, float low, float scale)
+        {
+            x = x == x ? std::min(std::max(x, low), 1.f) : 0.f;
+            return static_cast<int32_t>(MultiplyAdd(x, scale, x < 0.f ? -0.5f : 0.5f));
+        }
+
+        inline simd::vint Quantize(simd::vfloat x, float low, float scale)
+        {
+            const simd::vfloat zero    = simd::broadcast(0.f);
+            const simd::vfloat clamped = simd::min(simd::max(x, simd::broadcast(low)), simd::broadcast(1.f));
+            x                          = simd::select(x == x, clamped, zero);
+            const simd::vfloat half    = simd::select(x < zero, simd::broadcast(-0.5f), simd::broadcast(0.5f));
+            return simd::convert_trunc(simd::madd(x, simd::broadcast(scale), half));
+        }
+
+        // low is -1 for snorm, where both -2^(n-1) and -2^(n-1) + 1 decode to -1, and 0 for unorm
+        inline float Dequantize(int32_t c, float low, float scale)
+        {
+            return std::max(static_cast<float>(c) / scale, low);
+        }
+
+        inline simd::vfloat Dequantize(simd::vint c, float low, float scale)
+        {
+            return simd::max(simd::convert_float(c) / simd::broadcast(scale), simd::broadcast(low));
+        }
+
+        // The low 16 bits of every lane as a signed value
+        inline simd::vint SignExtend16(simd::vint c)
+        {
+            const simd::vint bias = simd::broadcast_int(0x8000);
+            return ((c & simd::broadcast_int(0xFFFF)) ^ bias) - bias;
+        }
+
+        inline float SignNotZero(float x)
+        {
+            return x >= 0.f ? 1.f : -1.f;
+        }
+
+        inline simd::vfloat SignNotZero(simd::vfloat x)
+        {
+            return simd::select(x >= simd::broadcast(0.f), simd::broadcast(1.f), simd::broadcast(-1.f));
+        }
+
+        // The scalar and SIMD versions of both octahedral mappings do the same operations in the
+        // same order
+        inline void OctahedralEncode(float x, float y, float z, float& u, float& v)
+        {
+            const float scale = 1.f / (std::abs(x) + std::abs(y) + std::abs(z));
+            x *= scale;
+            y *= scale;
+
+            const bool lower = z < 0.f;
+            u                = lower ? (1.f - std::abs(y)) * SignNotZero(x) : x;
+            v                = lower ? (1.f - std::abs(x)) * SignNotZero(y) : y;
+        }
+
+        inline void OctahedralEncode(simd::vfloat x, simd::vfloat y, simd::vfloat z, simd::vfloat& u, simd::vfloat& v)
+        {
+            const simd::vfloat one   = simd::broadcast(1.f);
+            const simd::vfloat scale = one / (simd::abs(x) + simd::abs(y) + simd::abs(z));
+            x *= scale;
+            y *= scale;
+
+            const simd::vmask lower = z < simd::broadcast(0.f);
+            u                       = simd::select(lower, (one - simd::abs(y)) * SignNotZero(x), x);
+            v                       = simd::select(lower, (one - simd::abs(x)) * SignNotZero(y), y);
+        }
+
+        inline void OctahedralDecode(float u, float v, float& x, float& y, float& z)
+        {
+            z = 1.f - std::abs(u) - std::abs(v);
+
+            // Unfolds the lower half: moves u and v toward the axes by the depth below z = 0
+            const float t = std::max(-z, 0.f);
+            u += u >= 0.f ? -t : t;
+            v += v >= 0.f ? -t : t;
+
+            const float length = std::sqrt(MultiplyAdd(z, z, MultiplyAdd(v, v, u * u)));
+            x                  = u / length;
+            y                  = v / length;
+            z                  = z / length;
+        }
+
+        inline void OctahedralDecode(simd::vfloat u, simd::vfloat v, simd::vfloat& x, simd::vfloat& y, simd::vfloat& z)
+        {
+            const simd::vfloat zero = simd::broadcast(0.f);
+            z                       = simd::broadcast(1.f) - simd::abs(u) - simd::abs(v);
+
+            const simd::vfloat t = simd::max(-z, zero);
+            u += simd::select(u >= zero, -t, t);
+            v += simd::select(v >= zero, -t, t);
+
+            const simd::vfloat length = simd::sqrt(simd::madd(z, z, simd::madd(v, v, u * u)));
+            x                         = u / length;
+            y                         = v / length;
+            z                         = z / length;
+        }
+
+        // Runs encode(const float* in, Out* out) on simd::kWidth elements of kComponents floats at
+        // a time, the tail on a zero padded copy
+        template <size_t kComponents, class Out, class Encode>
+        void EncodeBatch(const float* src, Out* dst, size_t count, Encode encode)
+        {
+            size_t i = 0;
+            for (; i + simd::kWidth <= count; i += simd::kWidth)
+                encode(src + i * kComponents, dst + i);
+
+            if (i < count)
+            {
+                float in[simd::kWidth * kComponents] = {};
+                Out   out[simd::kWidth];
+                std::memcpy(in, src + i * kComponents, (count - i) * kComponents * sizeof(float));
+                encode(in, out);
+                std::memcpy(dst + i, out, (count - i) * sizeof(Out));
+            }
+        }
+
+        // Runs decode(const In* in, float* out) the same way
+        template <size_t kComponents, class In, class Decode>
+        void DecodeBatch(const In* src, float* dst, size_t count, Decode decode)
+        {
+            size_t i = 0;
+            for (; i + simd::kWidth <= count; i += simd::kWidth)
+                decode(src + i, dst + i * kComponents);
+
+            if (i < count)
+            {
+                In    in[simd::kWidth] = {};
+                float out[simd::kWidth * kComponents];
+                std::memcpy(in, src + i, (count - i) * sizeof(In));
+                decode(in, out);
+                std::memcpy(dst + i * kComponents, out, (count - i) * kComponents * sizeof(float));
+            }
+        }
+
+        template <class T>
+        void QuantizeBatch(span<const float> in, span<T> out, float low, float scale)
+        {
+            assert(in.size() == out.size());
+            if constexpr (simd::kWidth == 1)
+            {
+                // Without SIMD the lambdas and lane copies only cost time
+                for (size_t i = 0; i < in.size(); ++i)
+                    out[i] = static_cast<T>(Quantize(in[i], low, scale));
+                return;
+            }
+            EncodeBatch<1>(in.data(), out.data(), in.size(), [=](const float* src, T* dst) {
+                uint32_t lanes[simd::kWidth];
+                simd::store(lanes, Quantize(simd::load(src), low, scale));
+                for (size_t lane = 0; lane < simd::kWidth; ++lane)
+                    dst[lane] = static_cast<T>(lanes[lane]);
+            });
+        }
+
+        template <class T>
+        void DequantizeBatch(span<const T> in, span<float> out, float low, float scale)
+        {
+            assert(in.size() == out.size());
+            if constexpr (simd::kWidth == 1)
+            {
+                for (size_t i = 0; i < in.size(); ++i)
+                    out[i] = Dequantize(in[i], low, scale);
+                return;
+            }
+            DecodeBatch<1>(in.data(), out.data(), in.size(), [=](const T* src, float* dst) {
+                int32_t lanes[simd::kWidth];
+                for (size_t lane = 0; lane < simd::kWidth; ++lane)
+                    lanes[lane] = src[lane];
+                simd::store(dst, Dequantize(simd::load(lanes), low, scale));
+            });
+        }
+
+        // The components of a stream of vectors as one flat span
+        template <class T, template <class> class Vector>
+        span<T> Components(span<Vector<T>> vectors)
+        {
+            return span<T>(vectors.data()->Data(), vectors.size() * (sizeof(Vector<T>) / sizeof(T)));
+        }
+
+        template <class T, template <class> class Vector>
+        span<const T> Components(span<const Vector<T>> vectors)
+        {
+            return span<const T>(vectors.data()->Data(), vectors.size() * (sizeof(Vector<T>) / sizeof(T)));
+        }
+    } // namespace detail
+
+    inline uint8_t EncodeUnorm8(float x)
+    {
+        return static_cast<uint8_t>(detail::Quantize(x, 0.f, detail::kUnorm8Scale));
+    }
+
+    inline float DecodeUnorm8(uint8_t c)
+    {
+        return detail::Dequantize(c, 0.f, detail::kUnorm8Scale);
+    }
+
+    inline uint16_t EncodeUnorm16(float x)
+    {
+        return static_cast<uint16_t>(detail::Quantize(x, 0.f, detail::kUnorm16Scale));
+    }
+
+    inline float DecodeUnorm16(uint16_t c)
+    {
+        return detail::Dequantize(c, 0.f, detail::kUnorm16Scale);
+    }
+
+    inline int8_t EncodeSnorm8(float x)
+    {
+        return static_cast<int8_t>(detail::Quantize(x, -1.f, detail::kSnorm8Scale));
+    }
+
+    inline float DecodeSnorm8(int8_t c)
+    {
+        return detail::Dequantize(c, -1.f, detail::kSnorm8Scale);
+    }
+
+    inline int16_t EncodeSnorm16(float x)
+    {
+        return static_cast<int16_t>(detail::Quantize(x, -1.f, detail::kSnorm16Scale));
+    }
+
+    inline float DecodeSnorm16(int16_t c)
+    {
+        return detail::Dequantize(c, -1.f, detail::kSnorm16Scale);
+    }
+
+    inline uint32_t EncodeR10G10B10A2(const float4& v)
+    {
+        uint32_t bits = 0;
+        bits |= static_cast<uint32_t>(detail::Quantize(v.x, 0.f, detail::kUnorm10Scale)) << 0u;
+        bits |= static_cast<uint32_t>(detail::Quantize(v.y, 0.f, detail::kUnorm10Scale)) << 10u;
+        bits |= static_cast<uint32_t>(detail::Quantize(v.z, 0.f, detail::kUnorm10Scale)) << 20u;
+        bits |= static_cast<uint32_t>(detail::Quantize(v.w, 0.f, detail::kUnorm2Scale)) << 30u;
+        return bits;
+    }
+
+    inline float4 DecodeR10G10B10A2(uint32_t bits)
+    {
+        return float4(detail::Dequantize(bits & 0x3FFu, 0.f, detail::kUnorm10Scale),
+                      detail::Dequantize((bits >> 10u) & 0x3FFu, 0.f, detail::kUnorm10Scale),
+                      detail::Dequantize((bits >> 20u) & 0x3FFu, 0.f, detail::kUnorm10Scale),
+                      detail::Dequantize(bits >> 30u, 0.f, detail::kUnorm2Scale));
+    }
+
+    // n need not be normalized, only its direction is kept
+    inline uint32_t EncodeOctahedral(const float3& n)
+    {
+        float u, v;
+        detail::OctahedralEncode(n.x, n.y, n.z, u, v);
+        const uint32_t low  = static_cast<uint32_t>(detail::Quantize(u, -1.f, detail::kSnorm16Scale)) & 0xFFFFu;
+        const uint32_t high = static_cast<uint32_t>(detail::Quantize(v, -1.f, detail::kSnorm16Scale)) << 16u;
+        return low | high;
+    }
+
+    inline float3 DecodeOctahedral(uint32_t bits)
+    {
+        const float u = DecodeSnorm16(static_cast<int16_t>(bits & 0xFFFFu));
+        const float v = DecodeSnorm16(static_cast<int16_t>(bits >> 16u));
+        float3      n;
+        detail::OctahedralDecode(u, v, n.x, n.y, n.z);
+        return n;
+    }
+
+    // out[i] = EncodeUnorm8(in[i]) etc.
+    inline void EncodeUnorm8(span<const float> in, span<uint8_t> out) { detail::QuantizeBatch(in, out, 0.f, detail::kUnorm8Scale); }
+    inline void DecodeUnorm8(span<const uint8_t> in, span<float> out) { detail::DequantizeBatch(in, out, 0.f, detail::kUnorm8Scale); }
+    inline void EncodeUnorm16(span<const float> in, span<uint16_t> out) { detail::QuantizeBatch(in, out, 0.f, detail::kUnorm16Scale); }
+    inline void DecodeUnorm16(span<const uint16_t> in, span<float> out) { detail::DequantizeBatch(in, out, 0.f, detail::kUnorm16Scale); }
+    inline void EncodeSnorm8(span<const float> in, span<int8_t> out) { detail::QuantizeBatch(in, out, -1.f, detail::kSnorm8Scale); }
+    inline void DecodeSnorm8(span<const int8_t> in, span<float> out) { detail::DequantizeBatch(in, out, -1.f, detail::kSnorm8Scale); }
+    inline void EncodeSnorm16(span<const float> in, span<int16_t> out) { detail::QuantizeBatch(in, out, -1.f, detail::kSnorm16Scale); }
+    inline void DecodeSnorm16(span<const int16_t> in, span<float> out) { detail::DequantizeBatch(in, out, -1.f, detail::kSnorm16Scale); }
+
+    // Whole vectors component by component, e.g. float2 texture coordinates to Vector2<uint16_t>
+    template <template <class> class Vector>
+    void EncodeUnorm8(span<const Vector<float>> in, span<Vector<uint8_t>> out) { EncodeUnorm8(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void DecodeUnorm8(span<const Vector<uint8_t>> in, span<Vector<float>> out) { DecodeUnorm8(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void EncodeUnorm16(span<const Vector<float>> in, span<Vector<uint16_t>> out) { EncodeUnorm16(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void DecodeUnorm16(span<const Vector<uint16_t>> in, span<Vector<float>> out) { DecodeUnorm16(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void EncodeSnorm8(span<const Vector<float>> in, span<Vector<int8_t>> out) { EncodeSnorm8(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void DecodeSnorm8(span<const Vector<int8_t>> in, span<Vector<float>> out) { DecodeSnorm8(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void EncodeSnorm16(span<const Vector<float>> in, span<Vector<int16_t>> out) { EncodeSnorm16(detail::Components(in), detail::Components(out)); }
+    template <template <class> class Vector>
+    void DecodeSnorm16(span<const Vector<int16_t>> in, span<Vector<float>> out) { DecodeSnorm16(detail::Components(in), detail::Components(out)); }
+
+    // out[i] = EncodeR10G10B10A2(in[i])
+    inline void EncodeR10G10B10A2(span<const float4> in, span<uint32_t> out)
+    {
+        assert(in.size() == out.size());
+        if constexpr (detail::kLoopVectorEncode)
+        {
+            for (size_t i = 0; i < in.size(); ++i)
+                out[i] = EncodeR10G10B10A2(in[i]);
+            return;
+        }
+        detail::EncodeBatch<4>(&in.data()->x, out.data(), in.size(), [](const float* src, uint32_t* dst) {
+            simd::vfloat r, g, b, a;
+            simd::load_interleaved4(src, r, g, b, a);
+            simd::vint bits = detail::Quantize(r, 0.f, detail::kUnorm10Scale);
+            bits            = bits | (detail::Quantize(g, 0.f, detail::kUnorm10Scale) << 10);
+            bits            = bits | (detail::Quantize(b, 0.f, detail::kUnorm10Scale) << 20);
+            bits            = bits | (detail::Quantize(a, 0.f, detail::kUnorm2Scale) << 30);
+            simd::store(dst, bits);
+        });
+    }
+
+    // out[i] = DecodeR10G10B10A2(in[i])
+    inline void DecodeR10G10B10A2(span<const uint32_t> in, span<float4> out)
+    {
+        assert(in.size() == out.size());
+        if constexpr (simd::kWidth == 1)
+        {
+            for (size_t i = 0; i < in.size(); ++i)
+                out[i] = DecodeR10G10B10A2(in[i]);
+            return;
+        }
+        detail::DecodeBatch<4>(in.data(), &out.data()->x, in.size(), [](const uint32_t* src, float* dst) {
+            const simd::vint bits = simd::load(src);
+            const simd::vint mask = simd::broadcast_int(0x3FF);
+            simd::store_interleaved4(dst, detail::Dequantize(bits & mask, 0.f, detail::kUnorm10Scale),
+                                     detail::Dequantize((bits >> 10) & mask, 0.f, detail::kUnorm10Scale),
+                                     detail::Dequantize((bits >> 20) & mask, 0.f, detail::kUnorm10Scale),
+                                     detail::Dequantize(bits >> 30, 0.f, detail::kUnorm2Scale));
+        });
+    }
+
+    // out[i] = EncodeOctahedral(in[i])
+    inline void EncodeOctahedral(span<const float3> in, span<uint32_t> out)
+    {
+        assert(in.size() == out.size());
+        if constexpr (detail::kLoopVectorEncode)
+        {
+            for (size_t i = 0; i < in.size(); ++i)
+                out[i] = EncodeOctahedral(in[i]);
+            return;
+        }
+        detail::EncodeBatch<3>(&in.data()->x, out.data(), in.size(), [](const float* src, uint32_t* dst) {
+            simd::vfloat x, y, z, u, v;
+            simd::load_interleaved3(src, x, y, z);
+            detail::OctahedralEncode(x, y, z, u, v);
+            const simd::vint low  = detail::Quantize(u, -1.f, detail::kSnorm16Scale) & simd::broadcast_int(0xFFFF);
+            const simd::vint high = detail::Quantize(v, -1.f, detail::kSnorm16Scale) << 16;
+            simd::store(dst, low | high);
+        });
+    }
+
+    // out[i] = DecodeOctahedral(in[i])
+    inline void DecodeOctahedral(span<const uint32_t> in, span<float3> out)
+    {
+        assert(in.size() == out.size());
+        if constexpr (simd::kWidth == 1)
+        {
+            for (size_t i = 0; i < in.size(); ++i)
+                out[i] = DecodeOctahedral(in[i]);
+            return;
+        }
+        detail::DecodeBatch<3>(in.data(), &out.data()->x, in.size(), [](const uint32_t* src, float* dst) {
+            const simd::vint bits = simd::load(src);
+            const simd::vfloat u  = detail::Dequantize(detail::SignExtend16(bits), -1.f, detail::kSnorm16Scale);
+            const simd::vfloat v  = detail::Dequantize(detail::SignExtend16(bits >> 16), -1.f, detail::kSnorm16Scale);
+            simd::vfloat       x, y, z;
+            detail::OctahedralDecode(u, v, x, y, z);
+            simd::store_interleaved3(dst, x, y, z);
+        });
+    }
+} // namespace math
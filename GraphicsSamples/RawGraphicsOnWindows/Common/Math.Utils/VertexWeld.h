@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "Span.h"
+
+// Vertex welding: merges the duplicated vertices of imported meshes (split per face or per
+// triangle by the exporter) so that the vertex buffer shrinks and the post-transform cache sees
+// the reuse again.
+//
+// Two vertices weld when their positions are at most positionEpsilon apart and every attribute
+// differs by at most attributeEpsilon, so vertices on a UV or normal seam stay apart. The
+// positions go into a uniform grid with cells at least 2 * positionEpsilon wide, so the
+// neighbourhood of a vertex touches at most 2 cells per axis; the occupied cells are kept in an
+// open addressing hash table with linear probing, each with a list of its vertices. Every vertex
+// costs a constant number of probes, the whole pass is O(N) expected time.
+//
+// Welding is not transitive: a vertex joins the earliest kept vertex within the tolerance and
+// kept vertices never merge with each other, so a chain of vertices each epsilon apart does not
+// collapse into one. The kept vertex keeps its own position and attributes.
+
+namespace math
+{
+    struct WeldedMesh
+    {
+        std::vector<float3>   positions;
+        std::vector<float>    attributes; // attributeStride floats per vertex, empty without attributes
+        std::vector<uint32_t> indices;    // without the triangles that collapsed
+        std::vector<uint32_t> remap;      // new index of every input vertex
+    };
+
+    namespace detail
+    {
+        // Grid coordinates of 21 bits each, packed into a 63-bit cell key
+        constexpr uint32_t kWeldGridBits = 21;
+
+        inline uint64_t WeldCellKey(uint32_t x, uint32_t y, uint32_t z)
+        {
+            return uint64_t(x) | (uint64_t(y) << kWeldGridBits) | (uint64_t(z) << (2 * kWeldGridBits));
+        }
+
+        // Cells with at least one kept vertex: linear probing over a power of two table, a
+        // singly linked list of vertices per cell
+        class WeldCellTable
+        {
+        public:
+            explicit WeldCellTable(size_t vertexCount) :
+                m_next(vertexCount, UINT32_MAX)
+            {
+                size_t capacity = 16;
+                while (capacity < 2 * vertexCount)
+                    capacity *= 2;
+                m_keys.resize(capacity);
+                m_heads.assign(capacity, UINT32_MAX);
+                m_mask = capacity - 1;
+            }
+
+            // First vertex of the cell, UINT32_MAX when it has none
+            uint32_t Head(uint64_t key) const
+            {
+                for (size_t slot = Hash(key);; slot = (slot + 1) & m_mask)
+                {
+                    if (m_heads[slot] == UINT32_MAX || m_keys[slot] == key)
+                        return m_heads[slot];
+                }
+            }
+
+            uint32_t Next(uint32_t vertex) const { return m_next[vertex]; }
+
+            void Insert(uint64_t key, uint32_t vertex)
+            {
+                size_t slot = Hash(key);
+                while (m_heads[slot] != UINT32_MAX && m_keys[slot] != key)
+                    slot = (slot + 1) & m_mask;
+                m_keys[slot]   = key;
+                m_next[vertex] = m_heads[slot];
+                m_heads[slot]  = vertex;
+            }
+
+        private:
+            size_t Hash(uint64_t key) const { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & m_mask; }
+
+            std::vector<uint64_t> m_keys;
+            std::vector<uint32_t> m_heads;
+            std::vector<uint32_t> m_next;
+            size_t                m_mask = 0;
+        };
+    } // namespace detail
+
+    // Writes the new index of every vertex to remap and returns the number of vertices after
+    // welding. New indices follow the order of the kept vertices in the input. attributes holds
+    // attributeStride floats per vertex and may be empty.
+    inline size_t GenerateWeldRemap(span<const float3> positions, span<const float> attributes, size_t attributeStride,
+                                    float positionEpsilon, float attributeEpsilon, span<uint32_t> remap)
+    {
+        const size_t vertexCount = positions.size();
+        assert(remap.size() == vertexCount);
+        assert(attributes.size() == vertexCount * attributeStride);
+        assert(positionEpsilon >= 0.f && attributeEpsilon >= 0.f);
+        assert(vertexCount < UINT32_MAX);
+        if (vertexCount == 0)
+            return 0;
+
+        float3 boxMin(FLT_MAX, FLT_MAX, FLT_MAX), boxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (const float3& p : positions)
+        {
+            assert(std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z));
+            boxMin = float3(std::min(boxMin.x, p.x), std::min(boxMin.y, p.y), std::min(boxMin.z, p.z));
+            boxMax = float3(std::max(boxMax.x, p.x), std::max(boxMax.y, p.y), std::max(boxMax.z, p.z));
+        }
+
+        // Cells wider than 2 * epsilon when the grid would not fit the key otherwise, or for
+        // epsilon 0; the grid starts one cell before the bounds so that no coordinate is negative
+        const float extent   = std::max(std::max(boxMax.x - boxMin.x, boxMax.y - boxMin.y), boxMax.z - boxMin.z);
+        const float cellSize = std::max(std::max(2.f * positionEpsilon, std::ldexp(extent, -int(detail::kWeldGridBits - 2))), FLT_MIN);
+        const float invCell  = 1.f / cellSize;
+        const float3 origin  = boxMin - float3(cellSize, cellSize, cellSize);
+
+        auto cell = [&](float p, float o) { return static_cast<uint32_t>(FastFloor((p - o) * invCell)); };
+
+        const float epsilon2 = positionEpsilon * positionEpsilon;
+        auto        same     = [&](uint32_t a, uint32_t b) {
+            const float3 d = positions[a] - positions[b];
+            if (dot(d, d) > epsilon2)
+                return false;
+            const float* attributesA = attributes.data() + a * attributeStride;
+            const float* attributesB = attributes.data() + b * attributeStride;
+            for (size_t i = 0; i < attributeStride; ++i)
+            {
+                if (!(std::abs(attributesA[i] - attributesB[i]) <= attributeEpsilon))
+                    return false;
+            }
+            return true;
+        };
+
+        detail::WeldCellTable table(vertexCount);
+        uint32_t              count = 0;
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            const float3& p = positions[v];
+            const uint32_t loX = cell(p.x - positionEpsilon, origin.x), hiX = cell(p.x + positionEpsilon, origin.x);
+            const uint32_t loY = cell(p.y - positionEpsilon, origin.y), hiY = cell(p.y + positionEpsilon, origin.y);
+            const uint32_t loZ = cell(p.z - positionEpsilon, origin.z), hiZ = cell(p.z + positionEpsilon, origin.z);
+
+            uint32_t match = UINT32_MAX;
+            for (uint32_t z = loZ; z <= hiZ; ++z)
+                for (uint32_t y = loY; y <= hiY; ++y)
+                    for (uint32_t x = loX; x <= hiX; ++x)
+                    {
+                        for (uint32_t kept = table.Head(detail::WeldCellKey(x, y, z)); kept != UINT32_MAX; kept = table.Next(kept))
+                        {
+                            if (kept < match && same(v, kept))
+                                match = kept;
+                        }
+                    }
+
+            if (match != UINT32_MAX)
+            {
+                remap[v] = remap[match];
+                continue;
+            }
+            remap[v] = count++;
+            table.Insert(detail::WeldCellKey(cell(p.x, origin.x), cell(p.y, origin.y), cell(p.z, origin.z)), v);
+        }
+        return count;
+    }
+
+    // Moves the first vertex of every welded group to its new index and drops the others
+    template <class Vertex>
+    void CompactWeldedVertices(std::vector<Vertex>& vertices, span<const uint32_t> remap, size_t count)
+    {
+        assert(vertices.size() == remap.size());
+        size_t next = 0;
+        for (size_t v = 0; v < vertices.size(); ++v)
+        {
+            if (remap[v] == next)
+                vertices[next++] = vertices[v];
+        }
+        assert(next == count);
+        vertices.resize(count);
+    }
+
+    // Rewrites the indices through remap and removes the triangles that the welding collapsed to
+    // a line or a point. Returns the new number of indices.
+    inline size_t RemapIndexBuffer(span<uint32_t> indices, span<const uint32_t> remap)
+    {
+        assert(indices.size() % 3 == 0);
+        size_t out = 0;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            indices[out++] = a;
+            indices[out++] = b;
+            indices[out++] = c;
+        }
+        return out;
+    }
+
+    // GenerateWeldRemap, CompactWeldedVertices and RemapIndexBuffer in one go
+    inline WeldedMesh WeldVertices(span<const float3> positions, span<const float> attributes, size_t attributeStride,
+                                   span<const uint32_t> indices, float positionEpsilon, float attributeEpsilon = 0.f)
+    {
+        WeldedMesh mesh;
+        mesh.remap.resize(positions.size());
+        const size_t count = GenerateWeldRemap(positions, attributes, attributeStride, positionEpsilon, attributeEpsilon, mesh.remap);
+
+        mesh.positions.reserve(count);
+        mesh.attributes.reserve(count * attributeStride);
+        for (size_t v = 0; v < positions.size(); ++v)
+        {
+            if (mesh.remap[v] != mesh.positions.size())
+                continue;
+            mesh.positions.push_back(positions[v]);
+            mesh.attributes.insert(mesh.attributes.end(), attributes.begin() + v * attributeStride, attributes.begin() + (v + 1) * attributeStride);
+        }
+
+        mesh.indices.assign(indices.begin(), indices.end());
+        mesh.indices.resize(RemapIndexBuffer(mesh.indices, mesh.remap));
+        return mesh;
+    }
+} // namespace math
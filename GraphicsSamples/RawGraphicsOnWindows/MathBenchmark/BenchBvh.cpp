@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Bvh.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    struct Mesh
+    {
+        std::vector<float3>   positions;
+        std::vector<uint32_t> indices;
+    };
+
+    // A bumpy torus, with the triangles shuffled the way an unoptimized asset would list them
+    Mesh MakeTorus(uint32_t rings, uint32_t sides)
+    {
+        const float pi = 3.14159265f;
+
+        Mesh mesh;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const float u = 2.f * pi * static_cast<float>(i) / static_cast<float>(rings);
+                const float v = 2.f * pi * static_cast<float>(j) / static_cast<float>(sides);
+                const float r = 1.f + 0.1f * std::sin(7.f * u) * std::sin(5.f * v);
+                mesh.positions.emplace_back((3.f + r * std::cos(v)) * std::cos(u), (3.f + r * std::cos(v)) * std::sin(u), r * std::sin(v));
+            }
+        }
+
+        std::vector<uint3> triangles;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const uint32_t a = i * sides + j;
+                const uint32_t b = ((i + 1) % rings) * sides + j;
+                const uint32_t c = ((i + 1) % rings) * sides + (j + 1) % sides;
+                const uint32_t d = i * sides + (j + 1) % sides;
+                triangles.emplace_back(a, b, c);
+                triangles.emplace_back(a, c, d);
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(10));
+        for (const uint3& t : triangles)
+            mesh.indices.insert(mesh.indices.end(), {t.x, t.y, t.z});
+        return mesh;
+    }
+
+    std::vector<Ray> MakeRays(size_t count, uint32_t seed)
+    {
+        std::mt19937                          rng(seed);
+        std::normal_distribution<float>       normal;
+        std::uniform_real_distribution<float> target(-4.5f, 4.5f);
+
+        std::vector<Ray> rays(count);
+        for (auto& ray : rays)
+        {
+            const float3 origin = normalize(float3(normal(rng), normal(rng), normal(rng))) * 10.f;
+            const float3 aim(target(rng), target(rng), target(rng) * 0.3f);
+            ray                 = Ray(origin, normalize(aim - origin));
+        }
+        return rays;
+    }
+
+    // What picking did before: every triangle against the ray
+    struct BruteForce
+    {
+        std::vector<detail::BvhTriangle> triangles;
+
+        explicit BruteForce(const Mesh& mesh)
+        {
+            for (size_t i = 0; i < mesh.indices.size(); i += 3)
+            {
+                const float3& a = mesh.positions[mesh.indices[i + 0]];
+                const float3& b = mesh.positions[mesh.indices[i + 1]];
+                const float3& c = mesh.positions[mesh.indices[i + 2]];
+                triangles.push_back({a, b, c});
+            }
+        }
+
+        bool Intersect(const Ray& ray, RayHit& hit) const
+        {
+            const detail::WatertightRay watertight(ray);
+            bool                        found = false;
+            float                       tMax  = ray.tMax;
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                const detail::BvhTriangle& tri = triangles[i];
+                float                      t, u, v;
+                if (detail::IntersectTriangle(watertight, tri.v0, tri.v1, tri.v2, ray.tMin, tMax, t, u, v))
+                {
+                    tMax  = t;
+                    hit   = {t, u, v, static_cast<uint32_t>(i)};
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        bool Occluded(const Ray& ray) const
+        {
+            const detail::WatertightRay watertight(ray);
+            for (const auto& tri : triangles)
+            {
+                float t, u, v;
+                if (detail::IntersectTriangle(watertight, tri.v0, tri.v1, tri.v2, ray.tMin, ray.tMax, t, u, v))
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    void RunBvh()
+    {
+        const Mesh   mesh      = MakeTorus(601, 167);
+        const size_t triangles = mesh.indices.size() / 3;
+        const size_t rayCount  = 97;
+
+        const BruteForce       brute(mesh);
+        const std::vector<Ray> rays = MakeRays(rayCount, 11);
+
+        // Occlusion rays stop halfway, so some are blocked and some are not
+        std::vector<Ray> shadowRays = rays;
+        for (auto& ray : shadowRays)
+            ray.tMax = 7.f;
+
+        Bvh bvh(mesh.positions, mesh.indices);
+        std::printf("  %zu triangles, %zu nodes of %zu bytes\n", triangles, bvh.Nodes().size(), sizeof(BvhNode));
+
+        size_t errors = 0, hits = 0, blocked = 0;
+        for (size_t i = 0; i < rayCount; ++i)
+        {
+            RayHit     expected, found;
+            const bool bruteHit = brute.Intersect(rays[i], expected);
+            const bool bvhHit   = bvh.Intersect(rays[i], found);
+            errors += bruteHit != bvhHit || expected.t != found.t;
+            errors += brute.Occluded(shadowRays[i]) != bvh.Occluded(shadowRays[i]);
+            hits += bvhHit;
+            blocked += bvh.Occluded(shadowRays[i]);
+        }
+        std::printf("  %zu rays, %zu hit, %zu of the shortened rays blocked, errors vs brute force: %zu\n", rayCount, hits, blocked, errors);
+
+        // Tasks own disjoint node slots, so the tree must not depend on the thread count
+        ThreadPool single(1), eight(8);
+        Bvh        serialBvh, parallelBvh;
+        serialBvh.Build(single, mesh.positions, mesh.indices);
+        parallelBvh.Build(eight, mesh.positions, mesh.indices);
+        const bool sameTree = serialBvh.Nodes().size() == parallelBvh.Nodes().size() &&
+                              std::memcmp(serialBvh.Nodes().data(), parallelBvh.Nodes().data(), serialBvh.Nodes().size_bytes()) == 0;
+        std::printf("  1 and 8 thread builds identical: %s\n", sameTree ? "yes" : "NO");
+
+        const unsigned threads = ThreadPool::Default().size();
+        auto           serial  = bench::Measure("Bvh::Build, 1 thread", static_cast<double>(triangles), 0, [&] {
+            bvh.Build(single, mesh.positions, mesh.indices);
+            bench::DoNotOptimize(bvh.Nodes().data());
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "Bvh::Build, default pool (%u threads)", threads);
+        bench::PrintSpeedup(serial, bench::Measure(name, static_cast<double>(triangles), 0, [&] {
+            bvh.Build(mesh.positions, mesh.indices);
+            bench::DoNotOptimize(bvh.Nodes().data());
+        }));
+
+        std::printf("  items = rays\n");
+        RayHit hit;
+        auto   brutePick = bench::Measure("closest hit, brute force", rayCount, 0, [&] {
+            for (const Ray& ray : rays)
+                bench::DoNotOptimize(brute.Intersect(ray, hit));
+        });
+        bench::PrintSpeedup(brutePick, bench::Measure("Bvh::Intersect", rayCount, 0, [&] {
+            for (const Ray& ray : rays)
+                bench::DoNotOptimize(bvh.Intersect(ray, hit));
+        }));
+
+        auto bruteShadow = bench::Measure("any hit, brute force", rayCount, 0, [&] {
+            for (const Ray& ray : shadowRays)
+                bench::DoNotOptimize(brute.Occluded(ray));
+        });
+        bench::PrintSpeedup(bruteShadow, bench::Measure("Bvh::Occluded", rayCount, 0, [&] {
+            for (const Ray& ray : shadowRays)
+                bench::DoNotOptimize(bvh.Occluded(ray));
+        }));
+    }
+
+    bench::Registrar bvhSuite("BVH", RunBvh);
+} // namespace
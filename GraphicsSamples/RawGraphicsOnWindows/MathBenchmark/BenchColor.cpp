@@ -0,0 +1,143 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/ColorConvert.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    // What the per-pixel code would do without tables
+    uint32_t EncodeSrgbPow(const float4& c)
+    {
+        const auto encode = [](float x) {
+            return detail::QuantizeUnorm8(static_cast<float>(detail::LinearToSrgb(clamp(x, 0.f, 1.f))));
+        };
+        return encode(c.r) | encode(c.g) << 8u | encode(c.b) << 16u | detail::QuantizeUnorm8(c.a) << 24u;
+    }
+
+    float4 DecodeSrgbPow(uint32_t c)
+    {
+        return float4(static_cast<float>(detail::SrgbToLinear(((c >> 0u) & 0xFF) / 255.0)),
+                      static_cast<float>(detail::SrgbToLinear(((c >> 8u) & 0xFF) / 255.0)),
+                      static_cast<float>(detail::SrgbToLinear(((c >> 16u) & 0xFF) / 255.0)),
+                      ((c >> 24u) & 0xFF) / 255.f);
+    }
+
+    void CheckConversions(const std::vector<uint32_t>& bytes, const std::vector<float4>& colors)
+    {
+        const size_t          count = colors.size();
+        std::vector<uint32_t> packed(count);
+        std::vector<float4>   unpacked(count);
+
+        size_t mismatches = 0;
+        F4Color_To_RGBA8Unorm(colors, packed);
+        for (size_t i = 0; i < count; ++i)
+            mismatches += packed[i] != F4Color_To_RGBA8Unorm(colors[i]);
+        RGBA8Unorm_To_F4Color(bytes, unpacked);
+        for (size_t i = 0; i < count; ++i)
+            mismatches += !(unpacked[i] == RGBA8Unorm_To_F4Color(bytes[i]));
+        std::printf("  unorm: bulk vs per-pixel mismatches %zu\n", mismatches);
+
+        // sRGB encode against the correctly rounded double precision curve
+        mismatches = 0;
+        F4Color_To_RGBA8Srgb(colors, packed);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float4& c = colors[i];
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                const double exact   = std::floor(detail::LinearToSrgb(clamp(c[channel], 0.f, 1.f)) * 255.0 + 0.5);
+                const auto   encoded = (packed[i] >> (8 * channel)) & 0xFF;
+                mismatches += encoded != exact;
+            }
+            mismatches += packed[i] >> 24u != detail::QuantizeUnorm8(c.a);
+            mismatches += packed[i] != F4Color_To_RGBA8Srgb(c);
+        }
+        RGBA8Srgb_To_F4Color(bytes, unpacked);
+        for (size_t i = 0; i < count; ++i)
+            mismatches += !(unpacked[i] == DecodeSrgbPow(bytes[i]));
+        std::printf("  srgb: mismatches vs exact rounding / pow decode %zu\n", mismatches);
+
+        // Every code survives decode -> encode
+        size_t roundTrip = 0;
+        for (uint32_t c = 0; c < 256; ++c)
+        {
+            const uint32_t pixel = c * 0x01010101u;
+            roundTrip += F4Color_To_RGBA8Srgb(RGBA8Srgb_To_F4Color(pixel)) != pixel;
+            roundTrip += F4Color_To_RGBA8Unorm(RGBA8Unorm_To_F4Color(pixel)) != pixel;
+        }
+        std::printf("  round trip failures %zu\n", roundTrip);
+    }
+
+    void RunColorConvert(size_t pixels)
+    {
+        std::printf("  %zu pixels\n", pixels);
+
+        std::mt19937                          rng(5);
+        std::uniform_real_distribution<float> dist(-0.05f, 1.05f);
+
+        std::vector<uint32_t> bytes(pixels);
+        std::vector<float4>   colors(pixels);
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            bytes[i]  = static_cast<uint32_t>(rng());
+            colors[i] = float4(dist(rng), dist(rng), dist(rng), dist(rng));
+        }
+
+        CheckConversions(bytes, colors);
+
+        std::vector<uint32_t> packed(pixels);
+        std::vector<float4>   unpacked(pixels);
+
+        const double traffic = static_cast<double>(pixels * (sizeof(uint32_t) + sizeof(float4)));
+
+        auto decode = bench::Measure("RGBA8Unorm_To_F4Color per pixel", pixels, traffic, [&] {
+            for (size_t i = 0; i < pixels; ++i)
+                unpacked[i] = RGBA8Unorm_To_F4Color(bytes[i]);
+            bench::DoNotOptimize(unpacked.data());
+        });
+        bench::PrintSpeedup(decode, bench::Measure("RGBA8Unorm_To_F4Color span", pixels, traffic, [&] {
+            RGBA8Unorm_To_F4Color(bytes, unpacked);
+            bench::DoNotOptimize(unpacked.data());
+        }));
+
+        auto encode = bench::Measure("F4Color_To_RGBA8Unorm per pixel", pixels, traffic, [&] {
+            for (size_t i = 0; i < pixels; ++i)
+                packed[i] = F4Color_To_RGBA8Unorm(colors[i]);
+            bench::DoNotOptimize(packed.data());
+        });
+        bench::PrintSpeedup(encode, bench::Measure("F4Color_To_RGBA8Unorm span", pixels, traffic, [&] {
+            F4Color_To_RGBA8Unorm(colors, packed);
+            bench::DoNotOptimize(packed.data());
+        }));
+
+        auto decodeSrgb = bench::Measure("sRGB decode with pow per pixel", pixels, traffic, [&] {
+            for (size_t i = 0; i < pixels; ++i)
+                unpacked[i] = DecodeSrgbPow(bytes[i]);
+            bench::DoNotOptimize(unpacked.data());
+        });
+        bench::PrintSpeedup(decodeSrgb, bench::Measure("RGBA8Srgb_To_F4Color span", pixels, traffic, [&] {
+            RGBA8Srgb_To_F4Color(bytes, unpacked);
+            bench::DoNotOptimize(unpacked.data());
+        }));
+
+        auto encodeSrgb = bench::Measure("sRGB encode with pow per pixel", pixels, traffic, [&] {
+            for (size_t i = 0; i < pixels; ++i)
+                packed[i] = EncodeSrgbPow(colors[i]);
+            bench::DoNotOptimize(packed.data());
+        });
+        bench::PrintSpeedup(encodeSrgb, bench::Measure("F4Color_To_RGBA8Srgb span", pixels, traffic, [&] {
+            F4Color_To_RGBA8Srgb(colors, packed);
+            bench::DoNotOptimize(packed.data());
+        }));
+    }
+
+    bench::Registrar colorConvert("RGBA8 <-> float4", [] {
+        RunColorConvert(128 * 128);   // a tile that stays in L2
+        RunColorConvert(3840 * 2160); // a 4K frame, bound by memory bandwidth
+    });
+} // namespace
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <cstdint>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    struct CubeMapMatrices
+    {
+        float4x4 viewProjection[6];
+    };
+
+    // D3D cube map face order +X, -X, +Y, -Y, +Z, -Z: right, up and forward of each face camera
+    constexpr float3 kFaceBasis[6][3] = {
+        {float3(0, 0, -1), float3(0, 1, 0), float3(1, 0, 0)},
+        {float3(0, 0, 1), float3(0, 1, 0), float3(-1, 0, 0)},
+        {float3(1, 0, 0), float3(0, 0, -1), float3(0, 1, 0)},
+        {float3(1, 0, 0), float3(0, 0, 1), float3(0, -1, 0)},
+        {float3(1, 0, 0), float3(0, 1, 0), float3(0, 0, 1)},
+        {float3(-1, 0, 0), float3(0, 1, 0), float3(0, 0, -1)},
+    };
+
+    constexpr CubeMapMatrices MakeCubeMapMatrices(const float3& position)
+    {
+        const float4x4 projection = float4x4::Projection(PI_F / 2, 1.f, 0.1f, 100.f, false);
+
+        CubeMapMatrices out;
+        for (int face = 0; face < 6; ++face)
+        {
+            const float4x4 view = float4x4::Translation(-position) *
+                                  float4x4::ViewFromBasis(kFaceBasis[face][0], kFaceBasis[face][1], kFaceBasis[face][2]);
+            out.viewProjection[face] = view * projection;
+        }
+        return out;
+    }
+
+    // A rig of kSteps orientations, e.g. for a turntable capture
+    constexpr int kSteps = 64;
+
+    struct RigMatrices
+    {
+        float4x4 world[kSteps];
+    };
+
+    constexpr RigMatrices MakeRigMatrices()
+    {
+        RigMatrices out;
+        for (int i = 0; i < kSteps; ++i)
+        {
+            const float angle = 2 * PI_F * static_cast<float>(i) / kSteps;
+            out.world[i]      = float4x4::RotationX(-0.3f) * float4x4::RotationY(angle) * float4x4::Translation(0.f, 1.5f, 4.f);
+        }
+        return out;
+    }
+
+    // Both tables are constants: they are in the read-only data of the executable
+    constexpr CubeMapMatrices kCubeMap = MakeCubeMapMatrices(float3(1.f, 2.f, 3.f));
+    constexpr RigMatrices     kRig     = MakeRigMatrices();
+
+    static_assert(float4x4::Identity() * float4x4::Scale(2.f) == float4x4::Scale(2.f), "constexpr Mul");
+    static_assert((float4(1, 2, 3, 1) * float4x4::Translation(1, 1, 1)) == float4(2, 3, 4, 1), "constexpr vector * matrix");
+    static_assert(normalize(float3(0, 3, 4)) == float3(0, 0.6f, 0.8f), "constexpr normalize");
+
+    // The run time versions of the same matrices use <cmath> and, where enabled, SIMD and FMA
+    // contraction, so they may differ from the compile-time ones in the last bits
+    float MaxDifference(const float4x4* a, const float4x4* b, int count)
+    {
+        float result = 0.f;
+        for (int k = 0; k < count; ++k)
+            for (int i = 0; i < 4; ++i)
+                for (int j = 0; j < 4; ++j)
+                    result = std::max(result, std::abs(a[k][i][j] - b[k][i][j]));
+        return result;
+    }
+
+    void RunConstexpr()
+    {
+        CubeMapMatrices cubeMap;
+        RigMatrices     rig;
+        const float3    position(1.f, 2.f, 3.f);
+
+        bench::Measure("cube map view-projections at run time", 6, 0, [&] {
+            cubeMap = MakeCubeMapMatrices(position);
+            bench::DoNotOptimize(cubeMap);
+        });
+        bench::Measure("rig matrices at run time", kSteps, 0, [&] {
+            rig = MakeRigMatrices();
+            bench::DoNotOptimize(rig);
+        });
+        std::printf("  max abs difference vs the constexpr tables: cube map %g, rig %g\n",
+                    MaxDifference(cubeMap.viewProjection, kCubeMap.viewProjection, 6),
+                    MaxDifference(rig.world, kRig.world, kSteps));
+    }
+
+    bench::Registrar constexprSuite("Constexpr", RunConstexpr);
+} // namespace
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/FastMath.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    // Largest errors of an approximation against the double precision function
+    struct ErrorStats
+    {
+        double maxUlp        = 0.0;
+        double maxAbsolute   = 0.0;
+        size_t simdMismatch  = 0;
+
+        void Add(float approx, double exact)
+        {
+            const double error = std::abs(static_cast<double>(approx) - exact);
+            const float  rounded = static_cast<float>(exact);
+            const double ulp   = rounded == 0.f ? std::ldexp(1.0, -149)
+                                                : std::ldexp(1.0, std::ilogb(std::abs(rounded)) - 23);
+            maxUlp             = std::max(maxUlp, error / ulp);
+            maxAbsolute        = std::max(maxAbsolute, error);
+        }
+
+        void Print(const char* name) const
+        {
+            std::printf("  %-34s max %6.2f ulp, max abs %.2e, scalar/SIMD mismatches %zu\n", name, maxUlp, maxAbsolute, simdMismatch);
+        }
+    };
+
+    // Runs the SIMD version over the inputs, simd::kWidth at a time, and counts the lanes that
+    // differ from the scalar version
+    template <class Scalar, class Wide>
+    size_t CountMismatches(const std::vector<float>& a, const std::vector<float>& b, Scalar scalar, Wide wide)
+    {
+        size_t mismatches = 0;
+        float  lanes[simd::kWidth];
+        for (size_t i = 0; i + simd::kWidth <= a.size(); i += simd::kWidth)
+        {
+            simd::store(lanes, wide(simd::load(&a[i]), simd::load(&b[i])));
+            for (size_t lane = 0; lane < simd::kWidth; ++lane)
+                mismatches += detail::FloatBits(lanes[lane]) != detail::FloatBits(scalar(a[i + lane], b[i + lane]));
+        }
+        return mismatches;
+    }
+
+    std::vector<float> Uniform(std::mt19937& rng, size_t count, float low, float high)
+    {
+        std::uniform_real_distribution<float> distribution(low, high);
+        std::vector<float>                    values(count);
+        for (float& v : values)
+            v = distribution(rng);
+        return values;
+    }
+
+    void CheckAccuracy()
+    {
+        std::mt19937 rng(3);
+        const size_t count = 1 << 22;
+
+        // sin and cos: uniform over the range and around the zeros of both
+        std::vector<float> angles = Uniform(rng, count, -8192.f, 8192.f);
+        for (int k = -5215; k <= 5215; ++k)
+        {
+            const float zero = static_cast<float>(k * (PI / 2));
+            for (int step = -8; step <= 8; ++step)
+                angles.push_back(zero + step * std::abs(zero) * 1e-7f);
+        }
+        ErrorStats sinStats, cosStats, smallSin, smallCos;
+        for (float x : angles)
+        {
+            float s, c;
+            fast::sincos(x, s, c);
+            const double exactSin = std::sin(static_cast<double>(x));
+            const double exactCos = std::cos(static_cast<double>(x));
+            (std::abs(exactSin) >= 0.25 ? sinStats : smallSin).Add(s, exactSin);
+            (std::abs(exactCos) >= 0.25 ? cosStats : smallCos).Add(c, exactCos);
+        }
+        const std::vector<float> unused(angles.size());
+        sinStats.simdMismatch = CountMismatches(
+            angles, unused, [](float x, float) { return fast::sin(x); }, [](simd::vfloat x, simd::vfloat) { return fast::sin(x); });
+        cosStats.simdMismatch = CountMismatches(
+            angles, unused, [](float x, float) { return fast::cos(x); }, [](simd::vfloat x, simd::vfloat) { return fast::cos(x); });
+        sinStats.Print("sin, |x| <= 8192, |sin| >= 0.25");
+        smallSin.Print("sin, |x| <= 8192, |sin| < 0.25");
+        cosStats.Print("cos, |x| <= 8192, |cos| >= 0.25");
+        smallCos.Print("cos, |x| <= 8192, |cos| < 0.25");
+
+        // acos on [-1, 1], densest near +-1
+        std::vector<float> cosines = Uniform(rng, count, -1.f, 1.f);
+        for (float d = 1.f; d > 1e-7f; d *= 0.99f)
+        {
+            cosines.push_back(1.f - d);
+            cosines.push_back(d - 1.f);
+        }
+        ErrorStats acosStats, acosNearOne;
+        for (float x : cosines)
+            (x < 0.99f ? acosStats : acosNearOne).Add(fast::acos(x), std::acos(static_cast<double>(x)));
+        acosStats.simdMismatch = CountMismatches(
+            cosines, std::vector<float>(cosines.size()), [](float x, float) { return fast::acos(x); },
+            [](simd::vfloat x, simd::vfloat) { return fast::acos(x); });
+        acosStats.Print("acos, x < 0.99");
+        acosNearOne.Print("acos, x >= 0.99");
+
+        // atan2 over all octants and scales, plus the axes
+        std::vector<float> ys = Uniform(rng, count, -1.f, 1.f), xs = Uniform(rng, count, -1.f, 1.f);
+        std::uniform_int_distribution<int> exponent(-30, 30);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const int scale = exponent(rng);
+            ys[i]           = std::ldexp(ys[i], scale);
+            xs[i]           = std::ldexp(xs[i], scale + exponent(rng) / 10);
+        }
+        const float axes[][2] = {{0.f, 1.f}, {1.f, 0.f}, {0.f, -1.f}, {-1.f, 0.f}, {-0.f, -1.f}, {1.f, 1.f}, {-1.f, -1.f}, {0.f, 0.f}};
+        for (const auto& axis : axes)
+        {
+            ys.push_back(axis[0]);
+            xs.push_back(axis[1]);
+        }
+        ErrorStats atanStats;
+        for (size_t i = 0; i < ys.size(); ++i)
+            atanStats.Add(fast::atan2(ys[i], xs[i]), std::atan2(static_cast<double>(ys[i]), static_cast<double>(xs[i])));
+        atanStats.simdMismatch = CountMismatches(
+            ys, xs, [](float y, float x) { return fast::atan2(y, x); }, [](simd::vfloat y, simd::vfloat x) { return fast::atan2(y, x); });
+        atanStats.Print("atan2");
+
+        // rsqrt over many binades; the scalar and SIMD estimates may differ
+        std::vector<float> positives = Uniform(rng, count, 1.f, 4.f);
+        for (size_t i = 0; i < count; ++i)
+            positives[i] = std::ldexp(positives[i], exponent(rng) * 4);
+        ErrorStats rsqrtStats;
+        for (float x : positives)
+            rsqrtStats.Add(fast::rsqrt(x), 1.0 / std::sqrt(static_cast<double>(x)));
+        rsqrtStats.simdMismatch = CountMismatches(
+            positives, std::vector<float>(positives.size()), [](float x, float) { return fast::rsqrt(x); },
+            [](simd::vfloat x, simd::vfloat) { return fast::rsqrt(x); });
+        rsqrtStats.Print("rsqrt");
+    }
+
+    void RunFastMath()
+    {
+        CheckAccuracy();
+
+        const size_t       count = 1 << 20;
+        std::mt19937       rng(9);
+        std::vector<float> angles = Uniform(rng, count, -10.f, 10.f);
+        std::vector<float> cosines = Uniform(rng, count, -1.f, 1.f);
+        std::vector<float> ys = Uniform(rng, count, -1.f, 1.f), xs = Uniform(rng, count, -1.f, 1.f);
+        std::vector<float> positives = Uniform(rng, count, 0.01f, 100.f);
+        std::vector<float> out0(count), out1(count);
+
+        auto reference = bench::Measure("std::sin + std::cos", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+            {
+                out0[i] = std::sin(angles[i]);
+                out1[i] = std::cos(angles[i]);
+            }
+            bench::DoNotOptimize(out0.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("fast::sincos scalar", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                fast::sincos(angles[i], out0[i], out1[i]);
+            bench::DoNotOptimize(out0.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("fast::sincos SIMD", count, 0, [&] {
+            for (size_t i = 0; i + simd::kWidth <= count; i += simd::kWidth)
+            {
+                simd::vfloat s, c;
+                fast::sincos(simd::load(&angles[i]), s, c);
+                simd::store(&out0[i], s);
+                simd::store(&out1[i], c);
+            }
+            bench::DoNotOptimize(out0.data());
+        }));
+
+        reference = bench::Measure("std::acos", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out0[i] = std::acos(cosines[i]);
+            bench::DoNotOptimize(out0.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("fast::acos scalar", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out0[i] = fast::acos(cosines[i]);
+            bench::DoNotOptimize(out0.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("fast::acos SIMD", count, 0, [&] {
+            for (size_t i = 0; i + simd::kWidth <= count; i += simd::kWidth)
+                simd::store(&out0[i], fast::acos(simd::load(&cosines[i])));
+            bench::DoNotOptimize(out0.data());
+        }));
+
+        reference = bench::Measure("std::atan2", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out0[i] = std::atan2(ys[i], xs[i]);
+            bench::DoNotOptimize(out0.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("fast::atan2 scalar", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out0[i] = fast::atan2(ys[i], xs[i]);
+            bench::DoNotOptimize(out0.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("fast::atan2 SIMD", count, 0, [&] {
+            for (size_t i = 0; i + simd::kWidth <= count; i += simd::kWidth)
+                simd::store(&out0[i], fast::atan2(simd::load(&ys[i]), simd::load(&xs[i])));
+            bench::DoNotOptimize(out0.data());
+        }));
+
+        reference = bench::Measure("1 / std::sqrt", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out0[i] = 1.f / std::sqrt(positives[i]);
+            bench::DoNotOptimize(out0.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("fast::rsqrt SIMD", count, 0, [&] {
+            for (size_t i = 0; i + simd::kWidth <= count; i += simd::kWidth)
+                simd::store(&out0[i], fast::rsqrt(simd::load(&positives[i])));
+            bench::DoNotOptimize(out0.data());
+        }));
+
+        // The builders in this build's configuration; compare a build with MATH_FAST_TRIG
+#if defined(MATH_FAST_TRIG)
+        std::printf("  rotation builders with MATH_FAST_TRIG\n");
+#else
+        std::printf("  rotation builders with <cmath>\n");
+#endif
+        std::vector<float4x4>   matrices(count);
+        std::vector<Quaternion> quaternions(count);
+        const float3            axis = normalize(float3(1.f, 2.f, 3.f));
+        bench::Measure("float4x4::RotationArbitrary", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                matrices[i] = float4x4::RotationArbitrary(axis, angles[i]);
+            bench::DoNotOptimize(matrices.data());
+        });
+        bench::Measure("float4x4::RotationY", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                matrices[i] = float4x4::RotationY(angles[i]);
+            bench::DoNotOptimize(matrices.data());
+        });
+        bench::Measure("Quaternion::RotationFromAxisAngle", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                quaternions[i] = Quaternion::RotationFromAxisAngle(axis, angles[i]);
+            bench::DoNotOptimize(quaternions.data());
+        });
+        bench::Measure("slerp", count, 0, [&] {
+            for (size_t i = 1; i < count; ++i)
+                quaternions[i] = slerp(quaternions[i - 1], quaternions[i], 0.3f);
+            bench::DoNotOptimize(quaternions.data());
+        });
+    }
+
+    bench::Registrar fastMathSuite("FastMath", RunFastMath);
+} // namespace
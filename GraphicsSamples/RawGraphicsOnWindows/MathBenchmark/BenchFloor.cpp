@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/FloorBatch.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    bool SameFloat(float a, float b)
+    {
+        if (std::isnan(a) || std::isnan(b))
+            return std::isnan(a) && std::isnan(b);
+        return std::memcmp(&a, &b, sizeof(float)) == 0;
+    }
+
+    // Every 257th bit pattern (all exponents, signs and NaN encodings) plus the edge cases
+    std::vector<float> MakeCheckValues()
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+
+        std::vector<float> values = {0.f, -0.f, 0.5f, -0.5f, 1.f, -1.f, 0.99999994f, -0.99999994f, 1e-45f, -1e-45f,
+                                     8388607.5f, -8388607.5f, 8388608.f, -8388608.f, 16777215.f, 2147483520.f,
+                                     2147483648.f, -2147483648.f, -2147483904.f, 1e20f, -1e20f, inf, -inf,
+                                     std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::max(),
+                                     std::numeric_limits<float>::lowest()};
+        for (uint64_t bits = 0; bits <= 0xFFFFFFFFu; bits += 257)
+        {
+            const uint32_t b = static_cast<uint32_t>(bits);
+            float          f;
+            std::memcpy(&f, &b, sizeof(f));
+            values.push_back(f);
+        }
+        return values;
+    }
+
+    size_t CheckFloor()
+    {
+        const std::vector<float> values = MakeCheckValues();
+        const size_t             count  = values.size();
+
+        std::vector<float> floors(count), ceils(count);
+        FastFloor(values, floors);
+        FastCeil(values, ceils);
+
+        size_t errors = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float x = values[i];
+            errors += !SameFloat(floors[i], std::floor(x));
+            errors += !SameFloat(ceils[i], std::ceil(x));
+            // The scalar versions may return +0 for -0
+            const float scalarFloor = FastFloor(x), scalarCeil = FastCeil(x);
+            errors += std::isnan(x) ? !std::isnan(scalarFloor) : scalarFloor != std::floor(x);
+            errors += std::isnan(x) ? !std::isnan(scalarCeil) : scalarCeil != std::ceil(x);
+        }
+
+        // In place, and lengths that end in a partial register
+        for (size_t length = 0; length < 3 * simd::kWidth; ++length)
+        {
+            std::vector<float> inPlace(values.begin() + 1000, values.begin() + 1000 + length);
+            FastFloor(inPlace, inPlace);
+            for (size_t i = 0; i < length; ++i)
+                errors += !SameFloat(inPlace[i], floors[1000 + i]);
+        }
+        std::printf("  %zu values, errors vs std::floor/std::ceil: %zu\n", count, errors);
+        return errors;
+    }
+
+    void RunFloor()
+    {
+        CheckFloor();
+
+        // Noise lattice coordinates: sample positions scaled by the frequency
+        const size_t                          count = 1000003;
+        std::mt19937                          rng(12);
+        std::uniform_real_distribution<float> coord(-1000.f, 1000.f);
+        std::vector<float>                    in(count), out(count);
+        for (auto& x : in)
+            x = coord(rng);
+
+        std::printf("  %zu floats\n", count);
+        const double bytes = 2.0 * count * sizeof(float);
+
+        auto reference = bench::Measure("std::floor loop", count, bytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = std::floor(in[i]);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("FastFloor(float) loop", count, bytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = FastFloor(in[i]);
+            bench::DoNotOptimize(out.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("FastFloor(span)", count, bytes, [&] {
+            FastFloor(in, out);
+            bench::DoNotOptimize(out.data());
+        }));
+
+        reference = bench::Measure("std::ceil loop", count, bytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = std::ceil(in[i]);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("FastCeil(span)", count, bytes, [&] {
+            FastCeil(in, out);
+            bench::DoNotOptimize(out.data());
+        }));
+    }
+
+    bench::Registrar floorSuite("Floor", RunFloor);
+} // namespace
@@ -0,0 +1,121 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Frustum.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    float4x4 MakeViewProjection(bool isGL)
+    {
+        const float4x4 view = float4x4::Translation(-10.f, -5.f, 20.f) * float4x4::RotationY(0.7f) * float4x4::RotationX(-0.2f);
+        return view * float4x4::Projection(1.2f, 16.f / 9.f, 0.5f, 150.f, isGL);
+    }
+
+    // Points are classified like the clipper does it, in clip space. Points within a small
+    // distance of a plane may go either way and are not counted.
+    size_t CheckPlanes(bool isGL)
+    {
+        const float4x4 viewProjection = MakeViewProjection(isGL);
+        const Frustum  frustum        = Frustum::FromMatrix(viewProjection, isGL);
+
+        std::mt19937                          rng(isGL ? 5 : 4);
+        std::uniform_real_distribution<float> coord(-200.f, 200.f);
+
+        size_t errors = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            const float3 p(coord(rng), coord(rng) * 0.2f, coord(rng));
+            bool         nearPlane = false;
+            for (const Plane& plane : frustum.planes)
+                nearPlane |= std::abs(plane.Distance(p)) < 1e-2f;
+            if (nearPlane)
+                continue;
+
+            const float4 clip   = float4(p, 1.f) * viewProjection;
+            const float  zMin   = isGL ? -clip.w : 0.f;
+            const bool   inside = std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && clip.z >= zMin && clip.z <= clip.w;
+            errors += inside != frustum.Contains(p);
+        }
+        return errors;
+    }
+
+    void RunFrustum()
+    {
+        std::printf("  plane errors vs clip space: D3D %zu, GL %zu\n", CheckPlanes(false), CheckPlanes(true));
+
+        // Objects scattered around the camera, about a quarter of them visible
+        const size_t                          count = 200000;
+        std::mt19937                          rng(6);
+        std::uniform_real_distribution<float> coord(-150.f, 150.f);
+        std::uniform_real_distribution<float> size(0.1f, 3.f);
+
+        std::vector<float> x(count), y(count), z(count), radius(count);
+        std::vector<float> minX(count), minY(count), minZ(count), maxX(count), maxY(count), maxZ(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            x[i]      = coord(rng);
+            y[i]      = coord(rng) * 0.2f;
+            z[i]      = coord(rng);
+            radius[i] = size(rng);
+            minX[i]   = x[i] - size(rng);
+            minY[i]   = y[i] - size(rng);
+            minZ[i]   = z[i] - size(rng);
+            maxX[i]   = x[i] + size(rng);
+            maxY[i]   = y[i] + size(rng);
+            maxZ[i]   = z[i] + size(rng);
+        }
+        const ConstFloat3Stream centers(x, y, z), boxMin(minX, minY, minZ), boxMax(maxX, maxY, maxZ);
+
+        const Frustum         frustum = Frustum::FromMatrix(MakeViewProjection(false), false);
+        std::vector<uint32_t> expected, visible(count);
+        size_t                visibleCount = 0;
+
+        // Objects within rounding distance of a plane may be classified differently when the
+        // compiler contracts the scalar expressions into FMAs
+        auto compare = [&](const char* what) {
+            size_t differences = expected.size() != visibleCount;
+            for (size_t i = 0; i < expected.size() && i < visibleCount; ++i)
+                differences += expected[i] != visible[i];
+            std::printf("  %s: %zu of %zu visible, differences vs one by one: %zu\n", what, visibleCount, count, differences);
+        };
+
+        const double sphereBytes = 4.0 * count * sizeof(float);
+        auto         reference   = bench::Measure("spheres one by one", count, sphereBytes, [&] {
+            expected.clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (frustum.Intersects(float3(x[i], y[i], z[i]), radius[i]))
+                    expected.push_back(static_cast<uint32_t>(i));
+            }
+            bench::DoNotOptimize(expected.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("CullSpheres", count, sphereBytes, [&] {
+            visibleCount = CullSpheres(frustum, centers, radius, visible);
+            bench::DoNotOptimize(visible.data());
+        }));
+        compare("spheres");
+
+        const double boxBytes = 6.0 * count * sizeof(float);
+        reference             = bench::Measure("boxes one by one", count, boxBytes, [&] {
+            expected.clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (frustum.Intersects(AABB<float>(float3(minX[i], minY[i], minZ[i]), float3(maxX[i], maxY[i], maxZ[i]))))
+                    expected.push_back(static_cast<uint32_t>(i));
+            }
+            bench::DoNotOptimize(expected.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("CullBoxes", count, boxBytes, [&] {
+            visibleCount = CullBoxes(frustum, boxMin, boxMax, visible);
+            bench::DoNotOptimize(visible.data());
+        }));
+        compare("boxes");
+    }
+
+    bench::Registrar frustumSuite("Frustum", RunFrustum);
+} // namespace
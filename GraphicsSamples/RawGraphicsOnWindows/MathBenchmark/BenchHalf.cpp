@@ -0,0 +1,147 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Half.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    // Round to nearest even in double: |f| = r * 2^(e - 10) with the exponent e of a normal
+    // half clamped to -14 below, so that r is the mantissa with its implicit bit, or the
+    // denormal mantissa. r = 2048 carries into the next exponent, at 2^15 that is infinity.
+    uint16_t ReferenceFloatToHalf(float f)
+    {
+        const uint16_t sign = std::signbit(f) ? 0x8000 : 0;
+        if (std::isnan(f))
+            return static_cast<uint16_t>(sign | 0x7E00 | ((detail::FloatBits(f) >> 13) & 0x3FF));
+
+        const double value = std::abs(static_cast<double>(f));
+        if (value >= 65536.0)
+            return static_cast<uint16_t>(sign | 0x7C00);
+        if (value == 0.0)
+            return sign;
+
+        int exponent;
+        std::frexp(value, &exponent);
+        exponent        = std::max(exponent - 1, -14);
+        const double r  = std::nearbyint(std::ldexp(value, 10 - exponent));
+        const int    bits = (exponent + 14) * 1024 + static_cast<int>(r);
+        return static_cast<uint16_t>(sign | std::min(bits, 0x7C00));
+    }
+
+    size_t CheckFloatToHalf(const std::vector<float>& values)
+    {
+        std::vector<half> converted(values.size()), generic(values.size());
+        FloatToHalf(values, converted);
+        detail::FloatToHalfGeneric(values, generic);
+
+        size_t errors = 0;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            const uint16_t expected = ReferenceFloatToHalf(values[i]);
+            errors += converted[i].bits != expected;
+            errors += generic[i].bits != expected;
+            errors += detail::FloatToHalfBitsGeneric(values[i]) != expected;
+            errors += half(values[i]).bits != expected;
+        }
+        return errors;
+    }
+
+    void CheckConversions()
+    {
+        // Every half: the float must convert back to the same half, except that NaN becomes quiet
+        std::vector<half> halves(65536);
+        for (uint32_t i = 0; i < 65536; ++i)
+            halves[i] = half::FromBits(static_cast<uint16_t>(i));
+
+        std::vector<float> floats(65536), generic(65536);
+        HalfToFloat(halves, floats);
+        detail::HalfToFloatGeneric(halves, generic);
+
+        size_t errors = 0;
+        for (uint32_t i = 0; i < 65536; ++i)
+        {
+            const uint32_t bits = detail::FloatBits(floats[i]);
+            errors += bits != detail::FloatBits(generic[i]);
+            errors += bits != detail::FloatBits(detail::HalfBitsToFloatGeneric(static_cast<uint16_t>(i)));
+            errors += bits != detail::FloatBits(static_cast<float>(halves[i]));
+
+            const bool nan = (i & 0x7C00) == 0x7C00 && (i & 0x3FF) != 0;
+            errors += ReferenceFloatToHalf(floats[i]) != (nan ? (i | 0x200) : i);
+        }
+        std::printf("  half -> float errors of 65536: %zu\n", errors);
+
+        // Every tie and its neighbours, then a uniform sample of all floats
+        std::vector<float> values;
+        for (uint32_t i = 0; i < 0x7C00; ++i)
+        {
+            const float    low     = static_cast<float>(half::FromBits(static_cast<uint16_t>(i)));
+            const uint32_t midBits = detail::FloatBits(low) + (i >= 0x400 ? 1u << 12 : 0u);
+            const float    mid     = i >= 0x400 ? detail::FloatFromBits(midBits)
+                                                : (low + static_cast<float>(half::FromBits(static_cast<uint16_t>(i + 1)))) * 0.5f;
+            for (float v : {mid, std::nextafter(mid, 0.f), std::nextafter(mid, 1e30f)})
+            {
+                values.push_back(v);
+                values.push_back(-v);
+            }
+        }
+        for (uint64_t bits = 0; bits <= UINT32_MAX; bits += 4093)
+            values.push_back(detail::FloatFromBits(static_cast<uint32_t>(bits)));
+        std::printf("  float -> half errors of %zu: %zu\n", values.size(), CheckFloatToHalf(values));
+    }
+
+    void RunHalf()
+    {
+        CheckConversions();
+
+        // A vertex stream worth of values around the range of positions and normals
+        const size_t                          count = 1 << 22;
+        std::mt19937                          rng(10);
+        std::uniform_real_distribution<float> coord(-100.f, 100.f);
+
+        std::vector<float> values(count), back(count);
+        std::vector<half>  halves(count);
+        for (float& v : values)
+            v = coord(rng);
+
+        auto reference = bench::Measure("float -> half one by one", count, count * 6.0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                halves[i] = half(values[i]);
+            bench::DoNotOptimize(halves.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("FloatToHalf", count, count * 6.0, [&] {
+            FloatToHalf(values, halves);
+            bench::DoNotOptimize(halves.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("FloatToHalf without F16C", count, count * 6.0, [&] {
+            detail::FloatToHalfGeneric(values, halves);
+            bench::DoNotOptimize(halves.data());
+        }));
+
+        reference = bench::Measure("half -> float one by one", count, count * 6.0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                back[i] = halves[i];
+            bench::DoNotOptimize(back.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("HalfToFloat", count, count * 6.0, [&] {
+            HalfToFloat(halves, back);
+            bench::DoNotOptimize(back.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("HalfToFloat without F16C", count, count * 6.0, [&] {
+            detail::HalfToFloatGeneric(halves, back);
+            bench::DoNotOptimize(back.data());
+        }));
+
+        float maxError = 0.f;
+        for (size_t i = 0; i < count; ++i)
+            maxError = std::max(maxError, std::abs(back[i] - values[i]) / std::abs(values[i]));
+        std::printf("  max relative round trip error: %g (2^-11 = %g)\n", maxError, std::ldexp(1.f, -11));
+    }
+
+    bench::Registrar halfSuite("Half", RunHalf);
+} // namespace
@@ -0,0 +1,199 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+
+using namespace math;
+
+namespace
+{
+    // The original implementation: sixteen Matrix3x3 cofactor determinants, transpose, scale
+    float4x4 InverseReference(const float4x4& m)
+    {
+        float4x4 inv;
+
+        // row 1
+        inv._11 =
+            float3x3(m._22, m._23, m._24,
+                     m._32, m._33, m._34,
+                     m._42, m._43, m._44)
+                .Determinant();
+
+        inv._12 =
+            -float3x3(m._21, m._23, m._24,
+                      m._31, m._33, m._34,
+                      m._41, m._43, m._44)
+                 .Determinant();
+
+        inv._13 =
+            float3x3(m._21, m._22, m._24,
+                     m._31, m._32, m._34,
+                     m._41, m._42, m._44)
+                .Determinant();
+
+        inv._14 =
+            -float3x3(m._21, m._22, m._23,
+                      m._31, m._32, m._33,
+                      m._41, m._42, m._43)
+                 .Determinant();
+
+
+        // row 2
+        inv._21 =
+            -float3x3(m._12, m._13, m._14,
+                      m._32, m._33, m._34,
+                      m._42, m._43, m._44)
+                 .Determinant();
+
+        inv._22 =
+            float3x3(m._11, m._13, m._14,
+                     m._31, m._33, m._34,
+                     m._41, m._43, m._44)
+                .Determinant();
+
+        inv._23 =
+            -float3x3(m._11, m._12, m._14,
+                      m._31, m._32, m._34,
+                      m._41, m._42, m._44)
+                 .Determinant();
+
+        inv._24 =
+            float3x3(m._11, m._12, m._13,
+                     m._31, m._32, m._33,
+                     m._41, m._42, m._43)
+                .Determinant();
+
+
+        // row 3
+        inv._31 =
+            float3x3(m._12, m._13, m._14,
+                     m._22, m._23, m._24,
+                     m._42, m._43, m._44)
+                .Determinant();
+
+        inv._32 =
+            -float3x3(m._11, m._13, m._14,
+                      m._21, m._23, m._24,
+                      m._41, m._43, m._44)
+                 .Determinant();
+
+        inv._33 =
+            float3x3(m._11, m._12, m._14,
+                     m._21, m._22, m._24,
+                     m._41, m._42, m._44)
+                .Determinant();
+
+        inv._34 =
+            -float3x3(m._11, m._12, m._13,
+                      m._21, m._22, m._23,
+                      m._41, m._42, m._43)
+                 .Determinant();
+
+
+        // row 4
+        inv._41 =
+            -float3x3(m._12, m._13, m._14,
+                      m._22, m._23, m._24,
+                      m._32, m._33, m._34)
+                 .Determinant();
+
+        inv._42 =
+            float3x3(m._11, m._13, m._14,
+                     m._21, m._23, m._24,
+                     m._31, m._33, m._34)
+                .Determinant();
+
+        inv._43 =
+            -float3x3(m._11, m._12, m._14,
+                      m._21, m._22, m._24,
+                      m._31, m._32, m._34)
+                 .Determinant();
+
+        inv._44 =
+            float3x3(m._11, m._12, m._13,
+                     m._21, m._22, m._23,
+                     m._31, m._32, m._33)
+                .Determinant();
+
+        auto det = m._11 * inv._11 + m._12 * inv._12 + m._13 * inv._13 + m._14 * inv._14;
+        inv      = inv.Transpose();
+        inv *= 1.f / det;
+
+        return inv;
+    }
+
+    float MaxErrorFromIdentity(const float4x4& m, const float4x4& inv)
+    {
+        const auto product  = m * inv;
+        const auto identity = float4x4::Identity();
+        float      maxError = 0;
+        for (int i = 0; i < 16; ++i)
+            maxError = std::max(maxError, std::abs(product.Data()[i] - identity.Data()[i]));
+        return maxError;
+    }
+
+    void RunInverse()
+    {
+        const size_t count = 1024;
+
+        std::mt19937                          rng(3);
+        std::uniform_real_distribution<float> angle(-PI_F, PI_F);
+        std::uniform_real_distribution<float> offset(-100.f, 100.f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.f);
+
+        // Model-like matrices: rotation * translation (rigid) and scale * rotation * translation (affine)
+        std::vector<float4x4> rigid(count), affine(count), general(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto rotation    = float4x4::RotationArbitrary(float3(offset(rng), offset(rng), offset(rng)), angle(rng));
+            const auto translation = float4x4::Translation(offset(rng), offset(rng), offset(rng));
+            rigid[i]               = rotation * translation;
+            affine[i]              = float4x4::Scale(scale(rng), scale(rng), scale(rng)) * rigid[i];
+            general[i]             = affine[i] * float4x4::Projection(1.f, 1.5f, 0.1f, 100.f, false);
+        }
+
+        float errReference = 0, errInverse = 0, errAffine = 0, errRigid = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            errReference = std::max(errReference, MaxErrorFromIdentity(general[i], InverseReference(general[i])));
+            errInverse   = std::max(errInverse, MaxErrorFromIdentity(general[i], general[i].Inverse()));
+            errAffine    = std::max(errAffine, MaxErrorFromIdentity(affine[i], affine[i].InverseAffine()));
+            errRigid     = std::max(errRigid, MaxErrorFromIdentity(rigid[i], rigid[i].InverseRigid()));
+        }
+        std::printf("  max |M * M^-1 - I|: reference %g, Inverse %g, InverseAffine %g, InverseRigid %g\n",
+                    errReference, errInverse, errAffine, errRigid);
+
+        std::vector<float4x4> out(count);
+
+        auto baseline = bench::Measure("reference cofactor Inverse", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = InverseReference(general[i]);
+            bench::DoNotOptimize(out.data());
+        });
+
+        auto inverse = bench::Measure("Inverse", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = general[i].Inverse();
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, inverse);
+
+        auto inverseAffine = bench::Measure("InverseAffine", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = affine[i].InverseAffine();
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, inverseAffine);
+
+        auto inverseRigid = bench::Measure("InverseRigid", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = rigid[i].InverseRigid();
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, inverseRigid);
+    }
+
+    bench::Registrar inverse("Matrix4x4::Inverse", RunInverse);
+} // namespace
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/MeshOptimize.h"
+
+using namespace math;
+
+namespace
+{
+    struct Mesh
+    {
+        std::vector<float3>   positions;
+        std::vector<uint32_t> indices;
+    };
+
+    // A bumpy torus in ring order, counter-clockwise seen from outside
+    Mesh MakeTorus(uint32_t rings, uint32_t sides)
+    {
+        const float pi = 3.14159265f;
+
+        Mesh mesh;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const float u = 2.f * pi * static_cast<float>(i) / static_cast<float>(rings);
+                const float v = 2.f * pi * static_cast<float>(j) / static_cast<float>(sides);
+                const float r = 1.f + 0.1f * std::sin(7.f * u) * std::sin(5.f * v);
+                mesh.positions.emplace_back((3.f + r * std::cos(v)) * std::cos(u), (3.f + r * std::cos(v)) * std::sin(u), r * std::sin(v));
+            }
+        }
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const uint32_t a = i * sides + j;
+                const uint32_t b = ((i + 1) % rings) * sides + j;
+                const uint32_t c = ((i + 1) % rings) * sides + (j + 1) % sides;
+                const uint32_t d = i * sides + (j + 1) % sides;
+                mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+            }
+        }
+        return mesh;
+    }
+
+    // The triangles as a sorted list of rotations starting at their smallest index, to check
+    // that reordering kept every triangle and its winding
+    std::vector<uint3> Canonical(span<const uint32_t> indices)
+    {
+        std::vector<uint3> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            uint3 t(indices[i], indices[i + 1], indices[i + 2]);
+            while (t.x > t.y || t.x > t.z)
+                t = uint3(t.y, t.z, t.x);
+            triangles.push_back(t);
+        }
+        std::sort(triangles.begin(), triangles.end(), [](const uint3& a, const uint3& b) {
+            return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+        });
+        return triangles;
+    }
+
+    void Report(const char* name, const Mesh& mesh, span<const uint32_t> indices)
+    {
+        const VertexCacheStats cache    = AnalyzeVertexCache(indices, mesh.positions.size());
+        const OverdrawStats    overdraw = AnalyzeOverdraw(indices, mesh.positions);
+        std::printf("  %-36s ACMR %.3f  ATVR %.3f  overdraw %.3f\n", name, cache.acmr, cache.atvr, overdraw.overdraw);
+    }
+
+    void RunMeshOptimize()
+    {
+        const Mesh   mesh      = MakeTorus(256, 96);
+        const size_t triangles = mesh.indices.size() / 3;
+        std::printf("  torus of %zu triangles, %zu vertices, FIFO of %u vertices\n", triangles, mesh.positions.size(), kPostTransformCacheSize);
+
+        // An exported asset lists its triangles in no useful order
+        std::vector<uint3> shuffledTriangles(triangles);
+        for (size_t t = 0; t < triangles; ++t)
+            shuffledTriangles[t] = uint3(mesh.indices[3 * t], mesh.indices[3 * t + 1], mesh.indices[3 * t + 2]);
+        std::shuffle(shuffledTriangles.begin(), shuffledTriangles.end(), std::mt19937(10));
+        std::vector<uint32_t> shuffled;
+        for (const uint3& t : shuffledTriangles)
+            shuffled.insert(shuffled.end(), {t.x, t.y, t.z});
+
+        Report("ring order", mesh, mesh.indices);
+        Report("shuffled", mesh, shuffled);
+
+        std::vector<uint32_t> cacheOptimized = shuffled;
+        OptimizeVertexCache(cacheOptimized, mesh.positions.size());
+        Report("shuffled, OptimizeVertexCache", mesh, cacheOptimized);
+
+        for (float threshold : {1.05f, 1.5f, 3.f})
+        {
+            std::vector<uint32_t> overdrawOptimized = cacheOptimized;
+            OptimizeOverdraw(overdrawOptimized, mesh.positions, threshold);
+            char name[64];
+            std::snprintf(name, sizeof(name), "  then OptimizeOverdraw(%.2f)", threshold);
+            Report(name, mesh, overdrawOptimized);
+            if (Canonical(overdrawOptimized) != Canonical(mesh.indices))
+                std::printf("  OptimizeOverdraw LOST OR CHANGED TRIANGLES\n");
+        }
+
+        // Vertex fetch order: the distance between consecutive new vertices
+        std::vector<uint32_t> fetchOptimized = cacheOptimized;
+        std::vector<float3>   vertices       = mesh.positions;
+        OptimizeVertexFetch(fetchOptimized, vertices);
+        auto averageJump = [](span<const uint32_t> indices, size_t vertexCount) {
+            std::vector<uint8_t> seen(vertexCount, 0);
+            double               jumps = 0.0;
+            uint32_t             last  = 0, fetched = 0;
+            for (uint32_t index : indices)
+                if (!seen[index])
+                {
+                    seen[index] = 1;
+                    jumps += std::abs(static_cast<double>(index) - static_cast<double>(last));
+                    last = index;
+                    ++fetched;
+                }
+            return jumps / fetched;
+        };
+        bool samePositions = vertices.size() == mesh.positions.size();
+        for (size_t i = 0; i < fetchOptimized.size() && samePositions; ++i)
+            samePositions = vertices[fetchOptimized[i]] == mesh.positions[cacheOptimized[i]];
+        std::printf("  OptimizeVertexFetch: average jump to the next new vertex %.1f -> %.1f vertices, positions %s\n",
+                    averageJump(cacheOptimized, mesh.positions.size()), averageJump(fetchOptimized, vertices.size()),
+                    samePositions ? "match" : "DIFFER");
+        if (Canonical(cacheOptimized) != Canonical(mesh.indices))
+            std::printf("  OptimizeVertexCache LOST OR CHANGED TRIANGLES\n");
+
+        // Imported meshes contain triangles that repeat a vertex; they must survive as well and
+        // end up behind the others
+        {
+            std::mt19937       rng(11);
+            std::vector<uint3> withDegenerate = shuffledTriangles;
+            const uint32_t     vertexCount    = static_cast<uint32_t>(mesh.positions.size());
+            for (uint32_t k = 0; k < 2000; ++k)
+            {
+                const uint32_t a = rng() % vertexCount, b = (a + 1 + rng() % 8) % vertexCount;
+                const uint3    patterns[] = {uint3(a, a, b), uint3(a, b, b), uint3(b, a, b), uint3(a, a, a)};
+                withDegenerate.insert(withDegenerate.begin() + rng() % (withDegenerate.size() + 1), patterns[k % 4]);
+            }
+            std::vector<uint32_t> degenerateInput;
+            for (const uint3& t : withDegenerate)
+                degenerateInput.insert(degenerateInput.end(), {t.x, t.y, t.z});
+
+            std::vector<uint32_t> optimized = degenerateInput;
+            OptimizeVertexCache(optimized, mesh.positions.size());
+            bool atEnd = true;
+            for (size_t i = 3 * triangles; i < optimized.size(); i += 3)
+                atEnd &= optimized[i] == optimized[i + 1] || optimized[i + 1] == optimized[i + 2] || optimized[i + 2] == optimized[i];
+            std::printf("  with 2000 degenerate triangles: %s, %s, ACMR %.3f\n",
+                        Canonical(optimized) == Canonical(degenerateInput) ? "every triangle survives" : "TRIANGLES LOST OR CHANGED",
+                        atEnd ? "degenerate ones last" : "DEGENERATE ONES NOT LAST",
+                        AnalyzeVertexCache(span<const uint32_t>(optimized.data(), 3 * triangles), mesh.positions.size()).acmr);
+        }
+
+        std::printf("  items = triangles\n");
+        std::vector<uint32_t> work;
+        bench::Measure("OptimizeVertexCache", triangles, 0, [&] {
+            work = shuffled;
+            OptimizeVertexCache(work, mesh.positions.size());
+            bench::DoNotOptimize(work.data());
+        });
+        bench::Measure("OptimizeOverdraw(1.05)", triangles, 0, [&] {
+            work = cacheOptimized;
+            OptimizeOverdraw(work, mesh.positions);
+            bench::DoNotOptimize(work.data());
+        });
+        bench::Measure("OptimizeVertexFetch", triangles, 0, [&] {
+            work     = cacheOptimized;
+            vertices = mesh.positions;
+            OptimizeVertexFetch(work, vertices);
+            bench::DoNotOptimize(vertices.data());
+        });
+        bench::Measure("AnalyzeVertexCache", triangles, 0, [&] {
+            VertexCacheStats stats = AnalyzeVertexCache(cacheOptimized, mesh.positions.size());
+            bench::DoNotOptimize(&stats);
+        });
+    }
+
+    bench::Registrar meshOptimizeSuite("MeshOptimize", RunMeshOptimize);
+} // namespace
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/MeshSimplify.h"
+
+using namespace math;
+
+namespace
+{
+    const float kPi = 3.14159265f;
+
+    struct Mesh
+    {
+        std::vector<float3>   positions;
+        std::vector<float4>   colors;
+        std::vector<uint32_t> indices;
+    };
+
+    float TorusRadius(float u, float v) { return 1.f + 0.1f * std::sin(7.f * u) * std::sin(5.f * v); }
+
+    // Color bands around the tube
+    float4 TorusColor(float u, float v) { return float4(std::sin(3.f * u) > 0.f ? 1.f : 0.2f, 0.5f + 0.5f * std::cos(v), 0.3f, 1.f); }
+
+    // A bumpy torus, counter-clockwise seen from outside
+    Mesh MakeTorus(uint32_t rings, uint32_t sides)
+    {
+        Mesh mesh;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const float u = 2.f * kPi * static_cast<float>(i) / static_cast<float>(rings);
+                const float v = 2.f * kPi * static_cast<float>(j) / static_cast<float>(sides);
+                const float r = TorusRadius(u, v);
+                mesh.positions.emplace_back((3.f + r * std::cos(v)) * std::cos(u), (3.f + r * std::cos(v)) * std::sin(u), r * std::sin(v));
+                mesh.colors.push_back(TorusColor(u, v));
+            }
+        }
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const uint32_t a = i * sides + j;
+                const uint32_t b = ((i + 1) % rings) * sides + j;
+                const uint32_t c = ((i + 1) % rings) * sides + (j + 1) % sides;
+                const uint32_t d = i * sides + (j + 1) % sides;
+                mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+            }
+        }
+        return mesh;
+    }
+
+    // Largest distance of the vertices from the torus surface and mean color difference to the
+    // color of the surface there, measured along the tube's radius
+    void Deviation(const SimplifiedMesh& mesh, float& distance, float& color)
+    {
+        distance = 0.f;
+        color    = 0.f;
+        for (size_t i = 0; i < mesh.positions.size(); ++i)
+        {
+            const float3& p      = mesh.positions[i];
+            const float   u      = std::atan2(p.y, p.x);
+            const float   radial = std::sqrt(p.x * p.x + p.y * p.y) - 3.f;
+            const float   v      = std::atan2(p.z, radial);
+            distance             = std::max(distance, std::abs(std::sqrt(radial * radial + p.z * p.z) - TorusRadius(u, v)));
+            if (!mesh.colors.empty())
+            {
+                const float4 difference = mesh.colors[i] - TorusColor(u, v);
+                color += std::sqrt(dot(difference, difference));
+            }
+        }
+        color /= static_cast<float>(std::max<size_t>(mesh.positions.size(), 1));
+    }
+
+    void RunMeshSimplify()
+    {
+        const Mesh   mesh      = MakeTorus(512, 192);
+        const size_t triangles = mesh.indices.size() / 3;
+        const float  diagonal  = length(float3(8.4f, 8.4f, 2.2f));
+        std::printf("  torus of %zu triangles, errors relative to the bounds diagonal %.2f\n", triangles, diagonal);
+
+        const std::vector<SimplifiedMesh> chain = BuildLodChain(mesh.positions, mesh.colors, mesh.indices, 8);
+        for (size_t level = 0; level < chain.size(); ++level)
+        {
+            float distance, color;
+            Deviation(chain[level], distance, color);
+            std::printf("  LOD %zu: %7zu triangles %7zu vertices, error %.5f, measured distance %.5f, color difference %.3f\n", level + 1,
+                        chain[level].indices.size() / 3, chain[level].positions.size(), chain[level].error, distance / diagonal, color);
+        }
+
+        // The same target with and without colors in the error
+        for (double colorWeight : {0.0, 0.01})
+        {
+            const SimplifiedMesh lod = SimplifyMesh(mesh.positions, mesh.colors, mesh.indices, triangles / 64, DBL_MAX, colorWeight);
+            float                distance, color;
+            Deviation(lod, distance, color);
+            std::printf("  1/64 of the triangles, color weight %.2f: error %.5f, color difference %.3f\n", colorWeight, lod.error, color);
+        }
+
+        // Error target instead of triangle count
+        const SimplifiedMesh byError = SimplifyMesh(mesh.positions, {}, mesh.indices, 0, 0.001);
+        std::printf("  error at most 0.001: %zu triangles\n", byError.indices.size() / 3);
+
+        // An open grid keeps its outline
+        Mesh grid;
+        for (uint32_t y = 0; y <= 256; ++y)
+            for (uint32_t x = 0; x <= 256; ++x)
+                grid.positions.emplace_back(static_cast<float>(x), static_cast<float>(y), 2.f * std::sin(0.05f * static_cast<float>(x)) * std::cos(0.07f * static_cast<float>(y)));
+        for (uint32_t y = 0; y < 256; ++y)
+            for (uint32_t x = 0; x < 256; ++x)
+            {
+                const uint32_t a = y * 257 + x;
+                grid.indices.insert(grid.indices.end(), {a, a + 1, a + 258, a, a + 258, a + 257});
+            }
+        const SimplifiedMesh openLod = SimplifyMesh(grid.positions, {}, grid.indices, grid.indices.size() / 3 / 50);
+        float                outline = 0.f;
+        for (const float3& p : openLod.positions)
+        {
+            const float border = std::min({p.x, p.y, 256.f - p.x, 256.f - p.y});
+            if (border < 1.f)
+                outline = std::max(outline, std::abs(border));
+        }
+        std::printf("  open grid of %zu triangles to %zu: largest distance of a border vertex from the border %g\n", grid.indices.size() / 3,
+                    openLod.indices.size() / 3, outline);
+
+        // The edge costs are evaluated on the pool; the result must not depend on it
+        ThreadPool           serial(1), eight(8);
+        const SimplifiedMesh serialLod = SimplifyMesh(serial, mesh.positions, mesh.colors, mesh.indices, triangles / 10);
+        const SimplifiedMesh eightLod  = SimplifyMesh(eight, mesh.positions, mesh.colors, mesh.indices, triangles / 10);
+        std::printf("  1 and 8 thread results identical: %s, %u threads in the default pool\n",
+                    serialLod.indices == eightLod.indices && serialLod.positions == eightLod.positions ? "yes" : "NO", ThreadPool::Default().size());
+
+        std::printf("  items = source triangles\n");
+        bench::Measure("SimplifyMesh to 1/10, colors, 1 thread", triangles, 0, [&] {
+            SimplifiedMesh lod = SimplifyMesh(serial, mesh.positions, mesh.colors, mesh.indices, triangles / 10);
+            bench::DoNotOptimize(lod.indices.data());
+        });
+        bench::Measure("SimplifyMesh to 1/10, colors", triangles, 0, [&] {
+            SimplifiedMesh lod = SimplifyMesh(mesh.positions, mesh.colors, mesh.indices, triangles / 10);
+            bench::DoNotOptimize(lod.indices.data());
+        });
+        bench::Measure("SimplifyMesh to 1/10, no colors", triangles, 0, [&] {
+            SimplifiedMesh lod = SimplifyMesh(mesh.positions, {}, mesh.indices, triangles / 10);
+            bench::DoNotOptimize(lod.indices.data());
+        });
+        bench::Measure("BuildLodChain, 8 levels of 1/2", triangles, 0, [&] {
+            std::vector<SimplifiedMesh> lods = BuildLodChain(mesh.positions, mesh.colors, mesh.indices, 8);
+            bench::DoNotOptimize(lods.data());
+        });
+    }
+
+    bench::Registrar meshSimplifySuite("MeshSimplify", RunMeshSimplify);
+} // namespace
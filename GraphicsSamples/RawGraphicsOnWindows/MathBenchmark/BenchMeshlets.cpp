@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Frustum.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/Meshlets.h"
+
+using namespace math;
+
+namespace
+{
+    const float kPi = 3.14159265f;
+
+    struct Mesh
+    {
+        std::vector<float3>   positions;
+        std::vector<uint32_t> indices;
+    };
+
+    // A bumpy torus, counter-clockwise seen from outside, triangles in random order
+    Mesh MakeTorus(uint32_t rings, uint32_t sides)
+    {
+        Mesh mesh;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const float u = 2.f * kPi * static_cast<float>(i) / static_cast<float>(rings);
+                const float v = 2.f * kPi * static_cast<float>(j) / static_cast<float>(sides);
+                const float r = 1.f + 0.1f * std::sin(7.f * u) * std::sin(5.f * v);
+                mesh.positions.emplace_back((3.f + r * std::cos(v)) * std::cos(u), (3.f + r * std::cos(v)) * std::sin(u), r * std::sin(v));
+            }
+        }
+
+        std::vector<uint32_t> quads(rings * sides);
+        for (uint32_t q = 0; q < quads.size(); ++q)
+            quads[q] = q;
+        std::shuffle(quads.begin(), quads.end(), std::mt19937(21));
+        for (uint32_t q : quads)
+        {
+            const uint32_t i = q / sides, j = q % sides;
+            const uint32_t a = i * sides + j;
+            const uint32_t b = ((i + 1) % rings) * sides + j;
+            const uint32_t c = ((i + 1) % rings) * sides + (j + 1) % sides;
+            const uint32_t d = i * sides + (j + 1) % sides;
+            mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+        }
+        return mesh;
+    }
+
+    // Triangles rotated so that the smallest index comes first, which keeps the winding
+    std::vector<uint32_t> CanonicalTriangles(span<const uint32_t> indices)
+    {
+        std::vector<uint32_t> out(indices.begin(), indices.end());
+        for (size_t t = 0; t < out.size(); t += 3)
+        {
+            while (out[t] > out[t + 1] || out[t] > out[t + 2])
+                std::rotate(out.begin() + t, out.begin() + t + 1, out.begin() + t + 3);
+        }
+        std::vector<uint64_t> keys;
+        for (size_t t = 0; t < out.size(); t += 3)
+            keys.push_back((uint64_t(out[t]) << 42) | (uint64_t(out[t + 1]) << 21) | out[t + 2]);
+        std::sort(keys.begin(), keys.end());
+        for (size_t t = 0; t < keys.size(); ++t)
+        {
+            out[3 * t + 0] = static_cast<uint32_t>(keys[t] >> 42);
+            out[3 * t + 1] = static_cast<uint32_t>(keys[t] >> 21) & 0x1FFFFF;
+            out[3 * t + 2] = static_cast<uint32_t>(keys[t]) & 0x1FFFFF;
+        }
+        return out;
+    }
+
+    void PrintStatistics(const char* what, const MeshletBuffers& buffers)
+    {
+        double vertices = 0.0, triangles = 0.0, radius = 0.0;
+        size_t cones    = 0;
+        for (size_t i = 0; i < buffers.meshlets.size(); ++i)
+        {
+            vertices += buffers.meshlets[i].vertexCount;
+            triangles += buffers.meshlets[i].triangleCount;
+            radius += buffers.bounds[i].radius;
+            cones += buffers.bounds[i].coneCutoff < 1.f;
+        }
+        const double count = static_cast<double>(buffers.meshlets.size());
+        std::printf("  %s: %zu meshlets, %.1f vertices, %.1f triangles, radius %.3f on average, %.0f%% with a cone\n", what,
+                    buffers.meshlets.size(), vertices / count, triangles / count, radius / count, 100.0 * cones / count);
+    }
+
+    // Fills the meshlets in index buffer order, for comparison
+    MeshletBuffers SplitInOrder(span<const uint32_t> indices, span<const float3> positions)
+    {
+        MeshletBuffers        out;
+        std::vector<uint32_t> local(positions.size(), UINT32_MAX);
+        Meshlet               meshlet;
+        auto                  finish = [&] {
+            for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+                local[out.vertices[meshlet.vertexOffset + i]] = UINT32_MAX;
+            out.meshlets.push_back(meshlet);
+            meshlet = Meshlet{static_cast<uint32_t>(out.vertices.size()), static_cast<uint32_t>(out.triangles.size() / 3), 0, 0};
+        };
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            const uint32_t added = (local[indices[t]] == UINT32_MAX) + (local[indices[t + 1]] == UINT32_MAX) + (local[indices[t + 2]] == UINT32_MAX);
+            if (meshlet.vertexCount + added > kMeshletMaxVertices || meshlet.triangleCount == kMeshletMaxTriangles)
+                finish();
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t v = indices[t + corner];
+                if (local[v] == UINT32_MAX)
+                {
+                    local[v] = meshlet.vertexCount++;
+                    out.vertices.push_back(v);
+                }
+                out.triangles.push_back(static_cast<uint8_t>(local[v]));
+            }
+            ++meshlet.triangleCount;
+        }
+        finish();
+        for (const Meshlet& m : out.meshlets)
+            out.bounds.push_back(ComputeMeshletBounds(positions, out, m));
+        return out;
+    }
+
+    // Camera at eye looking at the origin, left-handed like float4x4::Projection
+    float4x4 LookAtOrigin(const float3& eye)
+    {
+        const float3 forward = normalize(-eye);
+        const float3 right   = normalize(cross(float3(0.f, 0.f, 1.f), forward));
+        const float3 up      = cross(forward, right);
+        return float4x4::Translation(-eye) * float4x4::ViewFromBasis(right, up, forward);
+    }
+
+    void RunMeshlets()
+    {
+        const Mesh mesh = MakeTorus(512, 384);
+        std::printf("  torus: %zu vertices, %zu triangles in random order\n", mesh.positions.size(), mesh.indices.size() / 3);
+
+        MeshletBuffers buffers;
+        bench::Measure("BuildMeshlets", mesh.indices.size() / 3, 0, [&] {
+            buffers = BuildMeshlets(mesh.indices, mesh.positions);
+        }, 1.0);
+        PrintStatistics("BuildMeshlets", buffers);
+        PrintStatistics("index buffer order", SplitInOrder(mesh.indices, mesh.positions));
+
+        // Every triangle exactly once, within the limits
+        std::vector<uint32_t> rebuilt;
+        bool                  withinLimits = true;
+        for (const Meshlet& m : buffers.meshlets)
+        {
+            withinLimits &= m.vertexCount <= kMeshletMaxVertices && m.triangleCount <= kMeshletMaxTriangles;
+            for (uint32_t i = 0; i < 3 * m.triangleCount; ++i)
+                rebuilt.push_back(buffers.vertices[m.vertexOffset + buffers.triangles[3 * size_t(m.triangleOffset) + i]]);
+        }
+        const bool same = CanonicalTriangles(rebuilt) == CanonicalTriangles(mesh.indices);
+        std::printf("  meshlets %s the triangles of the mesh, %s the limits\n", same ? "hold exactly" : "DO NOT HOLD", withinLimits ? "within" : "BEYOND");
+
+        // Views from around the torus; the culling must keep every meshlet with a triangle that
+        // faces the camera and has a vertex in the frustum
+        const float4x4        projection = float4x4::Projection(1.f, 16.f / 9.f, 0.1f, 100.f, false);
+        const Frustum         frustum    = Frustum::FromMatrix(projection, false);
+        const MeshletCullData cullData(buffers.bounds);
+        const size_t          count = buffers.meshlets.size();
+        std::vector<uint32_t> expected, visible(count);
+        size_t                visibleCount = 0;
+
+        const float3 eyes[] = {float3(0.f, -9.f, 4.f), float3(5.f, 0.f, 1.f), float3(0.f, -2.f, 8.f), float3(1.5f, 2.5f, 0.3f)};
+        for (const float3& eye : eyes)
+        {
+            const float4x4 view = LookAtOrigin(eye);
+
+            auto reference = bench::Measure("meshlets one by one", count, count * sizeof(MeshletBounds), [&] {
+                expected.clear();
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (IsMeshletVisible(buffers.bounds[i], view, frustum))
+                        expected.push_back(static_cast<uint32_t>(i));
+                }
+                bench::DoNotOptimize(expected.data());
+            });
+            bench::PrintSpeedup(reference, bench::Measure("CullMeshlets", count, count * sizeof(MeshletBounds), [&] {
+                visibleCount = CullMeshlets(cullData, view, frustum, visible);
+                bench::DoNotOptimize(visible.data());
+            }));
+
+            // Meshlets on the culling boundary may go either way when the compiler contracts
+            // the scalar expressions into FMAs
+            size_t differences = expected.size() != visibleCount;
+            for (size_t i = 0; i < expected.size() && i < visibleCount; ++i)
+                differences += expected[i] != visible[i];
+
+            std::vector<bool> kept(count, false);
+            for (size_t i = 0; i < visibleCount; ++i)
+                kept[visible[i]] = true;
+            size_t inFrustum = 0, missed = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const MeshletBounds& b = buffers.bounds[i];
+                inFrustum += frustum.Intersects(detail::TransformPointScalar(view, b.center, false), b.radius);
+                if (kept[i])
+                    continue;
+
+                const Meshlet& m = buffers.meshlets[i];
+                for (uint32_t t = 0; t < m.triangleCount; ++t)
+                {
+                    float3 p[3];
+                    for (int corner = 0; corner < 3; ++corner)
+                        p[corner] = mesh.positions[buffers.vertices[m.vertexOffset + buffers.triangles[3 * size_t(m.triangleOffset + t) + corner]]];
+                    const float3 n       = normalize(cross(p[1] - p[0], p[2] - p[0]));
+                    const bool   facing  = dot(eye - p[0], n) > 1e-4f * length(eye - p[0]);
+                    bool         contain = false;
+                    for (const float3& q : p)
+                        contain |= frustum.Contains(detail::TransformPointScalar(view, q, false));
+                    missed += facing && contain;
+                }
+            }
+            std::printf("  eye (%.1f %.1f %.1f): %zu of %zu in the frustum, %zu also facing the camera, differences vs one by one %zu, "
+                        "visible triangles culled %zu\n",
+                        eye.x, eye.y, eye.z, inFrustum, count, visibleCount, differences, missed);
+        }
+    }
+
+    bench::Registrar meshletsSuite("Meshlets", RunMeshlets);
+} // namespace
@@ -0,0 +1,182 @@
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/Morton.h"
+
+using namespace math;
+
+namespace
+{
+    // Shift-and-mask versions, the fallback of Morton.h without BMI2
+    uint32_t Spread3Magic(uint32_t x)
+    {
+        x &= 0x000003FFu;
+        x = (x | (x << 16u)) & 0x030000FFu;
+        x = (x | (x << 8u)) & 0x0300F00Fu;
+        x = (x | (x << 4u)) & 0x030C30C3u;
+        x = (x | (x << 2u)) & 0x09249249u;
+        return x;
+    }
+
+    uint64_t Spread3Magic(uint64_t x)
+    {
+        x &= 0x00000000001FFFFFull;
+        x = (x | (x << 32u)) & 0x001F00000000FFFFull;
+        x = (x | (x << 16u)) & 0x001F0000FF0000FFull;
+        x = (x | (x << 8u)) & 0x100F00F00F00F00Full;
+        x = (x | (x << 4u)) & 0x10C30C30C30C30C3ull;
+        x = (x | (x << 2u)) & 0x1249249249249249ull;
+        return x;
+    }
+
+    uint64_t Compact3Magic(uint64_t x)
+    {
+        x &= 0x1249249249249249ull;
+        x = (x | (x >> 2u)) & 0x10C30C30C30C30C3ull;
+        x = (x | (x >> 4u)) & 0x100F00F00F00F00Full;
+        x = (x | (x >> 8u)) & 0x001F0000FF0000FFull;
+        x = (x | (x >> 16u)) & 0x001F00000000FFFFull;
+        x = (x | (x >> 32u)) & 0x00000000001FFFFFull;
+        return x;
+    }
+
+    uint32_t Encode3D32Magic(const uint3& c)
+    {
+        return Spread3Magic(c.x) | (Spread3Magic(c.y) << 1u) | (Spread3Magic(c.z) << 2u);
+    }
+
+    uint64_t Encode3D64Magic(const uint3& c)
+    {
+        return Spread3Magic(uint64_t(c.x)) | (Spread3Magic(uint64_t(c.y)) << 1u) | (Spread3Magic(uint64_t(c.z)) << 2u);
+    }
+
+    uint3 Decode3D64Magic(uint64_t code)
+    {
+        return uint3(uint32_t(Compact3Magic(code)), uint32_t(Compact3Magic(code >> 1u)), uint32_t(Compact3Magic(code >> 2u)));
+    }
+
+    size_t CheckMorton(const std::vector<uint3>& cells, const std::vector<float3>& points, const float3& boxMin, const float3& boxMax)
+    {
+        const size_t count  = cells.size();
+        size_t       errors = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint3& c = cells[i];
+            errors += BitInterleave16(uint16_t(c.x), uint16_t(c.y)) != MortonEncode2D32(c.x, c.y);
+            errors += !(MortonDecode2D32(MortonEncode2D32(c.x, c.y)) == uint2(c.x & 0xFFFF, c.y & 0xFFFF));
+            errors += !(MortonDecode2D64(MortonEncode2D64(c.x, c.y)) == uint2(c.x, c.y));
+            errors += !(MortonDecode3D32(MortonEncode3D32(c.x, c.y, c.z)) == uint3(c.x & 0x3FF, c.y & 0x3FF, c.z & 0x3FF));
+            errors += !(MortonDecode3D64(MortonEncode3D64(c.x, c.y, c.z)) == uint3(c.x & 0x1FFFFF, c.y & 0x1FFFFF, c.z & 0x1FFFFF));
+            errors += MortonEncode3D32(c.x, c.y, c.z) != Encode3D32Magic(c);
+            errors += MortonEncode3D64(c.x, c.y, c.z) != Encode3D64Magic(c);
+        }
+
+        std::vector<uint32_t> codes32(count);
+        std::vector<uint64_t> codes64(count);
+        MortonEncode3D32(cells, codes32);
+        MortonEncode3D64(cells, codes64);
+        for (size_t i = 0; i < count; ++i)
+        {
+            errors += codes32[i] != MortonEncode3D32(cells[i].x, cells[i].y, cells[i].z);
+            errors += codes64[i] != MortonEncode3D64(cells[i].x, cells[i].y, cells[i].z);
+        }
+
+        const detail::MortonQuantizer q10(boxMin, boxMax, 10), q21(boxMin, boxMax, 21);
+        MortonEncode3D32(points, boxMin, boxMax, codes32);
+        MortonEncode3D64(points, boxMin, boxMax, codes64);
+        for (size_t i = 0; i < count; ++i)
+        {
+            errors += codes32[i] != Encode3D32Magic(q10.Cell(points[i]));
+            errors += codes64[i] != Encode3D64Magic(q21.Cell(points[i]));
+        }
+        return errors;
+    }
+
+    void RunMorton()
+    {
+        const size_t count = 1000000;
+
+        std::mt19937                          rng(6);
+        std::uniform_real_distribution<float> coord(-10.f, 10.f);
+
+        // Random bits beyond the encoded width check the masking
+        std::vector<uint3>  cells(count);
+        std::vector<float3> points(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            cells[i]  = uint3(uint32_t(rng()), uint32_t(rng()), uint32_t(rng()));
+            points[i] = float3(coord(rng), coord(rng), coord(rng));
+        }
+        // Slightly smaller than the points, so some are clamped
+        const float3 boxMin(-9.5f, -9.5f, -9.5f), boxMax(9.5f, 9.5f, 9.5f);
+
+        std::printf("  errors vs reference/round trip: %zu\n", CheckMorton(cells, points, boxMin, boxMax));
+
+        std::vector<uint32_t> codes32(count);
+        std::vector<uint64_t> codes64(count);
+        std::vector<uint3>    decoded(count);
+
+        auto encode32 = bench::Measure("3D 32-bit encode, shift-and-mask", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                codes32[i] = Encode3D32Magic(cells[i]);
+            bench::DoNotOptimize(codes32.data());
+        });
+        bench::PrintSpeedup(encode32, bench::Measure("MortonEncode3D32 per point", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                codes32[i] = MortonEncode3D32(cells[i].x, cells[i].y, cells[i].z);
+            bench::DoNotOptimize(codes32.data());
+        }));
+        bench::PrintSpeedup(encode32, bench::Measure("MortonEncode3D32 span", count, 0, [&] {
+            MortonEncode3D32(cells, codes32);
+            bench::DoNotOptimize(codes32.data());
+        }));
+
+        auto encode64 = bench::Measure("3D 64-bit encode, shift-and-mask", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                codes64[i] = Encode3D64Magic(cells[i]);
+            bench::DoNotOptimize(codes64.data());
+        });
+        bench::PrintSpeedup(encode64, bench::Measure("MortonEncode3D64 span", count, 0, [&] {
+            MortonEncode3D64(cells, codes64);
+            bench::DoNotOptimize(codes64.data());
+        }));
+
+        auto decode64 = bench::Measure("3D 64-bit decode, shift-and-mask", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                decoded[i] = Decode3D64Magic(codes64[i]);
+            bench::DoNotOptimize(decoded.data());
+        });
+        bench::PrintSpeedup(decode64, bench::Measure("MortonDecode3D64", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                decoded[i] = MortonDecode3D64(codes64[i]);
+            bench::DoNotOptimize(decoded.data());
+        }));
+
+        const detail::MortonQuantizer q10(boxMin, boxMax, 10), q21(boxMin, boxMax, 21);
+
+        auto points32 = bench::Measure("float3 -> 32-bit, per point quantize + encode", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                codes32[i] = Encode3D32Magic(q10.Cell(points[i]));
+            bench::DoNotOptimize(codes32.data());
+        });
+        bench::PrintSpeedup(points32, bench::Measure("MortonEncode3D32 float3 span", count, 0, [&] {
+            MortonEncode3D32(points, boxMin, boxMax, codes32);
+            bench::DoNotOptimize(codes32.data());
+        }));
+
+        auto points64 = bench::Measure("float3 -> 64-bit, per point quantize + encode", count, 0, [&] {
+            for (size_t i = 0; i < count; ++i)
+                codes64[i] = Encode3D64Magic(q21.Cell(points[i]));
+            bench::DoNotOptimize(codes64.data());
+        });
+        bench::PrintSpeedup(points64, bench::Measure("MortonEncode3D64 float3 span", count, 0, [&] {
+            MortonEncode3D64(points, boxMin, boxMax, codes64);
+            bench::DoNotOptimize(codes64.data());
+        }));
+    }
+
+    bench::Registrar morton("Morton", RunMorton);
+} // namespace
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cfloat>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/MortonIndex.h"
+
+using namespace math;
+
+namespace
+{
+    bool InBox(const float3& p, const float3& boxMin, const float3& boxMax)
+    {
+        return p.x >= boxMin.x && p.x <= boxMax.x && p.y >= boxMin.y && p.y <= boxMax.y && p.z >= boxMin.z && p.z <= boxMax.z;
+    }
+
+    float DistanceSq(const float3& a, const float3& b)
+    {
+        const float3 d = a - b;
+        return dot(d, d);
+    }
+
+    void BruteForceBox(const std::vector<float3>& points, const float3& boxMin, const float3& boxMax, std::vector<uint32_t>& result)
+    {
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (InBox(points[i], boxMin, boxMax))
+                result.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    void BruteForceNearest(const std::vector<float3>& points, const float3& p, size_t k, std::vector<std::pair<float, uint32_t>>& scratch)
+    {
+        scratch.clear();
+        for (size_t i = 0; i < points.size(); ++i)
+            scratch.emplace_back(DistanceSq(points[i], p), static_cast<uint32_t>(i));
+        std::partial_sort(scratch.begin(), scratch.begin() + k, scratch.end());
+    }
+
+    // Clustered like scanned or simulated data: a few dense blobs plus uniform noise
+    std::vector<float3> MakeCloud(size_t count, uint32_t seed)
+    {
+        std::mt19937                          rng(seed);
+        std::uniform_real_distribution<float> uniform(-100.f, 100.f);
+        std::normal_distribution<float>       blob(0.f, 4.f);
+
+        std::vector<float3> centers(16);
+        for (auto& c : centers)
+            c = float3(uniform(rng), uniform(rng), uniform(rng));
+
+        std::vector<float3> points(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i % 4 == 0)
+                points[i] = float3(uniform(rng), uniform(rng), uniform(rng));
+            else
+                points[i] = centers[rng() % centers.size()] + float3(blob(rng), blob(rng), blob(rng));
+        }
+        return points;
+    }
+
+    size_t CheckIndex(const std::vector<float3>& points, const MortonIndex& index, const std::vector<float3>& queries, float halfSize, size_t k)
+    {
+        size_t                                  errors = 0;
+        std::vector<uint32_t>                   expected, found;
+        std::vector<std::pair<float, uint32_t>> scratch;
+
+        std::vector<float3> boxes = {float3(-1000, -1000, -1000), float3(1000, 1000, 1000), // everything
+                                     float3(-100, -100, -100), float3(-100, -100, -100),    // one corner
+                                     float3(5, 7, 9), float3(-5, -7, -9)};                  // empty, min > max
+        for (const float3& q : queries)
+        {
+            boxes.push_back(q - float3(halfSize, halfSize, halfSize));
+            boxes.push_back(q + float3(halfSize, halfSize, halfSize));
+        }
+
+        for (size_t b = 0; b < boxes.size(); b += 2)
+        {
+            expected.clear();
+            found.clear();
+            BruteForceBox(points, boxes[b], boxes[b + 1], expected);
+            index.QueryBox(boxes[b], boxes[b + 1], found);
+            std::sort(found.begin(), found.end());
+            errors += found != expected;
+        }
+
+        for (const float3& q : queries)
+        {
+            BruteForceNearest(points, q, k, scratch);
+            index.QueryNearest(q, k, found);
+            errors += found.size() != k;
+            for (size_t i = 0; i < found.size(); ++i)
+                errors += DistanceSq(points[found[i]], q) != scratch[i].first; // ties may swap indices
+        }
+        return errors;
+    }
+
+    // A collision pass: every point against its neighbours within radius
+    void RunCollisionPass(size_t count)
+    {
+        const std::vector<float3> points = MakeCloud(count, 9);
+        const float               radius = 1.f;
+        std::printf("  collision pass over %zu points, items = points\n", count);
+
+        size_t expectedPairs = 0;
+        auto   bruteForce    = bench::Measure("all pairs within radius, O(N^2)", count, 0, [&] {
+            size_t n = 0;
+            for (size_t i = 0; i < count; ++i)
+                for (size_t j = i + 1; j < count; ++j)
+                    n += DistanceSq(points[i], points[j]) <= radius * radius;
+            expectedPairs = n;
+            bench::DoNotOptimize(n);
+        });
+        size_t indexedPairs = 0;
+        bench::PrintSpeedup(bruteForce, bench::Measure("build + ForEachInBox per point", count, 0, [&] {
+            const MortonIndex index(points);
+            const float3      r(radius, radius, radius);
+            size_t            n = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                index.ForEachInBox(points[i] - r, points[i] + r, [&](uint32_t j, const float3& p) {
+                    n += j > i && DistanceSq(points[i], p) <= radius * radius;
+                });
+            }
+            indexedPairs = n;
+            bench::DoNotOptimize(n);
+        }));
+        std::printf("  pairs found: brute force %zu, index %zu\n", expectedPairs, indexedPairs);
+    }
+
+    void RunMortonIndex()
+    {
+        const size_t count   = 1000003;
+        const size_t queries = 50;
+        const size_t k       = 16;
+
+        const std::vector<float3> points = MakeCloud(count, 7);
+
+        std::mt19937                          rng(8);
+        std::uniform_real_distribution<float> uniform(-100.f, 100.f);
+        std::vector<float3>                   probes(queries);
+        for (size_t i = 0; i < queries; ++i)
+            probes[i] = i % 2 ? points[rng() % count] : float3(uniform(rng), uniform(rng), uniform(rng));
+
+        MortonIndex index(points);
+        std::printf("  %zu points, errors vs brute force: %zu\n", count, CheckIndex(points, index, probes, 3.f, k));
+
+        // Build: the radix sorted index against std::sort of the same (code, index) pairs
+        std::vector<uint32_t>                      codes(count);
+        std::vector<std::pair<uint32_t, uint32_t>> pairs(count);
+        auto build = bench::Measure("encode + std::sort", count, 0, [&] {
+            float3 lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (const float3& p : points)
+            {
+                lo = min(lo, p);
+                hi = max(hi, p);
+            }
+            MortonEncode3D32(points, lo, hi, codes);
+            for (size_t i = 0; i < count; ++i)
+                pairs[i] = {codes[i], static_cast<uint32_t>(i)};
+            std::sort(pairs.begin(), pairs.end());
+            bench::DoNotOptimize(pairs.data());
+        });
+        bench::PrintSpeedup(build, bench::Measure("MortonIndex::Build", count, 0, [&] {
+            index.Build(points);
+            bench::DoNotOptimize(index.Points().data());
+        }));
+
+        std::printf("  items = queries\n");
+        std::vector<uint32_t> found;
+        const float3          half(2.f, 2.f, 2.f);
+
+        auto bruteBox = bench::Measure("box query, brute force", queries, 0, [&] {
+            for (size_t q = 0; q < queries; ++q)
+            {
+                found.clear();
+                BruteForceBox(points, probes[q] - half, probes[q] + half, found);
+                bench::DoNotOptimize(found.data());
+            }
+        });
+        bench::PrintSpeedup(bruteBox, bench::Measure("MortonIndex::QueryBox", queries, 0, [&] {
+            for (size_t q = 0; q < queries; ++q)
+            {
+                found.clear();
+                index.QueryBox(probes[q] - half, probes[q] + half, found);
+                bench::DoNotOptimize(found.data());
+            }
+        }));
+
+        std::vector<std::pair<float, uint32_t>> scratch;
+        scratch.reserve(count);
+        auto bruteNearest = bench::Measure("16 nearest, brute force", queries, 0, [&] {
+            for (size_t q = 0; q < queries; ++q)
+            {
+                BruteForceNearest(points, probes[q], k, scratch);
+                bench::DoNotOptimize(scratch.data());
+            }
+        });
+        bench::PrintSpeedup(bruteNearest, bench::Measure("MortonIndex::QueryNearest", queries, 0, [&] {
+            for (size_t q = 0; q < queries; ++q)
+            {
+                index.QueryNearest(probes[q], k, found);
+                bench::DoNotOptimize(found.data());
+            }
+        }));
+    }
+
+    bench::Registrar mortonIndex("Morton index", [] {
+        RunMortonIndex();
+        RunCollisionPass(10007);
+        RunCollisionPass(40009);
+    });
+} // namespace
@@ -0,0 +1,279 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/Predicates.h"
+
+using namespace math;
+
+namespace
+{
+    int Sign(int64_t value)
+    {
+        return (value > 0) - (value < 0);
+    }
+
+    int Sign(double value)
+    {
+        return (value > 0.0) - (value < 0.0);
+    }
+
+    // Determinants in int64: exact for the coordinate ranges used below
+    int64_t Orient2DReference(const int2& a, const int2& b, const int2& c)
+    {
+        const int64_t acx = a.x - c.x, acy = a.y - c.y, bcx = b.x - c.x, bcy = b.y - c.y;
+        return acx * bcy - acy * bcx;
+    }
+
+    int64_t Orient3DReference(const int3& a, const int3& b, const int3& c, const int3& d)
+    {
+        const int64_t adx = a.x - d.x, ady = a.y - d.y, adz = a.z - d.z;
+        const int64_t bdx = b.x - d.x, bdy = b.y - d.y, bdz = b.z - d.z;
+        const int64_t cdx = c.x - d.x, cdy = c.y - d.y, cdz = c.z - d.z;
+        return adz * (bdx * cdy - bdy * cdx) + bdz * (cdx * ady - cdy * adx) + cdz * (adx * bdy - ady * bdx);
+    }
+
+    int64_t InCircleReference(const int2& a, const int2& b, const int2& c, const int2& d)
+    {
+        const int64_t adx = a.x - d.x, ady = a.y - d.y, bdx = b.x - d.x, bdy = b.y - d.y, cdx = c.x - d.x, cdy = c.y - d.y;
+        return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) + (bdx * bdx + bdy * bdy) * (cdx * ady - cdy * adx) +
+               (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+    }
+
+    // The naive double determinants, for comparison
+    double Orient2DNaive(const double2& a, const double2& b, const double2& c)
+    {
+        return (a.x - c.x) * (b.y - c.y) - (a.y - c.y) * (b.x - c.x);
+    }
+
+    double Orient3DNaive(const double3& a, const double3& b, const double3& c, const double3& d)
+    {
+        const double adx = a.x - d.x, ady = a.y - d.y, adz = a.z - d.z;
+        const double bdx = b.x - d.x, bdy = b.y - d.y, bdz = b.z - d.z;
+        const double cdx = c.x - d.x, cdy = c.y - d.y, cdz = c.z - d.z;
+        return adz * (bdx * cdy - bdy * cdx) + bdz * (cdx * ady - cdy * adx) + cdz * (adx * bdy - ady * bdx);
+    }
+
+    double InCircleNaive(const double2& a, const double2& b, const double2& c, const double2& d)
+    {
+        const double adx = a.x - d.x, ady = a.y - d.y, bdx = b.x - d.x, bdy = b.y - d.y, cdx = c.x - d.x, cdy = c.y - d.y;
+        return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) + (bdx * bdx + bdy * bdy) * (cdx * ady - cdy * adx) +
+               (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+    }
+
+    double2 ToDouble(const int2& v)
+    {
+        return double2(v.x, v.y);
+    }
+
+    double3 ToDouble(const int3& v)
+    {
+        return double3(v.x, v.y, v.z);
+    }
+
+    // Kettner et al., "Classroom Examples of Robustness Problems in Geometric Computations":
+    // p on a 2^-53 grid next to the line through q and r, where Orient2D(p, q, r) = 12 * 2^-53 * (j - i)
+    void CheckKettnerGrid()
+    {
+        const double2 q(12.0, 12.0), r(24.0, 24.0);
+        const double  ulp   = std::ldexp(1.0, -53);
+        size_t        wrong = 0, naiveWrong = 0;
+        for (int i = 0; i < 256; ++i)
+        {
+            for (int j = 0; j < 256; ++j)
+            {
+                const double2 p(0.5 + i * ulp, 0.5 + j * ulp);
+                const int     expected = (j > i) - (j < i);
+                wrong += Sign(Orient2D(p, q, r)) != expected;
+                naiveWrong += Sign(Orient2DNaive(p, q, r)) != expected;
+            }
+        }
+        std::printf("  Kettner grid, wrong Orient2D signs of 65536: %zu, naive double: %zu\n", wrong, naiveWrong);
+    }
+
+    // x * a + y * b == gcd(a, b)
+    int64_t ExtendedGcd(int64_t a, int64_t b, int64_t& x, int64_t& y)
+    {
+        if (b == 0)
+        {
+            x = 1;
+            y = 0;
+            return a;
+        }
+        int64_t       x1, y1;
+        const int64_t gcd = ExtendedGcd(b, a % b, x1, y1);
+        x                 = y1;
+        y                 = x1 - (a / b) * y1;
+        return gcd;
+    }
+
+    // Integer points with determinants of -1, 0 and 1 next to terms above 2^53, so that the
+    // double products round. The int64 references are exact.
+    void CheckDegenerate()
+    {
+        std::mt19937 rng(8);
+        const int    count = 100000;
+
+        // b - a = (p, q) and c - a = (r, s) with p * s - q * r = 1, or c - a = -(p, q)
+        std::uniform_int_distribution<int32_t> offset(-(1 << 24), 1 << 24), large(1 << 26, 1 << 27), choice(0, 2);
+        size_t                                 wrong = 0, naiveWrong = 0;
+        for (int k = 0; k < count;)
+        {
+            const int32_t p = large(rng), q = large(rng);
+            int64_t       s, minusR;
+            if (ExtendedGcd(p, q, s, minusR) != 1)
+                continue;
+            ++k;
+
+            const int2 a(offset(rng), offset(rng));
+            const int2 b(a.x + p, a.y + q);
+            const int  kind = choice(rng);
+            const int2 c    = kind == 0 ? int2(a.x - p, a.y - q) : int2(a.x - static_cast<int32_t>(minusR), a.y + static_cast<int32_t>(s));
+
+            const int2 first = kind == 2 ? c : b, second = kind == 2 ? b : c;
+            const int  expected = Sign(Orient2DReference(a, first, second));
+            wrong += Sign(Orient2D(a, first, second)) != expected;
+            naiveWrong += Sign(Orient2DNaive(ToDouble(a), ToDouble(first), ToDouble(second))) != expected;
+        }
+        std::printf("  nearly collinear points, wrong Orient2D signs of %d: %zu, naive double: %zu\n", count, wrong, naiveWrong);
+
+        // d on the plane through a, b and c, or one unit off it
+        std::uniform_int_distribution<int32_t> base(-(1 << 16), 1 << 16), step(-16, 16), coefficient(-(1 << 14), 1 << 14), nudge(-1, 1);
+        wrong = naiveWrong = 0;
+        for (int k = 0; k < count; ++k)
+        {
+            const int3 a(base(rng), base(rng), base(rng));
+            const int3 u(step(rng), step(rng), step(rng)), v(step(rng), step(rng), step(rng));
+            auto       onPlane = [&](int p, int q) { return int3(a.x + p * u.x + q * v.x, a.y + p * u.y + q * v.y, a.z + p * u.z + q * v.z); };
+            const int3 b       = onPlane(coefficient(rng), coefficient(rng));
+            const int3 c       = onPlane(coefficient(rng), coefficient(rng));
+            int3       d       = onPlane(coefficient(rng), coefficient(rng));
+            d.z += nudge(rng);
+
+            const int expected = Sign(Orient3DReference(a, b, c, d));
+            wrong += Sign(Orient3D(a, b, c, d)) != expected;
+            naiveWrong += Sign(Orient3DNaive(ToDouble(a), ToDouble(b), ToDouble(c), ToDouble(d))) != expected;
+        }
+        std::printf("  nearly coplanar points, wrong Orient3D signs of %d: %zu, naive double: %zu\n", count, wrong, naiveWrong);
+
+        // The lattice points of the circle of radius 8125 = 5^4 * 13, d on it or one unit off
+        const int64_t     radius = 8125;
+        std::vector<int2> circle;
+        for (int64_t x = -radius; x <= radius; ++x)
+        {
+            const int64_t y = static_cast<int64_t>(std::llround(std::sqrt(static_cast<double>(radius * radius - x * x))));
+            if (x * x + y * y == radius * radius)
+            {
+                circle.push_back(int2(static_cast<int32_t>(x), static_cast<int32_t>(y)));
+                if (y != 0)
+                    circle.push_back(int2(static_cast<int32_t>(x), static_cast<int32_t>(-y)));
+            }
+        }
+        std::uniform_int_distribution<size_t> pick(0, circle.size() - 1);
+        wrong = naiveWrong = 0;
+        for (int k = 0; k < count; ++k)
+        {
+            const int2 o(offset(rng), offset(rng));
+            int2       p[4];
+            for (int2& point : p)
+            {
+                const int2 onCircle = circle[pick(rng)];
+                point               = int2(o.x + onCircle.x, o.y + onCircle.y);
+            }
+            p[3].x += nudge(rng);
+
+            const int expected = Sign(InCircleReference(p[0], p[1], p[2], p[3]));
+            wrong += Sign(InCircle(p[0], p[1], p[2], p[3])) != expected;
+            naiveWrong += Sign(InCircleNaive(ToDouble(p[0]), ToDouble(p[1]), ToDouble(p[2]), ToDouble(p[3]))) != expected;
+        }
+        std::printf("  nearly cocircular points, wrong InCircle signs of %d: %zu, naive double: %zu\n", count, wrong, naiveWrong);
+    }
+
+    void RunPredicates()
+    {
+        CheckKettnerGrid();
+        CheckDegenerate();
+
+        // A random triangle soup: the filters decide everything but the triangles with a
+        // repeated vertex. Their determinant is 0, which the naive code only gets when the
+        // compiler does not contract it into an FMA.
+        const size_t                           vertexCount = 1 << 16, triangleCount = 1 << 20;
+        std::mt19937                           rng(9);
+        std::uniform_real_distribution<double> coord(-100.0, 100.0);
+        std::uniform_int_distribution<uint32_t> vertex(0, vertexCount - 1);
+
+        std::vector<double2> vertices2(vertexCount);
+        std::vector<double3> vertices3(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            vertices2[i] = double2(coord(rng), coord(rng));
+            vertices3[i] = double3(coord(rng), coord(rng), coord(rng));
+        }
+        std::vector<uint32_t> indices(3 * triangleCount);
+        for (uint32_t& index : indices)
+            index = vertex(rng);
+
+        std::vector<int8_t> signs(triangleCount), naiveSigns(triangleCount);
+        size_t              exacts = 0;
+        auto                differences = [&] {
+            size_t n = 0;
+            for (size_t t = 0; t < triangleCount; ++t)
+                n += signs[t] != naiveSigns[t];
+            return n;
+        };
+
+        const double2 point2(1.0, 2.0);
+        const double3 point3(1.0, 2.0, 3.0);
+
+        auto reference = bench::Measure("orient2d naive double", triangleCount, 0, [&] {
+            for (size_t t = 0; t < triangleCount; ++t)
+                naiveSigns[t] = static_cast<int8_t>(Sign(Orient2DNaive(vertices2[indices[3 * t]], vertices2[indices[3 * t + 1]], vertices2[indices[3 * t + 2]])));
+            bench::DoNotOptimize(naiveSigns.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("TriangleOrientations", triangleCount, 0, [&] {
+            exacts = TriangleOrientations<double>(vertices2, indices, signs);
+            bench::DoNotOptimize(signs.data());
+        }));
+        std::printf("  exact evaluations: %zu, sign differences vs naive: %zu\n", exacts, differences());
+
+        reference = bench::Measure("orient3d naive double", triangleCount, 0, [&] {
+            for (size_t t = 0; t < triangleCount; ++t)
+                naiveSigns[t] = static_cast<int8_t>(Sign(Orient3DNaive(vertices3[indices[3 * t]], vertices3[indices[3 * t + 1]], vertices3[indices[3 * t + 2]], point3)));
+            bench::DoNotOptimize(naiveSigns.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("SideOfTriangles", triangleCount, 0, [&] {
+            exacts = SideOfTriangles<double>(vertices3, indices, point3, signs);
+            bench::DoNotOptimize(signs.data());
+        }));
+        std::printf("  exact evaluations: %zu, sign differences vs naive: %zu\n", exacts, differences());
+
+        reference = bench::Measure("incircle naive double", triangleCount, 0, [&] {
+            for (size_t t = 0; t < triangleCount; ++t)
+                naiveSigns[t] = static_cast<int8_t>(Sign(InCircleNaive(vertices2[indices[3 * t]], vertices2[indices[3 * t + 1]], vertices2[indices[3 * t + 2]], point2)));
+            bench::DoNotOptimize(naiveSigns.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("InCircumcircles", triangleCount, 0, [&] {
+            exacts = InCircumcircles<double>(vertices2, indices, point2, signs);
+            bench::DoNotOptimize(signs.data());
+        }));
+        std::printf("  exact evaluations: %zu, sign differences vs naive: %zu\n", exacts, differences());
+
+        // Every triangle degenerate: the cost of the exact path
+        std::vector<double2> line(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const double t = coord(rng);
+            line[i]        = double2(0.1 + t * 0.3, 0.7 + t * 0.9);
+        }
+        bench::Measure("TriangleOrientations, nearly collinear", triangleCount, 0, [&] {
+            exacts = TriangleOrientations<double>(line, indices, signs);
+            bench::DoNotOptimize(signs.data());
+        });
+        std::printf("  exact evaluations: %zu\n", exacts);
+    }
+
+    bench::Registrar predicatesSuite("Predicates", RunPredicates);
+} // namespace
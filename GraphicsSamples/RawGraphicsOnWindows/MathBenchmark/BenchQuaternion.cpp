@@ -0,0 +1,122 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/QuaternionBatch.h"
+
+using namespace math;
+
+namespace
+{
+    // Rotation angle between two unit quaternions, in double precision.
+    // Computed from the chord |a - b| rather than acos(dot), which cannot resolve angles
+    // below ~5e-4 rad from float inputs.
+    double AngleBetween(const Quaternion& a, const Quaternion& b)
+    {
+        const double d    = double(a.q.x) * b.q.x + double(a.q.y) * b.q.y + double(a.q.z) * b.q.z + double(a.q.w) * b.q.w;
+        const double sign = d < 0 ? -1.0 : 1.0;
+        const double dx   = a.q.x - sign * b.q.x;
+        const double dy   = a.q.y - sign * b.q.y;
+        const double dz   = a.q.z - sign * b.q.z;
+        const double dw   = a.q.w - sign * b.q.w;
+        return 4.0 * std::asin(std::min(1.0, 0.5 * std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw)));
+    }
+
+    // Double precision slerp, the ground truth for the error columns
+    Quaternion SlerpExact(const Quaternion& a, const Quaternion& b, float t)
+    {
+        double q0[4] = {a.q.x, a.q.y, a.q.z, a.q.w};
+        double q1[4] = {b.q.x, b.q.y, b.q.z, b.q.w};
+        double d     = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+        if (d < 0)
+        {
+            for (auto& c : q1)
+                c = -c;
+            d = -d;
+        }
+        const double theta0 = std::acos(std::min(d, 1.0));
+        const double s      = std::sin(theta0);
+        const double s0     = s > 1e-12 ? std::sin((1.0 - t) * theta0) / s : 1.0 - t;
+        const double s1     = s > 1e-12 ? std::sin(t * theta0) / s : t;
+        return Quaternion(float(q0[0] * s0 + q1[0] * s1), float(q0[1] * s0 + q1[1] * s1),
+                          float(q0[2] * s0 + q1[2] * s1), float(q0[3] * s0 + q1[3] * s1));
+    }
+
+    Quaternion Nlerp(const Quaternion& a, Quaternion b, float t)
+    {
+        if (dot(a.q, b.q) < 0)
+            b.q = -b.q;
+        return normalize(Quaternion{lerp(a.q, b.q, t)});
+    }
+
+    Quaternion RandomRotation(std::mt19937& rng)
+    {
+        std::normal_distribution<float> dist;
+        return normalize(Quaternion(dist(rng), dist(rng), dist(rng), dist(rng)));
+    }
+
+    void RunSlerp()
+    {
+        // One sampling pass: 300 characters x 100 bones, each bone between its two keyframes
+        const size_t bones = 300 * 100;
+
+        std::mt19937                          rng(4);
+        std::uniform_real_distribution<float> param(0.f, 1.f);
+
+        std::vector<Quaternion> from(bones), to(bones), out(bones);
+        std::vector<float>      t(bones);
+        for (size_t i = 0; i < bones; ++i)
+        {
+            from[i] = RandomRotation(rng);
+            to[i]   = RandomRotation(rng);
+            t[i]    = param(rng);
+        }
+
+        std::vector<Quaternion> slerpBatch(bones), nlerpBatch(bones);
+        SlerpQuaternions(from, to, t, slerpBatch);
+        NlerpQuaternions(from, to, t, nlerpBatch);
+
+        double errSlerp = 0, errBatch = 0, errNlerp = 0, errNlerpCorrected = 0;
+        for (size_t i = 0; i < bones; ++i)
+        {
+            const auto exact  = SlerpExact(from[i], to[i], t[i]);
+            errSlerp          = std::max(errSlerp, AngleBetween(exact, slerp(from[i], to[i], t[i])));
+            errBatch          = std::max(errBatch, AngleBetween(exact, slerpBatch[i]));
+            errNlerp          = std::max(errNlerp, AngleBetween(exact, Nlerp(from[i], to[i], t[i])));
+            errNlerpCorrected = std::max(errNlerpCorrected, AngleBetween(exact, nlerpBatch[i]));
+        }
+        std::printf("  max angular error vs double slerp (rad): math::slerp %g, SlerpQuaternions %g, nlerp %g, NlerpQuaternions %g\n",
+                    errSlerp, errBatch, errNlerp, errNlerpCorrected);
+        std::printf("  items = bones\n");
+
+        const double bytes = static_cast<double>(bones * (3 * sizeof(Quaternion) + sizeof(float)));
+
+        auto baseline = bench::Measure("math::slerp per bone", bones, bytes, [&] {
+            for (size_t i = 0; i < bones; ++i)
+                out[i] = slerp(from[i], to[i], t[i]);
+            bench::DoNotOptimize(out.data());
+        });
+
+        auto batch = bench::Measure("SlerpQuaternions", bones, bytes, [&] {
+            SlerpQuaternions(from, to, t, out);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, batch);
+
+        auto batchUnit = bench::Measure("SlerpQuaternions (doNotNormalize)", bones, bytes, [&] {
+            SlerpQuaternions(from, to, t, out, true);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, batchUnit);
+
+        auto nlerp = bench::Measure("NlerpQuaternions", bones, bytes, [&] {
+            NlerpQuaternions(from, to, t, out);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, nlerp);
+    }
+
+    bench::Registrar slerpSuite("Quaternion slerp", RunSlerp);
+} // namespace
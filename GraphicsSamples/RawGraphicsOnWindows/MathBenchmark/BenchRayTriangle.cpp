@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Bvh.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/RayTriangle.h"
+
+using namespace math;
+
+namespace
+{
+    struct Mesh
+    {
+        std::vector<float3>   positions;
+        std::vector<uint32_t> indices;
+    };
+
+    // A bumpy torus, triangles shuffled
+    Mesh MakeTorus(uint32_t rings, uint32_t sides)
+    {
+        const float pi = 3.14159265f;
+
+        Mesh mesh;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const float u = 2.f * pi * static_cast<float>(i) / static_cast<float>(rings);
+                const float v = 2.f * pi * static_cast<float>(j) / static_cast<float>(sides);
+                const float r = 1.f + 0.1f * std::sin(7.f * u) * std::sin(5.f * v);
+                mesh.positions.emplace_back((3.f + r * std::cos(v)) * std::cos(u), (3.f + r * std::cos(v)) * std::sin(u), r * std::sin(v));
+            }
+        }
+
+        std::vector<uint3> triangles;
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const uint32_t a = i * sides + j;
+                const uint32_t b = ((i + 1) % rings) * sides + j;
+                const uint32_t c = ((i + 1) % rings) * sides + (j + 1) % sides;
+                const uint32_t d = i * sides + (j + 1) % sides;
+                triangles.emplace_back(a, b, c);
+                triangles.emplace_back(a, c, d);
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(10));
+        for (const uint3& t : triangles)
+            mesh.indices.insert(mesh.indices.end(), {t.x, t.y, t.z});
+        return mesh;
+    }
+
+    // A bumpy height field of cells x cells quads over [-size, size]^2
+    Mesh MakeTerrain(uint32_t cells, float size)
+    {
+        std::mt19937                          rng(12);
+        std::uniform_real_distribution<float> height(-size / static_cast<float>(cells), size / static_cast<float>(cells));
+
+        Mesh mesh;
+        for (uint32_t y = 0; y <= cells; ++y)
+            for (uint32_t x = 0; x <= cells; ++x)
+                mesh.positions.emplace_back(size * (2.f * static_cast<float>(x) / static_cast<float>(cells) - 1.f),
+                                            size * (2.f * static_cast<float>(y) / static_cast<float>(cells) - 1.f), height(rng));
+        for (uint32_t y = 0; y < cells; ++y)
+        {
+            for (uint32_t x = 0; x < cells; ++x)
+            {
+                const uint32_t a = y * (cells + 1) + x, b = a + 1, c = a + cells + 2, d = a + cells + 1;
+                mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+            }
+        }
+        return mesh;
+    }
+
+    // The scalar test of the Bvh leaves over every triangle
+    struct BruteForce
+    {
+        std::vector<detail::BvhTriangle> triangles;
+
+        explicit BruteForce(const Mesh& mesh)
+        {
+            for (size_t i = 0; i < mesh.indices.size(); i += 3)
+            {
+                const float3& a = mesh.positions[mesh.indices[i + 0]];
+                const float3& b = mesh.positions[mesh.indices[i + 1]];
+                const float3& c = mesh.positions[mesh.indices[i + 2]];
+                triangles.push_back({a, b, c});
+            }
+        }
+
+        bool Intersect(const Ray& ray, RayHit& hit) const
+        {
+            const detail::WatertightRay watertight(ray);
+            bool                        found = false;
+            float                       tMax  = ray.tMax;
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                const detail::BvhTriangle& tri = triangles[i];
+                float                      t, u, v;
+                if (detail::IntersectTriangle(watertight, tri.v0, tri.v1, tri.v2, ray.tMin, tMax, t, u, v))
+                {
+                    tMax  = t;
+                    hit   = {t, u, v, static_cast<uint32_t>(i)};
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        bool Occluded(const Ray& ray) const
+        {
+            const detail::WatertightRay watertight(ray);
+            for (const auto& tri : triangles)
+            {
+                float t, u, v;
+                if (detail::IntersectTriangle(watertight, tri.v0, tri.v1, tri.v2, ray.tMin, ray.tMax, t, u, v))
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    // Double sided Moller-Trumbore with u and v computed per triangle, which leaves cracks along
+    // shared edges: what the watertight test replaced
+    bool IntersectMollerTrumbore(const Ray& ray, const float3& a, const float3& b, const float3& c)
+    {
+        const float3 e1 = b - a, e2 = c - a;
+        const float3 p   = cross(ray.direction, e2);
+        const float  det = dot(e1, p);
+        if (det == 0.f)
+            return false;
+        const float  inv = 1.f / det;
+        const float3 s   = ray.origin - a;
+        const float  u   = dot(s, p) * inv;
+        const float3 q   = cross(s, e1);
+        const float  v   = dot(ray.direction, q) * inv;
+        const float  t   = dot(e2, q) * inv;
+        return u >= 0.f && v >= 0.f && u + v <= 1.f && t >= ray.tMin && t <= ray.tMax;
+    }
+
+    // Rays from random points of a sphere at random points in the torus' bounds
+    std::vector<Ray> MakeRays(size_t count, uint32_t seed)
+    {
+        std::mt19937                          rng(seed);
+        std::normal_distribution<float>       normal;
+        std::uniform_real_distribution<float> target(-4.5f, 4.5f);
+
+        std::vector<Ray> rays(count);
+        for (auto& ray : rays)
+        {
+            const float3 origin = normalize(float3(normal(rng), normal(rng), normal(rng))) * 10.f;
+            const float3 aim(target(rng), target(rng), target(rng) * 0.3f);
+            ray                 = Ray(origin, normalize(aim - origin));
+        }
+        return rays;
+    }
+
+    // A small pinhole camera: width x height rays from one point
+    std::vector<Ray> MakeCameraRays(uint32_t width, uint32_t height)
+    {
+        const float3 eye(0.f, -9.f, 4.f);
+        const float3 forward = normalize(-eye), right = normalize(cross(forward, float3(0.f, 0.f, 1.f))), up = cross(right, forward);
+
+        std::vector<Ray> rays;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const float sx = (static_cast<float>(x) + 0.5f) / static_cast<float>(width) * 2.f - 1.f;
+                const float sy = (static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2.f - 1.f;
+                rays.emplace_back(eye, normalize(forward + right * (0.6f * sx) + up * (0.6f * sy)));
+            }
+        }
+        return rays;
+    }
+
+    // Oblique rays through every inner vertex and edge midpoint of the terrain: each of them
+    // lies on the border of two to six triangles and must hit one of them. The rays stay within
+    // 30 degrees of the vertical and the terrain slopes stay below 55 degrees, so no ray passes
+    // a fold of the terrain edge-on, where rounding the point may move the ray off the surface.
+    std::vector<Ray> MakeEdgeRays(const Mesh& terrain, float size)
+    {
+        std::mt19937                          rng(13);
+        std::uniform_real_distribution<float> offset(-0.4f, 0.4f);
+
+        std::vector<Ray> rays;
+        auto             through = [&](const float3& p) {
+            if (std::max(std::abs(p.x), std::abs(p.y)) >= size)
+                return;
+            const float3 origin = p + float3(offset(rng), offset(rng), 1.f) * (size * 0.1f);
+            rays.emplace_back(origin, normalize(p - origin));
+        };
+        for (const float3& p : terrain.positions)
+            through(p);
+        for (size_t i = 0; i < terrain.indices.size(); i += 3)
+            for (int e = 0; e < 3; ++e)
+                through((terrain.positions[terrain.indices[i + e]] + terrain.positions[terrain.indices[i + (e + 1) % 3]]) * 0.5f);
+        return rays;
+    }
+
+    void RunRayTriangle()
+    {
+        const Mesh        mesh = MakeTorus(64, 40);
+        const BruteForce  brute(mesh);
+        const TriangleSoA soa(mesh.positions, mesh.indices);
+        std::printf("  %zu triangles, simd::kWidth %zu\n", soa.size(), simd::kWidth);
+
+        const std::vector<Ray> rays = MakeRays(97, 11);
+        std::vector<Ray>       shadowRays = rays;
+        for (auto& ray : shadowRays)
+            ray.tMax = 7.f;
+        const std::vector<Ray> cameraRays = MakeCameraRays(16, 16);
+
+        // Same nearest t as the scalar test, give or take rounding, and the same rays hit. A ray
+        // through an edge may pick either triangle, so only t is compared.
+        size_t errors = 0, hits = 0;
+        float  maxDifference = 0.f;
+        auto   compare       = [&](bool expectedHit, const RayHit& expected, bool found, const RayHit& hit) {
+            errors += expectedHit != found;
+            if (expectedHit && found)
+                maxDifference = std::max(maxDifference, std::abs(expected.t - hit.t) / expected.t);
+            hits += found;
+        };
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            RayHit expected, hit;
+            compare(brute.Intersect(rays[i], expected), expected, IntersectNearest(rays[i], soa, hit), hit);
+            errors += brute.Occluded(shadowRays[i]) != Occluded(shadowRays[i], soa);
+        }
+        std::vector<RayHit> packetHits(cameraRays.size());
+        IntersectNearest(span<const Ray>(cameraRays), soa, span<RayHit>(packetHits));
+        for (size_t i = 0; i < cameraRays.size(); ++i)
+        {
+            RayHit expected;
+            compare(brute.Intersect(cameraRays[i], expected), expected, packetHits[i].triangle != UINT32_MAX, packetHits[i]);
+        }
+        std::printf("  %zu rays, %zu hit, errors vs scalar: %zu, max relative t difference %g\n", rays.size() + cameraRays.size(), hits, errors,
+                    maxDifference);
+
+        // Rays through shared edges and vertices, far enough from the origin for rounding to show
+        for (float size : {1.f, 100.f, 1000.f})
+        {
+            const Mesh             terrain = MakeTerrain(64, size);
+            const BruteForce       terrainBrute(terrain);
+            const TriangleSoA      terrainSoA(terrain.positions, terrain.indices);
+            const std::vector<Ray> edgeRays = MakeEdgeRays(terrain, size);
+
+            std::vector<RayHit> packetEdgeHits(edgeRays.size());
+            IntersectNearest(span<const Ray>(edgeRays), terrainSoA, span<RayHit>(packetEdgeHits));
+
+            size_t mollerMisses = 0, scalarMisses = 0, soaMisses = 0, packetMisses = 0;
+            for (size_t r = 0; r < edgeRays.size(); ++r)
+            {
+                const Ray& ray = edgeRays[r];
+                bool       moller = false;
+                for (const auto& tri : terrainBrute.triangles)
+                    moller = moller || IntersectMollerTrumbore(ray, tri.v0, tri.v1, tri.v2);
+                RayHit hit;
+                mollerMisses += !moller;
+                scalarMisses += !terrainBrute.Intersect(ray, hit);
+                soaMisses += !IntersectNearest(ray, terrainSoA, hit);
+                packetMisses += packetEdgeHits[r].triangle == UINT32_MAX;
+            }
+            std::printf("  %zu rays through edges of a terrain %g units wide missed: Moller-Trumbore %zu, watertight scalar %zu, "
+                        "ray vs kWidth triangles %zu, kWidth rays vs triangle %zu\n",
+                        edgeRays.size(), 2.f * size, mollerMisses, scalarMisses, soaMisses, packetMisses);
+        }
+
+        std::printf("  items = rays\n");
+        RayHit hit;
+        auto   nearestReference = bench::Measure("closest hit, scalar", rays.size(), 0, [&] {
+            for (const Ray& ray : rays)
+                bench::DoNotOptimize(brute.Intersect(ray, hit));
+        });
+        bench::PrintSpeedup(nearestReference, bench::Measure("IntersectNearest, ray vs kWidth triangles", rays.size(), 0, [&] {
+            for (const Ray& ray : rays)
+                bench::DoNotOptimize(IntersectNearest(ray, soa, hit));
+        }));
+
+        auto shadowReference = bench::Measure("any hit, scalar", shadowRays.size(), 0, [&] {
+            for (const Ray& ray : shadowRays)
+                bench::DoNotOptimize(brute.Occluded(ray));
+        });
+        bench::PrintSpeedup(shadowReference, bench::Measure("Occluded, ray vs kWidth triangles", shadowRays.size(), 0, [&] {
+            for (const Ray& ray : shadowRays)
+                bench::DoNotOptimize(Occluded(ray, soa));
+        }));
+
+        auto cameraReference = bench::Measure("16x16 camera rays, scalar", cameraRays.size(), 0, [&] {
+            for (const Ray& ray : cameraRays)
+                bench::DoNotOptimize(brute.Intersect(ray, hit));
+        });
+        bench::PrintSpeedup(cameraReference, bench::Measure("16x16 camera rays, ray vs kWidth triangles", cameraRays.size(), 0, [&] {
+            for (const Ray& ray : cameraRays)
+                bench::DoNotOptimize(IntersectNearest(ray, soa, hit));
+        }));
+        bench::PrintSpeedup(cameraReference, bench::Measure("16x16 camera rays, kWidth rays vs triangle", cameraRays.size(), 0, [&] {
+            IntersectNearest(span<const Ray>(cameraRays), soa, span<RayHit>(packetHits));
+            bench::DoNotOptimize(packetHits.data());
+        }));
+    }
+
+    bench::Registrar rayTriangleSuite("RayTriangle", RunRayTriangle);
+} // namespace
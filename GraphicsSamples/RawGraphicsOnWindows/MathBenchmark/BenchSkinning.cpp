@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/Skinning.h"
+
+using namespace math;
+
+namespace
+{
+    struct SoA3
+    {
+        std::vector<float> x, y, z;
+
+        explicit SoA3(size_t count) :
+            x(count), y(count), z(count) {}
+
+        Float3Stream      Stream() { return Float3Stream(x, y, z); }
+        ConstFloat3Stream ConstStream() const { return ConstFloat3Stream(x, y, z); }
+    };
+
+    float MaxDifference(const SoA3& a, const SoA3& b)
+    {
+        float result = 0.f;
+        for (size_t i = 0; i < a.x.size(); ++i)
+            result = std::max({result, std::abs(a.x[i] - b.x[i]), std::abs(a.y[i] - b.y[i]), std::abs(a.z[i] - b.z[i])});
+        return result;
+    }
+
+    // The skinning the tools did so far: a float4x4 per vertex, blended element by element
+    void SkinNaive(span<const float4x4> palette, const SoA3& positions, const SoA3& normals, const SkinInfluenceStream& influences,
+                   SoA3& outPositions, SoA3& outNormals)
+    {
+        for (size_t i = 0; i < positions.x.size(); ++i)
+        {
+            float4x4 m;
+            for (int e = 0; e < 16; ++e)
+                m.m[e / 4][e % 4] = 0.f;
+            for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+            {
+                const float     w    = influences.weights[k][i];
+                const float4x4& bone = palette[influences.bones[k][i]];
+                for (int e = 0; e < 16; ++e)
+                    m.m[e / 4][e % 4] += w * bone.m[e / 4][e % 4];
+            }
+
+            const float4 p = float4(positions.x[i], positions.y[i], positions.z[i], 1.f) * m;
+            const float4 n = float4(normals.x[i], normals.y[i], normals.z[i], 0.f) * m;
+            const float3 unit = normalize(float3(n.x, n.y, n.z));
+            outPositions.x[i] = p.x;
+            outPositions.y[i] = p.y;
+            outPositions.z[i] = p.z;
+            outNormals.x[i]   = unit.x;
+            outNormals.y[i]   = unit.y;
+            outNormals.z[i]   = unit.z;
+        }
+    }
+
+    void RunSkinning()
+    {
+        // A count that leaves a tail in the last chunk and the last SIMD iteration
+        const size_t                          count     = (1 << 18) + 3;
+        const size_t                          boneCount = 64;
+        std::mt19937                          rng(5);
+        std::uniform_real_distribution<float> coord(-1.f, 1.f);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        std::uniform_int_distribution<uint32_t> bone(0, boneCount - 1);
+
+        std::vector<float4x4>       matrices(boneCount);
+        std::vector<float3x4>       linearPalette(boneCount);
+        std::vector<DualQuaternion> dualPalette(boneCount);
+        for (size_t b = 0; b < boneCount; ++b)
+        {
+            const Quaternion rotation = normalize(Quaternion(coord(rng), coord(rng), coord(rng), coord(rng)));
+            const float3     translation(coord(rng) * 5.f, coord(rng) * 5.f, coord(rng) * 5.f);
+            matrices[b]               = rotation.ToMatrix();
+            matrices[b].m[3][0]       = translation.x;
+            matrices[b].m[3][1]       = translation.y;
+            matrices[b].m[3][2]       = translation.z;
+            linearPalette[b]          = float3x4::FromMatrix(matrices[b]);
+            dualPalette[b]            = DualQuaternion(rotation, translation);
+        }
+
+        SoA3 positions(count), normals(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float3 n = normalize(float3(coord(rng), coord(rng), coord(rng)));
+            positions.x[i] = coord(rng) * 2.f;
+            positions.y[i] = coord(rng) * 2.f;
+            positions.z[i] = coord(rng) * 2.f;
+            normals.x[i]   = n.x;
+            normals.y[i]   = n.y;
+            normals.z[i]   = n.z;
+        }
+
+        // One to four influences per vertex, every fourth vertex rigid
+        std::vector<uint32_t> bones[kMaxBoneInfluences];
+        std::vector<float>    weights[kMaxBoneInfluences];
+        SkinInfluenceStream   influences;
+        for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+        {
+            bones[k].resize(count);
+            weights[k].resize(count);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t used = i % 4 == 0 ? 1 : 1 + i % kMaxBoneInfluences;
+            float        sum  = 0.f;
+            for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+            {
+                bones[k][i]   = bone(rng);
+                weights[k][i] = k < used ? 0.05f + unit(rng) : 0.f;
+                sum += weights[k][i];
+            }
+            for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+                weights[k][i] /= sum;
+        }
+        for (size_t k = 0; k < kMaxBoneInfluences; ++k)
+        {
+            influences.bones[k]   = bones[k];
+            influences.weights[k] = weights[k];
+        }
+
+        SoA3 naivePositions(count), naiveNormals(count);
+        SoA3 linearPositions(count), linearNormals(count);
+        SoA3 dualPositions(count), dualNormals(count);
+        SoA3 scalarPositions(count), scalarNormals(count);
+
+        // Linear blending against the float4x4 version, the scalar tail code against the SIMD loop
+        SkinNaive(matrices, positions, normals, influences, naivePositions, naiveNormals);
+        SkinLinear(linearPalette, positions.ConstStream(), normals.ConstStream(), influences, linearPositions.Stream(),
+                   linearNormals.Stream());
+        std::printf("  SkinLinear vs float4x4 blend: max position difference %g, max normal difference %g\n",
+                    MaxDifference(linearPositions, naivePositions), MaxDifference(linearNormals, naiveNormals));
+
+        SkinDualQuaternion(dualPalette, positions.ConstStream(), normals.ConstStream(), influences, dualPositions.Stream(),
+                           dualNormals.Stream());
+        detail::SkinScalar<DualQuaternion>(dualPalette, positions.ConstStream(), normals.ConstStream(), influences,
+                                           scalarPositions.Stream(), scalarNormals.Stream(), 0, count);
+        std::printf("  SkinDualQuaternion vs scalar: max position difference %g, max normal difference %g\n",
+                    MaxDifference(dualPositions, scalarPositions), MaxDifference(dualNormals, scalarNormals));
+
+        // Both methods agree on rigidly bound vertices
+        float rigidDifference = 0.f;
+        for (size_t i = 0; i < count; i += 4)
+            rigidDifference = std::max({rigidDifference, std::abs(dualPositions.x[i] - linearPositions.x[i]),
+                                        std::abs(dualPositions.y[i] - linearPositions.y[i]), std::abs(dualPositions.z[i] - linearPositions.z[i])});
+        std::printf("  rigid vertices, dual quaternion vs linear: max difference %g\n", rigidDifference);
+
+        // Positions and normals in and out, the influences in
+        const double   bytes   = count * (4.0 * sizeof(float3) + kMaxBoneInfluences * (sizeof(uint32_t) + sizeof(float)));
+        ThreadPool serial(1);
+        std::printf("  %u threads in the default pool\n", ThreadPool::Default().size());
+
+        auto reference = bench::Measure("float4x4 blend per vertex", count, bytes, [&] {
+            SkinNaive(matrices, positions, normals, influences, naivePositions, naiveNormals);
+            bench::DoNotOptimize(naivePositions.x.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("SkinLinear, 1 thread", count, bytes, [&] {
+            SkinLinear(serial, linearPalette, positions.ConstStream(), normals.ConstStream(), influences, linearPositions.Stream(),
+                       linearNormals.Stream());
+            bench::DoNotOptimize(linearPositions.x.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("SkinLinear, all threads", count, bytes, [&] {
+            SkinLinear(linearPalette, positions.ConstStream(), normals.ConstStream(), influences, linearPositions.Stream(),
+                       linearNormals.Stream());
+            bench::DoNotOptimize(linearPositions.x.data());
+        }));
+
+        reference = bench::Measure("dual quaternion scalar", count, bytes, [&] {
+            detail::SkinScalar<DualQuaternion>(dualPalette, positions.ConstStream(), normals.ConstStream(), influences,
+                                               scalarPositions.Stream(), scalarNormals.Stream(), 0, count);
+            bench::DoNotOptimize(scalarPositions.x.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("SkinDualQuaternion, 1 thread", count, bytes, [&] {
+            SkinDualQuaternion(serial, dualPalette, positions.ConstStream(), normals.ConstStream(), influences, dualPositions.Stream(),
+                               dualNormals.Stream());
+            bench::DoNotOptimize(dualPositions.x.data());
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("SkinDualQuaternion, all threads", count, bytes, [&] {
+            SkinDualQuaternion(dualPalette, positions.ConstStream(), normals.ConstStream(), influences, dualPositions.Stream(),
+                               dualNormals.Stream());
+            bench::DoNotOptimize(dualPositions.x.data());
+        }));
+    }
+
+    bench::Registrar skinningSuite("Skinning", RunSkinning);
+} // namespace
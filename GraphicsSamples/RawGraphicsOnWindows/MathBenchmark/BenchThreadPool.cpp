@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/ThreadPool.h"
+
+using namespace math;
+
+namespace
+{
+    AABB<float> Bounds(span<const float3> points)
+    {
+        AABB<float> box;
+        for (const float3& p : points)
+        {
+            box.min = float3(std::min(box.min.x, p.x), std::min(box.min.y, p.y), std::min(box.min.z, p.z));
+            box.max = float3(std::max(box.max.x, p.x), std::max(box.max.y, p.y), std::max(box.max.z, p.z));
+        }
+        return box;
+    }
+
+    AABB<float> Union(const AABB<float>& a, const AABB<float>& b)
+    {
+        return AABB<float>(float3(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)),
+                           float3(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)));
+    }
+
+    void RunThreadPool()
+    {
+        const size_t                          count = 1 << 18;
+        std::mt19937                          rng(13);
+        std::uniform_real_distribution<float> coord(-1.f, 1.f);
+
+        std::vector<float4x4> a(count), b(count), product(count), expected(count);
+        for (size_t i = 0; i < count; ++i)
+            for (int e = 0; e < 16; ++e)
+            {
+                a[i].m[e / 4][e % 4] = coord(rng);
+                b[i].m[e / 4][e % 4] = coord(rng);
+            }
+        std::vector<float3> points(count), transformed(count), expectedPoints(count);
+        for (float3& p : points)
+            p = float3(coord(rng), coord(rng), coord(rng)) * 10.f;
+        const float4x4 transform = float4x4::RotationArbitrary(float3(1.f, 2.f, 3.f), 0.7f) * float4x4::Translation(1.f, -2.f, 3.f);
+
+        auto multiplySerial = [&] {
+            for (size_t i = 0; i < count; ++i)
+                expected[i] = a[i] * b[i];
+        };
+        auto transformSerial = [&] {
+            for (size_t i = 0; i < count; ++i)
+                expectedPoints[i] = points[i] * transform;
+        };
+        multiplySerial();
+        transformSerial();
+        const AABB<float> expectedBounds = Bounds(points);
+
+        // Every thread count up to the hardware threads, each against the plain loop
+        const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::printf("  %u hardware threads\n", hardwareThreads);
+        auto multiplyReference  = bench::Measure("Matrix4x4 Mul, serial", count, 3 * count * sizeof(float4x4), multiplySerial);
+        auto transformReference = bench::Measure("float3 * float4x4, serial", count, 2 * count * sizeof(float3), transformSerial);
+        auto boundsReference    = bench::Measure("bounding box, serial", count, count * sizeof(float3), [&] {
+            AABB<float> box = Bounds(points);
+            bench::DoNotOptimize(&box);
+        });
+
+        for (unsigned threads = 1; threads <= hardwareThreads; ++threads)
+        {
+            ThreadPool pool(threads);
+            char       name[64];
+
+            std::snprintf(name, sizeof(name), "Matrix4x4 Mul, %u threads", threads);
+            bench::PrintSpeedup(multiplyReference, bench::Measure(name, count, 3 * count * sizeof(float4x4), [&] {
+                pool.ParallelFor(0, count, 0, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i)
+                        product[i] = a[i] * b[i];
+                });
+            }));
+
+            std::snprintf(name, sizeof(name), "float3 * float4x4, %u threads", threads);
+            bench::PrintSpeedup(transformReference, bench::Measure(name, count, 2 * count * sizeof(float3), [&] {
+                parallel_for(pool, span<float3>(transformed), [&](span<float3> out) {
+                    const float3* in = points.data() + (out.data() - transformed.data());
+                    for (size_t i = 0; i < out.size(); ++i)
+                        out[i] = in[i] * transform;
+                });
+            }));
+
+            AABB<float> box;
+            std::snprintf(name, sizeof(name), "bounding box, %u threads", threads);
+            bench::PrintSpeedup(boundsReference, bench::Measure(name, count, count * sizeof(float3), [&] {
+                box = parallel_reduce(pool, span<const float3>(points), AABB<float>(), Bounds, Union);
+                bench::DoNotOptimize(&box);
+            }));
+
+            const bool same = std::equal(product.begin(), product.end(), expected.begin()) &&
+                              std::equal(transformed.begin(), transformed.end(), expectedPoints.begin()) && box == expectedBounds;
+            std::printf("  %u threads: results %s the serial loops\n", threads, same ? "match" : "DIFFER FROM");
+        }
+
+        // Nested loops on more workers than a deque holds: the inner loops find the mailboxes of
+        // the workers that have not picked up their outer block yet still full, so nearly all of
+        // their blocks go to the calling worker's deque, and the ones that do not fit run at once
+        {
+            ThreadPool          wide(512);
+            std::atomic<size_t> sum{0};
+            wide.ParallelFor(0, 4 * wide.size(), 1, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i)
+                    wide.ParallelFor(0, 4 * wide.size(), 1, [&](size_t innerFirst, size_t innerLast) {
+                        sum.fetch_add(innerLast - innerFirst, std::memory_order_relaxed);
+                    });
+            });
+            const size_t expected = 16 * size_t(wide.size()) * wide.size();
+            std::printf("  nested loops on %u workers: %zu of %zu indices visited\n", wide.size(), sum.load(), expected);
+        }
+
+        // What a loop costs that is too small to be worth it
+        ThreadPool pool;
+        std::vector<float3> few(64);
+        bench::Measure("parallel_for over 64 float3, all threads", few.size(), 0, [&] {
+            parallel_for(pool, span<float3>(few), [&](span<float3> part) {
+                for (float3& p : part)
+                    p = p * transform;
+            }, 1);
+        });
+    }
+
+    bench::Registrar threadPoolSuite("ThreadPool", RunThreadPool);
+} // namespace
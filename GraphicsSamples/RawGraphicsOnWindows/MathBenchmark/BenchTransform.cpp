@@ -0,0 +1,103 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/BatchTransform.h"
+
+using namespace math;
+
+namespace
+{
+    void RunTransformPoints(size_t count)
+    {
+        std::printf(" %zu points\n", count);
+
+        std::mt19937                          rng(1);
+        std::uniform_real_distribution<float> dist(-100.f, 100.f);
+
+        std::vector<float3> points(count);
+        for (auto& p : points)
+            p = float3(dist(rng), dist(rng), dist(rng));
+
+        // SoA streams laid out the way a stream container would: one allocation,
+        // each stream padded to a whole number of cache lines so all six share
+        // their alignment
+        const size_t       stride = (count + 15) & ~size_t(15);
+        std::vector<float> streams(stride * 6);
+        const auto         stream = [&](size_t s) { return span<float>(streams.data() + s * stride, count); };
+        for (size_t i = 0; i < count; ++i)
+        {
+            stream(0)[i] = points[i].x;
+            stream(1)[i] = points[i].y;
+            stream(2)[i] = points[i].z;
+        }
+
+        const float4x4 model      = float4x4::Scale(2.f) * float4x4::RotationY(0.3f) * float4x4::Translation(1.f, 2.f, 3.f);
+        const float4x4 projection = float4x4::Projection(1.f, 16.f / 9.f, 0.1f, 1000.f, false);
+        const float4x4 mvp        = model * float4x4::Translation(0.f, 0.f, 300.f) * projection;
+
+        std::vector<float3> out(count);
+        const Float3Stream  inStream(stream(0), stream(1), stream(2));
+        const Float3Stream  outStream(stream(3), stream(4), stream(5));
+
+        // Accuracy against the one-vector-at-a-time operator
+        TransformPoints(mvp, points, out, true);
+        TransformPoints(mvp, inStream, outStream, true);
+        float maxRelError = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float3 ref = points[i] * mvp;
+            for (int c = 0; c < 3; ++c)
+            {
+                const float scale = std::max(1.f, std::abs(ref[c]));
+                maxRelError       = std::max(maxRelError, std::abs(ref[c] - out[i][c]) / scale);
+                maxRelError       = std::max(maxRelError, std::abs(ref[c] - outStream.Get(i)[c]) / scale);
+            }
+        }
+        std::printf("  max rel error vs float3 * float4x4: %g\n", maxRelError);
+
+        const double bytes = static_cast<double>(count * sizeof(float3) * 2);
+
+        auto baseline = bench::Measure("Vector4 * Matrix4x4 loop", count, bytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = float4(points[i], 1.f) * model;
+            bench::DoNotOptimize(out.data());
+        });
+
+        auto aos = bench::Measure("TransformPoints AoS", count, bytes, [&] {
+            TransformPoints(model, points, out);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baseline, aos);
+
+        auto soa = bench::Measure("TransformPoints SoA", count, bytes, [&] {
+            TransformPoints(model, inStream, outStream);
+            bench::DoNotOptimize(outStream.x.data());
+        });
+        bench::PrintSpeedup(baseline, soa);
+
+        auto baselineDivide = bench::Measure("float3 * float4x4 loop (divide)", count, bytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = points[i] * mvp;
+            bench::DoNotOptimize(out.data());
+        });
+
+        auto aosDivide = bench::Measure("TransformPoints AoS (divide)", count, bytes, [&] {
+            TransformPoints(mvp, points, out, true);
+            bench::DoNotOptimize(out.data());
+        });
+        bench::PrintSpeedup(baselineDivide, aosDivide);
+
+        auto soaDivide = bench::Measure("TransformPoints SoA (divide)", count, bytes, [&] {
+            TransformPoints(mvp, inStream, outStream, true);
+            bench::DoNotOptimize(outStream.x.data());
+        });
+        bench::PrintSpeedup(baselineDivide, soaDivide);
+    }
+
+    bench::Registrar transformPoints("TransformPoints", [] {
+        RunTransformPoints(4000);    // cache resident
+        RunTransformPoints(1 << 20); // memory bound
+    });
+} // namespace
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/TransformHierarchy.h"
+
+using namespace math;
+
+namespace
+{
+    struct LocalTransform
+    {
+        float3     translation;
+        Quaternion rotation;
+        float3     scale;
+    };
+
+    // What the samples do every frame: compose every node, parents first
+    void ComposeAll(span<const uint32_t> parents, span<const LocalTransform> locals, std::vector<float4x4>& world)
+    {
+        for (size_t i = 0; i < parents.size(); ++i)
+        {
+            const LocalTransform& local = locals[i];
+            const float4x4        m     = float4x4::Scale(local.scale) * local.rotation.ToMatrix() * float4x4::Translation(local.translation);
+            world[i]                    = parents[i] == TransformHierarchy::kNoParent ? m : m * world[parents[i]];
+        }
+    }
+
+    float MaxDifference(const TransformHierarchy& hierarchy, const std::vector<float4x4>& world)
+    {
+        float result = 0.f;
+        for (uint32_t i = 0; i < world.size(); ++i)
+            for (int e = 0; e < 16; ++e)
+                result = std::max(result, std::abs(hierarchy.GetWorld(i).m[e / 4][e % 4] - world[i].m[e / 4][e % 4]));
+        return result;
+    }
+
+    void RunTransformHierarchy()
+    {
+        // A scene of 16 roots with four or five children per node, 7 levels deep
+        const uint32_t                        count = 100000;
+        std::mt19937                          rng(11);
+        std::uniform_real_distribution<float> coord(-1.f, 1.f);
+        std::uniform_real_distribution<float> unit(0.8f, 1.2f);
+
+        std::vector<uint32_t> parents(count);
+        for (uint32_t i = 0; i < count; ++i)
+            parents[i] = i < 16 ? TransformHierarchy::kNoParent : (i - 16) * 2 / 9;
+
+        auto randomLocal = [&] {
+            return LocalTransform{float3(coord(rng), coord(rng), coord(rng)),
+                                  normalize(Quaternion(coord(rng), coord(rng), coord(rng), coord(rng))),
+                                  float3(unit(rng), unit(rng), unit(rng))};
+        };
+        std::vector<LocalTransform> locals(count);
+        TransformHierarchy          hierarchy(parents);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            locals[i] = randomLocal();
+            hierarchy.SetLocal(i, locals[i].translation, locals[i].rotation, locals[i].scale);
+        }
+
+        std::vector<float4x4> world(count);
+        ComposeAll(parents, locals, world);
+        const size_t updated = hierarchy.Update();
+        std::printf("  first Update: %zu nodes, max difference to ComposeAll %g\n", updated, MaxDifference(hierarchy, world));
+
+        // Move a few nodes, then check that only their subtrees changed and match
+        std::uniform_int_distribution<uint32_t> node(0, count - 1);
+        for (int i = 0; i < 100; ++i)
+        {
+            const uint32_t moved = node(rng);
+            locals[moved]        = randomLocal();
+            hierarchy.SetLocal(moved, locals[moved].translation, locals[moved].rotation, locals[moved].scale);
+        }
+        ComposeAll(parents, locals, world);
+        const size_t partial = hierarchy.Update();
+        std::printf("  100 nodes moved: %zu nodes updated, max difference to ComposeAll %g\n", partial, MaxDifference(hierarchy, world));
+
+        auto reference = bench::Measure("ComposeAll", count, 0, [&] {
+            ComposeAll(parents, locals, world);
+            bench::DoNotOptimize(world.data());
+        });
+
+        // Every node moves, e.g. a crowd of animated skeletons
+        ThreadPool serial(1);
+        bench::PrintSpeedup(reference, bench::Measure("Update, all nodes moved, 1 thread", count, 0, [&] {
+            for (uint32_t i = 0; i < count; ++i)
+                hierarchy.SetLocal(i, locals[i].translation, locals[i].rotation, locals[i].scale);
+            hierarchy.Update(serial);
+            bench::DoNotOptimize(&hierarchy);
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("Update, all nodes moved, all threads", count, 0, [&] {
+            for (uint32_t i = 0; i < count; ++i)
+                hierarchy.SetLocal(i, locals[i].translation, locals[i].rotation, locals[i].scale);
+            hierarchy.Update();
+            bench::DoNotOptimize(&hierarchy);
+        }));
+
+        // A mostly static scene: 1% of the nodes move, leaves more often than inner nodes
+        std::vector<uint32_t> moving(count / 100);
+        for (uint32_t& moved : moving)
+            moved = node(rng);
+        bench::PrintSpeedup(reference, bench::Measure("Update, 1% of the nodes moved", count, 0, [&] {
+            for (uint32_t moved : moving)
+                hierarchy.SetLocal(moved, locals[moved].translation, locals[moved].rotation, locals[moved].scale);
+            hierarchy.Update();
+            bench::DoNotOptimize(&hierarchy);
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("Update, one root moved", count, 0, [&] {
+            hierarchy.SetLocal(0, locals[0].translation, locals[0].rotation, locals[0].scale);
+            hierarchy.Update();
+            bench::DoNotOptimize(&hierarchy);
+        }));
+        bench::PrintSpeedup(reference, bench::Measure("Update, nothing moved", count, 0, [&] {
+            hierarchy.Update();
+            bench::DoNotOptimize(&hierarchy);
+        }));
+    }
+
+    bench::Registrar transformHierarchySuite("TransformHierarchy", RunTransformHierarchy);
+} // namespace
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/VectorExpr.h"
+
+using namespace math;
+
+namespace
+{
+    float MaxDifference(const float* a, const float* b, size_t count)
+    {
+        float result = 0.f;
+        for (size_t i = 0; i < count; ++i)
+            result = std::max(result, std::abs(a[i] - b[i]));
+        return result;
+    }
+
+    void RunVectorExpr()
+    {
+        const size_t                          count = 1 << 20;
+        std::mt19937                          rng(7);
+        std::uniform_real_distribution<float> coord(-10.f, 10.f);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+        std::vector<float3> points(count), rotated(count), expected(count);
+        for (float3& p : points)
+            p = float3(coord(rng), coord(rng), coord(rng));
+        const Quaternion q = normalize(Quaternion::RotationFromAxisAngle(normalize(float3(1.f, 2.f, 3.f)), 0.8f));
+
+        // v + 2 * cross(axis, cross(axis, v) + w * v)
+        const double rotateBytes = 2.0 * count * sizeof(float3);
+        auto         reference   = bench::Measure("RotateVector with Math.h operators", count, rotateBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                expected[i] = q.RotateVector(points[i]);
+            bench::DoNotOptimize(expected.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("RotateVector with expressions", count, rotateBytes, [&] {
+            const float3 axis(q.q.x, q.q.y, q.q.z);
+            const auto   a = expr::lazy(axis);
+            const auto   v = expr::lazy(points);
+            expr::assign(rotated, v + 2.f * expr::cross(a, expr::cross(a, v) + q.q.w * v));
+            bench::DoNotOptimize(rotated.data());
+        }));
+        std::printf("  max difference: %g\n", MaxDifference(&rotated[0].x, &expected[0].x, 3 * count));
+        bench::PrintSpeedup(reference, bench::Measure("RotateVector by hand", count, rotateBytes, [&] {
+            const float ax = q.q.x, ay = q.q.y, az = q.q.z, w = q.q.w;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float vx = points[i].x, vy = points[i].y, vz = points[i].z;
+                const float tx = ay * vz - az * vy + w * vx;
+                const float ty = az * vx - ax * vz + w * vy;
+                const float tz = ax * vy - ay * vx + w * vz;
+                rotated[i].x   = vx + 2.f * (ay * tz - az * ty);
+                rotated[i].y   = vy + 2.f * (az * tx - ax * tz);
+                rotated[i].z   = vz + 2.f * (ax * ty - ay * tx);
+            }
+            bench::DoNotOptimize(rotated.data());
+        }));
+
+        // Blends of two float4 streams with one weight, then with a weight per element
+        std::vector<float4> a(count), b(count), blended(count), blendedExpected(count);
+        std::vector<float>  weights(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            a[i]       = float4(coord(rng), coord(rng), coord(rng), coord(rng));
+            b[i]       = float4(coord(rng), coord(rng), coord(rng), coord(rng));
+            weights[i] = unit(rng);
+        }
+
+        const float  t         = 0.3f;
+        const double lerpBytes = 3.0 * count * sizeof(float4);
+        reference              = bench::Measure("lerp with Math.h operators", count, lerpBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                blendedExpected[i] = lerp(a[i], b[i], t);
+            bench::DoNotOptimize(blendedExpected.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("lerp with expressions", count, lerpBytes, [&] {
+            expr::assign(blended, expr::lazy(a) * (1.f - t) + expr::lazy(b) * t);
+            bench::DoNotOptimize(blended.data());
+        }));
+        std::printf("  max difference: %g\n", MaxDifference(&blended[0].x, &blendedExpected[0].x, 4 * count));
+        bench::PrintSpeedup(reference, bench::Measure("lerp by hand", count, lerpBytes, [&] {
+            const float  s   = 1.f - t;
+            const float* pa  = &a[0].x;
+            const float* pb  = &b[0].x;
+            float*       out = &blended[0].x;
+            for (size_t i = 0; i < 4 * count; ++i)
+                out[i] = pa[i] * s + pb[i] * t;
+            bench::DoNotOptimize(blended.data());
+        }));
+
+        const double weightedBytes = lerpBytes + count * sizeof(float);
+        reference                  = bench::Measure("weighted lerp with Math.h operators", count, weightedBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                blendedExpected[i] = a[i] + weights[i] * (b[i] - a[i]);
+            bench::DoNotOptimize(blendedExpected.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("weighted lerp with expressions", count, weightedBytes, [&] {
+            expr::assign(blended, expr::lazy(a) + expr::lazy(weights) * (expr::lazy(b) - expr::lazy(a)));
+            bench::DoNotOptimize(blended.data());
+        }));
+        std::printf("  max difference: %g\n", MaxDifference(&blended[0].x, &blendedExpected[0].x, 4 * count));
+        bench::PrintSpeedup(reference, bench::Measure("weighted lerp by hand", count, weightedBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float w = weights[i];
+                blended[i].x  = a[i].x + w * (b[i].x - a[i].x);
+                blended[i].y  = a[i].y + w * (b[i].y - a[i].y);
+                blended[i].z  = a[i].z + w * (b[i].z - a[i].z);
+                blended[i].w  = a[i].w + w * (b[i].w - a[i].w);
+            }
+            bench::DoNotOptimize(blended.data());
+        }));
+    }
+
+    bench::Registrar vectorExprSuite("VectorExpr", RunVectorExpr);
+} // namespace
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/VertexCodecs.h"
+
+using namespace math;
+
+namespace
+{
+    constexpr double kPi = 3.14159265358979323846;
+
+    // Every value of the range, its midpoints, values outside of it and NaN; the largest error
+    // against the clamped value must stay within half a step plus half a float ulp of 1
+    template <class T, class Encode, class Decode, class EncodeSpan, class DecodeSpan>
+    void CheckFormat(const char* name, float low, float scale, Encode encode, Decode decode, EncodeSpan encodeSpan, DecodeSpan decodeSpan)
+    {
+        std::vector<float> values;
+        for (int32_t c = static_cast<int32_t>(low * scale) - 2; c <= static_cast<int32_t>(scale) + 2; ++c)
+        {
+            values.push_back(c / scale);
+            values.push_back((c + 0.5f) / scale);
+            values.push_back(std::nextafter(c / scale, 2.f));
+        }
+        values.push_back(std::numeric_limits<float>::quiet_NaN());
+        values.push_back(std::numeric_limits<float>::infinity());
+        values.push_back(-std::numeric_limits<float>::infinity());
+
+        std::vector<T>     encoded(values.size());
+        std::vector<float> decoded(values.size());
+        encodeSpan(values, encoded);
+        decodeSpan(encoded, decoded);
+
+        size_t mismatches = 0;
+        double maxError   = 0.0;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            const T c = encode(values[i]);
+            mismatches += c != encoded[i];
+            mismatches += detail::FloatBits(decode(c)) != detail::FloatBits(decoded[i]);
+
+            const float clamped = values[i] == values[i] ? std::min(std::max(values[i], low), 1.f) : 0.f;
+            maxError            = std::max(maxError, std::abs(static_cast<double>(decoded[i]) - clamped));
+        }
+        const double bound = 0.5 / scale + std::numeric_limits<float>::epsilon() / 2;
+        std::printf("  %-8s max error %.3g (bound %.3g%s), scalar/span mismatches: %zu\n", name, maxError, bound,
+                    maxError <= bound ? "" : ", EXCEEDED", mismatches);
+    }
+
+    double AngleDegrees(const float3& a, const float3& b)
+    {
+        const double dot = static_cast<double>(a.x) * b.x + static_cast<double>(a.y) * b.y + static_cast<double>(a.z) * b.z;
+        const double la  = std::sqrt(static_cast<double>(a.x) * a.x + static_cast<double>(a.y) * a.y + static_cast<double>(a.z) * a.z);
+        const double lb  = std::sqrt(static_cast<double>(b.x) * b.x + static_cast<double>(b.y) * b.y + static_cast<double>(b.z) * b.z);
+
+        // acos loses precision near 1, the cross product does not
+        const double cx = static_cast<double>(a.y) * b.z - static_cast<double>(a.z) * b.y;
+        const double cy = static_cast<double>(a.z) * b.x - static_cast<double>(a.x) * b.z;
+        const double cz = static_cast<double>(a.x) * b.y - static_cast<double>(a.y) * b.x;
+        return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / kPi * (la > 0.0 && lb > 0.0 ? 1.0 : 0.0);
+    }
+
+    void CheckOctahedral(const std::vector<float3>& normals)
+    {
+        const size_t          count = normals.size();
+        std::vector<uint32_t> encoded(count);
+        std::vector<float3>   decoded(count);
+        EncodeOctahedral(normals, encoded);
+        DecodeOctahedral(encoded, decoded);
+
+        size_t mismatches = 0;
+        double maxAngle = 0.0, maxLengthError = 0.0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t bits = EncodeOctahedral(normals[i]);
+            const float3   n    = DecodeOctahedral(bits);
+            mismatches += bits != encoded[i];
+            mismatches += n.x != decoded[i].x || n.y != decoded[i].y || n.z != decoded[i].z;
+
+            maxAngle       = std::max(maxAngle, AngleDegrees(normals[i], decoded[i]));
+            maxLengthError = std::max(maxLengthError, std::abs(std::sqrt(static_cast<double>(dot(decoded[i], decoded[i]))) - 1.0));
+        }
+        std::printf("  octahedral max angle %.2e degrees (documented 4e-3), max |length - 1| %.1e, scalar/span mismatches: %zu\n",
+                    maxAngle, maxLengthError, mismatches);
+
+        // Special directions: the axes, the fold and the zero vector
+        const float3 special[] = {float3(1.f, 0.f, 0.f), float3(-1.f, 0.f, 0.f), float3(0.f, 1.f, 0.f), float3(0.f, -1.f, 0.f),
+                                  float3(0.f, 0.f, 1.f), float3(0.f, 0.f, -1.f), float3(1.f, 1.f, 0.f), float3(-1.f, -1.f, -0.f)};
+        double       specialAngle = 0.0;
+        for (const float3& s : special)
+            specialAngle = std::max(specialAngle, AngleDegrees(s, DecodeOctahedral(EncodeOctahedral(s))));
+        const float3 zero = DecodeOctahedral(EncodeOctahedral(float3(0.f, 0.f, 0.f)));
+        std::printf("  axes and fold max angle %.2e degrees, zero vector -> (%g, %g, %g)\n", specialAngle, zero.x, zero.y, zero.z);
+    }
+
+    // The vertex of the triangle samples, with the color as 10:10:10:2 and the same with a
+    // normal and texture coordinates
+    struct SampleVertex
+    {
+        float3 pos;
+        float3 color;
+    };
+
+    struct PackedSampleVertex
+    {
+        float3   pos;
+        uint32_t color;
+    };
+
+    struct MeshVertex
+    {
+        float3 pos;
+        float3 normal;
+        float2 uv;
+        float4 color;
+    };
+
+    struct PackedMeshVertex
+    {
+        float3            pos;
+        uint32_t          normal;
+        Vector2<uint16_t> uv;
+        uint32_t          color;
+    };
+
+    void RunVertexCodecs()
+    {
+        CheckFormat<uint8_t>(
+            "unorm8", 0.f, detail::kUnorm8Scale, [](float x) { return EncodeUnorm8(x); }, [](uint8_t c) { return DecodeUnorm8(c); },
+            [](span<const float> in, span<uint8_t> out) { EncodeUnorm8(in, out); }, [](span<const uint8_t> in, span<float> out) { DecodeUnorm8(in, out); });
+        CheckFormat<uint16_t>(
+            "unorm16", 0.f, detail::kUnorm16Scale, [](float x) { return EncodeUnorm16(x); }, [](uint16_t c) { return DecodeUnorm16(c); },
+            [](span<const float> in, span<uint16_t> out) { EncodeUnorm16(in, out); }, [](span<const uint16_t> in, span<float> out) { DecodeUnorm16(in, out); });
+        CheckFormat<int8_t>(
+            "snorm8", -1.f, detail::kSnorm8Scale, [](float x) { return EncodeSnorm8(x); }, [](int8_t c) { return DecodeSnorm8(c); },
+            [](span<const float> in, span<int8_t> out) { EncodeSnorm8(in, out); }, [](span<const int8_t> in, span<float> out) { DecodeSnorm8(in, out); });
+        CheckFormat<int16_t>(
+            "snorm16", -1.f, detail::kSnorm16Scale, [](float x) { return EncodeSnorm16(x); }, [](int16_t c) { return DecodeSnorm16(c); },
+            [](span<const float> in, span<int16_t> out) { EncodeSnorm16(in, out); }, [](span<const int16_t> in, span<float> out) { DecodeSnorm16(in, out); });
+
+        // unorm8 must round like F4Color_To_RGBA8Unorm, and snorm8 must decode -128 like -127
+        size_t rgbaMismatches = 0;
+        for (int32_t i = -300; i <= 300; ++i)
+        {
+            const float x = i / 256.f;
+            rgbaMismatches += EncodeUnorm8(x) != (F4Color_To_RGBA8Unorm(float4(x, 0.f, 0.f, 0.f)) & 0xFF);
+        }
+        std::printf("  unorm8 / RGBA8Unorm mismatches: %zu, DecodeSnorm8(-128) = %g\n", rgbaMismatches, DecodeSnorm8(-128));
+
+        const size_t                          count = 1 << 20;
+        std::mt19937                          rng(11);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        std::normal_distribution<float>       gauss;
+
+        // R10G10B10A2: every code of each channel round trips, random colors against the scalar version
+        size_t packedMismatches = 0;
+        for (uint32_t c = 0; c < 1024; ++c)
+        {
+            const uint32_t bits = c | (1023 - c) << 10 | ((c * 7) & 0x3FF) << 20 | (c & 3) << 30;
+            packedMismatches += EncodeR10G10B10A2(DecodeR10G10B10A2(bits)) != bits;
+        }
+
+        std::vector<float4> colors(count + 3), decodedColors(count + 3);
+        for (float4& c : colors)
+            c = float4(unit(rng) * 1.2f - 0.1f, unit(rng), unit(rng), unit(rng));
+        std::vector<uint32_t> packedColors(count + 3);
+        EncodeR10G10B10A2(colors, packedColors);
+        DecodeR10G10B10A2(packedColors, decodedColors);
+        double maxColorError = 0.0;
+        for (size_t i = 0; i < colors.size(); ++i)
+        {
+            packedMismatches += EncodeR10G10B10A2(colors[i]) != packedColors[i];
+            const float4 d = DecodeR10G10B10A2(packedColors[i]);
+            packedMismatches += d.x != decodedColors[i].x || d.y != decodedColors[i].y || d.z != decodedColors[i].z || d.w != decodedColors[i].w;
+            for (int k = 0; k < 3; ++k)
+                maxColorError = std::max(maxColorError, std::abs(static_cast<double>(d[k]) - std::min(std::max(colors[i][k], 0.f), 1.f)));
+        }
+        std::printf("  R10G10B10A2 max rgb error %.3g (bound %.3g), mismatches: %zu\n", maxColorError, 0.5 / 1023.0, packedMismatches);
+
+        // Uniform directions of random length, plus a count that leaves a tail
+        std::vector<float3> normals(count + 5);
+        for (float3& n : normals)
+            n = float3(gauss(rng), gauss(rng), gauss(rng)) * (0.1f + 10.f * unit(rng));
+        CheckOctahedral(normals);
+
+        // Unit normals for the timings, as a mesh would have them
+        normals.resize(count);
+        for (float3& n : normals)
+            n = normalize(n);
+        std::vector<uint32_t> octahedral(count);
+        std::vector<float3>   decodedNormals(count);
+
+        const double encodeBytes = count * (sizeof(float3) + sizeof(uint32_t));
+        auto         reference   = bench::Measure("EncodeOctahedral one by one", count, encodeBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                octahedral[i] = EncodeOctahedral(normals[i]);
+            bench::DoNotOptimize(octahedral.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("EncodeOctahedral span", count, encodeBytes, [&] {
+            EncodeOctahedral(normals, octahedral);
+            bench::DoNotOptimize(octahedral.data());
+        }));
+        reference = bench::Measure("DecodeOctahedral one by one", count, encodeBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                decodedNormals[i] = DecodeOctahedral(octahedral[i]);
+            bench::DoNotOptimize(decodedNormals.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("DecodeOctahedral span", count, encodeBytes, [&] {
+            DecodeOctahedral(octahedral, decodedNormals);
+            bench::DoNotOptimize(decodedNormals.data());
+        }));
+
+        std::vector<Vector3<int16_t>> snormNormals(count);
+        const double                  snormBytes = count * (sizeof(float3) + sizeof(Vector3<int16_t>));
+        reference                                = bench::Measure("EncodeSnorm16 float3 one by one", count, snormBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                snormNormals[i] = Vector3<int16_t>(EncodeSnorm16(normals[i].x), EncodeSnorm16(normals[i].y), EncodeSnorm16(normals[i].z));
+            bench::DoNotOptimize(snormNormals.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("EncodeSnorm16 float3 span", count, snormBytes, [&] {
+            EncodeSnorm16(span<const float3>(normals), span<Vector3<int16_t>>(snormNormals));
+            bench::DoNotOptimize(snormNormals.data());
+        }));
+
+        const double colorBytes = count * (sizeof(float4) + sizeof(uint32_t));
+        colors.resize(count);
+        packedColors.resize(count);
+        reference = bench::Measure("EncodeR10G10B10A2 one by one", count, colorBytes, [&] {
+            for (size_t i = 0; i < count; ++i)
+                packedColors[i] = EncodeR10G10B10A2(colors[i]);
+            bench::DoNotOptimize(packedColors.data());
+        });
+        bench::PrintSpeedup(reference, bench::Measure("EncodeR10G10B10A2 span", count, colorBytes, [&] {
+            EncodeR10G10B10A2(colors, packedColors);
+            bench::DoNotOptimize(packedColors.data());
+        }));
+
+        std::printf("  sample vertex %zu -> %zu bytes, mesh vertex with octahedral normal, unorm16 uv: %zu -> %zu bytes\n",
+                    sizeof(SampleVertex), sizeof(PackedSampleVertex), sizeof(MeshVertex), sizeof(PackedMeshVertex));
+    }
+
+    bench::Registrar vertexCodecsSuite("VertexCodecs", RunVertexCodecs);
+} // namespace
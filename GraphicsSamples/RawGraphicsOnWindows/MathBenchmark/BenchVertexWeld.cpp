@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/VertexWeld.h"
+
+using namespace math;
+
+namespace
+{
+    const float kPi = 3.14159265f;
+
+    // Normal and texture coordinates
+    constexpr size_t kAttributeStride = 5;
+
+    // A torus as the exporter writes it: three vertices per triangle. The grid has a row and a
+    // column of extra vertices on the texture seams, so welding must end at
+    // (rings + 1) * (sides + 1) vertices.
+    struct Soup
+    {
+        std::vector<float3>   positions;
+        std::vector<float>    attributes;
+        std::vector<uint32_t> indices;
+    };
+
+    Soup MakeTorusSoup(uint32_t rings, uint32_t sides, float positionNoise, float attributeNoise, uint32_t seed)
+    {
+        std::vector<float3> gridPositions, gridNormals;
+        std::vector<float2> gridUvs;
+        for (uint32_t i = 0; i <= rings; ++i)
+        {
+            for (uint32_t j = 0; j <= sides; ++j)
+            {
+                const float u = 2.f * kPi * static_cast<float>(i) / static_cast<float>(rings);
+                const float v = 2.f * kPi * static_cast<float>(j) / static_cast<float>(sides);
+                const float3 normal(std::cos(v) * std::cos(u), std::cos(v) * std::sin(u), std::sin(v));
+                gridPositions.push_back(float3(3.f * std::cos(u), 3.f * std::sin(u), 0.f) + normal);
+                gridNormals.push_back(normal);
+                gridUvs.emplace_back(static_cast<float>(i) / static_cast<float>(rings), static_cast<float>(j) / static_cast<float>(sides));
+            }
+        }
+
+        std::mt19937                          rng(seed);
+        std::uniform_real_distribution<float> position(-positionNoise, positionNoise);
+        std::uniform_real_distribution<float> attribute(-attributeNoise, attributeNoise);
+
+        Soup soup;
+        auto corner = [&](uint32_t g) {
+            soup.indices.push_back(static_cast<uint32_t>(soup.positions.size()));
+            soup.positions.push_back(gridPositions[g] + float3(position(rng), position(rng), position(rng)));
+            const float3& n = gridNormals[g];
+            const float2& t = gridUvs[g];
+            soup.attributes.insert(soup.attributes.end(), {n.x + attribute(rng), n.y + attribute(rng), n.z + attribute(rng),
+                                                           t.x + attribute(rng), t.y + attribute(rng)});
+        };
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < sides; ++j)
+            {
+                const uint32_t a = i * (sides + 1) + j;
+                const uint32_t b = a + sides + 1;
+                for (uint32_t g : {a, b, b + 1, a, b + 1, a + 1})
+                    corner(g);
+            }
+        }
+        return soup;
+    }
+
+    // Exact duplicates through a node based hash map over the vertex bytes
+    size_t WeldExact(const Soup& soup, std::vector<uint32_t>& remap)
+    {
+        std::unordered_map<std::string, uint32_t> unique;
+        unique.reserve(soup.positions.size());
+        remap.resize(soup.positions.size());
+        for (size_t v = 0; v < soup.positions.size(); ++v)
+        {
+            std::string key(reinterpret_cast<const char*>(&soup.positions[v]), sizeof(float3));
+            key.append(reinterpret_cast<const char*>(&soup.attributes[v * kAttributeStride]), kAttributeStride * sizeof(float));
+            remap[v] = unique.emplace(std::move(key), static_cast<uint32_t>(unique.size())).first->second;
+        }
+        return unique.size();
+    }
+
+    void RunVertexWeld()
+    {
+        const uint32_t rings = 512, sides = 256;
+        const size_t   expected = size_t(rings + 1) * (sides + 1);
+
+        // Exact duplicates: same result as the map
+        {
+            const Soup            soup = MakeTorusSoup(rings, sides, 0.f, 0.f, 1);
+            std::vector<uint32_t> reference, remap(soup.positions.size());
+            size_t                referenceCount = 0, count = 0;
+            std::printf("  %zu vertices, %zu triangles, %zu unique vertices\n", soup.positions.size(), soup.indices.size() / 3, expected);
+
+            const double bytes   = static_cast<double>(soup.positions.size() * (sizeof(float3) + kAttributeStride * sizeof(float)));
+            auto         mapTime = bench::Measure("unordered_map, exact", soup.positions.size(), bytes, [&] {
+                referenceCount = WeldExact(soup, reference);
+            });
+            bench::PrintSpeedup(mapTime, bench::Measure("GenerateWeldRemap, epsilon 0", soup.positions.size(), bytes, [&] {
+                count = GenerateWeldRemap(soup.positions, soup.attributes, kAttributeStride, 0.f, 0.f, remap);
+            }));
+            std::printf("  exact: %zu vertices (map %zu), remap %s the map\n", count, referenceCount, remap == reference ? "matches" : "DIFFERS FROM");
+        }
+
+        // Noisy duplicates within the tolerances, seams must stay apart
+        {
+            const float positionEpsilon = 1e-4f, attributeEpsilon = 1e-3f;
+            const Soup  soup            = MakeTorusSoup(rings, sides, 0.25f * positionEpsilon, 0.25f * attributeEpsilon, 2);
+
+            WeldedMesh welded;
+            bench::Measure("WeldVertices, epsilon 1e-4", soup.positions.size(), 0, [&] {
+                welded = WeldVertices(soup.positions, soup.attributes, kAttributeStride, soup.indices, positionEpsilon, attributeEpsilon);
+            });
+
+            float moved = 0.f;
+            for (size_t v = 0; v < soup.positions.size(); ++v)
+                moved = std::max(moved, length(welded.positions[welded.remap[v]] - soup.positions[v]));
+            bool sameTriangles = welded.indices.size() == soup.indices.size();
+            for (size_t i = 0; sameTriangles && i < soup.indices.size(); ++i)
+                sameTriangles = welded.indices[i] == welded.remap[soup.indices[i]];
+            std::printf("  noisy: %zu vertices (expected %zu), %zu triangles %s, largest move %.2g (epsilon %.2g)\n", welded.positions.size(),
+                        expected, welded.indices.size() / 3, sameTriangles ? "kept" : "CHANGED", moved, positionEpsilon);
+
+            // Ignoring the attributes closes the seams, rings * sides vertices. A tolerance above
+            // the shortest edge (2 pi / sides around the tube) collapses half of the triangles.
+            for (float epsilon : {0.01f, 0.025f})
+            {
+                const WeldedMesh coarse = WeldVertices(soup.positions, soup.attributes, kAttributeStride, soup.indices, epsilon, 2.f);
+                std::printf("  epsilon %.3g, attributes ignored: %zu vertices (grid %u), %zu of %zu triangles left\n", epsilon,
+                            coarse.positions.size(), rings * sides, coarse.indices.size() / 3, soup.indices.size() / 3);
+            }
+        }
+
+        // Expected linear time: the cost per vertex stays flat as the mesh grows
+        for (uint32_t scale : {1u, 4u})
+        {
+            const Soup            soup = MakeTorusSoup(rings * scale, sides, 0.f, 0.f, 3);
+            std::vector<uint32_t> remap(soup.positions.size());
+            char                  name[64];
+            std::snprintf(name, sizeof(name), "GenerateWeldRemap, %zu vertices", soup.positions.size());
+            bench::Measure(name, soup.positions.size(), 0, [&] {
+                GenerateWeldRemap(soup.positions, soup.attributes, kAttributeStride, 1e-4f, 1e-3f, remap);
+                bench::DoNotOptimize(remap.data());
+            });
+        }
+    }
+
+    bench::Registrar vertexWeldSuite("VertexWeld", RunVertexWeld);
+} // namespace
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace bench
+{
+    // Keeps the optimizer from discarding a computed value
+#if defined(_MSC_VER)
+    inline void UseCharPointer(char const volatile*) {}
+
+    template <typename T>
+    void DoNotOptimize(const T& value)
+    {
+        UseCharPointer(&reinterpret_cast<char const volatile&>(value));
+        _ReadWriteBarrier();
+    }
+#else
+    template <typename T>
+    void DoNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+#endif
+
+    struct Result
+    {
+        double nsPerIteration = 0;
+        double itemsPerSecond = 0;
+        double bytesPerSecond = 0;
+    };
+
+    // Runs `body` until at least `minSeconds` have passed (after one warm-up call)
+    // and reports the throughput. `items` and `bytes` describe one call of `body`.
+    inline Result Measure(const char* name, double items, double bytes, const std::function<void()>& body, double minSeconds = 0.25)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        body();
+
+        uint64_t iterations = 0;
+        auto     start      = Clock::now();
+        auto     elapsed    = 0.0;
+        for (uint64_t batch = 1; elapsed < minSeconds; batch *= 2)
+        {
+            for (uint64_t i = 0; i < batch; ++i)
+                body();
+            iterations += batch;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        Result result;
+        result.nsPerIteration = elapsed * 1e9 / static_cast<double>(iterations);
+        result.itemsPerSecond = items * static_cast<double>(iterations) / elapsed;
+        result.bytesPerSecond = bytes * static_cast<double>(iterations) / elapsed;
+
+        std::printf("  %-44s %12.1f ns/iter %10.2f M items/s", name, result.nsPerIteration, result.itemsPerSecond * 1e-6);
+        if (bytes > 0)
+            std::printf(" %8.2f GB/s", result.bytesPerSecond * 1e-9);
+        std::printf("\n");
+        return result;
+    }
+
+    inline void PrintSpeedup(const Result& baseline, const Result& optimized)
+    {
+        std::printf("  %-44s %12.2fx\n", "speedup", baseline.nsPerIteration / optimized.nsPerIteration);
+    }
+
+    // Benchmark registry: every Bench*.cpp registers its suites with a static Registrar
+    struct Suite
+    {
+        std::string           name;
+        std::function<void()> run;
+    };
+
+    inline std::vector<Suite>& Suites()
+    {
+        static std::vector<Suite> suites;
+        return suites;
+    }
+
+    struct Registrar
+    {
+        Registrar(const char* name, std::function<void()> run)
+        {
+            Suites().push_back(Suite{name, std::move(run)});
+        }
+    };
+
+} // namespace bench
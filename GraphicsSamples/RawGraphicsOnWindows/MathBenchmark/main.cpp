@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Benchmark.h"
+#include "Common/Math.Utils/Math.h"
+
+// Usage: MathBenchmark [suite-name-filter]
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    std::printf("SIMD:");
+#if defined(MATH_SIMD_SSE2)
+    std::printf(" SSE2");
+#endif
+#if defined(MATH_SIMD_SSE41)
+    std::printf(" SSE4.1");
+#endif
+#if defined(MATH_SIMD_AVX)
+    std::printf(" AVX");
+#endif
+#if defined(MATH_SIMD_AVX2)
+    std::printf(" AVX2");
+#endif
+#if defined(MATH_SIMD_AVX512)
+    std::printf(" AVX-512");
+#endif
+#if defined(MATH_SIMD_FMA)
+    std::printf(" FMA");
+#endif
+#if defined(MATH_SIMD_BMI2)
+    std::printf(" BMI2");
+#endif
+#if defined(MATH_SIMD_F16C)
+    std::printf(" F16C");
+#endif
+#if defined(MATH_FAST_TRIG)
+    std::printf(", MATH_FAST_TRIG");
+#endif
+    std::printf("\n\n");
+
+    for (const auto& suite : bench::Suites())
+    {
+        if (std::strstr(suite.name.c_str(), filter) == nullptr)
+            continue;
+
+        std::printf("[%s]\n", suite.name.c_str());
+        suite.run();
+        std::printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+#include "SW_Triangle.h"
+
+void SW_Triangle::DrawTriangle(sw::Image& image, uint32_t windowWidth, uint32_t windowHeight, unsigned threads)
+{
+    using namespace math;
+    using sw::Vertex;
+
+    // Same vertex, index and constant buffer data as the D3D samples
+    const Vertex vertexBufferData[3] = { {{ 1.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+                                         {{-1.0f, -1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+                                         {{ 0.0f,  1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}} };
+    const uint32_t indexBufferData[3] = { 0, 1, 2 };
+    const sw::ConstantBuffer cbVS;
+
+    sw::SoftwareRasterizer rasterizer(windowWidth, windowHeight, threads);
+    rasterizer.Clear(float4(0.2f, 0.2f, 0.2f, 1.0f));
+    rasterizer.Draw(vertexBufferData, indexBufferData, cbVS);
+    rasterizer.Resolve(image);
+}
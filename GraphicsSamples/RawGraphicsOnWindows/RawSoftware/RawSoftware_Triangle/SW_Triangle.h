@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SoftwareRasterizer.h"
+
+class SW_Triangle
+{
+public:
+    // The frame of DX12_Triangle::DrawTriangle, rendered on the CPU
+    void DrawTriangle(sw::Image& image, uint32_t windowWidth, uint32_t windowHeight, unsigned threads = 0);
+};
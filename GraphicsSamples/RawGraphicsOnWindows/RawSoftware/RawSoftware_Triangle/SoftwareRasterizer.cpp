@@ -0,0 +1,422 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#include "Common/Math.Utils/Simd.h"
+
+using namespace math;
+
+namespace
+{
+    // Subpixel precision of the snapped vertex positions
+    constexpr int32_t kSubpixelBits = 4;
+    constexpr int32_t kSubpixels    = 1 << kSubpixelBits;
+
+    // Triangles are clipped in x and y to this many pixels around the viewport only, the
+    // rest is left to the edge functions. With kMaxSize this keeps positions below 2^18
+    // subpixels and edge function values across one tile below 2^30, so int32 suffices
+    // inside a tile.
+    constexpr float kGuardBand = 6144.f;
+
+    // Minimum work per task, smaller draws run on fewer threads
+    constexpr size_t kVerticesPerTask  = 4096;
+    constexpr size_t kTrianglesPerTask = 1024;
+
+    // Clip space planes as distances, inside >= 0. D3D clips z to [0, w].
+    constexpr int kPlaneCount = 6;
+
+    float PlaneDistance(const float4& p, int plane, const float2& guardBand)
+    {
+        switch (plane)
+        {
+        case 0: return p.z;
+        case 1: return p.w - p.z;
+        case 2: return guardBand.x * p.w + p.x;
+        case 3: return guardBand.x * p.w - p.x;
+        case 4: return guardBand.y * p.w + p.y;
+        default: return guardBand.y * p.w - p.y;
+        }
+    }
+} // namespace
+
+namespace sw
+{
+    bool Image::WritePpm(const char* path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        file << "P6\n" << width << " " << height << "\n255\n";
+        std::vector<char> row(width * 3);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint32_t pixel = pixels[y * width + x];
+                row[x * 3 + 0]       = static_cast<char>(pixel & 0xFF);
+                row[x * 3 + 1]       = static_cast<char>((pixel >> 8u) & 0xFF);
+                row[x * 3 + 2]       = static_cast<char>((pixel >> 16u) & 0xFF);
+            }
+            file.write(row.data(), static_cast<std::streamsize>(row.size()));
+        }
+        return static_cast<bool>(file);
+    }
+
+    SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height, unsigned threads) :
+        m_ownPool(threads ? std::make_unique<ThreadPool>(threads) : nullptr),
+        m_pool(m_ownPool ? m_ownPool.get() : &ThreadPool::Default()),
+        m_width(width),
+        m_height(height),
+        m_threads(m_pool->size()),
+        m_tilesX((width + kTileSize - 1) / kTileSize),
+        m_tilesY((height + kTileSize - 1) / kTileSize),
+        m_stride(m_tilesX * kTileSize),
+        m_guardBand(2.f * kGuardBand / static_cast<float>(width) + 1.f, 2.f * kGuardBand / static_cast<float>(height) + 1.f),
+        m_color(static_cast<size_t>(m_stride) * m_tilesY * kTileSize),
+        m_bins(m_threads)
+    {
+        assert(width > 0 && width <= kMaxSize && height > 0 && height <= kMaxSize);
+        for (auto& bin : m_bins)
+            bin.tiles.resize(static_cast<size_t>(m_tilesX) * m_tilesY);
+    }
+
+    void SoftwareRasterizer::Clear(const float4& color)
+    {
+        std::fill(m_color.begin(), m_color.end(), F4Color_To_RGBA8Unorm(color));
+    }
+
+    void SoftwareRasterizer::Resolve(Image& image) const
+    {
+        image.width  = m_width;
+        image.height = m_height;
+        image.pixels.resize(static_cast<size_t>(m_width) * m_height);
+        for (uint32_t y = 0; y < m_height; ++y)
+            std::copy_n(&m_color[static_cast<size_t>(y) * m_stride], m_width, &image.pixels[static_cast<size_t>(y) * m_width]);
+    }
+
+    // Runs task(0) .. task(count - 1) on the pool, the calling thread taking part
+    template <typename F>
+    void SoftwareRasterizer::RunTasks(unsigned count, F&& task) const
+    {
+        m_pool->ParallelFor(0, count, 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+                task(static_cast<unsigned>(i));
+        });
+    }
+
+    void SoftwareRasterizer::Draw(span<const Vertex> vertices, span<const uint32_t> indices, const ConstantBuffer& cb)
+    {
+        assert(indices.size() % 3 == 0);
+
+        // triangle.vs.hlsl: mul(float4(inPos, 1.0), mul(modelMatrix, mul(viewMatrix, projectionMatrix)))
+        const float4x4 matrix      = cb.modelMatrix * (cb.viewMatrix * cb.projectionMatrix);
+        const size_t   vertexCount = vertices.size();
+        m_clipVertices.resize(vertexCount);
+
+        const unsigned vertexTasks = static_cast<unsigned>(std::min<size_t>(m_threads, vertexCount / kVerticesPerTask + 1));
+        RunTasks(vertexTasks, [&](unsigned task) {
+            const size_t first = vertexCount * task / vertexTasks;
+            const size_t last  = vertexCount * (task + 1) / vertexTasks;
+            for (size_t i = first; i < last; ++i)
+            {
+                m_clipVertices[i].position = float4(vertices[i].position, 1.f) * matrix;
+                m_clipVertices[i].color    = vertices[i].color;
+                Project(m_clipVertices[i]);
+            }
+        });
+
+        // Each setup task takes a contiguous run of triangles, so reading the bins in task
+        // order keeps the submission order
+        const size_t   triangleCount = indices.size() / 3;
+        const unsigned setupTasks    = static_cast<unsigned>(std::min<size_t>(m_threads, triangleCount / kTrianglesPerTask + 1));
+        RunTasks(setupTasks, [&](unsigned task) {
+            SetupRange(m_bins[task], indices, triangleCount * task / setupTasks, triangleCount * (task + 1) / setupTasks);
+        });
+        for (unsigned task = setupTasks; task < m_threads; ++task)
+        {
+            m_bins[task].triangles.clear();
+            for (auto& tile : m_bins[task].tiles)
+                tile.clear();
+        }
+
+        const uint32_t        tileCount = m_tilesX * m_tilesY;
+        std::atomic<uint32_t> nextTile(0);
+        RunTasks(std::min(m_threads, tileCount), [&](unsigned) {
+            for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+                RasterizeTile(tile);
+        });
+    }
+
+    void SoftwareRasterizer::SetupRange(Bin& bin, span<const uint32_t> indices, size_t first, size_t last) const
+    {
+        bin.triangles.clear();
+        for (auto& tile : bin.tiles)
+            tile.clear();
+
+        for (size_t i = first; i < last; ++i)
+        {
+            assert(indices[i * 3 + 0] < m_clipVertices.size() && indices[i * 3 + 1] < m_clipVertices.size() &&
+                   indices[i * 3 + 2] < m_clipVertices.size());
+            ClipAndSetup(bin, m_clipVertices[indices[i * 3 + 0]], m_clipVertices[indices[i * 3 + 1]], m_clipVertices[indices[i * 3 + 2]]);
+        }
+    }
+
+    // Vertices are shared by several triangles, so the perspective divide and the
+    // snapping happen once per vertex
+    void SoftwareRasterizer::Project(ClipVertex& v) const
+    {
+        v.outside = 0;
+        for (int plane = 0; plane < kPlaneCount; ++plane)
+            v.outside |= (PlaneDistance(v.position, plane, m_guardBand) < 0.f ? 1u : 0u) << plane;
+        if (v.outside != 0)
+            return;
+
+        // Inside every plane w >= 0, and w == 0 only for the eye point itself
+        const float invW = v.position.w > 0.f ? 1.f / v.position.w : 0.f;
+        const float sx   = (v.position.x * invW + 1.f) * 0.5f * static_cast<float>(m_width);
+        const float sy   = (1.f - v.position.y * invW) * 0.5f * static_cast<float>(m_height);
+        v.x              = static_cast<int32_t>(FastFloor(sx * kSubpixels + 0.5f));
+        v.y              = static_cast<int32_t>(FastFloor(sy * kSubpixels + 0.5f));
+        v.attributes[0]  = invW;
+        v.attributes[1]  = v.color.x * invW;
+        v.attributes[2]  = v.color.y * invW;
+        v.attributes[3]  = v.color.z * invW;
+    }
+
+    void SoftwareRasterizer::ClipAndSetup(Bin& bin, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2) const
+    {
+        if ((v0.outside & v1.outside & v2.outside) != 0)
+            return;
+        if ((v0.outside | v1.outside | v2.outside) == 0)
+        {
+            Setup(bin, v0, v1, v2);
+            return;
+        }
+
+        // Sutherland-Hodgman against the planes that cut the triangle, then a fan
+        ClipVertex polygon[3 + kPlaneCount], clipped[3 + kPlaneCount];
+        int        count = 3;
+        polygon[0]       = v0;
+        polygon[1]       = v1;
+        polygon[2]       = v2;
+
+        const uint32_t planes = v0.outside | v1.outside | v2.outside;
+        for (int plane = 0; plane < kPlaneCount && count >= 3; ++plane)
+        {
+            if ((planes & (1u << plane)) == 0)
+                continue;
+
+            int clippedCount = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                const ClipVertex& a  = polygon[i];
+                const ClipVertex& b  = polygon[(i + 1) % count];
+                const float       da = PlaneDistance(a.position, plane, m_guardBand);
+                const float       db = PlaneDistance(b.position, plane, m_guardBand);
+
+                if (da >= 0.f)
+                    clipped[clippedCount++] = a;
+                if ((da >= 0.f) != (db >= 0.f))
+                {
+                    const float t     = da / (da - db);
+                    ClipVertex& v     = clipped[clippedCount++];
+                    v.position        = lerp(a.position, b.position, t);
+                    v.color           = lerp(a.color, b.color, t);
+                }
+            }
+            std::copy_n(clipped, clippedCount, polygon);
+            count = clippedCount;
+        }
+
+        // Rounding may leave new vertices a hair outside the plane they were clipped to,
+        // which is harmless: the guard band is far from the viewport, z only needs w > 0
+        for (int i = 0; i < count; ++i)
+        {
+            Project(polygon[i]);
+            polygon[i].outside = 0;
+        }
+        for (int i = 1; i + 1 < count; ++i)
+            Setup(bin, polygon[0], polygon[i], polygon[i + 1]);
+    }
+
+    void SoftwareRasterizer::Setup(Bin& bin, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2) const
+    {
+        // Only degenerate triangles through the eye survive clipping with w <= 0
+        if (!(v0.position.w > 0.f && v1.position.w > 0.f && v2.position.w > 0.f))
+            return;
+
+        int32_t      x[3] = {v0.x, v1.x, v2.x};
+        int32_t      y[3] = {v0.y, v1.y, v2.y};
+        const float* f[3] = {v0.attributes, v1.attributes, v2.attributes}; // 1/w, r/w, g/w, b/w
+
+        // CULL_MODE_NONE: make every triangle counter-clockwise on screen
+        int64_t area2 = int64_t(x[1] - x[0]) * (y[2] - y[0]) - int64_t(y[1] - y[0]) * (x[2] - x[0]);
+        if (area2 == 0)
+            return;
+        if (area2 < 0)
+        {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(f[1], f[2]);
+            area2 = -area2;
+        }
+
+        SetupTriangle t;
+        // First pixel center at or right of the leftmost vertex, last at or left of the rightmost
+        t.minX = std::max<int32_t>(0, (std::min({x[0], x[1], x[2]}) + kSubpixels / 2 - 1) >> kSubpixelBits);
+        t.minY = std::max<int32_t>(0, (std::min({y[0], y[1], y[2]}) + kSubpixels / 2 - 1) >> kSubpixelBits);
+        t.maxX = std::min<int32_t>(m_width - 1, (std::max({x[0], x[1], x[2]}) - kSubpixels / 2) >> kSubpixelBits);
+        t.maxY = std::min<int32_t>(m_height - 1, (std::max({y[0], y[1], y[2]}) - kSubpixels / 2) >> kSubpixelBits);
+        if (t.minX > t.maxX || t.minY > t.maxY)
+            return;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const int j = (i + 1) % 3;
+            t.a[i]      = y[i] - y[j];
+            t.b[i]      = x[j] - x[i];
+            t.c[i]      = -(int64_t(t.a[i]) * x[i] + int64_t(t.b[i]) * y[i]);
+            // Top-left rule: samples exactly on an edge belong to the triangle only for
+            // left edges (a > 0) and top edges (a == 0, b > 0)
+            if (!(t.a[i] > 0 || (t.a[i] == 0 && t.b[i] > 0)))
+                t.c[i] -= 1;
+        }
+
+        // Attribute planes in pixels, relative to vertex 0
+        const float dx1  = static_cast<float>(x[1] - x[0]) / kSubpixels;
+        const float dy1  = static_cast<float>(y[1] - y[0]) / kSubpixels;
+        const float dx2  = static_cast<float>(x[2] - x[0]) / kSubpixels;
+        const float dy2  = static_cast<float>(y[2] - y[0]) / kSubpixels;
+        const float invArea = kSubpixels * kSubpixels / static_cast<float>(area2);
+        t.x0             = static_cast<float>(x[0]) / kSubpixels;
+        t.y0             = static_cast<float>(y[0]) / kSubpixels;
+        for (int k = 0; k < 4; ++k)
+        {
+            const float df1     = f[1][k] - f[0][k];
+            const float df2     = f[2][k] - f[0][k];
+            t.attributes[k][0] = f[0][k];
+            t.attributes[k][1] = (df1 * dy2 - df2 * dy1) * invArea;
+            t.attributes[k][2] = (df2 * dx1 - df1 * dx2) * invArea;
+        }
+
+        const auto index = static_cast<uint32_t>(bin.triangles.size());
+        bin.triangles.push_back(t);
+        for (uint32_t ty = static_cast<uint32_t>(t.minY) / kTileSize; ty <= static_cast<uint32_t>(t.maxY) / kTileSize; ++ty)
+        {
+            for (uint32_t tx = static_cast<uint32_t>(t.minX) / kTileSize; tx <= static_cast<uint32_t>(t.maxX) / kTileSize; ++tx)
+                bin.tiles[ty * m_tilesX + tx].push_back(index);
+        }
+    }
+
+    void SoftwareRasterizer::RasterizeTile(uint32_t tile)
+    {
+        const uint32_t tileX = tile % m_tilesX * kTileSize;
+        const uint32_t tileY = tile / m_tilesX * kTileSize;
+        for (const Bin& bin : m_bins)
+        {
+            for (uint32_t index : bin.tiles[tile])
+                RasterizeTriangle(bin.triangles[index], tileX, tileY);
+        }
+    }
+
+    void SoftwareRasterizer::RasterizeTriangle(const SetupTriangle& t, uint32_t tileX, uint32_t tileY)
+    {
+        using namespace simd;
+        constexpr auto kLanes = static_cast<int32_t>(kWidth);
+
+        // Whole registers: kTileSize is a multiple of kWidth, so they never leave the
+        // tile, and lanes past the viewport write into the padding of m_color
+        const int32_t xBegin = std::max(t.minX, static_cast<int32_t>(tileX)) & ~(kLanes - 1);
+        const int32_t xEnd   = std::min(t.maxX, static_cast<int32_t>(tileX + kTileSize - 1));
+        const int32_t xLast  = xEnd | (kLanes - 1);
+        const int32_t yBegin = std::max(t.minY, static_cast<int32_t>(tileY));
+        const int32_t yEnd   = std::min(t.maxY, static_cast<int32_t>(tileY + kTileSize - 1));
+
+        // Edges that pass through the rectangle are evaluated per pixel, edges with the
+        // whole rectangle inside are skipped, any edge with it outside rejects the triangle
+        int32_t rowValue[3], rowStep[3];
+        vint    laneValue[3], chunkStep[3];
+        bool    partial = false;
+        for (int i = 0; i < 3; ++i)
+        {
+            const int64_t e  = int64_t(t.a[i]) * (xBegin * kSubpixels + kSubpixels / 2) + int64_t(t.b[i]) * (yBegin * kSubpixels + kSubpixels / 2) + t.c[i];
+            const int64_t dx = int64_t(t.a[i]) * kSubpixels * (xLast - xBegin);
+            const int64_t dy = int64_t(t.b[i]) * kSubpixels * (yEnd - yBegin);
+            if (e + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0) < 0)
+                return;
+
+            int32_t    lanes[kWidth] = {};
+            const bool crosses       = e + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0) < 0;
+            if (crosses)
+            {
+                for (int32_t lane = 0; lane < kLanes; ++lane)
+                    lanes[lane] = t.a[i] * kSubpixels * lane;
+            }
+            partial      = partial || crosses;
+            rowValue[i]  = crosses ? static_cast<int32_t>(e) : 0;
+            rowStep[i]   = crosses ? t.b[i] * kSubpixels : 0;
+            laneValue[i] = load(lanes);
+            chunkStep[i] = broadcast_int(crosses ? t.a[i] * kSubpixels * kLanes : 0);
+        }
+
+        float laneOffsets[kWidth];
+        for (int32_t lane = 0; lane < kLanes; ++lane)
+            laneOffsets[lane] = static_cast<float>(lane);
+        const vfloat laneX = load(laneOffsets);
+
+        const vfloat zero = broadcast(0.f), one = broadcast(1.f);
+        const vfloat scale = broadcast(255.f), half = broadcast(0.5f);
+        const vint   alpha = broadcast_int(static_cast<int32_t>(0xFF000000u));
+        vfloat       ddx[4];
+        for (int k = 0; k < 4; ++k)
+            ddx[k] = broadcast(t.attributes[k][1]);
+
+        for (int32_t y = yBegin; y <= yEnd; ++y)
+        {
+            const float dy = static_cast<float>(y) + 0.5f - t.y0;
+            vfloat      rowBase[4];
+            for (int k = 0; k < 4; ++k)
+                rowBase[k] = broadcast(t.attributes[k][0] + t.attributes[k][2] * dy);
+
+            vint      e0  = broadcast_int(rowValue[0]) + laneValue[0];
+            vint      e1  = broadcast_int(rowValue[1]) + laneValue[1];
+            vint      e2  = broadcast_int(rowValue[2]) + laneValue[2];
+            uint32_t* row = &m_color[static_cast<size_t>(y) * m_stride];
+
+            for (int32_t x = xBegin; x <= xEnd; x += kLanes)
+            {
+                // int -> float keeps the sign, so the test stays exact
+                const vmask inside = (convert_float(e0) >= zero) & (convert_float(e1) >= zero) & (convert_float(e2) >= zero);
+                e0                 = e0 + chunkStep[0];
+                e1                 = e1 + chunkStep[1];
+                e2                 = e2 + chunkStep[2];
+                if (!any(inside))
+                    continue;
+
+                // triangle.ps.hlsl: float4(color, 1.0), perspective-correct
+                const vfloat dx   = laneX + broadcast(static_cast<float>(x) + 0.5f - t.x0);
+                const vfloat w    = one / madd(ddx[0], dx, rowBase[0]);
+                const auto   unorm = [&](int k) {
+                    const vfloat c = min(max(madd(ddx[k], dx, rowBase[k]) * w, zero), one);
+                    return convert_trunc(madd(c, scale, half));
+                };
+                const vint pixels = unorm(1) | unorm(2) << 8 | unorm(3) << 16 | alpha;
+
+                if (partial)
+                    store(row + x, reinterpret_int(select(inside, reinterpret_float(pixels), reinterpret_float(load(row + x)))));
+                else
+                    store(row + x, pixels);
+            }
+
+            rowValue[0] += rowStep[0];
+            rowValue[1] += rowStep[1];
+            rowValue[2] += rowStep[2];
+        }
+    }
+} // namespace sw
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Common/Math.Utils/Math.h"
+#include "Common/Math.Utils/Span.h"
+#include "Common/Math.Utils/ThreadPool.h"
+
+// CPU implementation of the pipeline of the RawDX11/RawDX12 triangle samples:
+// triangle.vs.hlsl, CULL_MODE_NONE, no depth test and triangle.ps.hlsl into an
+// R8G8B8A8_UNORM render target. Runs anywhere, so frames can be rendered and compared
+// without a GPU.
+//
+// Draw works in three multithreaded passes:
+//   1. vertex shading into clip space,
+//   2. clipping, triangle setup and binning into 64x64 pixel tiles,
+//   3. rasterization, one tile per thread at a time.
+// The passes run on a ThreadPool that lives as long as the rasterizer.
+// Vertices are snapped to 1/16 pixel and covered by integer edge functions with the
+// D3D top-left rule, evaluated for simd::kWidth pixels at once (8 with AVX2). Colors
+// are interpolated perspective-correct. Each tile draws its triangles in submission
+// order, so the image does not depend on the number of threads.
+
+namespace sw
+{
+    // Input layout of triangle.vs.hlsl: POSITION, COLOR
+    struct Vertex
+    {
+        math::float3 position;
+        math::float3 color;
+    };
+
+    // cbuffer cb : register(b0) of triangle.vs.hlsl, row_major
+    struct ConstantBuffer
+    {
+        math::float4x4 projectionMatrix = math::float4x4::Identity();
+        math::float4x4 modelMatrix      = math::float4x4::Identity();
+        math::float4x4 viewMatrix       = math::float4x4::Identity();
+    };
+
+    // RGBA8 pixels as in DXGI_FORMAT_R8G8B8A8_UNORM: r in the low byte, row by row
+    struct Image
+    {
+        uint32_t              width  = 0;
+        uint32_t              height = 0;
+        std::vector<uint32_t> pixels;
+
+        // Binary PPM (P6), alpha is dropped
+        bool WritePpm(const char* path) const;
+    };
+
+    class SoftwareRasterizer
+    {
+    public:
+        static constexpr uint32_t kTileSize = 64;
+        static constexpr uint32_t kMaxSize  = 4096;
+
+        // threads = 0 runs on math::ThreadPool::Default(), otherwise on a pool of its own
+        SoftwareRasterizer(uint32_t width, uint32_t height, unsigned threads = 0);
+
+        void Clear(const math::float4& color);
+
+        // Indexed triangle list. Later triangles overwrite earlier ones, as without depth test.
+        void Draw(math::span<const Vertex> vertices, math::span<const uint32_t> indices, const ConstantBuffer& cb);
+
+        // Copies the render target out of the padded working buffer
+        void Resolve(Image& image) const;
+
+        uint32_t Width() const { return m_width; }
+        uint32_t Height() const { return m_height; }
+        unsigned Threads() const { return m_threads; }
+
+    private:
+        // Clip space vertex; unless it is outside one of the clip planes also the snapped
+        // screen position (1/16 pixels) and the attributes divided by w
+        struct ClipVertex
+        {
+            math::float4 position;
+            math::float3 color;
+            uint32_t     outside; // bit per clip plane
+            int32_t      x, y;
+            float        attributes[4]; // 1/w, r/w, g/w, b/w
+        };
+
+        // Edge functions in 1/16 pixel units, E(x, y) = a * x + b * y + c >= 0 inside.
+        // Attributes are planes in pixels relative to vertex 0: value, d/dx, d/dy.
+        struct SetupTriangle
+        {
+            int32_t a[3];
+            int32_t b[3];
+            int64_t c[3];
+            int32_t minX, minY, maxX, maxY; // covered pixels, inclusive and inside the viewport
+            float   x0, y0;
+            float   attributes[4][3]; // 1/w, r/w, g/w, b/w
+        };
+
+        // Output of one setup task: its triangles and, per tile, the ones that touch it
+        struct Bin
+        {
+            std::vector<SetupTriangle>         triangles;
+            std::vector<std::vector<uint32_t>> tiles;
+        };
+
+        template <typename F>
+        void RunTasks(unsigned count, F&& task) const;
+
+        void SetupRange(Bin& bin, math::span<const uint32_t> indices, size_t first, size_t last) const;
+        void Project(ClipVertex& v) const;
+        void ClipAndSetup(Bin& bin, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2) const;
+        void Setup(Bin& bin, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2) const;
+        void RasterizeTile(uint32_t tile);
+        void RasterizeTriangle(const SetupTriangle& triangle, uint32_t tileX, uint32_t tileY);
+
+        std::unique_ptr<math::ThreadPool> m_ownPool;
+        math::ThreadPool*                 m_pool;
+
+        uint32_t m_width;
+        uint32_t m_height;
+        unsigned m_threads;
+        uint32_t m_tilesX;
+        uint32_t m_tilesY;
+        uint32_t m_stride; // pixels per row of m_color, a whole number of tiles
+
+        math::float2 m_guardBand; // clip space x and y limit, in multiples of w
+
+        std::vector<uint32_t>   m_color;
+        std::vector<ClipVertex> m_clipVertices;
+        std::vector<Bin>        m_bins;
+    };
+} // namespace sw
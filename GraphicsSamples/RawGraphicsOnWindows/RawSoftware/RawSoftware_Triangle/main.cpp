@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "SW_Triangle.h"
+#include "SoftwareRasterizer.h"
+
+namespace
+{
+    struct Scene
+    {
+        std::vector<sw::Vertex> vertices;
+        std::vector<uint32_t>   indices;
+        sw::ConstantBuffer      cb;
+    };
+
+    // A wavy terrain grid seen in perspective: many small triangles in the distance,
+    // large ones in front, and rows crossing the near plane that need clipping.
+    // Rows go from far to near, so without depth test nearer hills cover farther ones.
+    Scene MakeTerrain(uint32_t columns, uint32_t rows, float aspectRatio)
+    {
+        using namespace math;
+
+        Scene scene;
+        for (uint32_t j = 0; j <= rows; ++j)
+        {
+            for (uint32_t i = 0; i <= columns; ++i)
+            {
+                const float u = static_cast<float>(i) / static_cast<float>(columns);
+                const float v = static_cast<float>(j) / static_cast<float>(rows);
+                const float h = 0.05f * std::sin(40.f * u) * std::cos(30.f * v);
+                scene.vertices.push_back({float3(u * 2.f - 1.f, h, 1.f - v * 2.f), float3(u, v, 0.5f + 10.f * h)});
+            }
+        }
+        for (uint32_t j = 0; j < rows; ++j)
+        {
+            for (uint32_t i = 0; i < columns; ++i)
+            {
+                const uint32_t a = j * (columns + 1) + i;
+                const uint32_t b = a + columns + 1;
+                scene.indices.insert(scene.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+            }
+        }
+
+        scene.cb.modelMatrix      = float4x4::Scale(4.f);
+        scene.cb.viewMatrix       = float4x4::Translation(0.f, -2.f, 3.f) * float4x4::RotationX(-0.5f);
+        scene.cb.projectionMatrix = float4x4::Projection(1.f, aspectRatio, 0.1f, 100.f, false);
+        return scene;
+    }
+
+    // Renders frames for about a second, returns seconds per frame
+    double MeasureFrames(sw::SoftwareRasterizer& rasterizer, const Scene& scene)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const auto start  = Clock::now();
+        double     elapsed = 0;
+        uint32_t   frames  = 0;
+        while (elapsed < 1.0 || frames < 3)
+        {
+            rasterizer.Clear(math::float4(0.2f, 0.2f, 0.2f, 1.0f));
+            rasterizer.Draw(scene.vertices, scene.indices, scene.cb);
+            ++frames;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        return elapsed / frames;
+    }
+} // namespace
+
+// Usage: RawSoftware_Triangle [output.ppm]
+// Writes the frame of the D3D triangle samples, then measures the rasterizer.
+int main(int argc, char* argv[])
+{
+    const char* output       = argc > 1 ? argv[1] : "triangle.ppm";
+    uint32_t    windowWidth  = 800;
+    uint32_t    windowHeight = 600;
+
+    sw::Image   image;
+    SW_Triangle sample;
+    sample.DrawTriangle(image, windowWidth, windowHeight);
+    if (!image.WritePpm(output))
+    {
+        std::printf("cannot write %s\n", output);
+        return 1;
+    }
+    std::printf("%s: %ux%u\n", output, image.width, image.height);
+
+    // Benchmark: the same scene on one thread and on all of them must give the same image
+    windowWidth  = 1280;
+    windowHeight = 720;
+    const Scene  scene     = MakeTerrain(400, 300, static_cast<float>(windowWidth) / static_cast<float>(windowHeight));
+    const size_t triangles = scene.indices.size() / 3;
+    std::printf("terrain: %zu triangles at %ux%u\n", triangles, windowWidth, windowHeight);
+
+    sw::SoftwareRasterizer serial(windowWidth, windowHeight, 1);
+    sw::SoftwareRasterizer parallel(windowWidth, windowHeight);
+
+    const double serialFrame   = MeasureFrames(serial, scene);
+    const double parallelFrame = MeasureFrames(parallel, scene);
+    std::printf("  1 thread:    %8.2f ms/frame %8.2f M triangles/s\n", serialFrame * 1e3, triangles / serialFrame * 1e-6);
+    std::printf("  %2u threads:  %8.2f ms/frame %8.2f M triangles/s\n", parallel.Threads(), parallelFrame * 1e3, triangles / parallelFrame * 1e-6);
+
+    sw::Image serialImage, parallelImage;
+    serial.Resolve(serialImage);
+    parallel.Resolve(parallelImage);
+    std::printf("  images identical: %s\n", serialImage.pixels == parallelImage.pixels ? "yes" : "NO");
+    return 0;
+}